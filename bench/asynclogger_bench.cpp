@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <thread>
+#include <tech/asynclogger.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+void nullSink(LogLevel level, const String& file, int line, const String& message)
+{
+	doNotOptimize(level);
+	doNotOptimize(file);
+	doNotOptimize(line);
+	doNotOptimize(message);
+}
+
+
+// Emulates a slow sink (e.g. a terminal or a network socket)
+void slowSink(LogLevel level, const String& file, int line, const String& message)
+{
+	nullSink(level, file, line, message);
+	std::this_thread::sleep_for(std::chrono::microseconds(1));
+}
+
+
+void nullRecordSink(LogLevel level, const String& file, int line, const char* message,
+		const LogFields& fields)
+{
+	doNotOptimize(level);
+	doNotOptimize(file);
+	doNotOptimize(line);
+	doNotOptimize(message);
+	doNotOptimize(fields);
+}
+
+
+void reportPercentiles(BenchmarkState& state, std::vector<u64>* samples)
+{
+	if(samples->empty())
+		return;
+
+	std::sort(samples->begin(), samples->end());
+
+	auto percentile = [samples](double p) {
+		size_t index = static_cast<size_t>(p * (samples->size() - 1));
+		return static_cast<double>((*samples)[index]);
+	};
+
+	state.setCounter("p50", percentile(0.5));
+	state.setCounter("p99", percentile(0.99));
+	state.setCounter("p99.9", percentile(0.999));
+	state.setCounter("max", static_cast<double>(samples->back()));
+}
+
+
+void producerLatency(BenchmarkState& state, AsyncLogger::OverflowPolicy policy,
+		LogMessageHandler sink)
+{
+	static const size_t kMaxSamples = 1 << 20;
+
+	String file = "render.cpp";
+	String message = "frame 1024 rendered in 16 ms";
+
+	std::vector<u64> samples;
+	samples.reserve(std::min<u64>(state.iterations(), kMaxSamples));
+
+	AsyncLogger logger(sink, AsyncLogger::kDefaultCapacity, policy);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		u64 begin = nanoseconds();
+		logger.post(LogLevel::kInfo, file, 42, message);
+		u64 end = nanoseconds();
+
+		if(samples.size() < kMaxSamples)
+			samples.push_back(end - begin);
+	}
+
+	state.pauseTiming();
+	logger.flush();
+	reportPercentiles(state, &samples);
+	state.setItemsProcessed(state.iterations());
+
+	if(logger.droppedCount())
+		state.setCounter("dropped", logger.droppedCount());
+}
+
+
+void concurrentProducers(BenchmarkState& state, int threadCount,
+		AsyncLogger::OverflowPolicy policy)
+{
+	String file = "worker.cpp";
+	String message = "task finished";
+	AsyncLogger logger(LogMessageHandler(&nullSink), AsyncLogger::kDefaultCapacity,
+			policy);
+
+	u64 perThread = state.iterations() / threadCount + 1;
+	std::vector<std::thread> threads;
+
+	for(int i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&]() {
+			for(u64 j = 0; j < perThread; ++j)
+				logger.post(LogLevel::kInfo, file, 7, message);
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	logger.flush();
+	state.setItemsProcessed(perThread * threadCount);
+
+	if(logger.droppedCount())
+		state.setCounter("dropped", logger.droppedCount());
+}
+
+
+// Producer side cost of LOG with arguments: the message is either formatted by the
+// caller and posted or the arguments are copied into the ring buffer as is
+void formattedLatency(BenchmarkState& state, bool isDeferred)
+{
+	static const size_t kMaxSamples = 1 << 20;
+
+	String name = "main window";
+	std::vector<u64> samples;
+	samples.reserve(std::min<u64>(state.iterations(), kMaxSamples));
+
+	AsyncLogger logger(LogMessageHandler(&nullSink), AsyncLogger::kDefaultCapacity);
+	setLogMessageHandler(LogMessageHandler(&logger, &AsyncLogger::post));
+
+	if(isDeferred)
+		setDeferredLogSink(&logger);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		u64 begin = nanoseconds();
+		LOG_INFO("frame {} of {} rendered in {} ms", i, name, 16);
+		u64 end = nanoseconds();
+
+		if(samples.size() < kMaxSamples)
+			samples.push_back(end - begin);
+	}
+
+	state.pauseTiming();
+	logger.flush();
+	setDeferredLogSink(nullptr);
+	setLogMessageHandler(LogMessageHandler());
+	reportPercentiles(state, &samples);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Producer side cost of the structured counterpart of the message above, the writer
+// thread either passes the fields to the record handler or renders them as text
+void structuredLatency(BenchmarkState& state, bool hasRecordHandler)
+{
+	static const size_t kMaxSamples = 1 << 20;
+
+	String name = "main window";
+	std::vector<u64> samples;
+	samples.reserve(std::min<u64>(state.iterations(), kMaxSamples));
+
+	AsyncLogger logger(LogMessageHandler(&nullSink), AsyncLogger::kDefaultCapacity);
+
+	if(hasRecordHandler)
+		logger.setRecordHandler(LogRecordHandler(&nullRecordSink));
+
+	setDeferredLogSink(&logger);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		u64 begin = nanoseconds();
+		logFields(LogLevel::kInfo, "render.cpp", 42, "frame rendered", "frame", i, "window",
+				name, "elapsed", Duration(16));
+		u64 end = nanoseconds();
+
+		if(samples.size() < kMaxSamples)
+			samples.push_back(end - begin);
+	}
+
+	state.pauseTiming();
+	logger.flush();
+	setDeferredLogSink(nullptr);
+	reportPercentiles(state, &samples);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+} // namespace
+
+
+BENCHMARK(SyncLogMessageNullSink)
+{
+	String file = "render.cpp";
+	String message = "frame 1024 rendered in 16 ms";
+	LogMessageHandler handler(&nullSink);
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		handler(LogLevel::kInfo, file, 42, message);
+}
+
+
+BENCHMARK(SyncLogMessageSlowSink)
+{
+	String file = "render.cpp";
+	String message = "frame 1024 rendered in 16 ms";
+	LogMessageHandler handler(&slowSink);
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		handler(LogLevel::kInfo, file, 42, message);
+}
+
+
+BENCHMARK(AsyncLoggerLatencyBlock)
+{
+	producerLatency(state, AsyncLogger::OverflowPolicy::kBlock,
+			LogMessageHandler(&nullSink));
+}
+
+
+BENCHMARK(AsyncLoggerFormattedEager)
+{
+	formattedLatency(state, false);
+}
+
+
+BENCHMARK(AsyncLoggerFormattedDeferred)
+{
+	formattedLatency(state, true);
+}
+
+
+BENCHMARK(AsyncLoggerStructured)
+{
+	structuredLatency(state, true);
+}
+
+
+BENCHMARK(AsyncLoggerStructuredRendered)
+{
+	structuredLatency(state, false);
+}
+
+
+BENCHMARK(AsyncLoggerLatencyDropSlowSink)
+{
+	producerLatency(state, AsyncLogger::OverflowPolicy::kDrop,
+			LogMessageHandler(&slowSink));
+}
+
+
+BENCHMARK(AsyncLoggerLatencyDropOldestSlowSink)
+{
+	producerLatency(state, AsyncLogger::OverflowPolicy::kDropOldest,
+			LogMessageHandler(&slowSink));
+}
+
+
+BENCHMARK(AsyncLogger4ProducersBlock)
+{
+	concurrentProducers(state, 4, AsyncLogger::OverflowPolicy::kBlock);
+}
+
+
+BENCHMARK(AsyncLogger4ProducersDropOldest)
+{
+	concurrentProducers(state, 4, AsyncLogger::OverflowPolicy::kDropOldest);
+}
@@ -0,0 +1,189 @@
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+struct BenchmarkInfo {
+	const char* name;
+	BenchmarkProc proc;
+};
+
+
+std::vector<BenchmarkInfo>& benchmarks()
+{
+	static std::vector<BenchmarkInfo> result;
+	return result;
+}
+
+
+void runBenchmark(const BenchmarkInfo& info, double minTime)
+{
+	u64 iterations = 1;
+
+	while(true) {
+		BenchmarkState state(iterations);
+		state.start();
+		info.proc(state);
+		state.stop();
+
+		double elapsed = state.elapsedNanoseconds();
+		if(elapsed >= minTime * 1e9 || iterations >= (u64(1) << 40)) {
+			double seconds = elapsed / 1e9;
+
+			std::printf("%-48s %12llu %12.1f ns/op", info.name,
+					static_cast<ulonglong>(iterations), elapsed / iterations);
+
+			if(state.itemsProcessed())
+				std::printf(" %12.0f items/s", state.itemsProcessed() / seconds);
+
+			if(state.bytesProcessed()) {
+				std::printf(" %10.1f MB/s",
+						state.bytesProcessed() / seconds / (1024.0 * 1024.0));
+			}
+
+			for(const auto& counter : state.counters())
+				std::printf(" %s=%.1f", counter.first, counter.second);
+
+			std::printf("\n");
+			std::fflush(stdout);
+			return;
+		}
+
+		// Estimate the iteration count required to run for at least minTime
+		double scale = elapsed > 0.0 ? minTime * 1.4e9 / elapsed : 100.0;
+		scale = scale < 2.0 ? 2.0 : (scale > 100.0 ? 100.0 : scale);
+		iterations = static_cast<u64>(iterations * scale);
+	}
+}
+
+
+} // namespace
+
+
+BenchmarkState::BenchmarkState(u64 iterations) :
+	iterations_(iterations),
+	items_(0),
+	bytes_(0),
+	elapsed_(Clock::duration::zero()),
+	isRunning_(false)
+{
+}
+
+
+u64 BenchmarkState::iterations() const
+{
+	return iterations_;
+}
+
+
+void BenchmarkState::pauseTiming()
+{
+	stop();
+}
+
+
+void BenchmarkState::resumeTiming()
+{
+	start();
+}
+
+
+void BenchmarkState::setItemsProcessed(u64 count)
+{
+	items_ = count;
+}
+
+
+void BenchmarkState::setBytesProcessed(u64 count)
+{
+	bytes_ = count;
+}
+
+
+void BenchmarkState::setCounter(const char* name, double value)
+{
+	counters_.emplace_back(makePair(name, value));
+}
+
+
+double BenchmarkState::elapsedNanoseconds() const
+{
+	return std::chrono::duration<double, std::nano>(elapsed_).count();
+}
+
+
+u64 BenchmarkState::itemsProcessed() const
+{
+	return items_;
+}
+
+
+u64 BenchmarkState::bytesProcessed() const
+{
+	return bytes_;
+}
+
+
+const std::vector<Pair<const char*, double>>& BenchmarkState::counters() const
+{
+	return counters_;
+}
+
+
+void BenchmarkState::start()
+{
+	if(!isRunning_) {
+		isRunning_ = true;
+		started_ = Clock::now();
+	}
+}
+
+
+void BenchmarkState::stop()
+{
+	if(isRunning_) {
+		elapsed_ += Clock::now() - started_;
+		isRunning_ = false;
+	}
+}
+
+
+int registerBenchmark(const char* name, BenchmarkProc proc)
+{
+	benchmarks().push_back(BenchmarkInfo{ name, proc });
+	return static_cast<int>(benchmarks().size());
+}
+
+
+} // namespace Tech
+
+
+int main(int argc, char** argv)
+{
+	double minTime = 0.5;
+	const char* filter = nullptr;
+
+	for(int i = 1; i < argc; ++i) {
+		if(std::strncmp(argv[i], "--min-time=", 11) == 0) {
+			minTime = std::atof(argv[i] + 11);
+		}
+		else {
+			filter = argv[i];
+		}
+	}
+
+	for(const auto& info : Tech::benchmarks()) {
+		if(!filter || std::strstr(info.name, filter))
+			Tech::runBenchmark(info, minTime);
+	}
+
+	return 0;
+}
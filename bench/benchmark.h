@@ -0,0 +1,102 @@
+#ifndef TECH_BENCH_BENCHMARK_H
+#define TECH_BENCH_BENCHMARK_H
+
+#include <chrono>
+#include <vector>
+#include <tech/types.h>
+
+
+#define BENCHMARK(name)                                                               \
+	static void name(Tech::BenchmarkState& state);                                    \
+	static const int name##Registration = Tech::registerBenchmark(#name, name);       \
+	static void name(Tech::BenchmarkState& state)
+
+
+namespace Tech {
+
+
+/**
+ * State of a single benchmark run. The benchmark body should perform iterations()
+ * repetitions of the measured operation. The runner increases the iteration count until
+ * the run takes long enough to give a stable result.
+ */
+class BenchmarkState {
+public:
+	explicit BenchmarkState(u64 iterations);
+
+	u64 iterations() const;
+
+	/**
+	 * Excludes the time between pauseTiming() and resumeTiming() from the measurement.
+	 */
+	void pauseTiming();
+	void resumeTiming();
+
+	/**
+	 * Sets the number of processed items (lines, tasks, messages) to report items/s.
+	 */
+	void setItemsProcessed(u64 count);
+
+	/**
+	 * Sets the number of processed bytes to report MB/s.
+	 */
+	void setBytesProcessed(u64 count);
+
+	/**
+	 * Adds a named value to the benchmark report (e.g. a latency percentile).
+	 */
+	void setCounter(const char* name, double value);
+
+	double elapsedNanoseconds() const;
+	u64 itemsProcessed() const;
+	u64 bytesProcessed() const;
+	const std::vector<Pair<const char*, double>>& counters() const;
+
+	void start();
+	void stop();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	u64 iterations_;
+	u64 items_;
+	u64 bytes_;
+	Clock::time_point started_;
+	Clock::duration elapsed_;
+	bool isRunning_;
+	std::vector<Pair<const char*, double>> counters_;
+};
+
+
+using BenchmarkProc = void(*)(BenchmarkState& state);
+
+
+int registerBenchmark(const char* name, BenchmarkProc proc);
+
+
+/**
+ * Prevents the compiler from optimizing away computation of @p value.
+ */
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+/**
+ * Returns the monotonic time in nanoseconds, suitable for per-operation latency
+ * measurements.
+ */
+inline u64 nanoseconds()
+{
+	using namespace std::chrono;
+	return duration_cast<std::chrono::nanoseconds>(
+			steady_clock::now().time_since_epoch()).count();
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_BENCH_BENCHMARK_H
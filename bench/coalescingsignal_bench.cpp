@@ -0,0 +1,94 @@
+#include <utility>
+#include <vector>
+#include <tech/coalescingsignal.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const size_t kChainLength = 8;
+static const u64 kMovesPerFrame = 64;
+
+
+// Widget which lays itself out from the value of the previous widget in the chain and
+// notifies the next one
+template<typename S>
+class Stage : public Trackable {
+public:
+	template<typename ...Args>
+	explicit Stage(Args&&... args) :
+		changed(std::forward<Args>(args)...)
+	{
+	}
+
+	void update(int value)
+	{
+		int layout = value;
+		for(int i = 0; i < 32; ++i)
+			layout = layout * 31 + i;
+
+		doNotOptimize(layout);
+		++updates;
+		changed(value + 1);
+	}
+
+	u64 updates = 0;
+	S changed;
+};
+
+
+// Every iteration moves the slider, the event loop iteration ends after kMovesPerFrame
+// moves and runs the queued tasks
+template<typename S, typename ...Args>
+void driveChain(BenchmarkState& state, TaskQueue* queue, const Args&... args)
+{
+	S slider(args...);
+	std::vector<Box<Stage<S>>> stages;
+
+	for(size_t i = 0; i < kChainLength; ++i) {
+		stages.emplace_back(new Stage<S>(args...));
+		S& source = i == 0 ? slider : stages[i - 1]->changed;
+		source.connect(stages.back().get(), &Stage<S>::update);
+	}
+
+	u64 frames = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		slider(static_cast<int>(i));
+
+		if((i + 1) % kMovesPerFrame == 0 || i + 1 == state.iterations()) {
+			while(!queue->isEmpty())
+				queue->processTasks();
+
+			++frames;
+		}
+	}
+
+	u64 updates = 0;
+	for(auto& stage : stages)
+		updates += stage->updates;
+
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("updatesPerFrame", static_cast<double>(updates) / frames);
+}
+
+
+} // namespace
+
+
+BENCHMARK(SliderChainImmediate)
+{
+	TaskQueue queue;
+	driveChain<Signal<void(int)>>(state, &queue);
+}
+
+
+BENCHMARK(SliderChainCoalescing)
+{
+	TaskQueue queue;
+	driveChain<CoalescingSignal<void(int)>>(state, &queue, &queue);
+}
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <tech/concurrentsignal.h>
+#include <tech/signal.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Receiver {
+public:
+	void slot(int value)
+	{
+		sum_ += value;
+		doNotOptimize(sum_);
+	}
+
+private:
+	int sum_ = 0;
+};
+
+
+void emitSignal(BenchmarkState& state, size_t slotCount)
+{
+	Signal<void(int)> signal;
+	std::vector<Receiver> receivers(slotCount);
+
+	for(auto& receiver : receivers)
+		signal.connect(&receiver, &Receiver::slot);
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		signal(1);
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Emission while another thread keeps connecting and disconnecting a slot, which
+// replaces the snapshot every time
+void emitConcurrentSignal(BenchmarkState& state, size_t slotCount, bool hasWriter)
+{
+	ConcurrentSignal<void(int)> signal;
+	std::vector<Receiver> receivers(slotCount);
+	Receiver extra;
+	std::atomic<bool> isDone(false);
+	std::atomic<u64> changeCount(0);
+
+	for(auto& receiver : receivers)
+		signal.connect(&receiver, &Receiver::slot);
+
+	std::thread writer;
+
+	if(hasWriter) {
+		writer = std::thread([&]() {
+			while(!isDone.load(std::memory_order_relaxed)) {
+				signal.connect(&extra, &Receiver::slot);
+				signal.disconnect(&extra, &Receiver::slot);
+				changeCount.fetch_add(2, std::memory_order_relaxed);
+				std::this_thread::yield();
+			}
+		});
+	}
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		signal(1);
+
+	state.pauseTiming();
+	isDone.store(true);
+
+	if(writer.joinable())
+		writer.join();
+
+	state.setItemsProcessed(state.iterations());
+
+	if(hasWriter)
+		state.setCounter("changes", changeCount.load());
+}
+
+
+} // namespace
+
+
+BENCHMARK(SignalEmit1)
+{
+	emitSignal(state, 1);
+}
+
+
+BENCHMARK(SignalEmit8)
+{
+	emitSignal(state, 8);
+}
+
+
+BENCHMARK(SignalEmit64)
+{
+	emitSignal(state, 64);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit1)
+{
+	emitConcurrentSignal(state, 1, false);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit8)
+{
+	emitConcurrentSignal(state, 8, false);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit64)
+{
+	emitConcurrentSignal(state, 64, false);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit1WithConnects)
+{
+	emitConcurrentSignal(state, 1, true);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit8WithConnects)
+{
+	emitConcurrentSignal(state, 8, true);
+}
+
+
+BENCHMARK(ConcurrentSignalEmit64WithConnects)
+{
+	emitConcurrentSignal(state, 64, true);
+}
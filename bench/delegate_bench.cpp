@@ -0,0 +1,203 @@
+#include <functional>
+#include <vector>
+#include <tech/delegate.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+int globalSum = 0;
+
+
+void addGlobal(int value)
+{
+	globalSum += value;
+}
+
+
+class Accumulator {
+public:
+	void add(int value)
+	{
+		sum_ += value;
+	}
+
+	int sum() const
+	{
+		return sum_;
+	}
+
+private:
+	int sum_ = 0;
+};
+
+
+// Baseline: the interface a class would implement instead of exposing a callback
+class Listener {
+public:
+	virtual ~Listener() = default;
+	virtual void add(int value) = 0;
+};
+
+
+class AccumulatorListener : public Listener {
+public:
+	explicit AccumulatorListener(Accumulator* accumulator) :
+		accumulator_(accumulator)
+	{
+	}
+
+	void add(int value) override
+	{
+		accumulator_->add(value);
+	}
+
+private:
+	Accumulator* accumulator_;
+};
+
+
+class VirtualCallback {
+public:
+	explicit VirtualCallback(Listener* listener) :
+		listener_(listener)
+	{
+	}
+
+	void operator()(int value) const
+	{
+		listener_->add(value);
+	}
+
+private:
+	Listener* listener_;
+};
+
+
+// Calls every callback of the array, which keeps the call indirect
+template<typename F>
+void callArray(BenchmarkState& state, std::vector<F>& callbacks)
+{
+	size_t count = callbacks.size();
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		callbacks[i % count](1);
+		doNotOptimize(callbacks);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+} // namespace
+
+
+BENCHMARK(DelegateCallFunction)
+{
+	std::vector<Delegate<void(int)>> callbacks(4, Delegate<void(int)>(&addGlobal));
+
+	callArray(state, callbacks);
+	doNotOptimize(globalSum);
+}
+
+
+BENCHMARK(DelegateCallMember)
+{
+	Accumulator accumulator;
+	std::vector<Delegate<void(int)>> callbacks(4,
+			Delegate<void(int)>(&accumulator, &Accumulator::add));
+
+	callArray(state, callbacks);
+	doNotOptimize(accumulator.sum());
+}
+
+
+BENCHMARK(DelegateCallLambda)
+{
+	Accumulator accumulator;
+	int scale = 1;
+	std::vector<Delegate<void(int)>> callbacks(4,
+			Delegate<void(int)>([&accumulator, scale](int value) {
+				accumulator.add(value * scale);
+			}));
+
+	callArray(state, callbacks);
+	doNotOptimize(accumulator.sum());
+}
+
+
+BENCHMARK(StdFunctionCallMember)
+{
+	Accumulator accumulator;
+	std::vector<std::function<void(int)>> callbacks(4,
+			std::bind(&Accumulator::add, &accumulator, std::placeholders::_1));
+
+	callArray(state, callbacks);
+	doNotOptimize(accumulator.sum());
+}
+
+
+BENCHMARK(StdFunctionCallLambda)
+{
+	Accumulator accumulator;
+	int scale = 1;
+	std::vector<std::function<void(int)>> callbacks(4,
+			[&accumulator, scale](int value) {
+				accumulator.add(value * scale);
+			});
+
+	callArray(state, callbacks);
+	doNotOptimize(accumulator.sum());
+}
+
+
+BENCHMARK(VirtualCall)
+{
+	Accumulator accumulator;
+	AccumulatorListener listener(&accumulator);
+	std::vector<VirtualCallback> callbacks(4, VirtualCallback(&listener));
+
+	callArray(state, callbacks);
+	doNotOptimize(accumulator.sum());
+}
+
+
+// Construction and destruction of a callback with a three pointer capture
+BENCHMARK(DelegateCreateLambda)
+{
+	Accumulator accumulator;
+	int* first = nullptr;
+	int* second = nullptr;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		Delegate<void(int)> delegate([&accumulator, first, second](int value) {
+			accumulator.add(value + (first == second));
+		});
+
+		doNotOptimize(delegate);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(StdFunctionCreateLambda)
+{
+	Accumulator accumulator;
+	int* first = nullptr;
+	int* second = nullptr;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		std::function<void(int)> function([&accumulator, first, second](int value) {
+			accumulator.add(value + (first == second));
+		});
+
+		doNotOptimize(function);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
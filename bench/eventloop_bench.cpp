@@ -0,0 +1,82 @@
+#include <vector>
+#include <tech/platform.h>
+#include "benchmark.h"
+
+#ifdef PLATFORM_LINUX
+#include <unistd.h>
+#include <tech/eventloop.h>
+#include <tech/utils.h>
+#endif
+
+
+#ifdef PLATFORM_LINUX
+
+using namespace Tech;
+
+
+// Every iteration dispatches one event of 64 pipes which stay readable, a busy X
+// connection and many sockets look the same to the loop
+BENCHMARK(EventLoopReadyPipes64)
+{
+	static const int kPipeCount = 64;
+
+	EventLoop loop;
+	std::vector<int> fds;
+	u64 sum = 0;
+
+	auto onRead = [&sum](int fd, IoEvents events) {
+		UNUSED(events);
+		sum += static_cast<u64>(fd);
+	};
+
+	for(int i = 0; i < kPipeCount; ++i) {
+		int pair[2];
+		if(pipe(pair) != 0)
+			break;
+
+		ssize_t result = write(pair[1], "x", 1);
+		UNUSED(result);
+
+		loop.watch(pair[0], IoEvent::kRead, EventLoop::IoHandler(onRead));
+		fds.push_back(pair[0]);
+		fds.push_back(pair[1]);
+	}
+
+	u64 handled = 0;
+	while(handled < state.iterations())
+		handled += loop.processEvents(Duration());
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(handled);
+	state.setCounter("events/wait", static_cast<double>(loop.statistics().ioEvents) /
+			static_cast<double>(loop.statistics().iterations));
+
+	for(size_t i = 0; i < fds.size(); ++i) {
+		if(i % 2 == 0)
+			loop.unwatch(fds[i]);
+
+		close(fds[i]);
+	}
+}
+
+
+// Every iteration is a task posted to the loop and run by it, in bursts of 256 which the
+// loop drains with one wakeup
+BENCHMARK(EventLoopPostedTasks)
+{
+	EventLoop loop;
+	u64 sum = 0;
+	u64 handled = 0;
+
+	while(handled < state.iterations()) {
+		for(int i = 0; i < 256; ++i)
+			loop.taskQueue()->post(Delegate<void()>([&sum]() { ++sum; }));
+
+		handled += loop.processEvents(Duration());
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(handled);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include <vector>
+#include <tech/platform.h>
+#include "benchmark.h"
+
+#ifdef PLATFORM_LINUX
+#include <sys/stat.h>
+#include <tech/fileio.h>
+#endif
+
+
+#ifdef PLATFORM_LINUX
+
+using namespace Tech;
+
+
+namespace {
+
+
+// Every iteration is a status request completed on the loop, 256 requests are in flight
+void runStatusRequests(BenchmarkState& state, FileIo::Backend backend)
+{
+	EventLoop loop;
+	FileIo io(&loop, ThreadPool::shared(), backend);
+	u64 completed = 0;
+	u64 size = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		io.status("/proc/self/exe").then([&completed, &size](FileStatus&& status) {
+			size += status.size;
+			++completed;
+		});
+
+		while(io.pendingCount() >= 256)
+			loop.processEvents();
+	}
+
+	while(io.pendingCount() != 0)
+		loop.processEvents();
+
+	doNotOptimize(size);
+	state.setItemsProcessed(completed);
+}
+
+
+} // namespace
+
+
+BENCHMARK(FileIoStatusUring)
+{
+	runStatusRequests(state, FileIo::Backend::kUring);
+}
+
+
+BENCHMARK(FileIoStatusThreadPool)
+{
+	runStatusRequests(state, FileIo::Backend::kThreadPool);
+}
+
+
+// Baseline: the blocking call on the loop thread
+BENCHMARK(FileIoStatusBlocking)
+{
+	u64 size = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		struct stat status;
+		if(::stat("/proc/self/exe", &status) == 0)
+			size += static_cast<u64>(status.st_size);
+	}
+
+	doNotOptimize(size);
+	state.setItemsProcessed(state.iterations());
+}
+
+#endif
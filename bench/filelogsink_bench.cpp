@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <unistd.h>
+#include <tech/asynclogger.h>
+#include <tech/filelogsink.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+const char kLogPath[] = "/tmp/tech-filelogsink-bench.log";
+
+
+// A typical hand-written handler: one fprintf() per line and fflush() to keep the file
+// up to date
+class FprintfSink {
+public:
+	FprintfSink() :
+		file_(std::fopen(kLogPath, "a"))
+	{
+	}
+
+	~FprintfSink()
+	{
+		std::fclose(file_);
+	}
+
+	void write(LogLevel level, const String& file, int line, const String& message)
+	{
+		std::fprintf(file_, "[%s] %s:%d: %s\n", logLevelName(level),
+				file.toUtf8().constData(), line, message.toUtf8().constData());
+		std::fflush(file_);
+	}
+
+private:
+	FILE* file_;
+};
+
+
+void runSink(BenchmarkState& state, const LogMessageHandler& handler,
+		const Delegate<void()>& flush)
+{
+	String file = "render.cpp";
+	String message = "frame 1024 rendered in 16 ms, 2 layers, 3 widgets updated";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		handler(LogLevel::kInfo, file, 42, message);
+
+	if(!flush.isNull())
+		flush();
+}
+
+
+void reportFileSize(BenchmarkState& state)
+{
+	state.stop();
+
+	FILE* file = std::fopen(kLogPath, "r");
+
+	if(file) {
+		std::fseek(file, 0, SEEK_END);
+		state.setBytesProcessed(std::ftell(file));
+		std::fclose(file);
+	}
+
+	state.setItemsProcessed(state.iterations());
+	::unlink(kLogPath);
+}
+
+
+void runAsync(BenchmarkState& state, FileLogSink::SyncPolicy policy)
+{
+	{
+		FileLogSink sink(kLogPath);
+		sink.setSyncPolicy(policy);
+
+		AsyncLogger logger(LogMessageHandler(&sink, &FileLogSink::write),
+				AsyncLogger::kDefaultCapacity, AsyncLogger::OverflowPolicy::kBlock,
+				Delegate<void()>(&sink, &FileLogSink::flush));
+
+		String file = "render.cpp";
+		String message = "frame 1024 rendered in 16 ms, 2 layers, 3 widgets updated";
+
+		for(u64 i = 0; i < state.iterations(); ++i)
+			logger.post(LogLevel::kInfo, file, 42, message);
+
+		logger.flush();
+	}
+
+	reportFileSize(state);
+}
+
+
+} // namespace
+
+
+BENCHMARK(FileLogFprintf)
+{
+	{
+		FprintfSink sink;
+		runSink(state, LogMessageHandler(&sink, &FprintfSink::write), Delegate<void()>());
+	}
+
+	reportFileSize(state);
+}
+
+
+BENCHMARK(FileLogSinkDirect)
+{
+	{
+		FileLogSink sink(kLogPath);
+		runSink(state, LogMessageHandler(&sink, &FileLogSink::write),
+				Delegate<void()>(&sink, &FileLogSink::flush));
+	}
+
+	reportFileSize(state);
+}
+
+
+BENCHMARK(FileLogSinkAsync)
+{
+	runAsync(state, FileLogSink::SyncPolicy::kNever);
+}
+
+
+BENCHMARK(FileLogSinkAsyncPeriodicSync)
+{
+	runAsync(state, FileLogSink::SyncPolicy::kPeriodic);
+}
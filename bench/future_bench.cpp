@@ -0,0 +1,85 @@
+#include <thread>
+#include <tech/future.h>
+#include <tech/semaphore.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const u64 kChainLength = 64;
+
+
+} // namespace
+
+
+// Promise, continuation and result on one thread: two shared states and a callback
+BENCHMARK(FutureThenInline)
+{
+	u64 sum = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		Promise<u64> promise;
+		Future<u64> result = promise.future().then([](u64&& value) { return value + 1; });
+		promise.setValue(i);
+		sum += result.get();
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Every iteration is a continuation which runs on the pool after the previous one
+BENCHMARK(FutureChainThreadPool)
+{
+	ThreadPool pool(1);
+	u64 remaining = state.iterations();
+	u64 sum = 0;
+
+	while(remaining) {
+		u64 count = remaining < kChainLength ? remaining : kChainLength;
+		Promise<u64> promise;
+		Future<u64> result = promise.future();
+
+		for(u64 i = 0; i < count; ++i)
+			result = result.then(&pool, [](u64&& value) { return value + 1; });
+
+		promise.setValue(sum);
+		sum = result.get();
+		remaining -= count;
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Baseline: every step is handed over to a thread blocked on a semaphore and back
+BENCHMARK(SemaphoreHandoff)
+{
+	Semaphore request;
+	Semaphore response;
+	u64 value = 0;
+	u64 count = state.iterations();
+
+	std::thread worker([&request, &response, &value, count]() {
+		for(u64 i = 0; i < count; ++i) {
+			request.wait();
+			++value;
+			response.post();
+		}
+	});
+
+	for(u64 i = 0; i < count; ++i) {
+		request.post();
+		response.wait();
+	}
+
+	worker.join();
+	doNotOptimize(value);
+	state.setItemsProcessed(state.iterations());
+}
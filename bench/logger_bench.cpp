@@ -0,0 +1,109 @@
+#include <tech/logger.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+void nullHandler(LogLevel level, const String& file, int line, const String& message)
+{
+	doNotOptimize(level);
+	doNotOptimize(file);
+	doNotOptimize(line);
+	doNotOptimize(message);
+}
+
+
+// Installs the handler for the duration of a benchmark
+class HandlerScope {
+public:
+	explicit HandlerScope(const LogMessageHandler& handler)
+	{
+		setLogMessageHandler(handler);
+	}
+
+	~HandlerScope()
+	{
+		setLogMessageHandler(LogMessageHandler());
+		resetLogLevels();
+	}
+};
+
+
+} // namespace
+
+
+// Cost of a disabled message before levels were introduced: the arguments are formatted
+// and then discarded because there is no handler
+BENCHMARK(LogFormatWithoutHandler)
+{
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		logMessage(LogLevel::kDebug, "render.cpp", 42, "frame {} of {}", i, name);
+}
+
+
+BENCHMARK(LogDisabledWithoutHandler)
+{
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG_DEBUG("frame {} of {}", i, name);
+}
+
+
+BENCHMARK(LogDisabledBelowThreshold)
+{
+	HandlerScope scope{LogMessageHandler(&nullHandler)};
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG_DEBUG("frame {} of {}", i, name);
+}
+
+
+BENCHMARK(LogDisabledByFileThreshold)
+{
+	HandlerScope scope{LogMessageHandler(&nullHandler)};
+	setFileLogLevel("logger_bench.cpp", LogLevel::kOff);
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG_ERROR("frame {} of {}", i, name);
+}
+
+
+BENCHMARK(LogFieldsDisabledBelowThreshold)
+{
+	HandlerScope scope{LogMessageHandler(&nullHandler)};
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG_KV_AT(LogLevel::kDebug, "frame rendered", "frame", i, "window", name);
+}
+
+
+BENCHMARK(LogEnabled)
+{
+	HandlerScope scope{LogMessageHandler(&nullHandler)};
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG("frame {} of {}", i, name);
+}
+
+
+BENCHMARK(LogEvery1000)
+{
+	HandlerScope scope{LogMessageHandler(&nullHandler)};
+	String name = "main window";
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		LOG_EVERY_N(LogLevel::kInfo, 1000, "frame {} of {}", i, name);
+
+	state.setItemsProcessed(state.iterations() / 1000);
+}
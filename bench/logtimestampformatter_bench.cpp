@@ -0,0 +1,72 @@
+#include <ctime>
+#include <tech/calendartime.h>
+#include <tech/format.h>
+#include <tech/logtimestampformatter.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+// The way a log handler renders the time with the library types
+BENCHMARK(TimestampCalendarTime)
+{
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		CalendarTime time(Duration::fromEpoch());
+		doNotOptimize(Formatter::format("{}-{:0>2}-{:0>2} {:0>2}:{:0>2}:{:0>2}.{:0>3}",
+				time.year(), time.month(), time.monthDay(), time.hour(), time.minute(),
+				time.second(), time.msecond()));
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(TimestampLocaltimeSnprintf)
+{
+	// Enough for any values of the fields
+	char buffer[96];
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		timespec time;
+		clock_gettime(CLOCK_REALTIME, &time);
+
+		tm local;
+		localtime_r(&time.tv_sec, &local);
+
+		std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+				local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour,
+				local.tm_min, local.tm_sec, static_cast<int>(time.tv_nsec / 1000000));
+		doNotOptimize(buffer);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(TimestampFormatterPrecise)
+{
+	LogTimestampFormatter formatter;
+	char buffer[LogTimestampFormatter::kLength];
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		formatter.format(buffer);
+		doNotOptimize(buffer);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(TimestampFormatterCoarse)
+{
+	LogTimestampFormatter formatter(LogTimestampFormatter::Clock::kCoarse);
+	char buffer[LogTimestampFormatter::kLength];
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		formatter.format(buffer);
+		doNotOptimize(buffer);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
@@ -0,0 +1,48 @@
+#include <unistd.h>
+#include <tech/mappedlogsink.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+BENCHMARK(MappedLogSinkWrite)
+{
+	const char* path = "/tmp/tech-mappedlogsink-bench.log";
+
+	{
+		MappedLogSink sink(path);
+		String file = "render.cpp";
+		String message = "frame 1024 rendered in 16 ms, 2 layers, 3 widgets updated";
+
+		for(u64 i = 0; i < state.iterations(); ++i)
+			sink.write(LogLevel::kInfo, file, 42, message);
+
+		state.setItemsProcessed(state.iterations());
+		state.setBytesProcessed(state.iterations() * (file.length() + message.length()));
+	}
+
+	::unlink(path);
+}
+
+
+BENCHMARK(MappedLogReaderLast1000)
+{
+	const char* path = "/tmp/tech-mappedlogsink-bench.log";
+
+	state.pauseTiming();
+
+	{
+		MappedLogSink sink(path);
+
+		for(int i = 0; i < 100000; ++i)
+			sink.write(LogLevel::kInfo, "render.cpp", i, "frame rendered");
+	}
+
+	state.resumeTiming();
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		doNotOptimize(MappedLogReader(path).lastRecords(1000));
+
+	::unlink(path);
+}
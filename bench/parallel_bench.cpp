@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <tech/parallel.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const size_t kSortSize = 200000;
+static const size_t kReduceSize = 4 * 1024 * 1024;
+static const size_t kLineCount = 1000000;
+
+
+// Keys of 16 to 32 bytes with a short common prefix, like log categories or paths
+const ByteArrayList& sortInput()
+{
+	static ByteArrayList list;
+
+	if(list.empty()) {
+		std::mt19937 random(1);
+
+		for(size_t i = 0; i < kSortSize; ++i) {
+			ByteArray key("key/");
+			size_t length = 12 + random() % 17;
+
+			for(size_t j = 0; j < length; ++j)
+				key.append(static_cast<char>('a' + random() % 26));
+
+			list.push_back(key);
+		}
+	}
+
+	return list;
+}
+
+
+// Keys of sortInput() repeated ten times on average, like the words of a text
+const ByteArrayList& duplicateInput()
+{
+	static ByteArrayList list;
+
+	if(list.empty()) {
+		const ByteArrayList& keys = sortInput();
+		std::mt19937 random(3);
+
+		for(size_t i = 0; i < kSortSize; ++i)
+			list.push_back(keys[random() % (kSortSize / 10)]);
+	}
+
+	return list;
+}
+
+
+// Lines of "<id> <value>" as in a text log or CSV
+const ByteArray& lineInput()
+{
+	static ByteArray buffer;
+
+	if(buffer.isEmpty()) {
+		std::mt19937 random(2);
+
+		for(size_t i = 0; i < kLineCount; ++i) {
+			buffer.append(std::to_string(i).c_str());
+			buffer.append(' ');
+			buffer.append(std::to_string(random() % 100000).c_str());
+			buffer.append('\n');
+		}
+	}
+
+	return buffer;
+}
+
+
+// Every iteration sorts a copy of the list, std::sort is the baseline
+void runSort(BenchmarkState& state, size_t threadCount)
+{
+	ThreadPool pool(threadCount);
+	const ByteArrayList& input = sortInput();
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		state.pauseTiming();
+		ByteArrayList list = input;
+		state.resumeTiming();
+
+		if(threadCount)
+			parallelSort(&pool, &list);
+		else
+			std::sort(list.begin(), list.end());
+
+		doNotOptimize(list.front());
+	}
+
+	state.setItemsProcessed(state.iterations() * kSortSize);
+	state.setCounter("threads", static_cast<double>(threadCount));
+}
+
+
+// Every iteration sorts and deduplicates a copy of the list, std::sort and std::unique
+// are the baseline
+void runSortUnique(BenchmarkState& state, size_t threadCount)
+{
+	ThreadPool pool(threadCount);
+	const ByteArrayList& input = duplicateInput();
+	size_t uniqueCount = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		state.pauseTiming();
+		ByteArrayList list = input;
+		state.resumeTiming();
+
+		if(threadCount) {
+			parallelSortUnique(&pool, &list);
+		}
+		else {
+			std::sort(list.begin(), list.end());
+			list.erase(std::unique(list.begin(), list.end()), list.end());
+		}
+
+		uniqueCount = list.size();
+		doNotOptimize(list.front());
+	}
+
+	state.setItemsProcessed(state.iterations() * kSortSize);
+	state.setCounter("threads", static_cast<double>(threadCount));
+	state.setCounter("unique", static_cast<double>(uniqueCount));
+}
+
+
+// Every iteration sums a vector of 32 MB, std::accumulate is the baseline
+void runReduce(BenchmarkState& state, size_t threadCount)
+{
+	ThreadPool pool(threadCount);
+	std::vector<u64> values(kReduceSize);
+
+	for(size_t i = 0; i < values.size(); ++i)
+		values[i] = i * 2654435761u;
+
+	u64 sum = 0;
+	auto reduce = [](u64 a, u64 b) { return a + (b ^ (b >> 7)); };
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		if(threadCount)
+			sum += parallelReduce(&pool, values.begin(), values.end(), u64(0), reduce);
+		else
+			sum += std::accumulate(values.begin(), values.end(), u64(0), reduce);
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * kReduceSize);
+	state.setCounter("threads", static_cast<double>(threadCount));
+}
+
+
+// Every iteration parses the numbers of a buffer of lines and sums them. The baseline is
+// a serial memchr() loop
+void runLines(BenchmarkState& state, size_t threadCount)
+{
+	ThreadPool pool(threadCount);
+	const ByteArray& buffer = lineInput();
+	std::atomic<u64> sum(0);
+
+	auto parseLine = [&sum](const char* data, size_t size) {
+		const char* value = static_cast<const char*>(std::memchr(data, ' ', size)) + 1;
+		u64 number = 0;
+
+		for(; value != data + size; ++value)
+			number = number * 10 + static_cast<u64>(*value - '0');
+
+		sum.fetch_add(number, std::memory_order_relaxed);
+	};
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		if(threadCount) {
+			parallelForEachRecord(&pool, buffer, '\n', parseLine);
+			continue;
+		}
+
+		const char* begin = buffer.constData();
+		const char* end = begin + buffer.length();
+
+		while(begin != end) {
+			const char* line = static_cast<const char*>(std::memchr(begin, '\n',
+					static_cast<size_t>(end - begin)));
+			parseLine(begin, static_cast<size_t>(line - begin));
+			begin = line + 1;
+		}
+	}
+
+	doNotOptimize(sum.load());
+	state.setItemsProcessed(state.iterations() * kLineCount);
+	state.setCounter("threads", static_cast<double>(threadCount));
+}
+
+
+} // namespace
+
+
+BENCHMARK(ByteArrayListStdSort)
+{
+	runSort(state, 0);
+}
+
+
+BENCHMARK(ByteArrayListParallelSort1)
+{
+	runSort(state, 1);
+}
+
+
+BENCHMARK(ByteArrayListParallelSort2)
+{
+	runSort(state, 2);
+}
+
+
+BENCHMARK(ByteArrayListParallelSort4)
+{
+	runSort(state, 4);
+}
+
+
+BENCHMARK(ByteArrayListParallelSortAllCores)
+{
+	runSort(state, ThreadPool::defaultThreadCount());
+}
+
+
+BENCHMARK(ByteArrayListStdSortUnique)
+{
+	runSortUnique(state, 0);
+}
+
+
+BENCHMARK(ByteArrayListParallelSortUnique1)
+{
+	runSortUnique(state, 1);
+}
+
+
+BENCHMARK(ByteArrayListParallelSortUniqueAllCores)
+{
+	runSortUnique(state, ThreadPool::defaultThreadCount());
+}
+
+
+BENCHMARK(ReduceSerial)
+{
+	runReduce(state, 0);
+}
+
+
+BENCHMARK(ReduceAllCores)
+{
+	runReduce(state, ThreadPool::defaultThreadCount());
+}
+
+
+BENCHMARK(SplitLinesSerial)
+{
+	runLines(state, 0);
+}
+
+
+BENCHMARK(SplitLinesParallel1)
+{
+	runLines(state, 1);
+}
+
+
+BENCHMARK(SplitLinesParallelAllCores)
+{
+	runLines(state, ThreadPool::defaultThreadCount());
+}
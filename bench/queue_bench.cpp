@@ -0,0 +1,258 @@
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <tech/blockingqueue.h>
+#include <tech/mpmcqueue.h>
+#include <tech/spscqueue.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const size_t kCapacity = 1024;
+static const size_t kBatchSize = 32;
+
+
+// Baseline: the hand-off used before the lock-free queues
+class MutexDeque {
+public:
+	bool tryPush(u64 value)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(deque_.size() == kCapacity)
+			return false;
+
+		deque_.push_back(value);
+		return true;
+	}
+
+	bool tryPop(u64* value)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(deque_.empty())
+			return false;
+
+		*value = deque_.front();
+		deque_.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex mutex_;
+	std::deque<u64> deque_;
+};
+
+
+// Baseline for BlockingQueue
+class ConditionDeque {
+public:
+	void push(u64 value)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		notFull_.wait(lock, [this]() { return deque_.size() < kCapacity; });
+		deque_.push_back(value);
+		notEmpty_.notify_one();
+	}
+
+	void pop(u64* value)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		notEmpty_.wait(lock, [this]() { return !deque_.empty(); });
+		*value = deque_.front();
+		deque_.pop_front();
+		notFull_.notify_one();
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable notEmpty_;
+	std::condition_variable notFull_;
+	std::deque<u64> deque_;
+};
+
+
+// Every iteration is a value passed from one of @p threadCount producers to one of
+// @p threadCount consumers. Threads spin with yield() when the queue is full or empty.
+template<typename Queue>
+void runTryThroughput(BenchmarkState& state, Queue* queue, size_t threadCount)
+{
+	u64 countPerThread = state.iterations() / threadCount;
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([queue, countPerThread]() {
+			for(u64 j = 0; j < countPerThread; ++j) {
+				while(!queue->tryPush(j))
+					std::this_thread::yield();
+			}
+		});
+
+		threads.emplace_back([queue, countPerThread]() {
+			u64 value = 0;
+			u64 sum = 0;
+
+			for(u64 j = 0; j < countPerThread; ++j) {
+				while(!queue->tryPop(&value))
+					std::this_thread::yield();
+
+				sum += value;
+			}
+
+			doNotOptimize(sum);
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	state.setItemsProcessed(countPerThread * threadCount);
+	state.setCounter("threads", static_cast<double>(threadCount * 2));
+}
+
+
+// Same with blocking push() and pop()
+template<typename Queue>
+void runBlockingThroughput(BenchmarkState& state, Queue* queue, size_t threadCount)
+{
+	u64 countPerThread = state.iterations() / threadCount;
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([queue, countPerThread]() {
+			for(u64 j = 0; j < countPerThread; ++j)
+				queue->push(j);
+		});
+
+		threads.emplace_back([queue, countPerThread]() {
+			u64 value = 0;
+			u64 sum = 0;
+
+			for(u64 j = 0; j < countPerThread; ++j) {
+				queue->pop(&value);
+				sum += value;
+			}
+
+			doNotOptimize(sum);
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	state.setItemsProcessed(countPerThread * threadCount);
+	state.setCounter("threads", static_cast<double>(threadCount * 2));
+}
+
+
+} // namespace
+
+
+BENCHMARK(SpscQueueThroughput)
+{
+	SpscQueue<u64> queue(kCapacity);
+	runTryThroughput(state, &queue, 1);
+}
+
+
+// The consumer drains and the producer fills kBatchSize values per publication
+BENCHMARK(SpscQueueBatchThroughput)
+{
+	SpscQueue<u64> queue(kCapacity);
+	u64 count = state.iterations();
+
+	std::thread consumer([&queue, count]() {
+		u64 values[kBatchSize];
+		u64 sum = 0;
+
+		for(u64 received = 0; received < count;) {
+			size_t batch = queue.popBatch(values, kBatchSize);
+			if(!batch)
+				std::this_thread::yield();
+
+			for(size_t i = 0; i < batch; ++i)
+				sum += values[i];
+
+			received += batch;
+		}
+
+		doNotOptimize(sum);
+	});
+
+	u64 values[kBatchSize];
+	for(size_t i = 0; i < kBatchSize; ++i)
+		values[i] = i;
+
+	for(u64 sent = 0; sent < count;) {
+		u64 wanted = count - sent < kBatchSize ? count - sent : kBatchSize;
+		size_t batch = queue.pushBatch(values, wanted);
+		if(!batch)
+			std::this_thread::yield();
+
+		sent += batch;
+	}
+
+	consumer.join();
+	state.setItemsProcessed(count);
+}
+
+
+BENCHMARK(MpmcQueueThroughput1)
+{
+	MpmcQueue<u64> queue(kCapacity);
+	runTryThroughput(state, &queue, 1);
+}
+
+
+BENCHMARK(MpmcQueueThroughput2)
+{
+	MpmcQueue<u64> queue(kCapacity);
+	runTryThroughput(state, &queue, 2);
+}
+
+
+BENCHMARK(MpmcQueueThroughput4)
+{
+	MpmcQueue<u64> queue(kCapacity);
+	runTryThroughput(state, &queue, 4);
+}
+
+
+BENCHMARK(MutexDequeThroughput1)
+{
+	MutexDeque queue;
+	runTryThroughput(state, &queue, 1);
+}
+
+
+BENCHMARK(MutexDequeThroughput2)
+{
+	MutexDeque queue;
+	runTryThroughput(state, &queue, 2);
+}
+
+
+BENCHMARK(MutexDequeThroughput4)
+{
+	MutexDeque queue;
+	runTryThroughput(state, &queue, 4);
+}
+
+
+BENCHMARK(BlockingMpmcQueueThroughput2)
+{
+	BlockingQueue<MpmcQueue<u64>> queue(kCapacity);
+	runBlockingThroughput(state, &queue, 2);
+}
+
+
+BENCHMARK(ConditionDequeThroughput2)
+{
+	ConditionDeque queue;
+	runBlockingThroughput(state, &queue, 2);
+}
@@ -0,0 +1,78 @@
+#include <thread>
+#include <tech/lightweightsemaphore.h>
+#include <tech/semaphore.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+// Every iteration is a round trip: the thread posts to the partner and waits for the
+// answer
+template<typename S>
+void runPingPong(BenchmarkState& state)
+{
+	S ping;
+	S pong;
+	u64 count = state.iterations();
+
+	std::thread partner([&ping, &pong, count]() {
+		for(u64 i = 0; i < count; ++i) {
+			ping.wait();
+			pong.post();
+		}
+	});
+
+	for(u64 i = 0; i < count; ++i) {
+		ping.post();
+		pong.wait();
+	}
+
+	partner.join();
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Posts without waiters: the cost of a wakeup when the consumer is busy
+template<typename S>
+void runPostWait(BenchmarkState& state)
+{
+	S semaphore;
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		semaphore.post();
+		semaphore.wait();
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+} // namespace
+
+
+BENCHMARK(SemaphorePingPong)
+{
+	runPingPong<Semaphore>(state);
+}
+
+
+BENCHMARK(LightweightSemaphorePingPong)
+{
+	runPingPong<LightweightSemaphore>(state);
+}
+
+
+BENCHMARK(SemaphorePostWait)
+{
+	runPostWait<Semaphore>(state);
+}
+
+
+BENCHMARK(LightweightSemaphorePostWait)
+{
+	runPostWait<LightweightSemaphore>(state);
+}
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <tech/signal.h>
+#include "benchmark.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const size_t kReceiverCount = 4096;
+static const size_t kEmitSlotCount = 8;
+static const size_t kChurnSlotCount = 64;
+
+
+class Receiver : public Trackable {
+public:
+	void slot(int value)
+	{
+		sum_ += value;
+		doNotOptimize(sum_);
+	}
+
+private:
+	int sum_ = 0;
+};
+
+
+class PlainReceiver {
+public:
+	void slot(int value)
+	{
+		sum_ += value;
+		doNotOptimize(sum_);
+	}
+
+private:
+	int sum_ = 0;
+};
+
+
+// Baseline for emission: observers implementing an interface
+class Observer {
+public:
+	virtual ~Observer() = default;
+	virtual void notify(int value) = 0;
+};
+
+
+class ObserverReceiver : public Observer {
+public:
+	void notify(int value) override
+	{
+		sum_ += value;
+		doNotOptimize(sum_);
+	}
+
+private:
+	int sum_ = 0;
+};
+
+
+// Baseline for connection churn: callbacks removed by the identifier returned on
+// addition
+class CallbackList {
+public:
+	u64 add(const std::function<void(int)>& callback)
+	{
+		callbacks_.emplace_back(++lastId_, callback);
+		return lastId_;
+	}
+
+	void remove(u64 id)
+	{
+		auto it = std::find_if(callbacks_.begin(), callbacks_.end(),
+				[id](const Pair<u64, std::function<void(int)>>& callback) {
+					return callback.first == id;
+				});
+
+		if(it != callbacks_.end())
+			callbacks_.erase(it);
+	}
+
+	void operator()(int value) const
+	{
+		for(const auto& callback : callbacks_)
+			callback.second(value);
+	}
+
+private:
+	u64 lastId_ = 0;
+	std::vector<Pair<u64, std::function<void(int)>>> callbacks_;
+};
+
+
+// Every iteration destroys one of kReceiverCount trackable receivers connected to the
+// same signal, which disconnects it
+void destroyTrackables(BenchmarkState& state, size_t signalCount)
+{
+	std::vector<Signal<void(int)>> emitters(signalCount);
+	u64 remaining = state.iterations();
+
+	while(remaining) {
+		size_t count = static_cast<size_t>(std::min<u64>(remaining, kReceiverCount));
+
+		state.pauseTiming();
+		std::vector<Box<Receiver>> receivers;
+
+		for(size_t i = 0; i < count; ++i) {
+			receivers.emplace_back(new Receiver());
+
+			for(auto& signal : emitters)
+				signal.connect(receivers.back().get(), &Receiver::slot);
+		}
+
+		state.resumeTiming();
+
+		for(auto& receiver : receivers)
+			receiver.reset();
+
+		remaining -= count;
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Heap bytes in use, if the C library can tell
+double heapBytes()
+{
+#ifdef __GLIBC__
+	return static_cast<double>(mallinfo2().uordblks);
+#else
+	return 0.0;
+#endif
+}
+
+
+// Every iteration creates a trackable receiver, connects it to @p signalCount signals
+// and destroys it. Reports the size of Trackable and the heap memory taken by a
+// receiver with its connections.
+void connectTrackable(BenchmarkState& state, size_t signalCount)
+{
+	std::vector<Signal<void(int)>> emitters(signalCount);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		Receiver receiver;
+
+		for(auto& signal : emitters)
+			signal.connect(&receiver, &Receiver::slot);
+	}
+
+	state.pauseTiming();
+
+	// Signals keep their slot vectors, so only the per receiver part is measured
+	std::vector<Box<Receiver>> receivers(kReceiverCount);
+	for(auto& signal : emitters) {
+		for(auto& receiver : receivers)
+			signal.connect(receiver.get(), &Receiver::slot);
+
+		signal.disconnect();
+	}
+
+	double before = heapBytes();
+
+	for(auto& receiver : receivers) {
+		receiver.reset(new Receiver());
+
+		for(auto& signal : emitters)
+			signal.connect(receiver.get(), &Receiver::slot);
+	}
+
+	double after = heapBytes();
+
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("sizeof", sizeof(Trackable));
+	state.setCounter("heapBytesPerReceiver", (after - before) / kReceiverCount);
+}
+
+
+} // namespace
+
+
+// Compare with SignalEmit8 from concurrentsignal_bench.cpp
+BENCHMARK(StdFunctionListEmit8)
+{
+	CallbackList callbacks;
+	std::vector<PlainReceiver> receivers(kEmitSlotCount);
+
+	for(auto& receiver : receivers)
+		callbacks.add(std::bind(&PlainReceiver::slot, &receiver, std::placeholders::_1));
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		callbacks(1);
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(VirtualObserverEmit8)
+{
+	std::vector<ObserverReceiver> receivers(kEmitSlotCount);
+	std::vector<Observer*> observers;
+
+	for(auto& receiver : receivers)
+		observers.push_back(&receiver);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		for(Observer* observer : observers)
+			observer->notify(1);
+
+		doNotOptimize(observers);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Every iteration connects and disconnects a slot of a signal with kChurnSlotCount
+// other connections
+BENCHMARK(SignalConnectDisconnectHandle)
+{
+	Signal<void(int)> signal;
+	std::vector<PlainReceiver> receivers(kChurnSlotCount);
+	PlainReceiver receiver;
+
+	for(auto& other : receivers)
+		signal.connect(&other, &PlainReceiver::slot);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		Connection connection = signal.connect(&receiver, &PlainReceiver::slot);
+		connection.disconnect();
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(SignalConnectDisconnectTarget)
+{
+	Signal<void(int)> signal;
+	std::vector<PlainReceiver> receivers(kChurnSlotCount);
+	PlainReceiver receiver;
+
+	for(auto& other : receivers)
+		signal.connect(&other, &PlainReceiver::slot);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		signal.connect(&receiver, &PlainReceiver::slot);
+		signal.disconnect(&receiver, &PlainReceiver::slot);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(StdFunctionListAddRemove)
+{
+	CallbackList callbacks;
+	std::vector<PlainReceiver> receivers(kChurnSlotCount);
+	PlainReceiver receiver;
+
+	for(auto& other : receivers)
+		callbacks.add(std::bind(&PlainReceiver::slot, &other, std::placeholders::_1));
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		u64 id = callbacks.add(std::bind(&PlainReceiver::slot, &receiver,
+				std::placeholders::_1));
+
+		callbacks.remove(id);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(TrackableConnect1)
+{
+	connectTrackable(state, 1);
+}
+
+
+BENCHMARK(TrackableConnect2)
+{
+	connectTrackable(state, 2);
+}
+
+
+BENCHMARK(TrackableConnect8)
+{
+	connectTrackable(state, 8);
+}
+
+
+BENCHMARK(SignalDestroyTrackables)
+{
+	destroyTrackables(state, 1);
+}
+
+
+BENCHMARK(SignalDestroyTrackables4Signals)
+{
+	destroyTrackables(state, 4);
+}
+
+
+// Every iteration disconnects one of kReceiverCount plain receivers by target
+BENCHMARK(SignalDisconnectTargets)
+{
+	Signal<void(int)> signal;
+	std::vector<PlainReceiver> receivers(kReceiverCount);
+	u64 remaining = state.iterations();
+
+	while(remaining) {
+		size_t count = static_cast<size_t>(std::min<u64>(remaining, kReceiverCount));
+
+		state.pauseTiming();
+		for(size_t i = 0; i < count; ++i)
+			signal.connect(&receivers[i], &PlainReceiver::slot);
+
+		state.resumeTiming();
+
+		for(size_t i = 0; i < count; ++i)
+			signal.disconnect(&receivers[i]);
+
+		remaining -= count;
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Every iteration disconnects one of kReceiverCount slots through its handle
+BENCHMARK(SignalDisconnectHandles)
+{
+	Signal<void(int)> signal;
+	std::vector<PlainReceiver> receivers(kReceiverCount);
+	std::vector<Connection> connections(kReceiverCount);
+	u64 remaining = state.iterations();
+
+	while(remaining) {
+		size_t count = static_cast<size_t>(std::min<u64>(remaining, kReceiverCount));
+
+		state.pauseTiming();
+		for(size_t i = 0; i < count; ++i)
+			connections[i] = signal.connect(&receivers[i], &PlainReceiver::slot);
+
+		state.resumeTiming();
+
+		for(size_t i = 0; i < count; ++i)
+			connections[i].disconnect();
+
+		remaining -= count;
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+
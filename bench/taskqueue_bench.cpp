@@ -0,0 +1,167 @@
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <tech/semaphore.h>
+#include <tech/signal.h>
+#include <tech/string.h>
+#include <tech/taskqueue.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Receiver {
+public:
+	void slot(const String& text, int value)
+	{
+		sum_ += text.length() + value;
+		doNotOptimize(sum_);
+	}
+
+private:
+	size_t sum_ = 0;
+};
+
+
+class Wakeup {
+public:
+	void wakeup()
+	{
+		count.fetch_add(1, std::memory_order_relaxed);
+		semaphore.post();
+	}
+
+	std::atomic<u64> count{0};
+	Semaphore semaphore;
+};
+
+
+// Hand-rolled alternative: a heap allocated closure and a wakeup per emission
+class HeapQueue {
+public:
+	explicit HeapQueue(Wakeup* wakeup) :
+		wakeup_(wakeup)
+	{
+	}
+
+	void post(std::function<void()>* task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.push_back(task);
+		}
+
+		wakeup_->wakeup();
+	}
+
+	size_t processTasks()
+	{
+		std::vector<std::function<void()>*> tasks;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks.swap(tasks_);
+		}
+
+		for(auto* task : tasks) {
+			(*task)();
+			delete task;
+		}
+
+		return tasks.size();
+	}
+
+private:
+	Wakeup* wakeup_;
+	std::mutex mutex_;
+	std::vector<std::function<void()>*> tasks_;
+};
+
+
+} // namespace
+
+
+// Emission and delivery on the same thread, the queue is drained every 256 emissions
+BENCHMARK(QueuedSignalEmit)
+{
+	TaskQueue queue;
+	Signal<void(const String&, int)> signal;
+	Receiver receiver;
+	String text("queued");
+
+	signal.connect(&receiver, &Receiver::slot, &queue);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		signal(text, static_cast<int>(i));
+
+		if((i & 255) == 255)
+			queue.processTasks();
+	}
+
+	queue.processTasks();
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Emission from a worker thread, delivery on the owner thread woken by a semaphore
+BENCHMARK(QueuedSignalCrossThread)
+{
+	Wakeup wakeup;
+	TaskQueue queue(TaskQueue::WakeupHandler(&wakeup, &Wakeup::wakeup));
+	Signal<void(const String&, int)> signal;
+	Receiver receiver;
+	String text("queued");
+	u64 iterations = state.iterations();
+
+	signal.connect(&receiver, &Receiver::slot, &queue);
+
+	std::thread producer([&]() {
+		for(u64 i = 0; i < iterations; ++i)
+			signal(text, static_cast<int>(i));
+	});
+
+	u64 total = 0;
+	while(total < iterations) {
+		wakeup.semaphore.wait();
+		total += queue.processTasks();
+	}
+
+	producer.join();
+	state.setItemsProcessed(iterations);
+	state.setCounter("wakeups", static_cast<double>(wakeup.count.load()));
+}
+
+
+BENCHMARK(HeapTaskCrossThread)
+{
+	Wakeup wakeup;
+	HeapQueue queue(&wakeup);
+	Receiver receiver;
+	String text("queued");
+	u64 iterations = state.iterations();
+
+	std::thread producer([&]() {
+		for(u64 i = 0; i < iterations; ++i) {
+			int value = static_cast<int>(i);
+			queue.post(new std::function<void()>([&receiver, text, value]() {
+				receiver.slot(text, value);
+			}));
+		}
+	});
+
+	u64 total = 0;
+	while(total < iterations) {
+		wakeup.semaphore.wait();
+		total += queue.processTasks();
+	}
+
+	producer.join();
+	state.setItemsProcessed(iterations);
+	state.setCounter("wakeups", static_cast<double>(wakeup.count.load()));
+}
@@ -0,0 +1,153 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <tech/threadpool.h>
+#include "benchmark.h"
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+// Leaves of the fork-join tree run kLeafWork steps, about a microsecond
+static const u64 kLeafWork = 512;
+static const u64 kTasksPerBatch = 1024;
+
+
+u64 leafWork(u64 seed)
+{
+	u64 value = seed;
+	for(u64 i = 0; i < kLeafWork; ++i)
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+
+	return value;
+}
+
+
+// Binary fork-join over [begin, end) leaves
+u64 forkJoin(ThreadPool* pool, u64 begin, u64 end)
+{
+	if(end - begin == 1)
+		return leafWork(begin);
+
+	u64 middle = begin + (end - begin) / 2;
+	u64 left = 0;
+	ThreadPool::Group group;
+
+	pool->submit(&group, [pool, begin, middle, &left]() {
+		left = forkJoin(pool, begin, middle);
+	});
+
+	u64 right = forkJoin(pool, middle, end);
+	pool->wait(&group);
+	return left ^ right;
+}
+
+
+// Every iteration is a leaf task of the tree, the time per leaf should fall linearly
+// with the thread count up to the number of cores
+void runForkJoin(BenchmarkState& state, size_t threadCount)
+{
+	ThreadPool pool(threadCount);
+	ThreadPool::Group group;
+	u64 result = 0;
+	u64 leafCount = state.iterations();
+
+	pool.submit(&group, [&pool, &result, leafCount]() {
+		result = forkJoin(&pool, 0, leafCount);
+	});
+
+	pool.wait(&group);
+	doNotOptimize(result);
+
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("threads", static_cast<double>(pool.threadCount()));
+}
+
+
+} // namespace
+
+
+// Baseline: the leaves run serially on the calling thread
+BENCHMARK(ForkJoinSerial)
+{
+	u64 result = 0;
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		result ^= leafWork(i);
+
+	doNotOptimize(result);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(ThreadPoolForkJoin1)
+{
+	runForkJoin(state, 1);
+}
+
+
+BENCHMARK(ThreadPoolForkJoin2)
+{
+	runForkJoin(state, 2);
+}
+
+
+BENCHMARK(ThreadPoolForkJoin4)
+{
+	runForkJoin(state, 4);
+}
+
+
+BENCHMARK(ThreadPoolForkJoinAllCores)
+{
+	runForkJoin(state, ThreadPool::defaultThreadCount());
+}
+
+
+// Tiny tasks submitted from outside the pool in batches of kTasksPerBatch
+BENCHMARK(ThreadPoolSubmitWait)
+{
+	ThreadPool pool;
+	std::atomic<u64> sum(0);
+	u64 remaining = state.iterations();
+
+	while(remaining) {
+		u64 count = remaining < kTasksPerBatch ? remaining : kTasksPerBatch;
+		ThreadPool::Group group;
+
+		for(u64 i = 0; i < count; ++i)
+			pool.submit(&group, [&sum]() { sum.fetch_add(1, std::memory_order_relaxed); });
+
+		pool.wait(&group);
+		remaining -= count;
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Baseline: a thread per leaf task
+BENCHMARK(StdThreadPerTask)
+{
+	u64 remaining = state.iterations();
+	size_t threadCount = ThreadPool::defaultThreadCount();
+
+	while(remaining) {
+		u64 count = remaining < threadCount ? remaining : threadCount;
+		std::vector<std::thread> threads;
+
+		for(u64 i = 0; i < count; ++i)
+			threads.emplace_back([i]() { doNotOptimize(leafWork(i)); });
+
+		for(auto& thread : threads)
+			thread.join();
+
+		remaining -= count;
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
@@ -0,0 +1,114 @@
+#include <cstring>
+#include <random>
+#include <vector>
+#include <tech/platform.h>
+#include <tech/timerwheel.h>
+#include "benchmark.h"
+
+#ifdef PLATFORM_LINUX
+#include <unistd.h>
+#include <sys/timerfd.h>
+#endif
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+static const size_t kTimerCount = 100000;
+
+
+// Starts kTimerCount timers with timeouts up to a minute
+void startTimers(TimerWheel* wheel, std::vector<TimerWheel::Handle>* handles)
+{
+	std::mt19937 random(1);
+
+	for(size_t i = 0; i < kTimerCount; ++i) {
+		TimerWheel::Handle handle = wheel->create();
+		wheel->start(handle, 0, 1 + random() % 60000);
+		handles->push_back(handle);
+	}
+}
+
+
+} // namespace
+
+
+// Every iteration restarts one of 100k active timers, as an animation or a timeout does
+BENCHMARK(TimerWheelRestart100k)
+{
+	TimerWheel wheel;
+	std::vector<TimerWheel::Handle> handles;
+	startTimers(&wheel, &handles);
+
+	for(u64 i = 0; i < state.iterations(); ++i)
+		wheel.start(handles[i % kTimerCount], 0, 1 + static_cast<i64>(i % 60000));
+
+	doNotOptimize(wheel.nextDeadline());
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Every iteration stops and starts one of 100k active timers
+BENCHMARK(TimerWheelStopStart100k)
+{
+	TimerWheel wheel;
+	std::vector<TimerWheel::Handle> handles;
+	startTimers(&wheel, &handles);
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		TimerWheel::Handle handle = handles[(i * 7919) % kTimerCount];
+		wheel.stop(handle);
+		wheel.start(handle, 0, 1 + static_cast<i64>(i % 60000));
+	}
+
+	doNotOptimize(wheel.activeCount());
+	state.setItemsProcessed(state.iterations());
+}
+
+
+// Every iteration is an expiration of one of 100k periodic timers, the wheel advances by
+// a millisecond per event loop wakeup
+BENCHMARK(TimerWheelExpire100k)
+{
+	TimerWheel wheel;
+	std::mt19937 random(2);
+
+	for(size_t i = 0; i < kTimerCount; ++i)
+		wheel.start(wheel.create(), 0, 1 + random() % 10000, true);
+
+	u64 expired = 0;
+	u64 sum = 0;
+
+	for(i64 now = 1; expired < state.iterations(); ++now) {
+		expired += wheel.advance(now, [&sum](TimerWheel::Handle handle) {
+			sum += handle;
+		});
+	}
+
+	doNotOptimize(sum);
+	state.setItemsProcessed(expired);
+}
+
+
+#ifdef PLATFORM_LINUX
+
+// Baseline: the timer start before the wheel, a timerfd_settime() call per start
+BENCHMARK(TimerfdRestart)
+{
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	itimerspec data;
+	std::memset(&data, 0, sizeof(data));
+
+	for(u64 i = 0; i < state.iterations(); ++i) {
+		data.it_value.tv_sec = 60 + static_cast<time_t>(i % 60);
+		timerfd_settime(fd, 0, &data, nullptr);
+	}
+
+	close(fd);
+	state.setItemsProcessed(state.iterations());
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef TECH_ASYNCLOGGER_H
+#define TECH_ASYNCLOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <tech/lightweightsemaphore.h>
+#include <tech/logger.h>
+#include <tech/thread.h>
+
+
+namespace Tech {
+
+
+/**
+ * Asynchronous logging backend. Producers put messages into a bounded lock-free
+ * multi-producer ring buffer and return immediately, a dedicated writer thread drains
+ * the buffer in batches and passes every message to the @p sink handler. Thus slow
+ * sinks (files, sockets, terminals) never stall the threads which produce messages.
+ *
+ * The logger is installed as a regular log message handler:
+ *
+ *   AsyncLogger logger(LogMessageHandler(&writeToFile));
+ *   setLogMessageHandler(LogMessageHandler(&logger, &AsyncLogger::post));
+ *
+ * In deferred mode the producers don't format messages at all: LOG copies the raw
+ * arguments and the pointer to the format string into the buffer and the writer thread
+ * calls Formatter::format(). The mode is enabled by installing the logger as a deferred
+ * sink in addition to the handler above:
+ *
+ *   setDeferredLogSink(&logger);
+ *
+ * Messages whose arguments don't fit into kMaxDeferredSize bytes are formatted by the
+ * producer and posted as usual.
+ *
+ * Installed as a deferred sink, the logger also queues structured records (see LOG_KV)
+ * as encoded fields. The writer thread passes them to the record handler, if one is set
+ * by setRecordHandler(), or renders them as text for the sink.
+ *
+ * All queued messages are written before the destructor returns. The sink is always
+ * called from the writer thread.
+ */
+class AsyncLogger : public DeferredLogSink {
+public:
+	/**
+	 * Behaviour of post() when the ring buffer is full.
+	 */
+	enum class OverflowPolicy {
+		kBlock,     ///< Wait until the writer thread frees space in the buffer
+		kDrop,      ///< Discard the new message
+		kDropOldest ///< Discard the oldest queued message to make space for the new one
+	};
+
+	static const size_t kDefaultCapacity = 8192;
+	static const size_t kMaxDeferredSize = 128;
+
+	/**
+	 * Creates the logger and starts the writer thread. @p capacity is rounded up to the
+	 * nearest power of two. @p drainHandler is called on the writer thread whenever it
+	 * has written all queued messages, which lets buffering sinks (see FileLogSink) pass
+	 * their buffers to the system in batches.
+	 */
+	explicit AsyncLogger(const LogMessageHandler& sink,
+			size_t capacity = kDefaultCapacity,
+			OverflowPolicy policy = OverflowPolicy::kBlock,
+			const Delegate<void()>& drainHandler = Delegate<void()>());
+
+	AsyncLogger(const AsyncLogger&) = delete;
+	AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+	/**
+	 * Writes all queued messages and stops the writer thread.
+	 */
+	~AsyncLogger() override;
+
+	/**
+	 * Queues the message for the writer thread. The function has LogMessageHandler
+	 * signature, so it can be bound as a global log message handler.
+	 */
+	void post(LogLevel level, const String& file, int line, const String& message);
+
+	/**
+	 * Queues the unformatted message, the writer thread formats it before passing to the
+	 * sink. Returns @c false if the arguments don't fit into the buffer cell.
+	 */
+	bool postDeferred(LogLevel level, const char* fileName, int line,
+			const DeferredMessage& message) override;
+
+	/**
+	 * Queues the structured record. Returns @c false if the fields don't fit into the
+	 * buffer cell.
+	 */
+	bool postFields(LogLevel level, const char* fileName, int line, const char* message,
+			const LogFields& fields) override;
+
+	/**
+	 * Sets the handler for structured records, which is called on the writer thread.
+	 * Must be called before the logger is installed.
+	 */
+	void setRecordHandler(const LogRecordHandler& handler);
+
+	/**
+	 * Blocks until all messages posted before the call are passed to the sink. Must not
+	 * be called from the sink itself.
+	 */
+	void flush();
+
+	size_t capacity() const;
+	OverflowPolicy overflowPolicy() const;
+
+	/**
+	 * Returns the number of messages discarded due to buffer overflow.
+	 */
+	u64 droppedCount() const;
+
+private:
+	class Writer;
+
+	static const size_t kCacheLineSize = 64;
+	static const size_t kBatchSize = 256;
+	static const size_t kMaxUndrainedCount = 4096;
+
+	enum class RecordType {
+		kMessage,  ///< Formatted message
+		kDeferred, ///< Arguments of a deferred message, destroyed by proc
+		kFields    ///< Encoded fields of a structured record
+	};
+
+	// Strings of formatted records are left in the cell after writing and are released
+	// by the next producer which reuses the cell. For deferred and structured records
+	// format is the format string or the message respectively.
+	struct Record {
+		RecordType type;
+		LogLevel level;
+		int line;
+		String file;
+		String message;
+
+		const char* fileName;
+		const char* format;
+		DeferredMessage::Proc proc;
+		size_t fieldsSize;
+		alignas(std::max_align_t) u8 arguments[kMaxDeferredSize];
+	};
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		Record record;
+	};
+
+	LogMessageHandler sink_;
+	LogRecordHandler recordHandler_;
+	Delegate<void()> drainHandler_;
+	OverflowPolicy policy_;
+	size_t mask_;
+	Box<Cell[]> cells_;
+
+	// Producer and consumer positions are placed on separate cache lines to avoid false
+	// sharing between the producers and the writer thread
+	u8 padding1_[kCacheLineSize];
+	std::atomic<size_t> enqueuePos_;
+	u8 padding2_[kCacheLineSize];
+	std::atomic<size_t> dequeuePos_;
+	std::atomic<size_t> completed_;
+	u8 padding3_[kCacheLineSize];
+
+	std::atomic<u64> dropped_;
+	std::atomic<bool> isWriterSleeping_;
+	LightweightSemaphore wakeup_;
+
+	// Threads blocked in flush() wait on flushEpoch_, which is advanced after completed_
+	// only while flushWaiters_ isn't zero
+	std::atomic<u32> flushWaiters_;
+	std::atomic<u32> flushEpoch_;
+	Box<Writer> writer_;
+
+	// Owned by the writer thread. File name of the last deferred record is cached as
+	// String, so that it isn't decoded for every message.
+	const char* lastFileName_;
+	String lastFile_;
+	std::string renderBuffer_;
+
+	// Number of written records which are not yet reported to the drain handler
+	size_t undrainedCount_;
+
+	// Producers claim a cell, fill the record in place and publish it. The writer (or a
+	// producer dropping the oldest record) acquires a published cell and releases it when
+	// the record is no longer needed.
+	Cell* tryReserve(size_t* pos);
+	Cell* reserve(size_t* pos);
+	void publish(Cell* cell, size_t pos);
+	Cell* tryAcquire(size_t* pos);
+	void release(Cell* cell, size_t pos);
+	void wakeWriter();
+	void complete(size_t count);
+
+	// Writer thread side
+	const String& fileOf(const Record& record);
+	void write(Record* record);
+	bool processBatch();
+	void waitForRecords();
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_ASYNCLOGGER_H
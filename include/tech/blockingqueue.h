@@ -0,0 +1,194 @@
+#ifndef TECH_BLOCKINGQUEUE_H
+#define TECH_BLOCKINGQUEUE_H
+
+#include <thread>
+#include <utility>
+#include <tech/duration.h>
+#include <tech/lightweightsemaphore.h>
+
+
+namespace Tech {
+
+
+/**
+ * Blocking wrapper over a bounded lock-free queue, SpscQueue or MpmcQueue.
+ *
+ * Two semaphores count the values and the free slots, so push() blocks while the queue is
+ * full and pop() while it's empty. The semaphores park a thread only when it actually has
+ * to wait, otherwise an operation is a few atomic instructions. The threading
+ * restrictions of @p Queue apply to the wrapper.
+ */
+template<typename Queue>
+class BlockingQueue {
+public:
+	using ValueType = typename Queue::ValueType;
+
+	explicit BlockingQueue(size_t capacity);
+
+	BlockingQueue(const BlockingQueue&) = delete;
+	BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+	size_t capacity() const;
+
+	/**
+	 * Constructs the value from @p args at the tail, waiting for a free slot.
+	 */
+	template<typename ...Args>
+	void emplace(Args&&... args);
+
+	void push(const ValueType& value);
+	void push(ValueType&& value);
+
+	template<typename ...Args>
+	bool tryEmplace(Args&&... args);
+
+	bool tryPush(const ValueType& value);
+	bool tryPush(ValueType&& value);
+
+	/**
+	 * Waits for a value and moves it to @p value.
+	 */
+	void pop(ValueType* value);
+
+	/**
+	 * Waits for a value for at most @p timeout. Returns @c false on timeout.
+	 */
+	bool pop(ValueType* value, const Duration& timeout);
+
+	bool tryPop(ValueType* value);
+
+private:
+	Queue queue_;
+	LightweightSemaphore values_;
+	LightweightSemaphore slots_;
+
+	// A slot (or value) is counted when the operation which released it finishes, but
+	// MpmcQueue hands out positions in order, so the cell of the claimed position may
+	// still be in use by a slower thread for a moment
+	template<typename ...Args>
+	void emplaceCounted(Args&&... args);
+	void popCounted(ValueType* value);
+};
+
+
+template<typename Queue>
+BlockingQueue<Queue>::BlockingQueue(size_t capacity) :
+	queue_(capacity),
+	values_(0),
+	slots_(queue_.capacity())
+{
+}
+
+
+template<typename Queue>
+size_t BlockingQueue<Queue>::capacity() const
+{
+	return queue_.capacity();
+}
+
+
+template<typename Queue>
+template<typename ...Args>
+void BlockingQueue<Queue>::emplace(Args&&... args)
+{
+	slots_.wait();
+	emplaceCounted(std::forward<Args>(args)...);
+}
+
+
+template<typename Queue>
+void BlockingQueue<Queue>::push(const ValueType& value)
+{
+	emplace(value);
+}
+
+
+template<typename Queue>
+void BlockingQueue<Queue>::push(ValueType&& value)
+{
+	emplace(std::move(value));
+}
+
+
+template<typename Queue>
+template<typename ...Args>
+bool BlockingQueue<Queue>::tryEmplace(Args&&... args)
+{
+	if(!slots_.tryWait())
+		return false;
+
+	emplaceCounted(std::forward<Args>(args)...);
+	return true;
+}
+
+
+template<typename Queue>
+bool BlockingQueue<Queue>::tryPush(const ValueType& value)
+{
+	return tryEmplace(value);
+}
+
+
+template<typename Queue>
+bool BlockingQueue<Queue>::tryPush(ValueType&& value)
+{
+	return tryEmplace(std::move(value));
+}
+
+
+template<typename Queue>
+void BlockingQueue<Queue>::pop(ValueType* value)
+{
+	values_.wait();
+	popCounted(value);
+}
+
+
+template<typename Queue>
+bool BlockingQueue<Queue>::pop(ValueType* value, const Duration& timeout)
+{
+	if(!values_.wait(timeout))
+		return false;
+
+	popCounted(value);
+	return true;
+}
+
+
+template<typename Queue>
+bool BlockingQueue<Queue>::tryPop(ValueType* value)
+{
+	if(!values_.tryWait())
+		return false;
+
+	popCounted(value);
+	return true;
+}
+
+
+template<typename Queue>
+template<typename ...Args>
+void BlockingQueue<Queue>::emplaceCounted(Args&&... args)
+{
+	// Arguments aren't moved from unless the value is constructed
+	while(!queue_.tryEmplace(std::forward<Args>(args)...))
+		std::this_thread::yield();
+
+	values_.post();
+}
+
+
+template<typename Queue>
+void BlockingQueue<Queue>::popCounted(ValueType* value)
+{
+	while(!queue_.tryPop(value))
+		std::this_thread::yield();
+
+	slots_.post();
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_BLOCKINGQUEUE_H
@@ -0,0 +1,272 @@
+#ifndef TECH_COALESCINGSIGNAL_H
+#define TECH_COALESCINGSIGNAL_H
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tech/signal.h>
+
+
+namespace Tech {
+
+
+/**
+ * Сигнал с объединением генераций: вместо немедленного вызова подключенных функций
+ * аргументы генерации запоминаются, а вызов откладывается до выполнения задачи в очереди
+ * @c TaskQueue (как правило, очереди цикла обработки событий, см.
+ * WindowSystem::taskQueue()). Все генерации до выполнения задачи объединяются в одну:
+ * по умолчанию сохраняются аргументы последней из них, либо они сворачиваются функцией
+ * @c Reducer. Подходит для часто генерируемых уведомлений (изменение значения,
+ * геометрии), обработчикам которых важно только итоговое состояние за итерацию цикла
+ * обработки событий.
+ *
+ * Пример:
+ * CoalescingSignal<void(int)> scrolled(queue, [](Tuple<int>* pending, int delta) {
+ *     std::get<0>(*pending) += delta;
+ * });
+ *
+ * scrolled(1);
+ * scrolled(2);            // Функции будут вызваны один раз с аргументом 3
+ *
+ * Подключение и отключение функций выполняется так же, как у Signal. Генерация сигнала
+ * должна выполняться в потоке очереди задач. Функции, вызванные при доставке, могут
+ * снова генерировать сигнал: новая генерация будет доставлена следующей задачей.
+ *
+ * @tparam T Сигнатура функции, к которой будет подключаться сигнал, возвращаемый тип
+ *           должен быть @c void.
+ * @tparam K Ключ доступа, аналогичный ключу Signal.
+ */
+template<typename T, typename K = void>
+class CoalescingSignal;
+
+
+template<typename K, typename ...A>
+class CoalescingSignal<void(A...), K> : private Signal<void(A...)> {
+public:
+	using Arguments = Tuple<typename std::decay<A>::type...>;
+
+	/**
+	 * Функция, объединяющая аргументы ожидающей доставки @p pending с аргументами новой
+	 * генерации.
+	 */
+	using Reducer = Delegate<void(Arguments* pending, A... args)>;
+
+	/**
+	 * Создает сигнал, доставка которого выполняется через очередь @p queue. Если
+	 * @p reducer не задан, доставляются аргументы последней генерации.
+	 */
+	explicit CoalescingSignal(TaskQueue* queue, const Reducer& reducer = Reducer());
+
+	CoalescingSignal(const CoalescingSignal&) = delete;
+	CoalescingSignal& operator=(const CoalescingSignal&) = delete;
+
+	/**
+	 * Уничтожает сигнал, ожидающая доставка отменяется.
+	 */
+	~CoalescingSignal();
+
+	/**
+	 * Запоминает генерацию сигнала с аргументами @p args. Данная версия функции
+	 * присутствует только когда отсутствует ключ доступа @p K.
+	 */
+	template<typename T = K, EnableIf<std::is_void<T>>...>
+	void operator()(A... args) const;
+
+	/**
+	 * Запоминает генерацию сигнала с аргументами @p args. Данная версия функции
+	 * присутствует только когда задан ключ доступа @p K.
+	 */
+	template<typename T = K, EnableIf<Not<std::is_void<T>>>...>
+	void operator()(T key, A... args) const;
+
+	/**
+	 * Возвращает @c true, если есть генерация, ожидающая доставки.
+	 */
+	bool isPending() const;
+
+	/**
+	 * Немедленно вызывает подключенные функции с ожидающими доставки аргументами, не
+	 * дожидаясь выполнения задачи в очереди.
+	 */
+	void flush() const;
+
+	using Signal<void(A...)>::hasConnections;
+	using Signal<void(A...)>::connect;
+	using Signal<void(A...)>::disconnect;
+
+private:
+	using SignalType = Signal<void(A...)>;
+
+	// Задача доставки. Сигнал и задача ссылаются друг на друга, пока генерация ожидает
+	// доставки, и разрывают связь при отмене доставки с любой из сторон.
+	class Delivery;
+
+	TaskQueue* queue_;
+	Reducer reducer_;
+	mutable Delivery* delivery_;
+
+	// Аргументы ожидающей доставки, существуют только пока delivery_ не равен nullptr
+	mutable typename std::aligned_storage<sizeof(Arguments), alignof(Arguments)>::type
+			storage_;
+
+	Arguments* pending() const;
+
+	void emit(A... args) const;
+
+	// Вызывает подключенные функции с ожидающими доставки аргументами
+	void deliver() const;
+
+	// Уничтожает ожидающие доставки аргументы без вызова функций
+	void discard() const;
+
+	template<size_t ...I>
+	void invoke(const Arguments& arguments, std::index_sequence<I...>) const;
+};
+
+
+template<typename K, typename ...A>
+class CoalescingSignal<void(A...), K>::Delivery final : public TaskQueue::Task {
+public:
+	explicit Delivery(const CoalescingSignal* signal) :
+		signal_(signal)
+	{
+		signal_->delivery_ = this;
+	}
+
+	~Delivery() override
+	{
+		// Очередь уничтожена до выполнения задачи
+		if(signal_)
+			signal_->discard();
+	}
+
+	void run() override
+	{
+		if(signal_) {
+			const CoalescingSignal* signal = signal_;
+			signal_ = nullptr;
+			signal->deliver();
+		}
+	}
+
+	void cancel()
+	{
+		signal_ = nullptr;
+	}
+
+private:
+	const CoalescingSignal* signal_;
+};
+
+
+template<typename K, typename ...A>
+CoalescingSignal<void(A...), K>::CoalescingSignal(TaskQueue* queue,
+		const Reducer& reducer) :
+	queue_(queue),
+	reducer_(reducer),
+	delivery_(nullptr)
+{
+}
+
+
+template<typename K, typename ...A>
+CoalescingSignal<void(A...), K>::~CoalescingSignal()
+{
+	if(delivery_) {
+		delivery_->cancel();
+		discard();
+	}
+}
+
+
+template<typename K, typename ...A>
+template<typename T, EnableIf<std::is_void<T>>...>
+void CoalescingSignal<void(A...), K>::operator()(A... args) const
+{
+	emit(args...);
+}
+
+
+template<typename K, typename ...A>
+template<typename T, EnableIf<Not<std::is_void<T>>>...>
+void CoalescingSignal<void(A...), K>::operator()(T key, A... args) const
+{
+	UNUSED(key);
+	emit(args...);
+}
+
+
+template<typename K, typename ...A>
+bool CoalescingSignal<void(A...), K>::isPending() const
+{
+	return delivery_ != nullptr;
+}
+
+
+template<typename K, typename ...A>
+void CoalescingSignal<void(A...), K>::flush() const
+{
+	if(delivery_) {
+		delivery_->cancel();
+		deliver();
+	}
+}
+
+
+template<typename K, typename ...A>
+auto CoalescingSignal<void(A...), K>::pending() const -> Arguments*
+{
+	return reinterpret_cast<Arguments*>(&storage_);
+}
+
+
+template<typename K, typename ...A>
+void CoalescingSignal<void(A...), K>::emit(A... args) const
+{
+	if(delivery_) {
+		if(!reducer_.isNull())
+			reducer_(pending(), args...);
+		else
+			*pending() = Arguments(args...);
+
+		return;
+	}
+
+	new(&storage_) Arguments(args...);
+	queue_->post<Delivery>(this);
+}
+
+
+template<typename K, typename ...A>
+void CoalescingSignal<void(A...), K>::deliver() const
+{
+	// Аргументы забираются до вызова функций, чтобы генерация из них начала новое
+	// объединение
+	Arguments arguments(std::move(*pending()));
+	discard();
+
+	invoke(arguments, std::index_sequence_for<A...>());
+}
+
+
+template<typename K, typename ...A>
+void CoalescingSignal<void(A...), K>::discard() const
+{
+	pending()->~Arguments();
+	delivery_ = nullptr;
+}
+
+
+template<typename K, typename ...A>
+template<size_t ...I>
+void CoalescingSignal<void(A...), K>::invoke(const Arguments& arguments,
+		std::index_sequence<I...>) const
+{
+	SignalType::operator()(std::get<I>(arguments)...);
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_COALESCINGSIGNAL_H
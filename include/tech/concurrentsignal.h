@@ -0,0 +1,431 @@
+#ifndef TECH_CONCURRENTSIGNAL_H
+#define TECH_CONCURRENTSIGNAL_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <tech/delegate.h>
+#include <tech/traits.h>
+
+
+namespace Tech {
+
+
+/**
+ * Потокобезопасный вариант Signal: генерация сигнала может выполняться из любого числа
+ * потоков одновременно с подключением и отключением функций.
+ *
+ * Подключенные функции хранятся в неизменяемом снимке (snapshot) с подсчетом ссылок.
+ * Генерация сигнала захватывает текущий снимок без блокировок и выделения памяти,
+ * вызывает функции из него и освобождает снимок. Подключение и отключение создают новый
+ * снимок под мьютексом и публикуют его, старый снимок удаляется последним использующим
+ * его потоком (RCU).
+ *
+ * Отсюда следует, что генерация, начавшаяся до отключения функции в другом потоке, еще
+ * может ее вызвать. Отслеживание объектов Trackable не поддерживается: объект должен
+ * быть отключен, и все генерации сигнала в других потоках должны завершиться, прежде
+ * чем объект будет уничтожен.
+ */
+template<typename T>
+class ConcurrentSignal;
+
+
+template<typename R, typename ...A>
+class ConcurrentSignal<R(A...)> {
+public:
+	ConcurrentSignal();
+
+	ConcurrentSignal(const ConcurrentSignal&) = delete;
+	ConcurrentSignal& operator=(const ConcurrentSignal&) = delete;
+
+	/**
+	 * Уничтожает сигнал. Генерация сигнала в других потоках к этому моменту должна быть
+	 * завершена.
+	 */
+	~ConcurrentSignal();
+
+	/**
+	 * Производит вызов всех подключенных функций, передавая им @p args в качестве
+	 * аргументов.
+	 */
+	template<typename T1 = R, EnableIf<std::is_void<T1>>...>
+	void operator()(A... args) const;
+
+	/**
+	 * Производит вызов всех подключенных функций и возвращает значение, которое вернет
+	 * последняя из вызванных функций.
+	 */
+	template<typename T1 = R, EnableIf<Not<std::is_void<T1>>>...>
+	R operator()(A... args) const;
+
+	/**
+	 * Возвращает @c true, если сигнал подключен хотя бы к одной функции.
+	 */
+	bool hasConnections() const;
+
+	/**
+	 * Подключает статическую функцию @p function.
+	 */
+	void connect(R(*function)(A...));
+
+	/**
+	 * Подключает неконстантную функцию-член @p function объекта @p target.
+	 */
+	template<typename T, typename B, EnableIf<std::is_base_of<B, T>>...>
+	void connect(T* target, R(B::*function)(A...));
+
+	/**
+	 * Подключает константную функцию-член @p function объекта @p target.
+	 */
+	template<typename T, typename B, EnableIf<std::is_base_of<B, T>>...>
+	void connect(T* target, R(B::*function)(A...) const);
+
+	/**
+	 * Отключает все подключенные функции.
+	 */
+	void disconnect();
+
+	/**
+	 * Отключает подключенную статическую функцию @p function.
+	 */
+	void disconnect(R(*function)(A...));
+
+	/**
+	 * Отключает подключенную неконстантную функцию-член @p function объекта @p target.
+	 */
+	template<typename T>
+	void disconnect(T* target, R(T::*function)(A...));
+
+	/**
+	 * Отключает подключенную константную функцию-член @p function объекта @p target.
+	 */
+	template<typename T>
+	void disconnect(T* target, R(T::*function)(A...) const);
+
+	/**
+	 * Отключает все подключенные функции-члены объекта @p target.
+	 */
+	template<typename T>
+	void disconnect(T* target);
+
+private:
+	using DelegateType = Delegate<R(A...)>;
+
+	// Снимок подключенных функций. Пока снимок опубликован, refs содержит число
+	// освобождений со знаком минус: захваты учитываются во внешнем счетчике state_ и
+	// переносятся в refs при замене снимка.
+	struct Snapshot {
+		std::atomic<i64> refs;
+		std::vector<DelegateType> slots;
+	};
+
+	// Захват снимка, освобождающий его при выходе из области видимости
+	class SnapshotLock {
+	public:
+		explicit SnapshotLock(const ConcurrentSignal* signal);
+		SnapshotLock(const SnapshotLock&) = delete;
+		SnapshotLock& operator=(const SnapshotLock&) = delete;
+		~SnapshotLock();
+
+		const Snapshot* snapshot() const;
+
+	private:
+		const ConcurrentSignal* signal_;
+		Snapshot* snapshot_;
+	};
+
+	// Указатель на текущий снимок в младших битах и число захвативших его потоков в
+	// старших. Указатели пользовательского пространства 64-битных платформ занимают не
+	// более 48 бит.
+	static const int kCountShift = sizeof(void*) == 8 ? 48 : 32;
+	static const u64 kCountOne = u64(1) << kCountShift;
+	static const u64 kPointerMask = kCountOne - 1;
+
+	mutable std::atomic<u64> state_;
+
+	// Упорядочивает изменения снимка
+	std::mutex mutex_;
+
+	Snapshot* acquire() const;
+	void release(Snapshot* snapshot) const;
+
+	// Должны вызываться под mutex_
+	const Snapshot* current() const;
+	void publish(Snapshot* snapshot);
+
+	void doConnect(const DelegateType& delegate);
+
+	template<typename P>
+	void doDisconnect(P predicate);
+
+	static Snapshot* pointerOf(u64 state);
+};
+
+
+template<typename R, typename ...A>
+ConcurrentSignal<R(A...)>::SnapshotLock::SnapshotLock(const ConcurrentSignal* signal) :
+	signal_(signal),
+	snapshot_(signal->acquire())
+{
+}
+
+
+template<typename R, typename ...A>
+ConcurrentSignal<R(A...)>::SnapshotLock::~SnapshotLock()
+{
+	if(snapshot_)
+		signal_->release(snapshot_);
+}
+
+
+template<typename R, typename ...A>
+auto ConcurrentSignal<R(A...)>::SnapshotLock::snapshot() const -> const Snapshot*
+{
+	return snapshot_;
+}
+
+
+template<typename R, typename ...A>
+ConcurrentSignal<R(A...)>::ConcurrentSignal() :
+	state_(0)
+{
+}
+
+
+template<typename R, typename ...A>
+ConcurrentSignal<R(A...)>::~ConcurrentSignal()
+{
+	delete pointerOf(state_.load(std::memory_order_acquire));
+}
+
+
+template<typename R, typename ...A>
+template<typename T1, EnableIf<std::is_void<T1>>...>
+void ConcurrentSignal<R(A...)>::operator()(A... args) const
+{
+	SnapshotLock lock(this);
+
+	if(lock.snapshot()) {
+		for(const auto& slot : lock.snapshot()->slots)
+			slot(args...);
+	}
+}
+
+
+template<typename R, typename ...A>
+template<typename T1, EnableIf<Not<std::is_void<T1>>>...>
+R ConcurrentSignal<R(A...)>::operator()(A... args) const
+{
+	R result = R();
+	SnapshotLock lock(this);
+
+	if(lock.snapshot()) {
+		for(const auto& slot : lock.snapshot()->slots)
+			result = slot(args...);
+	}
+
+	return result;
+}
+
+
+template<typename R, typename ...A>
+bool ConcurrentSignal<R(A...)>::hasConnections() const
+{
+	return (state_.load(std::memory_order_relaxed) & kPointerMask) != 0;
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::connect(R(*function)(A...))
+{
+	doConnect(DelegateType(function));
+}
+
+
+template<typename R, typename ...A>
+template<typename T, typename B, EnableIf<std::is_base_of<B, T>>...>
+void ConcurrentSignal<R(A...)>::connect(T* target, R(B::*function)(A...))
+{
+	doConnect(DelegateType(target, function));
+}
+
+
+template<typename R, typename ...A>
+template<typename T, typename B, EnableIf<std::is_base_of<B, T>>...>
+void ConcurrentSignal<R(A...)>::connect(T* target, R(B::*function)(A...) const)
+{
+	doConnect(DelegateType(target, function));
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::disconnect()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	publish(nullptr);
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::disconnect(R(*function)(A...))
+{
+	DelegateType delegate(function);
+	doDisconnect([&delegate](const DelegateType& slot) { return slot == delegate; });
+}
+
+
+template<typename R, typename ...A>
+template<typename T>
+void ConcurrentSignal<R(A...)>::disconnect(T* target, R(T::*function)(A...))
+{
+	DelegateType delegate(target, function);
+	doDisconnect([&delegate](const DelegateType& slot) { return slot == delegate; });
+}
+
+
+template<typename R, typename ...A>
+template<typename T>
+void ConcurrentSignal<R(A...)>::disconnect(T* target, R(T::*function)(A...) const)
+{
+	DelegateType delegate(target, function);
+	doDisconnect([&delegate](const DelegateType& slot) { return slot == delegate; });
+}
+
+
+template<typename R, typename ...A>
+template<typename T>
+void ConcurrentSignal<R(A...)>::disconnect(T* target)
+{
+	if(!target)
+		return;
+
+	doDisconnect([target](const DelegateType& slot) { return slot.target() == target; });
+}
+
+
+template<typename R, typename ...A>
+auto ConcurrentSignal<R(A...)>::acquire() const -> Snapshot*
+{
+	// Захват учитывается во внешнем счетчике, поэтому снимок не может быть удален между
+	// чтением указателя и увеличением счетчика. Счетчик пустого состояния не меняется,
+	// т.к. при публикации снимка он был бы потерян.
+	u64 state = state_.load(std::memory_order_relaxed);
+
+	while(pointerOf(state)) {
+		if(state_.compare_exchange_weak(state, state + kCountOne, std::memory_order_acquire,
+				std::memory_order_relaxed))
+			return pointerOf(state);
+	}
+
+	return nullptr;
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::release(Snapshot* snapshot) const
+{
+	u64 state = state_.load(std::memory_order_relaxed);
+
+	// Пока снимок опубликован, уменьшаем внешний счетчик. Указатель не может совпасть с
+	// адресом нового снимка, т.к. захваченный нами снимок еще не удален.
+	while(pointerOf(state) == snapshot) {
+		if(state_.compare_exchange_weak(state, state - kCountOne, std::memory_order_release,
+				std::memory_order_relaxed))
+			return;
+	}
+
+	// Снимок заменен, и наш захват перенесен в refs
+	if(snapshot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete snapshot;
+}
+
+
+template<typename R, typename ...A>
+auto ConcurrentSignal<R(A...)>::current() const -> const Snapshot*
+{
+	return pointerOf(state_.load(std::memory_order_relaxed));
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::publish(Snapshot* snapshot)
+{
+	if(snapshot && snapshot->slots.empty()) {
+		delete snapshot;
+		snapshot = nullptr;
+	}
+
+	u64 state = state_.exchange(static_cast<u64>(reinterpret_cast<iptr>(snapshot)),
+			std::memory_order_acq_rel);
+	Snapshot* old = pointerOf(state);
+
+	if(!old)
+		return;
+
+	// Переносим захваты в refs: если все захватившие потоки уже освободили снимок,
+	// удаляем его здесь, иначе его удалит последний из них
+	i64 count = static_cast<i64>(state >> kCountShift);
+
+	if(old->refs.fetch_add(count, std::memory_order_acq_rel) + count == 0)
+		delete old;
+}
+
+
+template<typename R, typename ...A>
+void ConcurrentSignal<R(A...)>::doConnect(const DelegateType& delegate)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Snapshot* snapshot = current();
+
+	Snapshot* result = new Snapshot();
+	result->refs.store(0, std::memory_order_relaxed);
+
+	if(snapshot) {
+		result->slots.reserve(snapshot->slots.size() + 1);
+		result->slots = snapshot->slots;
+	}
+
+	result->slots.push_back(delegate);
+	publish(result);
+}
+
+
+template<typename R, typename ...A>
+template<typename P>
+void ConcurrentSignal<R(A...)>::doDisconnect(P predicate)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Snapshot* snapshot = current();
+
+	if(!snapshot)
+		return;
+
+	Snapshot* result = new Snapshot();
+	result->refs.store(0, std::memory_order_relaxed);
+	result->slots.reserve(snapshot->slots.size());
+
+	for(const auto& slot : snapshot->slots) {
+		if(!predicate(slot))
+			result->slots.push_back(slot);
+	}
+
+	if(result->slots.size() == snapshot->slots.size()) {
+		delete result;
+		return;
+	}
+
+	publish(result);
+}
+
+
+template<typename R, typename ...A>
+auto ConcurrentSignal<R(A...)>::pointerOf(u64 state) -> Snapshot*
+{
+	return reinterpret_cast<Snapshot*>(static_cast<iptr>(state & kPointerMask));
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_CONCURRENTSIGNAL_H
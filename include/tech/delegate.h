@@ -49,12 +49,31 @@
  * Tech::Delegate<void(int, const char*)> delegate2(&foo, &Foo::func);
  * delegate2(15, "test"); // Вызывает функцию-член foo.func(15, "test")
  *
+ * int base = 10;
+ * Tech::Delegate<int(int)> delegate3([base](int value) { return base + value; });
+ * delegate3(5); // Вызывает лямбда-функцию, возвращает 15
+ *
+ * Функциональные объекты (в том числе лямбда-функции с захватом) хранятся внутри
+ * делегата без выделения памяти, поэтому их размер ограничен kDelegateInlineSize байт,
+ * а сами объекты должны быть тривиально копируемыми и уничтожаемыми (захватывать
+ * указатели, ссылки и простые значения). Нарушение этих ограничений приводит к ошибке
+ * компиляции: для объектов большего размера или с нетривиальным копированием следует
+ * использовать std::function.
  */
 
 #include <cstring>
+#include <functional>
 #include <map>
+#include <new>
+#include <type_traits>
 #include <tech/utils.h>
 
+// Размер буфера для хранения функциональных объектов внутри делегата. Может быть
+// переопределен при сборке, но должен быть одинаковым во всех единицах трансляции.
+#ifndef TECH_DELEGATE_INLINE_SIZE
+#define TECH_DELEGATE_INLINE_SIZE (3 * sizeof(void*))
+#endif
+
 
 namespace internal {
 
@@ -86,6 +105,14 @@ static constexpr size_t kFunctionPointerMaxSize = maxOf(
 		sizeof(void(internal::Undefined::*)())
 );
 
+// Максимальный размер функционального объекта, который может быть привязан к делегату
+static constexpr size_t kDelegateInlineSize = TECH_DELEGATE_INLINE_SIZE;
+
+// Размер буфера делегата, достаточный как для указателя на функцию, так и для
+// функционального объекта
+static constexpr size_t kDelegateStorageSize = maxOf(kFunctionPointerMaxSize,
+		kDelegateInlineSize);
+
 
 template<typename>
 class Delegate;
@@ -120,6 +147,23 @@ public:
 			std::is_base_of<B, T>>...>
 	Delegate(T* target, R(B::*function)(A...) const);
 
+	/**
+	 * Создает делегат и привязывает его к копии функционального объекта @p functor
+	 * (например, лямбда-функции). Объект хранится внутри делегата, поэтому его размер не
+	 * должен превышать kDelegateInlineSize байт, а копирование и уничтожение должны быть
+	 * тривиальными.
+	 */
+	template<typename F, EnableIf<
+			std::is_class<F>,
+			Not<std::is_same<F, Delegate<R(A...)>>>>...>
+	Delegate(const F& functor);
+
+	/**
+	 * Копирует делегат @p other. Копия пустого делегата также является пустой.
+	 */
+	Delegate(const Delegate& other);
+	Delegate& operator=(const Delegate& other);
+
 	/**
 	 * Вызывает привязанную функцию, передавая ей @c args в качестве аргументов.
 	 */
@@ -153,11 +197,18 @@ public:
 
 	/**
 	 * Возвращает указатель на начало данных объекта, с методом которого связан делегат.
-	 * В случае, если делегат пустой или связан со статической функцией, возвращается
-	 * @c nullptr.
+	 * В случае, если делегат пустой, связан со статической функцией или функциональным
+	 * объектом, возвращается @c nullptr.
 	 */
 	void* target() const;
 
+	/**
+	 * Смещает указатель на объект, с методом которого связан делегат, на @p offset байт.
+	 * Используется для перепривязки делегата к перемещенному объекту. Для пустого
+	 * делегата и делегата, связанного со статической функцией, ничего не делает.
+	 */
+	void moveTarget(iptr offset);
+
 private:
 	// Структура для хранения значения указателя на функцию.
 	// C++ не позволяет выполнять приведение типа указателя на функцию-член к какому-либо
@@ -171,16 +222,16 @@ private:
 	};
 
 	// Указатель на объект, к методу которого привязан делегат. При связи со статической
-	// функцией содержит nullptr. Если значение равно this, то это интерпретируется как
-	// признак пустого делегата. Такое поведение обусловлено оптимизацией, чтобы избежать
-	// сравнения всего массива storage_ с нулем в методе isNull() или использования
-	// дополнительной памяти для хранения признака пустого делегата. Значение this
-	// выбрано в качестве специального, потому что нет смысла присоединять делегат к
-	// самому себе, т.к. это приведет к бесконечной рекурсии.
+	// функцией или функциональным объектом содержит nullptr. Если значение равно this,
+	// то это интерпретируется как признак пустого делегата. Такое поведение обусловлено
+	// оптимизацией, чтобы избежать сравнения всего массива storage_ с нулем в методе
+	// isNull() или использования дополнительной памяти для хранения признака пустого
+	// делегата. Значение this выбрано в качестве специального, потому что нет смысла
+	// присоединять делегат к самому себе, т.к. это приведет к бесконечной рекурсии.
 	void* target_;
 
-	// Буфер, хранящий указатель на функцию
-	u8 storage_[kFunctionPointerMaxSize];
+	// Буфер, хранящий указатель на функцию или функциональный объект
+	alignas(void*) u8 storage_[kDelegateStorageSize];
 
 	// Указатель на функцию-трамплин, которая восстанавливает тип и осуществляет вызов
 	// привязанной функции
@@ -204,6 +255,15 @@ private:
 		auto pointerData = reinterpret_cast<const PointerWrapper<F>*>(self->storage_);
 		return (target->*pointerData->value)(std::forward<A>(args)...);
 	}
+
+	// Трамплин для вызова функционального объекта. Объект может изменять свое состояние
+	// (mutable лямбда-функции), как и объект, к методу которого привязан делегат.
+	template<typename F>
+	static R functorCaller(const Delegate<R(A...)>* self, A&&... args)
+	{
+		auto functor = reinterpret_cast<F*>(const_cast<u8*>(self->storage_));
+		return (*functor)(std::forward<A>(args)...);
+	}
 };
 
 
@@ -255,6 +315,28 @@ Delegate<R(A...)>::Delegate(T* target, R(B::*function)(A...) const) :
 }
 
 
+template<typename R, typename ...A>
+template<typename F, EnableIf<
+		std::is_class<F>,
+		Not<std::is_same<F, Delegate<R(A...)>>>>...>
+Delegate<R(A...)>::Delegate(const F& functor) :
+	target_(nullptr),
+	storage_{ 0 }
+{
+	static_assert(sizeof(F) <= kDelegateInlineSize,
+			"Functor is too large for Delegate, use std::function instead");
+	static_assert(alignof(F) <= alignof(void*),
+			"Functor is overaligned for Delegate, use std::function instead");
+	static_assert(std::is_trivially_copyable<F>::value &&
+			std::is_trivially_destructible<F>::value,
+			"Functor must be trivially copyable and destructible, "
+			"use std::function instead");
+
+	new (storage_) F(functor);
+	callerProc_ = functorCaller<F>;
+}
+
+
 template<typename R, typename ...A>
 R Delegate<R(A...)>::operator()(A... args) const
 {
@@ -262,13 +344,38 @@ R Delegate<R(A...)>::operator()(A... args) const
 }
 
 
+template<typename R, typename ...A>
+Delegate<R(A...)>::Delegate(const Delegate& other) :
+	target_(other.isNull() ? this : other.target_),
+	callerProc_(other.callerProc_)
+{
+	std::memcpy(storage_, other.storage_, kDelegateStorageSize);
+}
+
+
+template<typename R, typename ...A>
+Delegate<R(A...)>& Delegate<R(A...)>::operator=(const Delegate& other)
+{
+	// Признак пустого делегата зависит от адреса объекта, поэтому не копируется
+	target_ = other.isNull() ? this : other.target_;
+	callerProc_ = other.callerProc_;
+	std::memcpy(storage_, other.storage_, kDelegateStorageSize);
+	return *this;
+}
+
+
 template<typename R, typename ...A>
 bool Delegate<R(A...)>::operator==(const Delegate& other) const
 {
-	if(target() == other.target())
-		return std::memcmp(storage_, other.storage_, kFunctionPointerMaxSize) == 0;
+	if(target() != other.target())
+		return false;
 
-	return false;
+	// Функциональные объекты с одинаковыми захваченными значениями различаются только
+	// трамплином
+	if(!target() && callerProc_ != other.callerProc_)
+		return false;
+
+	return std::memcmp(storage_, other.storage_, kDelegateStorageSize) == 0;
 }
 
 
@@ -282,10 +389,13 @@ bool Delegate<R(A...)>::operator!=(const Delegate& other) const
 template<typename R, typename ...A>
 bool Delegate<R(A...)>::operator<(const Delegate& other) const
 {
-	if(target() < other.target())
-		return true;
+	if(target() != other.target())
+		return std::less<void*>()(target(), other.target());
+
+	if(!target() && callerProc_ != other.callerProc_)
+		return std::less<CallerProc>()(callerProc_, other.callerProc_);
 
-	return std::memcmp(storage_, other.storage_, kFunctionPointerMaxSize) < 0;
+	return std::memcmp(storage_, other.storage_, kDelegateStorageSize) < 0;
 }
 
 
@@ -314,6 +424,14 @@ void* Delegate<R(A...)>::target() const
 }
 
 
+template<typename R, typename ...A>
+void Delegate<R(A...)>::moveTarget(iptr offset)
+{
+	if(!isNull() && target_)
+		target_ = static_cast<u8*>(target_) + offset;
+}
+
+
 } // namespace Tech
 
 
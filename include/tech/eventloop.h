@@ -0,0 +1,216 @@
+#ifndef TECH_EVENTLOOP_H
+#define TECH_EVENTLOOP_H
+
+#include <atomic>
+#include <vector>
+#include <tech/delegate.h>
+#include <tech/duration.h>
+#include <tech/flags.h>
+#include <tech/taskqueue.h>
+#include <tech/timerwheel.h>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+enum class IoEvent {
+	kNone   = 0x00,
+	kRead   = 0x01,
+	kWrite  = 0x02,
+	kError  = 0x04,
+	kHangup = 0x08
+};
+
+using IoEvents = Flags<IoEvent>;
+DECLARE_FLAG_OPERATORS(IoEvent)
+
+
+/**
+ * Event loop of a thread, usable without a display.
+ *
+ * The loop waits on a single epoll instance for three kinds of sources: watched file
+ * descriptors, timers and tasks posted from any thread. All timers share one timerfd
+ * armed to the nearest deadline of a TimerWheel. Posted tasks and quit() wake the loop
+ * through an eventfd. The window system registers its display connection as one of the
+ * watched descriptors, so GUI and non-GUI code run on the same loop.
+ *
+ * Everything except taskQueue()->post(), wakeup() and quit() must be called from the
+ * thread running the loop. Handlers may add and remove watches and timers, including
+ * their own.
+ */
+class EventLoop {
+public:
+	using IoHandler = Delegate<void(int fd, IoEvents events)>;
+	using TimerHandle = TimerWheel::Handle;
+	using TimerHandler = Delegate<void()>;
+
+	static const TimerHandle kInvalidTimer = TimerWheel::kInvalidHandle;
+
+	/**
+	 * Work done by the loop, times are in nanoseconds.
+	 */
+	struct Statistics {
+		u64 iterations;
+
+		// Handled descriptor events, expired timers and run tasks
+		u64 ioEvents;
+		u64 timers;
+		u64 tasks;
+
+		// Time blocked in epoll_wait() and spent in the handlers of every source
+		i64 waitTime;
+		i64 ioTime;
+		i64 timerTime;
+		i64 taskTime;
+	};
+
+	EventLoop();
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	~EventLoop();
+
+	/**
+	 * Returns the loop of the calling thread, created on the first call.
+	 */
+	static EventLoop* instance();
+
+	/**
+	 * Returns @c false if the descriptors of the loop couldn't be created.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Calls @p handler when @p fd becomes ready for any of @p events. Errors and hangups
+	 * are always reported. The watch is level-triggered. Returns @c false if the
+	 * descriptor is already watched or can't be added to epoll.
+	 */
+	bool watch(int fd, IoEvents events, const IoHandler& handler);
+
+	/**
+	 * Changes the events of the watched @p fd.
+	 */
+	bool modifyWatch(int fd, IoEvents events);
+
+	/**
+	 * Stops watching @p fd. Must be called before the descriptor is closed.
+	 */
+	void unwatch(int fd);
+
+	bool isWatched(int fd) const;
+
+	TimerHandle createTimer(const TimerHandler& handler);
+	void destroyTimer(TimerHandle handle);
+
+	/**
+	 * Starts or restarts the timer, it's called after @p timeout and then every
+	 * @p timeout if @p periodic is @c true. The timer is a few operations in memory, the
+	 * timerfd is re-armed only for a nearer deadline.
+	 */
+	void startTimer(TimerHandle handle, const Duration& timeout, bool periodic = false);
+	void stopTimer(TimerHandle handle);
+
+	bool isTimerActive(TimerHandle handle) const;
+	Duration timerInterval(TimerHandle handle) const;
+
+	/**
+	 * Returns the queue of tasks run by the loop. Tasks may be posted from any thread.
+	 */
+	TaskQueue* taskQueue();
+
+	/**
+	 * Runs the loop until quit() and returns the code passed to it.
+	 */
+	int run();
+
+	/**
+	 * Waits for events and dispatches everything that is ready. Returns the number of
+	 * handled descriptor events, expired timers and run tasks.
+	 */
+	size_t processEvents();
+
+	/**
+	 * Same, but waits for at most @p timeout. A null timeout only dispatches the events
+	 * which are ready.
+	 */
+	size_t processEvents(const Duration& timeout);
+
+	/**
+	 * Makes run() return @p code after the current event. May be called from any thread,
+	 * also before run(), which then returns right away.
+	 */
+	void quit(int code = 0);
+
+	/**
+	 * Interrupts the wait of the loop. May be called from any thread.
+	 */
+	void wakeup();
+
+	bool isRunning() const;
+
+	/**
+	 * Returns the statistics of the last iteration, which is a wait and the dispatch of
+	 * the events it returned.
+	 */
+	const Statistics& lastIteration() const;
+
+	/**
+	 * Returns the statistics summed over all iterations since the creation of the loop or
+	 * resetStatistics().
+	 */
+	const Statistics& statistics() const;
+	void resetStatistics();
+
+private:
+	// Events harvested by one epoll_wait() call
+	static const int kMaxEvents = 64;
+
+	struct Watch {
+		IoHandler handler;
+		IoEvents events;
+		u32 generation;
+		bool isActive;
+	};
+
+	int epollFd_;
+	int wakeupFd_;
+	int timerFd_;
+
+	// Watches indexed by descriptor. The generation in the epoll data tells events of a
+	// removed watch from events of a new watch of a reused descriptor.
+	std::vector<Watch> watches_;
+
+	TimerWheel timerWheel_;
+	std::vector<TimerHandler> timerHandlers_;
+	i64 armedDeadline_;
+
+	// Timer whose handler is being called, reset if the handler destroys it
+	TimerHandle runningTimer_;
+
+	TaskQueue taskQueue_;
+	std::atomic<bool> quitRequested_;
+	std::atomic<int> exitCode_;
+	bool isRunning_;
+
+	Statistics lastIteration_;
+	Statistics statistics_;
+
+	bool addToEpoll(int fd, u64 data, u32 events);
+
+	// Returns the number of handled events, waiting for at most @p timeout milliseconds
+	// or indefinitely if it's negative
+	size_t dispatch(int timeout);
+
+	// Return the number of run tasks and expired timers
+	size_t processWakeup();
+	size_t processTimers(i64 now);
+	void armTimerFd();
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_EVENTLOOP_H
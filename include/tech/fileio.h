@@ -0,0 +1,178 @@
+#ifndef TECH_FILEIO_H
+#define TECH_FILEIO_H
+
+#include <atomic>
+#include <tech/bytearray.h>
+#include <tech/duration.h>
+#include <tech/eventloop.h>
+#include <tech/flags.h>
+#include <tech/future.h>
+#include <tech/string.h>
+#include <tech/threadpool.h>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+class IoUring;
+
+
+namespace internal {
+
+
+class FileOperation;
+
+
+} // namespace internal
+
+
+enum class FileOpenFlag {
+	kRead     = 0x01,
+	kWrite    = 0x02,
+	kCreate   = 0x04,
+	kTruncate = 0x08,
+	kAppend   = 0x10
+};
+
+using FileOpenFlags = Flags<FileOpenFlag>;
+DECLARE_FLAG_OPERATORS(FileOpenFlag)
+
+
+/**
+ * Result of FileIo::open(), close() and write(): the descriptor or the number of written
+ * bytes. The error is the errno of a failed operation, or 0.
+ */
+struct FileResult {
+	int error;
+	i64 value;
+};
+
+
+/**
+ * Result of FileIo::read() and readFile(). Data is empty at the end of the file.
+ */
+struct FileData {
+	int error;
+	ByteArray data;
+};
+
+
+struct FileStatus {
+	int error;
+	u64 size;
+	u32 mode;
+
+	// Since the epoch
+	Duration modificationTime;
+};
+
+
+/**
+ * Asynchronous file operations of an event loop.
+ *
+ * Requests return futures which are completed on the thread of the loop, so continuations
+ * attached with InlineExecutor run there as well. With the io_uring backend a request is
+ * an entry in the submission ring, the completion ring signals an eventfd watched by the
+ * loop and no thread is blocked. Requests made by completion handlers are submitted
+ * together when the handlers return. Data is read directly into the storage of the
+ * returned ByteArray.
+ *
+ * If io_uring is unavailable (kernels before 5.6, seccomp filters) or the thread pool
+ * backend is requested, the blocking system calls run on @p pool and their completions
+ * are passed to the loop through the same eventfd.
+ *
+ * All methods must be called from the thread of the loop. The destructor waits for the
+ * requests in flight and completes them; futures of requests made meanwhile are broken.
+ */
+class FileIo {
+public:
+	enum class Backend {
+		kUring,
+		kThreadPool
+	};
+
+	explicit FileIo(EventLoop* loop = EventLoop::instance(),
+			ThreadPool* pool = ThreadPool::shared(), Backend backend = Backend::kUring);
+
+	FileIo(const FileIo&) = delete;
+	FileIo& operator=(const FileIo&) = delete;
+
+	~FileIo();
+
+	/**
+	 * Returns the backend actually used, which is the thread pool if io_uring isn't
+	 * available.
+	 */
+	Backend backend() const;
+
+	/**
+	 * Opens @p path, the descriptor is created with O_CLOEXEC.
+	 */
+	Future<FileResult> open(const String& path, FileOpenFlags flags, u32 mode = 0644);
+	Future<FileResult> close(int fd);
+
+	/**
+	 * Reads up to @p size bytes at @p offset, less at the end of the file.
+	 */
+	Future<FileData> read(int fd, u64 offset, size_t size);
+
+	/**
+	 * Writes @p data at @p offset. The number of written bytes may be less than the
+	 * size of @p data.
+	 */
+	Future<FileResult> write(int fd, u64 offset, const ByteArray& data);
+
+	Future<FileStatus> status(const String& path);
+
+	/**
+	 * Reads the whole file, the chain of open, status, reads and close doesn't leave the
+	 * backend.
+	 */
+	Future<FileData> readFile(const String& path);
+
+	/**
+	 * Returns the number of requests which aren't completed yet.
+	 */
+	size_t pendingCount() const;
+
+private:
+	friend class internal::FileOperation;
+
+	EventLoop* loop_;
+	ThreadPool* pool_;
+	Box<IoUring> ring_;
+	int eventFd_;
+
+	// Requests waiting for room in the rings
+	internal::FileOperation* backlogHead_;
+	internal::FileOperation* backlogTail_;
+
+	u32 inFlight_;
+	size_t pendingCount_;
+	bool isDispatching_;
+	bool isClosing_;
+
+	ThreadPool::Group group_;
+
+	// Operations completed by the pool, in reverse order
+	std::atomic<internal::FileOperation*> completed_;
+
+	// Counts the new operation as pending and submits it, or destroys it when closing
+	void start(internal::FileOperation* operation);
+
+	// Passes the operation to the backend, returns @c false when closing
+	bool submit(internal::FileOperation* operation);
+	void submitBacklog();
+	void flush();
+
+	void pushCompleted(internal::FileOperation* operation);
+	void processCompletions(int fd, IoEvents events);
+	void finish(internal::FileOperation* operation, i64 result);
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_FILEIO_H
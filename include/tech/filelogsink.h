@@ -0,0 +1,173 @@
+#ifndef TECH_FILELOGSINK_H
+#define TECH_FILELOGSINK_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <tech/duration.h>
+#include <tech/logger.h>
+#include <tech/logtimestampformatter.h>
+
+
+namespace Tech {
+
+
+/**
+ * Log message handler which writes messages to a file. Lines are encoded into large
+ * buffers and passed to the system with a single writev() call per batch, the file is
+ * opened with O_APPEND, so several processes may share it.
+ *
+ * The sink is meant to run behind AsyncLogger, which calls flush() when its queue is
+ * drained. Thus the producers never wait for the disk, including file rotation:
+ *
+ *   FileLogSink sink("app.log");
+ *   AsyncLogger logger(LogMessageHandler(&sink, &FileLogSink::write),
+ *           AsyncLogger::kDefaultCapacity, AsyncLogger::OverflowPolicy::kBlock,
+ *           Delegate<void()>(&sink, &FileLogSink::flush));
+ *
+ * When used directly as a log message handler, lines are written when the buffer is
+ * full or when flush() is called.
+ */
+class FileLogSink {
+public:
+	/**
+	 * When written data is forced to the storage device with fdatasync().
+	 */
+	enum class SyncPolicy {
+		kNever,      ///< Leave it to the system
+		kEveryFlush, ///< After every batch of lines
+		kPeriodic    ///< After a batch, if the previous sync is older than the interval
+	};
+
+	static const size_t kDefaultBufferSize = 1024 * 1024;
+
+	explicit FileLogSink(const String& fileName, size_t bufferSize = kDefaultBufferSize);
+
+	FileLogSink(const FileLogSink&) = delete;
+	FileLogSink& operator=(const FileLogSink&) = delete;
+
+	/**
+	 * Writes the buffered lines and closes the file.
+	 */
+	~FileLogSink();
+
+	String fileName() const;
+	bool isOpen() const;
+
+	/**
+	 * Returns the error code (errno) of the last failed operation or 0.
+	 */
+	int lastError() const;
+
+	/**
+	 * Rotates the file when it grows larger than @p size bytes. 0 disables size-based
+	 * rotation.
+	 */
+	void setMaxFileSize(u64 size);
+
+	/**
+	 * Rotates the file when it has been open longer than @p interval. Null duration
+	 * disables time-based rotation.
+	 */
+	void setRotationInterval(const Duration& interval);
+
+	/**
+	 * Number of rotated files to keep: "app.log.1" is the newest, "app.log.N" the oldest.
+	 * With 0 the file is truncated on rotation.
+	 */
+	void setMaxBackupCount(int count);
+
+	void setSyncPolicy(SyncPolicy policy, const Duration& interval = Duration::second());
+
+	/**
+	 * Selects the clock for the timestamps of the lines. The coarse clock is cheaper to
+	 * read, but has a resolution of a few milliseconds.
+	 */
+	void setTimestampClock(LogTimestampFormatter::Clock clock);
+
+	/**
+	 * Representation of structured records written by writeRecord(), kText by default.
+	 */
+	void setRecordFormat(LogFieldFormat format);
+
+	/**
+	 * Encodes the message as "2016-05-17 14:03:12.345 [info] window.cpp:42: message" and
+	 * puts it into the buffer. The function has LogMessageHandler signature.
+	 */
+	void write(LogLevel level, const String& file, int line, const String& message);
+
+	/**
+	 * Renders the structured record after the same prefix as write(). The function has
+	 * LogRecordHandler signature, so it can be set as the record handler of AsyncLogger.
+	 */
+	void writeRecord(LogLevel level, const String& file, int line, const char* message,
+			const LogFields& fields);
+
+	/**
+	 * Writes all buffered lines to the file and applies the sync policy.
+	 */
+	void flush();
+
+	/**
+	 * Closes the current file, renames it to a backup and opens a new one.
+	 */
+	void rotate();
+
+	u64 linesWritten() const;
+	u64 bytesWritten() const;
+
+private:
+	static const size_t kChunkSize = 64 * 1024;
+	static const size_t kMaxChunkCount = 64;
+
+	struct Chunk {
+		std::vector<char> data;
+		size_t size;
+	};
+
+	mutable std::mutex mutex_;
+	LogTimestampFormatter timestamp_;
+	String fileName_;
+	std::string path_;
+	int fd_;
+	int lastError_;
+
+	u64 maxFileSize_;
+	i64 rotationInterval_;
+	int maxBackupCount_;
+	SyncPolicy syncPolicy_;
+	i64 syncInterval_;
+	LogFieldFormat recordFormat_;
+	std::string recordBuffer_;
+
+	// Lines are appended to the chunks in order, all filled chunks are written at once
+	std::vector<Chunk> chunks_;
+	size_t currentChunk_;
+	size_t pendingSize_;
+	u64 pendingLines_;
+
+	u64 fileSize_;
+	i64 rotationTime_;
+	i64 lastSyncTime_;
+	u64 linesWritten_;
+	u64 bytesWritten_;
+
+	void open(i64 now);
+	void close();
+	void renameBackups();
+	std::string backupPath(int index) const;
+	char* writePrefix(char* pos, const char* timestamp, LogLevel level, const String& file,
+			int line);
+	char* reserve(size_t size);
+	void commit(size_t size);
+	void writeBuffers();
+	void sync();
+	bool isRotationNeeded(i64 now, size_t lineSize) const;
+	void doRotate(i64 now);
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_FILELOGSINK_H
@@ -54,6 +54,8 @@ public:
 	constexpr Flags(const Flags& other);
 	constexpr Flags(T flag);
 
+	Flags& operator=(const Flags& other) = default;
+
 	constexpr operator bool() const;
 
 	constexpr bool operator!() const;
@@ -149,7 +151,7 @@ constexpr bool Flags<T>::operator!=(T flag) const
 template<typename T>
 constexpr Flags<T> Flags<T>::operator&(Flags<T> mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result &= mask;
 	return result;
 }
@@ -158,7 +160,7 @@ constexpr Flags<T> Flags<T>::operator&(Flags<T> mask) const
 template<typename T>
 constexpr Flags<T> Flags<T>::operator&(T mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result &= mask;
 	return result;
 }
@@ -183,7 +185,7 @@ Flags<T>& Flags<T>::operator&=(T mask)
 template<typename T>
 constexpr Flags<T> Flags<T>::operator|(Flags<T> mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result |= mask;
 	return result;
 }
@@ -192,7 +194,7 @@ constexpr Flags<T> Flags<T>::operator|(Flags<T> mask) const
 template<typename T>
 constexpr Flags<T> Flags<T>::operator|(T mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result |= mask;
 	return result;
 }
@@ -217,7 +219,7 @@ Flags<T>& Flags<T>::operator|=(T mask)
 template<typename T>
 constexpr Flags<T> Flags<T>::operator^(Flags<T> mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result ^= mask;
 	return result;
 }
@@ -226,7 +228,7 @@ constexpr Flags<T> Flags<T>::operator^(Flags<T> mask) const
 template<typename T>
 constexpr Flags<T> Flags<T>::operator^(T mask) const
 {
-	Flags<T> result;
+	Flags<T> result(*this);
 	result ^= mask;
 	return result;
 }
@@ -0,0 +1,919 @@
+#ifndef TECH_FUTURE_H
+#define TECH_FUTURE_H
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tech/semaphore.h>
+#include <tech/taskqueue.h>
+#include <tech/threadpool.h>
+#include <tech/traits.h>
+#include <tech/types.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+template<typename T>
+class Future;
+
+template<typename T>
+class Promise;
+
+
+/**
+ * Executor which runs continuations on the thread which completes the future, or on the
+ * thread which calls Future::then() if the future is already complete.
+ */
+class InlineExecutor {};
+
+
+/**
+ * Executors which run continuations: inline, on a ThreadPool or on the thread of a
+ * TaskQueue (e.g. WindowSystem::taskQueue() for the UI thread). Other executors are
+ * supported by overloads of execute() found by argument-dependent lookup. The executor
+ * must run @p function exactly once or destroy it without running.
+ */
+template<typename F>
+void execute(InlineExecutor executor, F&& function);
+
+template<typename F>
+void execute(ThreadPool* pool, F&& function);
+
+template<typename F>
+void execute(TaskQueue* queue, F&& function);
+
+
+namespace internal {
+
+
+struct FutureUnit {};
+
+template<typename T>
+using FutureValue = Conditional<std::is_void<T>, FutureUnit, T>;
+
+
+/**
+ * Callback run once when the shared state completes, with a value or broken. The
+ * callback manages its own lifetime.
+ */
+class FutureCallback {
+public:
+	virtual ~FutureCallback() = default;
+	virtual void invoke() = 0;
+
+private:
+	friend class FutureStateBase;
+
+	FutureCallback* next_ = nullptr;
+};
+
+
+/**
+ * Completion part of the shared state. Callbacks are kept in a lock-free list, which is
+ * replaced by a marker when the state completes, so neither completion nor addition of
+ * a callback takes a lock.
+ */
+class FutureStateBase {
+public:
+	FutureStateBase();
+
+	FutureStateBase(const FutureStateBase&) = delete;
+	FutureStateBase& operator=(const FutureStateBase&) = delete;
+
+	bool isReady() const;
+
+	/**
+	 * Returns @c false if the promise was destroyed without a value. Valid only when
+	 * isReady() returns @c true.
+	 */
+	bool hasValue() const;
+
+	/**
+	 * Runs @p callback when the state completes, or right away if it's already complete.
+	 */
+	void addCallback(FutureCallback* callback);
+
+	void wait();
+
+protected:
+	void complete(bool hasValue);
+
+private:
+	std::atomic<FutureCallback*> callbacks_;
+	bool hasValue_;
+
+	// The list head of a complete state, never a valid callback address
+	FutureCallback* completedMarker() const;
+};
+
+
+/**
+ * Shared state of a promise and its future, the only allocation per promise.
+ */
+template<typename T>
+class FutureState final : public FutureStateBase {
+public:
+	FutureState();
+	~FutureState();
+
+	void addRef();
+	void release();
+
+	template<typename ...Args>
+	void setValue(Args&&... args);
+
+	void breakPromise();
+
+	FutureValue<T>& value();
+
+private:
+	std::atomic<int> refs_;
+	typename std::aligned_storage<sizeof(FutureValue<T>), alignof(FutureValue<T>)>::type
+			storage_;
+};
+
+
+template<typename F, typename T>
+struct ContinuationResult {
+	using Type = typename std::result_of<F&(T&&)>::type;
+};
+
+template<typename F>
+struct ContinuationResult<F, void> {
+	using Type = typename std::result_of<F&()>::type;
+};
+
+
+template<typename E, typename F, typename T>
+class ThenCallback;
+
+
+template<typename F>
+class ExecutorTask final : public TaskQueue::Task {
+public:
+	template<typename G>
+	explicit ExecutorTask(G&& function) :
+		function_(std::forward<G>(function))
+	{
+	}
+
+	void run() override
+	{
+		function_();
+	}
+
+private:
+	F function_;
+};
+
+
+template<typename T>
+class PromiseBase {
+public:
+	PromiseBase();
+	PromiseBase(PromiseBase&& other);
+	PromiseBase& operator=(PromiseBase&& other);
+
+	/**
+	 * Completes the future as broken if no value was set.
+	 */
+	~PromiseBase();
+
+	/**
+	 * Returns the future of the promise, may be called once.
+	 */
+	Future<T> future();
+
+protected:
+	FutureState<T>* state_;
+};
+
+
+template<typename T>
+class WhenAllState;
+
+template<typename T>
+class WhenAnyState;
+
+
+} // namespace internal
+
+
+/**
+ * Result of whenAny(): the index of the first complete future, or size_t(-1) for an
+ * empty set, and all the futures.
+ */
+template<typename T>
+struct WhenAnyResult {
+	size_t index;
+	std::vector<Future<T>> futures;
+};
+
+
+/**
+ * Result of an asynchronous operation which is produced by a Promise.
+ *
+ * A continuation attached with then() runs on the given executor when the value is set,
+ * and receives the value by rvalue reference. then() returns the future of the
+ * continuation's result, so the work is chained without blocking any thread:
+ *
+ * decodeImage(data)                                 // Future<Image> from a ThreadPool
+ *     .then(windowSystem->taskQueue(), [view](Image&& image) {
+ *         view->setImage(image);
+ *     });
+ *
+ * If the promise is destroyed without a value, the future completes as broken: the
+ * continuation isn't called and the future it returned is broken as well. The future is
+ * move-only and its continuation is attached once.
+ */
+template<typename T>
+class Future {
+public:
+	/**
+	 * Creates an invalid future without a state.
+	 */
+	Future();
+
+	Future(Future&& other);
+	Future& operator=(Future&& other);
+	~Future();
+
+	bool isValid() const;
+
+	/**
+	 * Returns @c true if the value was set or the promise was broken.
+	 */
+	bool isReady() const;
+
+	bool isBroken() const;
+
+	/**
+	 * Blocks the calling thread until the future is ready.
+	 */
+	void wait() const;
+
+	/**
+	 * Waits for the future and returns its value. The future must not be broken.
+	 */
+	template<typename T1 = T, EnableIf<Not<std::is_void<T1>>>...>
+	T1& get();
+
+	template<typename T1 = T, EnableIf<std::is_void<T1>>...>
+	void get();
+
+	/**
+	 * Runs @p function with the value on @p executor when the future is ready and
+	 * returns the future of its result. The future becomes invalid.
+	 */
+	template<typename E, typename F>
+	Future<typename internal::ContinuationResult<typename std::decay<F>::type, T>::Type>
+	then(E executor, F&& function);
+
+	/**
+	 * Runs @p function with InlineExecutor.
+	 */
+	template<typename F>
+	Future<typename internal::ContinuationResult<typename std::decay<F>::type, T>::Type>
+	then(F&& function);
+
+private:
+	template<typename U>
+	friend class internal::PromiseBase;
+
+	template<typename U>
+	friend Future<std::vector<Future<U>>> whenAll(std::vector<Future<U>> futures);
+
+	template<typename U>
+	friend Future<WhenAnyResult<U>> whenAny(std::vector<Future<U>> futures);
+
+	internal::FutureState<T>* state_;
+
+	explicit Future(internal::FutureState<T>* state);
+};
+
+
+/**
+ * Producer side of a Future. The value is set once, from any thread.
+ */
+template<typename T>
+class Promise : public internal::PromiseBase<T> {
+public:
+	/**
+	 * Constructs the value from @p args and runs the continuation.
+	 */
+	template<typename ...Args>
+	void setValue(Args&&... args);
+};
+
+
+template<>
+class Promise<void> : public internal::PromiseBase<void> {
+public:
+	void setValue();
+};
+
+
+/**
+ * Returns the future which completes when all @p futures are ready (with a value or
+ * broken) and holds them.
+ */
+template<typename T>
+Future<std::vector<Future<T>>> whenAll(std::vector<Future<T>> futures);
+
+/**
+ * Returns the future which completes when any of @p futures is ready and holds all of
+ * them with the index of the first one.
+ */
+template<typename T>
+Future<WhenAnyResult<T>> whenAny(std::vector<Future<T>> futures);
+
+
+template<typename F>
+void execute(InlineExecutor executor, F&& function)
+{
+	UNUSED(executor);
+	function();
+}
+
+
+template<typename F>
+void execute(ThreadPool* pool, F&& function)
+{
+	pool->submit(std::forward<F>(function));
+}
+
+
+template<typename F>
+void execute(TaskQueue* queue, F&& function)
+{
+	queue->post<internal::ExecutorTask<typename std::decay<F>::type>>(
+			std::forward<F>(function));
+}
+
+
+namespace internal {
+
+
+inline
+FutureStateBase::FutureStateBase() :
+	callbacks_(nullptr),
+	hasValue_(false)
+{
+}
+
+
+inline
+bool FutureStateBase::isReady() const
+{
+	return callbacks_.load(std::memory_order_acquire) == completedMarker();
+}
+
+
+inline
+bool FutureStateBase::hasValue() const
+{
+	return hasValue_;
+}
+
+
+inline
+void FutureStateBase::addCallback(FutureCallback* callback)
+{
+	FutureCallback* head = callbacks_.load(std::memory_order_acquire);
+
+	do {
+		if(head == completedMarker()) {
+			callback->invoke();
+			return;
+		}
+
+		callback->next_ = head;
+	} while(!callbacks_.compare_exchange_weak(head, callback, std::memory_order_release,
+			std::memory_order_acquire));
+}
+
+
+inline
+void FutureStateBase::wait()
+{
+	if(isReady())
+		return;
+
+	class WaitCallback final : public FutureCallback {
+	public:
+		void invoke() override
+		{
+			semaphore.post();
+		}
+
+		Semaphore semaphore;
+	};
+
+	WaitCallback callback;
+	addCallback(&callback);
+	callback.semaphore.wait();
+}
+
+
+inline
+void FutureStateBase::complete(bool hasValue)
+{
+	hasValue_ = hasValue;
+	FutureCallback* callback = callbacks_.exchange(completedMarker(),
+			std::memory_order_acq_rel);
+
+	// Callbacks are added to the front of the list, run them in the order of addition
+	FutureCallback* ordered = nullptr;
+
+	while(callback) {
+		FutureCallback* next = callback->next_;
+		callback->next_ = ordered;
+		ordered = callback;
+		callback = next;
+	}
+
+	// A callback may destroy itself, so the next one is taken before the call
+	while(ordered) {
+		FutureCallback* next = ordered->next_;
+		ordered->invoke();
+		ordered = next;
+	}
+}
+
+
+inline
+FutureCallback* FutureStateBase::completedMarker() const
+{
+	return reinterpret_cast<FutureCallback*>(const_cast<FutureStateBase*>(this));
+}
+
+
+template<typename T>
+FutureState<T>::FutureState() :
+	refs_(1)
+{
+}
+
+
+template<typename T>
+FutureState<T>::~FutureState()
+{
+	if(isReady() && hasValue())
+		value().~FutureValue<T>();
+}
+
+
+template<typename T>
+void FutureState<T>::addRef()
+{
+	refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+template<typename T>
+void FutureState<T>::release()
+{
+	if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete this;
+}
+
+
+template<typename T>
+template<typename ...Args>
+void FutureState<T>::setValue(Args&&... args)
+{
+	new(&storage_) FutureValue<T>(std::forward<Args>(args)...);
+	complete(true);
+}
+
+
+template<typename T>
+void FutureState<T>::breakPromise()
+{
+	complete(false);
+}
+
+
+template<typename T>
+FutureValue<T>& FutureState<T>::value()
+{
+	return *reinterpret_cast<FutureValue<T>*>(&storage_);
+}
+
+
+/**
+ * Continuation attached by Future::then(). Owns the reference to the source state and
+ * the promise of the result, and is passed to the executor as a task when the source
+ * completes with a value. If the source is broken or the executor destroys the task
+ * without running it, the promise is destroyed unset and the result is broken.
+ */
+template<typename E, typename F, typename T>
+class ThenCallback final : public FutureCallback {
+public:
+	using ResultType = typename ContinuationResult<F, T>::Type;
+
+	template<typename G>
+	ThenCallback(const E& executor, G&& function, FutureState<T>* state,
+			Promise<ResultType>&& promise) :
+		executor_(executor),
+		function_(std::forward<G>(function)),
+		state_(state),
+		promise_(std::move(promise))
+	{
+	}
+
+	~ThenCallback() override
+	{
+		state_->release();
+	}
+
+	void invoke() override
+	{
+		Box<ThenCallback> self(this);
+
+		if(state_->hasValue())
+			execute(executor_, Runner(std::move(self)));
+	}
+
+private:
+	class Runner {
+	public:
+		explicit Runner(Box<ThenCallback> callback) :
+			callback_(std::move(callback))
+		{
+		}
+
+		void operator()()
+		{
+			callback_->run(std::is_void<ResultType>(), std::is_void<T>());
+		}
+
+	private:
+		Box<ThenCallback> callback_;
+	};
+
+	E executor_;
+	F function_;
+	FutureState<T>* state_;
+	Promise<ResultType> promise_;
+
+	void run(std::false_type, std::false_type)
+	{
+		promise_.setValue(function_(std::move(state_->value())));
+	}
+
+	void run(std::true_type, std::false_type)
+	{
+		function_(std::move(state_->value()));
+		promise_.setValue();
+	}
+
+	void run(std::false_type, std::true_type)
+	{
+		promise_.setValue(function_());
+	}
+
+	void run(std::true_type, std::true_type)
+	{
+		function_();
+		promise_.setValue();
+	}
+};
+
+
+template<typename T>
+PromiseBase<T>::PromiseBase() :
+	state_(new FutureState<T>())
+{
+}
+
+
+template<typename T>
+PromiseBase<T>::PromiseBase(PromiseBase&& other) :
+	state_(other.state_)
+{
+	other.state_ = nullptr;
+}
+
+
+template<typename T>
+PromiseBase<T>& PromiseBase<T>::operator=(PromiseBase&& other)
+{
+	if(this != &other) {
+		if(state_) {
+			if(!state_->isReady())
+				state_->breakPromise();
+
+			state_->release();
+		}
+
+		state_ = other.state_;
+		other.state_ = nullptr;
+	}
+
+	return *this;
+}
+
+
+template<typename T>
+PromiseBase<T>::~PromiseBase()
+{
+	if(state_) {
+		if(!state_->isReady())
+			state_->breakPromise();
+
+		state_->release();
+		state_ = nullptr;
+	}
+}
+
+
+template<typename T>
+Future<T> PromiseBase<T>::future()
+{
+	state_->addRef();
+	return Future<T>(state_);
+}
+
+
+// Completes the promise when all registered callbacks have fired and the registration
+// is over
+template<typename T>
+class WhenAllState {
+public:
+	explicit WhenAllState(std::vector<Future<T>>&& futures) :
+		remaining(futures.size() + 1),
+		futures(std::move(futures))
+	{
+	}
+
+	void release()
+	{
+		if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			promise.setValue(std::move(futures));
+	}
+
+	std::atomic<size_t> remaining;
+	std::vector<Future<T>> futures;
+	Promise<std::vector<Future<T>>> promise;
+};
+
+
+// The first callback wins, the promise is completed when both the winner and the
+// registration are done
+template<typename T>
+class WhenAnyState {
+public:
+	explicit WhenAnyState(std::vector<Future<T>>&& futures) :
+		index(size_t(-1)),
+		gate(2),
+		futures(std::move(futures))
+	{
+	}
+
+	void win(size_t winner)
+	{
+		size_t expected = size_t(-1);
+		if(index.compare_exchange_strong(expected, winner, std::memory_order_acq_rel))
+			release();
+	}
+
+	void release()
+	{
+		if(gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			promise.setValue(WhenAnyResult<T>{index.load(), std::move(futures)});
+	}
+
+	std::atomic<size_t> index;
+	std::atomic<int> gate;
+	std::vector<Future<T>> futures;
+	Promise<WhenAnyResult<T>> promise;
+};
+
+
+template<typename S>
+class WhenCallback final : public FutureCallback {
+public:
+	WhenCallback(const Arc<S>& state, size_t index) :
+		state_(state),
+		index_(index)
+	{
+	}
+
+	void invoke() override;
+
+private:
+	Arc<S> state_;
+	size_t index_;
+};
+
+
+template<typename T>
+void invokeWhenCallback(WhenAllState<T>* state, size_t index)
+{
+	UNUSED(index);
+	state->release();
+}
+
+
+template<typename T>
+void invokeWhenCallback(WhenAnyState<T>* state, size_t index)
+{
+	state->win(index);
+}
+
+
+template<typename S>
+void WhenCallback<S>::invoke()
+{
+	invokeWhenCallback(state_.get(), index_);
+	delete this;
+}
+
+
+} // namespace internal
+
+
+template<typename T>
+Future<T>::Future() :
+	state_(nullptr)
+{
+}
+
+
+template<typename T>
+Future<T>::Future(internal::FutureState<T>* state) :
+	state_(state)
+{
+}
+
+
+template<typename T>
+Future<T>::Future(Future&& other) :
+	state_(other.state_)
+{
+	other.state_ = nullptr;
+}
+
+
+template<typename T>
+Future<T>& Future<T>::operator=(Future&& other)
+{
+	if(this != &other) {
+		if(state_)
+			state_->release();
+
+		state_ = other.state_;
+		other.state_ = nullptr;
+	}
+
+	return *this;
+}
+
+
+template<typename T>
+Future<T>::~Future()
+{
+	if(state_)
+		state_->release();
+}
+
+
+template<typename T>
+bool Future<T>::isValid() const
+{
+	return state_ != nullptr;
+}
+
+
+template<typename T>
+bool Future<T>::isReady() const
+{
+	return state_->isReady();
+}
+
+
+template<typename T>
+bool Future<T>::isBroken() const
+{
+	return state_->isReady() && !state_->hasValue();
+}
+
+
+template<typename T>
+void Future<T>::wait() const
+{
+	state_->wait();
+}
+
+
+template<typename T>
+template<typename T1, EnableIf<Not<std::is_void<T1>>>...>
+T1& Future<T>::get()
+{
+	state_->wait();
+	return state_->value();
+}
+
+
+template<typename T>
+template<typename T1, EnableIf<std::is_void<T1>>...>
+void Future<T>::get()
+{
+	state_->wait();
+}
+
+
+template<typename T>
+template<typename E, typename F>
+Future<typename internal::ContinuationResult<typename std::decay<F>::type, T>::Type>
+Future<T>::then(E executor, F&& function)
+{
+	using Callback = internal::ThenCallback<E, typename std::decay<F>::type, T>;
+	using ResultType = typename Callback::ResultType;
+
+	Promise<ResultType> promise;
+	Future<ResultType> result = promise.future();
+
+	// The callback takes over the reference to the state
+	internal::FutureState<T>* state = state_;
+	state_ = nullptr;
+	state->addCallback(new Callback(executor, std::forward<F>(function), state,
+			std::move(promise)));
+
+	return result;
+}
+
+
+template<typename T>
+template<typename F>
+Future<typename internal::ContinuationResult<typename std::decay<F>::type, T>::Type>
+Future<T>::then(F&& function)
+{
+	return then(InlineExecutor(), std::forward<F>(function));
+}
+
+
+template<typename T>
+template<typename ...Args>
+void Promise<T>::setValue(Args&&... args)
+{
+	this->state_->setValue(std::forward<Args>(args)...);
+}
+
+
+inline
+void Promise<void>::setValue()
+{
+	state_->setValue();
+}
+
+
+template<typename T>
+Future<std::vector<Future<T>>> whenAll(std::vector<Future<T>> futures)
+{
+	using State = internal::WhenAllState<T>;
+
+	size_t count = futures.size();
+	Arc<State> state = makeArc<State>(std::move(futures));
+	Future<std::vector<Future<T>>> result = state->promise.future();
+
+	// The state can't complete before the final release(), so the vector stays in place
+	for(size_t i = 0; i < count; ++i)
+		state->futures[i].state_->addCallback(new internal::WhenCallback<State>(state, i));
+
+	state->release();
+	return result;
+}
+
+
+template<typename T>
+Future<WhenAnyResult<T>> whenAny(std::vector<Future<T>> futures)
+{
+	using State = internal::WhenAnyState<T>;
+
+	size_t count = futures.size();
+	Arc<State> state = makeArc<State>(std::move(futures));
+	Future<WhenAnyResult<T>> result = state->promise.future();
+
+	if(count == 0) {
+		state->promise.setValue(WhenAnyResult<T>{size_t(-1), std::move(state->futures)});
+		return result;
+	}
+
+	for(size_t i = 0; i < count; ++i)
+		state->futures[i].state_->addCallback(new internal::WhenCallback<State>(state, i));
+
+	state->release();
+	return result;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_FUTURE_H
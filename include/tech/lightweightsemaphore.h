@@ -0,0 +1,101 @@
+#ifndef TECH_LIGHTWEIGHTSEMAPHORE_H
+#define TECH_LIGHTWEIGHTSEMAPHORE_H
+
+#include <atomic>
+#include <chrono>
+#include <tech/duration.h>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Counting semaphore with the interface of Semaphore, built on an atomic counter.
+ *
+ * post() and a wait() which finds the counter positive are a single atomic operation.
+ * A waiter spins for a short while, then registers itself by making the counter negative
+ * and parks on a futex (a condition variable on platforms without futexes). post() which
+ * finds the counter negative hands a wakeup to exactly one registered waiter, so a system
+ * call is made once per parked waiter, not once per post.
+ *
+ * Unlike Semaphore, post() accesses the object after the counter is incremented, so a
+ * waiter may not destroy the semaphore right after wait() returns while post() may still
+ * be running.
+ */
+class LightweightSemaphore {
+public:
+	explicit LightweightSemaphore(size_t count = 0);
+
+	LightweightSemaphore(const LightweightSemaphore&) = delete;
+	LightweightSemaphore& operator=(const LightweightSemaphore&) = delete;
+
+	void post();
+
+	/**
+	 * Decrements the counter if it's positive, never blocks.
+	 */
+	bool tryWait();
+
+	/**
+	 * Waits for the counter to become positive for at most @p duration, or without a
+	 * time limit if it's null. Returns @c false on timeout.
+	 */
+	bool wait(const Duration& duration = Duration());
+
+	/**
+	 * Waits until @p timestamp, the time since the Epoch as returned by
+	 * Duration::fromEpoch().
+	 */
+	bool waitUntil(const Duration& timestamp);
+
+private:
+	// Negative while threads are registered as waiters
+	std::atomic<i32> count_;
+
+	// Wakeups handed over to registered waiters, the futex word
+	std::atomic<u32> wakeups_;
+
+	// Registers the calling thread as a waiter and parks it until a wakeup is handed over
+	// or @p deadline (if not null) passes
+	bool park(const std::chrono::steady_clock::time_point* deadline);
+	bool takeWakeup();
+	void wake();
+};
+
+
+inline
+LightweightSemaphore::LightweightSemaphore(size_t count) :
+	count_(static_cast<i32>(count)),
+	wakeups_(0)
+{
+}
+
+
+inline
+void LightweightSemaphore::post()
+{
+	if(count_.fetch_add(1, std::memory_order_release) < 0)
+		wake();
+}
+
+
+inline
+bool LightweightSemaphore::tryWait()
+{
+	i32 count = count_.load(std::memory_order_relaxed);
+
+	while(count > 0) {
+		if(count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire,
+				std::memory_order_relaxed))
+			return true;
+	}
+
+	return false;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_LIGHTWEIGHTSEMAPHORE_H
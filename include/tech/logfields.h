@@ -0,0 +1,197 @@
+#ifndef TECH_LOGFIELDS_H
+#define TECH_LOGFIELDS_H
+
+#include <string>
+#include <type_traits>
+#include <tech/duration.h>
+#include <tech/string.h>
+#include <tech/traits.h>
+
+
+namespace Tech {
+
+
+/**
+ * Types of the values of structured log fields. Boolean values are stored in the type.
+ */
+enum class LogFieldType : u8 {
+	kFalse,
+	kTrue,
+	kInt,
+	kUInt,
+	kDouble,
+	kString,
+	kDuration
+};
+
+
+/**
+ * Representation of a rendered structured record.
+ */
+enum class LogFieldFormat {
+	kText, ///< message id=42 widget=button elapsed=16ms
+	kJson  ///< {"message":"message","id":42,"widget":"button","elapsed":16}
+};
+
+
+/**
+ * Fields of a structured log record in the compact binary encoding. Every field is
+ * stored as the type byte, the key length byte, the key in UTF-8 and the value:
+ * integers and durations (in milliseconds) are variable-length integers, signed ones in
+ * the zigzag encoding, doubles take 8 bytes and strings are stored as the length and
+ * UTF-8 bytes. The encoding doesn't contain pointers, so the fields may be copied
+ * between threads and processes as plain bytes.
+ *
+ * The class doesn't own the data, see LogFieldWriter.
+ */
+class LogFields {
+public:
+	constexpr LogFields() :
+		data_(nullptr),
+		size_(0)
+	{
+	}
+
+	constexpr LogFields(const u8* data, size_t size) :
+		data_(data),
+		size_(size)
+	{
+	}
+
+	const u8* data() const;
+	size_t size() const;
+	bool isEmpty() const;
+
+private:
+	const u8* data_;
+	size_t size_;
+};
+
+
+/**
+ * Encodes the fields into a buffer, which is placed on the stack unless the fields are
+ * larger than kInlineCapacity bytes. Keys longer than 255 bytes are truncated.
+ */
+class LogFieldWriter {
+public:
+	static const size_t kInlineCapacity = 256;
+
+	LogFieldWriter();
+	LogFieldWriter(const LogFieldWriter&) = delete;
+	LogFieldWriter& operator=(const LogFieldWriter&) = delete;
+	~LogFieldWriter();
+
+	void add(const char* key, bool value);
+	void add(const char* key, double value);
+	void add(const char* key, const char* value);
+	void add(const char* key, const String& value);
+	void add(const char* key, const Duration& value);
+
+	template<typename T, EnableIf<
+			std::is_integral<T>,
+			Not<std::is_same<T, bool>>>...>
+	void add(const char* key, T value);
+
+	LogFields fields() const;
+
+private:
+	u8* data_;
+	size_t size_;
+	size_t capacity_;
+	u8 inline_[kInlineCapacity];
+
+	void addInt(const char* key, i64 value);
+	void addUInt(const char* key, u64 value);
+	void addKey(LogFieldType type, const char* key, size_t valueSize);
+	void addVarint(u64 value);
+	void reserve(size_t size);
+};
+
+
+/**
+ * Decodes the fields one by one:
+ *
+ *   LogFieldReader reader(fields);
+ *
+ *   while(reader.next()) {
+ *       if(reader.type() == LogFieldType::kInt)
+ *           ...
+ *   }
+ *
+ * Value accessors must match the type of the current field.
+ */
+class LogFieldReader {
+public:
+	explicit LogFieldReader(const LogFields& fields);
+
+	/**
+	 * Moves to the next field. Returns @c false at the end of the data or if the data is
+	 * malformed.
+	 */
+	bool next();
+
+	LogFieldType type() const;
+
+	/**
+	 * Key in UTF-8, not null-terminated.
+	 */
+	const char* key() const;
+	size_t keyLength() const;
+
+	bool toBool() const;
+	i64 toInt() const;
+	u64 toUInt() const;
+	double toDouble() const;
+	Duration toDuration() const;
+
+	/**
+	 * String value in UTF-8, not null-terminated.
+	 */
+	const char* string() const;
+	size_t stringLength() const;
+
+private:
+	const u8* pos_;
+	const u8* end_;
+	LogFieldType type_;
+	const char* key_;
+	size_t keyLength_;
+	const char* string_;
+
+	union {
+		i64 int_;
+		u64 uint_;
+		double double_;
+	};
+
+	bool readVarint(u64* value);
+};
+
+
+/**
+ * Appends the message and the fields in UTF-8 to @p result.
+ */
+void renderLogRecord(LogFieldFormat format, const char* message, const LogFields& fields,
+		std::string* result);
+
+String formatLogRecord(LogFieldFormat format, const char* message, const LogFields& fields);
+
+
+template<typename T, EnableIf<
+		std::is_integral<T>,
+		Not<std::is_same<T, bool>>>...>
+void LogFieldWriter::add(const char* key, T value)
+{
+	if(std::is_signed<T>::value) {
+		addInt(key, static_cast<i64>(value));
+	}
+	else {
+		addUInt(key, static_cast<u64>(value));
+	}
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_LOGFIELDS_H
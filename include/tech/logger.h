@@ -1,29 +1,424 @@
 #ifndef TECH_LOGGER_H
 #define TECH_LOGGER_H
 
+#include <atomic>
+#include <new>
+#include <utility>
 #include <tech/delegate.h>
 #include <tech/format.h>
+#include <tech/logfields.h>
+#include <tech/traits.h>
 #include <tech/utils.h>
 
 
-#define LOG(format, ...) Tech::logMessage(__FILENAME__, __LINE__, format, ##__VA_ARGS__)
+// Severity levels for the compile-time filter
+#define TECH_LOG_LEVEL_TRACE   0
+#define TECH_LOG_LEVEL_DEBUG   1
+#define TECH_LOG_LEVEL_INFO    2
+#define TECH_LOG_LEVEL_WARNING 3
+#define TECH_LOG_LEVEL_ERROR   4
+
+// Messages below this level are removed at compile time, their arguments are never
+// compiled or evaluated
+#ifndef TECH_MIN_LOG_LEVEL
+#define TECH_MIN_LOG_LEVEL TECH_LOG_LEVEL_TRACE
+#endif
+
+// Name of the module used for runtime thresholds, see setModuleLogLevel(). Should be
+// defined before including this header (e.g. by the build system for a whole library).
+#ifndef TECH_LOG_MODULE
+#define TECH_LOG_MODULE ""
+#endif
+
+// Every call site has a static LogSite which caches whether the level is enabled, so a
+// disabled message costs two relaxed loads and doesn't evaluate its arguments. The
+// format must be a string literal, so the message can be formatted later on another
+// thread (see setDeferredLogSink()).
+#define TECH_LOG_IF(level, condition, format, ...)                                     \
+	do {                                                                               \
+		static Tech::LogSite logSite_(__FILE__, TECH_LOG_MODULE, level);               \
+		if((level) >= Tech::kMinLogLevel && logSite_.isEnabled() && (condition))       \
+			Tech::internal::logLiteral(level, __FILENAME__, __LINE__, "" format,       \
+					##__VA_ARGS__);                                                    \
+	} while(false)
+
+#define TECH_LOG_DISABLED() static_cast<void>(0)
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_TRACE
+#define LOG_TRACE(format, ...) TECH_LOG_IF(Tech::LogLevel::kTrace, true, format, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(format, ...) TECH_LOG_DISABLED()
+#endif
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) TECH_LOG_IF(Tech::LogLevel::kDebug, true, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) TECH_LOG_DISABLED()
+#endif
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) TECH_LOG_IF(Tech::LogLevel::kInfo, true, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) TECH_LOG_DISABLED()
+#endif
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_WARNING
+#define LOG_WARNING(format, ...) \
+		TECH_LOG_IF(Tech::LogLevel::kWarning, true, format, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(format, ...) TECH_LOG_DISABLED()
+#endif
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) TECH_LOG_IF(Tech::LogLevel::kError, true, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) TECH_LOG_DISABLED()
+#endif
+
+#define LOG(format, ...) LOG_INFO(format, ##__VA_ARGS__)
+
+// Rate limited messages for hot loops. LOG_EVERY_N writes the first of every n enabled
+// messages, LOG_EVERY_MS writes at most one message per interval of milliseconds.
+#define LOG_EVERY_N(level, n, format, ...) \
+		TECH_LOG_IF(level, logSite_.everyN(n), format, ##__VA_ARGS__)
+
+#define LOG_EVERY_MS(level, milliseconds, format, ...) \
+		TECH_LOG_IF(level, logSite_.atMostEvery(milliseconds), format, ##__VA_ARGS__)
+
+// Structured messages: the message is followed by key-value pairs, which are encoded
+// into LogFields and rendered by the backend, e.g.
+//
+//   LOG_KV("frame rendered", "layers", layerCount, "elapsed", elapsed);
+#define TECH_LOG_KV_IF(level, condition, message, ...)                              \
+	do {                                                                            \
+		static Tech::LogSite logSite_(__FILE__, TECH_LOG_MODULE, level);            \
+		if((level) >= Tech::kMinLogLevel && logSite_.isEnabled() && (condition))    \
+			Tech::logFields(level, __FILENAME__, __LINE__, message, ##__VA_ARGS__); \
+	} while(false)
+
+#define LOG_KV_AT(level, message, ...) TECH_LOG_KV_IF(level, true, message, ##__VA_ARGS__)
+
+#define LOG_KV_EVERY_N(level, n, message, ...) \
+		TECH_LOG_KV_IF(level, logSite_.everyN(n), message, ##__VA_ARGS__)
+
+#if TECH_MIN_LOG_LEVEL <= TECH_LOG_LEVEL_INFO
+#define LOG_KV(message, ...) LOG_KV_AT(Tech::LogLevel::kInfo, message, ##__VA_ARGS__)
+#else
+#define LOG_KV(message, ...) TECH_LOG_DISABLED()
+#endif
 
 
 namespace Tech {
 
 
-using LogMessageHandler =
-		Delegate<void(const String& file, int line, const String& message)>;
+enum class LogLevel {
+	kTrace   = TECH_LOG_LEVEL_TRACE,
+	kDebug   = TECH_LOG_LEVEL_DEBUG,
+	kInfo    = TECH_LOG_LEVEL_INFO,
+	kWarning = TECH_LOG_LEVEL_WARNING,
+	kError   = TECH_LOG_LEVEL_ERROR,
+	kOff     ///< Threshold which disables all messages
+};
+
+
+constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(TECH_MIN_LOG_LEVEL);
+
+
+using LogMessageHandler = Delegate<void(LogLevel level, const String& file, int line,
+		const String& message)>;
+
+// Message of a structured record is a string literal, see LOG_KV
+using LogRecordHandler = Delegate<void(LogLevel level, const String& file, int line,
+		const char* message, const LogFields& fields)>;
+
+
+/**
+ * Static state of a LOG call site. Caches the result of the threshold lookup until the
+ * logging configuration changes.
+ */
+class LogSite {
+public:
+	constexpr LogSite(const char* file, const char* module, LogLevel level) :
+		file_(file),
+		module_(module),
+		level_(level),
+		state_(0),
+		counter_(0),
+		nextTime_(0)
+	{
+	}
+
+	LogSite(const LogSite&) = delete;
+	LogSite& operator=(const LogSite&) = delete;
 
+	bool isEnabled();
+
+	/**
+	 * Returns @c true for the first of every @p n calls.
+	 */
+	bool everyN(u32 n);
+
+	/**
+	 * Returns @c true if the previous call which returned @c true was at least
+	 * @p milliseconds ago.
+	 */
+	bool atMostEvery(i64 milliseconds);
+
+	/**
+	 * Invalidates the cached state of all sites. Called by the functions which change
+	 * thresholds or handlers.
+	 */
+	static void invalidateAll();
+
+private:
+	const char* file_;
+	const char* module_;
+	LogLevel level_;
+
+	// Generation of the configuration shifted left by one, the lowest bit is the cached
+	// value. The initial value 0 never matches, since generations start at 1.
+	std::atomic<u32> state_;
+
+	std::atomic<u32> counter_;
+	std::atomic<i64> nextTime_;
+
+	static std::atomic<u32> generation_;
+
+	bool refresh();
+};
+
+
+/**
+ * Type-erased copy of logMessage() arguments. Allows a backend to store the arguments
+ * in its own memory and to format the message later, on another thread.
+ */
+struct DeferredMessage {
+	enum Operation {
+		kConstruct, ///< Copy the arguments from source into storage
+		kFormat,    ///< Format the message from the arguments in storage into result
+		kDestroy    ///< Destroy the arguments in storage
+	};
+
+	using Proc = void(*)(Operation operation, void* storage, const void* source,
+			const char* format, String* result);
+
+	// Format string of the message. It is not copied: only the LOG macros, which require
+	// a string literal, pass messages to the deferred log sink.
+	const char* format;
+
+	// Function which performs operations on the arguments
+	Proc proc;
+
+	// Pointer to a tuple of references to the arguments, used by kConstruct
+	const void* source;
+
+	// Size and alignment of the storage required for the copied arguments
+	size_t size;
+	size_t alignment;
+};
+
+
+/**
+ * Backend which receives messages before they are formatted. Strings are copied by
+ * reference counting and trivially copyable arguments are copied as is, so that the
+ * caller doesn't pay for Formatter::format().
+ */
+class DeferredLogSink {
+public:
+	virtual ~DeferredLogSink() = default;
+
+	/**
+	 * Stores the message. Returns @c false if the backend can't store the arguments, in
+	 * this case the message is formatted by the caller and passed to the handler.
+	 */
+	virtual bool postDeferred(LogLevel level, const char* fileName, int line,
+			const DeferredMessage& message) = 0;
+
+	/**
+	 * Stores the structured record. @p message has static storage duration, @p fields
+	 * must be copied. Returns @c false if the backend can't store the record, in this
+	 * case it is passed to the record handler or rendered as text by the caller. The
+	 * default implementation returns @c false.
+	 */
+	virtual bool postFields(LogLevel level, const char* fileName, int line,
+			const char* message, const LogFields& fields);
+};
+
+
+const char* logLevelName(LogLevel level);
+
+/**
+ * Thresholds of messages which are passed to the handler. The most specific threshold
+ * is used: the one set for the file name (e.g. "window.cpp"), then the one for the
+ * module (see TECH_LOG_MODULE), then the global one. The default global threshold is
+ * LogLevel::kInfo.
+ */
+void setLogLevel(LogLevel level);
+void setModuleLogLevel(const String& module, LogLevel level);
+void setFileLogLevel(const String& fileName, LogLevel level);
+void resetLogLevels();
+
+/**
+ * Returns @c true if messages of @p level from the file and the module pass the
+ * thresholds and there is a handler or a deferred sink to receive them.
+ */
+bool isLogEnabled(LogLevel level, const char* fileName, const char* module = "");
 
 void setLogMessageHandler(const LogMessageHandler& handler);
-void logMessage(const char* fileName, int line, const String& message);
+void logMessage(LogLevel level, const char* fileName, int line, const String& message);
+
+/**
+ * Installs the handler of structured records which are not taken by the deferred log
+ * sink. Without the handler such records are rendered as LogFieldFormat::kText and
+ * passed to the log message handler.
+ */
+void setLogRecordHandler(const LogRecordHandler& handler);
+void logFields(LogLevel level, const char* fileName, int line, const char* message,
+		const LogFields& fields);
 
+/**
+ * Installs the backend for deferred formatting. While it is set, the LOG macros bypass
+ * the log message handler and pass the unformatted message to @p sink. logMessage()
+ * always formats the message immediately, since its format may be a temporary buffer.
+ * Passing @c nullptr restores immediate formatting.
+ */
+void setDeferredLogSink(DeferredLogSink* sink);
+DeferredLogSink* deferredLogSink();
 
+
+namespace internal {
+
+
+// Arguments are stored by value. C-strings may point to temporary buffers, so they are
+// converted to String before the call returns.
+template<typename T>
+using DeferredArgumentType = Conditional<
+		Any<std::is_same<typename std::decay<T>::type, const char*>,
+			std::is_same<typename std::decay<T>::type, char*>>,
+		String, typename std::decay<T>::type>;
+
+
+template<typename ...Args>
+class DeferredArguments {
+public:
+	using Stored = Tuple<DeferredArgumentType<Args>...>;
+	using Source = Tuple<const Args&...>;
+
+	static void proc(DeferredMessage::Operation operation, void* storage,
+			const void* source, const char* format, String* result)
+	{
+		switch(operation) {
+		case DeferredMessage::kConstruct:
+			new (storage) Stored(*static_cast<const Source*>(source));
+			break;
+
+		case DeferredMessage::kFormat:
+			*result = formatStored(format, *static_cast<Stored*>(storage),
+					std::index_sequence_for<Args...>());
+			break;
+
+		case DeferredMessage::kDestroy:
+			static_cast<Stored*>(storage)->~Stored();
+			break;
+		}
+	}
+
+private:
+	template<size_t ...I>
+	static String formatStored(const char* format, Stored& stored,
+			std::index_sequence<I...>)
+	{
+		UNUSED(stored);
+		return Formatter::format(format, std::get<I>(stored)...);
+	}
+};
+
+
+inline
+void addLogFields(LogFieldWriter& writer)
+{
+	UNUSED(writer);
+}
+
+
+template<typename Value, typename ...Rest>
+void addLogFields(LogFieldWriter& writer, const char* key, const Value& value,
+		const Rest&... rest)
+{
+	writer.add(key, value);
+	addLogFields(writer, rest...);
+}
+
+
+/**
+ * Entry point of the LOG macros. @p format is a string literal, so it outlives the call
+ * and the message may be formatted by the deferred log sink.
+ */
 template<typename ...Args>
-void logMessage(const char* fileName, int line, const char* format, const Args&... args)
+void logLiteral(LogLevel level, const char* fileName, int line, const char* format,
+		const Args&... args)
 {
-	logMessage(fileName, line, Formatter::format(format, args...));
+	DeferredLogSink* sink = deferredLogSink();
+
+	if(sink) {
+		using Arguments = DeferredArguments<Args...>;
+
+		typename Arguments::Source source(args...);
+		DeferredMessage message {
+			format,
+			&Arguments::proc,
+			&source,
+			sizeof(typename Arguments::Stored),
+			alignof(typename Arguments::Stored)
+		};
+
+		if(sink->postDeferred(level, fileName, line, message))
+			return;
+	}
+
+	logMessage(level, fileName, line, Formatter::format(format, args...));
+}
+
+
+} // namespace internal
+
+
+inline
+bool LogSite::isEnabled()
+{
+	u32 state = state_.load(std::memory_order_relaxed);
+
+	if(state >> 1 == (generation_.load(std::memory_order_relaxed) & 0x7FFFFFFF))
+		return state & 1;
+
+	return refresh();
+}
+
+
+inline
+bool LogSite::everyN(u32 n)
+{
+	return n <= 1 || counter_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+
+template<typename ...Args>
+void logMessage(LogLevel level, const char* fileName, int line, const char* format,
+		const Args&... args)
+{
+	logMessage(level, fileName, line, Formatter::format(format, args...));
+}
+
+
+template<typename ...Args>
+void logFields(LogLevel level, const char* fileName, int line, const char* message,
+		const Args&... args)
+{
+	static_assert(sizeof...(Args) % 2 == 0, "fields must be given as key-value pairs");
+
+	LogFieldWriter writer;
+	internal::addLogFields(writer, args...);
+	logFields(level, fileName, line, message, writer.fields());
 }
 
 
@@ -0,0 +1,82 @@
+#ifndef TECH_LOGTIMESTAMPFORMATTER_H
+#define TECH_LOGTIMESTAMPFORMATTER_H
+
+#include <atomic>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Renders timestamps of log lines as "2016-05-17 14:03:12.345". The date and time up to
+ * the seconds are converted to the calendar representation once per second and cached,
+ * for other messages within the same second only the milliseconds are written.
+ *
+ * format() may be called from any number of threads. The cache is protected by a
+ * sequence counter: readers never block, and a thread which finds the cache outdated
+ * either updates it or, if another thread is updating it at the same moment, renders
+ * the timestamp on its own.
+ */
+class LogTimestampFormatter {
+public:
+	enum class Clock {
+		kPrecise, ///< CLOCK_REALTIME
+		kCoarse   ///< CLOCK_REALTIME_COARSE: cheaper, but updated only every few ms
+	};
+
+	enum class TimeZone {
+		kLocal,
+		kUtc
+	};
+
+	static const size_t kLength = 23;
+
+	explicit LogTimestampFormatter(Clock clock = Clock::kPrecise,
+			TimeZone zone = TimeZone::kLocal);
+
+	LogTimestampFormatter(const LogTimestampFormatter&) = delete;
+	LogTimestampFormatter& operator=(const LogTimestampFormatter&) = delete;
+
+	Clock clock() const;
+	void setClock(Clock clock);
+
+	TimeZone timeZone() const;
+
+	/**
+	 * Writes kLength characters of the current time to @p buffer (without terminating
+	 * null) and returns the time in milliseconds since the Epoch.
+	 */
+	i64 format(char* buffer);
+
+	/**
+	 * Writes kLength characters of @p msecs since the Epoch to @p buffer.
+	 */
+	void format(i64 msecs, char* buffer);
+
+	/**
+	 * Returns the current time of the configured clock in milliseconds since the Epoch.
+	 */
+	i64 now() const;
+
+private:
+	// "2016-05-17 14:03:12." takes 20 characters, they are stored in atomic words so
+	// that concurrent reads and updates are well defined
+	static const size_t kPrefixLength = 20;
+	static const size_t kWordCount = 3;
+
+	std::atomic<Clock> clock_;
+	TimeZone zone_;
+
+	std::atomic<u32> version_; // Odd while the cache is being updated
+	std::atomic<i64> second_;
+	std::atomic<u64> prefix_[kWordCount];
+
+	void renderPrefix(i64 second, char* buffer) const;
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_LOGTIMESTAMPFORMATTER_H
@@ -0,0 +1,120 @@
+#ifndef TECH_MAPPEDLOGSINK_H
+#define TECH_MAPPEDLOGSINK_H
+
+#include <mutex>
+#include <vector>
+#include <tech/duration.h>
+#include <tech/logger.h>
+
+
+namespace Tech {
+
+
+/**
+ * Log message handler which keeps the latest messages in a fixed-size ring stored in a
+ * memory-mapped file. Appending a message is a plain memory copy, without system calls,
+ * and the data belongs to the page cache rather than to the process, so the messages
+ * logged right before a crash survive it. After a restart the messages can be read
+ * with MappedLogReader.
+ *
+ * The file starts with a header containing positions of the oldest and the newest
+ * records and the next sequence number. Records never wrap around the end of the ring.
+ * The header is updated after the record is written, so a record interrupted by a crash
+ * is not visible to the reader.
+ *
+ * If the file already contains a valid ring of the same capacity, new messages are
+ * appended to it.
+ */
+class MappedLogSink {
+public:
+	static const size_t kDefaultCapacity = 4 * 1024 * 1024;
+
+	/**
+	 * Opens or creates @p fileName and maps the ring of @p capacity bytes (rounded up to
+	 * a multiple of 8).
+	 */
+	explicit MappedLogSink(const String& fileName, size_t capacity = kDefaultCapacity);
+
+	MappedLogSink(const MappedLogSink&) = delete;
+	MappedLogSink& operator=(const MappedLogSink&) = delete;
+
+	~MappedLogSink();
+
+	bool isOpen() const;
+	size_t capacity() const;
+
+	/**
+	 * Appends the message to the ring, overwriting the oldest messages if necessary.
+	 * Messages longer than a quarter of the ring are truncated. The function has
+	 * LogMessageHandler signature.
+	 */
+	void write(LogLevel level, const String& file, int line, const String& message);
+
+	/**
+	 * Writes the mapped pages to the storage device. Not needed to survive a crash of
+	 * the process, only of the whole system.
+	 */
+	void sync();
+
+private:
+	mutable std::mutex mutex_;
+	int fd_;
+	u8* mapping_;
+	size_t mappingSize_;
+	u8* data_;
+	u64 capacity_;
+
+	void reset();
+	bool isRingValid() const;
+	u64 recordSize(u64 position) const;
+	void makeRoom(u64 head, u64 size);
+};
+
+
+/**
+ * Reads messages written by MappedLogSink, e.g. after the process has crashed. The file
+ * is read without mapping, so the reader may run while the sink is still writing.
+ */
+class MappedLogReader {
+public:
+	struct Record {
+		u64 sequence;
+		Duration time; ///< Time since the Epoch
+		LogLevel level;
+		String file;
+		int line;
+		String message;
+	};
+
+	explicit MappedLogReader(const String& fileName);
+
+	/**
+	 * Returns @c false if the file can't be read or doesn't contain a log ring.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Returns the newest @p count messages, from the oldest to the newest.
+	 */
+	std::vector<Record> lastRecords(size_t count) const;
+
+	/**
+	 * Returns all messages in the ring.
+	 */
+	std::vector<Record> records() const;
+
+private:
+	bool isValid_;
+	std::vector<u8> content_;
+
+	// Offsets of the valid records in content_, from the oldest to the newest
+	std::vector<size_t> offsets_;
+
+	Record decode(size_t offset) const;
+};
+
+
+} // namespace Tech
+
+
+#endif // TECH_MAPPEDLOGSINK_H
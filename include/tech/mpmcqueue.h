@@ -0,0 +1,208 @@
+#ifndef TECH_MPMCQUEUE_H
+#define TECH_MPMCQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tech/types.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+/**
+ * Bounded lock-free queue for any number of producer and consumer threads.
+ *
+ * This is the queue by Dmitry Vyukov: every cell has a sequence number which tells
+ * whether it's free for the producer of the given position or holds the value for the
+ * consumer of that position. Producers and consumers claim positions with a CAS on their
+ * own counter, so an operation costs one contended atomic and neither side ever waits
+ * for the other to finish a half-done operation on a different cell.
+ *
+ * Values may be move-only. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class MpmcQueue {
+public:
+	using ValueType = T;
+
+	explicit MpmcQueue(size_t capacity);
+
+	MpmcQueue(const MpmcQueue&) = delete;
+	MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+	/**
+	 * Destroys the values left in the queue.
+	 */
+	~MpmcQueue();
+
+	size_t capacity() const;
+
+	/**
+	 * Constructs the value from @p args at the tail. Returns @c false if the queue is
+	 * full.
+	 */
+	template<typename ...Args>
+	bool tryEmplace(Args&&... args);
+
+	bool tryPush(const T& value);
+	bool tryPush(T&& value);
+
+	/**
+	 * Moves the head value to @p value. Returns @c false if the queue is empty.
+	 */
+	bool tryPop(T* value);
+
+	/**
+	 * Returns @c true if the queue had no values at the moment of the call.
+	 */
+	bool isEmpty() const;
+
+private:
+	static const size_t kCacheLineSize = 64;
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+		T* value()
+		{
+			return reinterpret_cast<T*>(&storage);
+		}
+	};
+
+	size_t mask_;
+	Box<Cell[]> cells_;
+
+	// Producer and consumer positions are placed on separate cache lines
+	u8 padding1_[kCacheLineSize];
+	std::atomic<size_t> enqueuePos_;
+	u8 padding2_[kCacheLineSize];
+	std::atomic<size_t> dequeuePos_;
+	u8 padding3_[kCacheLineSize];
+};
+
+
+template<typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity) :
+	mask_(ceilToPowerOfTwo(static_cast<u64>(std::max<size_t>(capacity, 2))) - 1),
+	cells_(new Cell[mask_ + 1]),
+	enqueuePos_(0),
+	dequeuePos_(0)
+{
+	for(size_t i = 0; i <= mask_; ++i)
+		cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+
+template<typename T>
+MpmcQueue<T>::~MpmcQueue()
+{
+	size_t end = enqueuePos_.load(std::memory_order_acquire);
+
+	for(size_t pos = dequeuePos_.load(std::memory_order_relaxed); pos != end; ++pos)
+		cells_[pos & mask_].value()->~T();
+}
+
+
+template<typename T>
+size_t MpmcQueue<T>::capacity() const
+{
+	return mask_ + 1;
+}
+
+
+template<typename T>
+template<typename ...Args>
+bool MpmcQueue<T>::tryEmplace(Args&&... args)
+{
+	size_t position = enqueuePos_.load(std::memory_order_relaxed);
+	Cell* cell;
+
+	for(;;) {
+		cell = &cells_[position & mask_];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		iptr diff = static_cast<iptr>(sequence) - static_cast<iptr>(position);
+
+		if(diff == 0) {
+			if(enqueuePos_.compare_exchange_weak(position, position + 1,
+					std::memory_order_relaxed))
+				break;
+		}
+		else if(diff < 0) {
+			// The cell still holds the value of the previous lap
+			return false;
+		}
+		else {
+			position = enqueuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	new(cell->value()) T(std::forward<Args>(args)...);
+	cell->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T>
+bool MpmcQueue<T>::tryPush(const T& value)
+{
+	return tryEmplace(value);
+}
+
+
+template<typename T>
+bool MpmcQueue<T>::tryPush(T&& value)
+{
+	return tryEmplace(std::move(value));
+}
+
+
+template<typename T>
+bool MpmcQueue<T>::tryPop(T* value)
+{
+	size_t position = dequeuePos_.load(std::memory_order_relaxed);
+	Cell* cell;
+
+	for(;;) {
+		cell = &cells_[position & mask_];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		iptr diff = static_cast<iptr>(sequence) - static_cast<iptr>(position + 1);
+
+		if(diff == 0) {
+			if(dequeuePos_.compare_exchange_weak(position, position + 1,
+					std::memory_order_relaxed))
+				break;
+		}
+		else if(diff < 0) {
+			return false;
+		}
+		else {
+			position = dequeuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	T* item = cell->value();
+	*value = std::move(*item);
+	item->~T();
+	cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T>
+bool MpmcQueue<T>::isEmpty() const
+{
+	size_t position = dequeuePos_.load(std::memory_order_relaxed);
+	size_t sequence = cells_[position & mask_].sequence.load(std::memory_order_acquire);
+	return static_cast<iptr>(sequence) - static_cast<iptr>(position + 1) < 0;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_MPMCQUEUE_H
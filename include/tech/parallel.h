@@ -0,0 +1,377 @@
+#ifndef TECH_PARALLEL_H
+#define TECH_PARALLEL_H
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include <tech/bytearray.h>
+#include <tech/string.h>
+#include <tech/threadpool.h>
+#include <tech/types.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+/**
+ * Parallel algorithms on a ThreadPool, usually ThreadPool::shared().
+ *
+ * The input is cut into chunks, about four per worker, so that uneven chunks are
+ * balanced by work stealing. The calling thread runs the last chunk itself and then
+ * waits for the others, so the algorithms may also be called from the tasks of the pool.
+ * Inputs smaller than a chunk are processed on the calling thread without the pool.
+ */
+
+
+/**
+ * Calls @p function(begin, end) for the chunks of [0, @p count), which have at least
+ * @p minChunkSize elements.
+ */
+template<typename F>
+void parallelFor(ThreadPool* pool, size_t count, size_t minChunkSize, F&& function);
+
+/**
+ * Writes @p function(*it) for every element of [@p first, @p last) to the range starting
+ * at @p out. The iterators must be random access.
+ */
+template<typename InputIt, typename OutputIt, typename F>
+void parallelTransform(ThreadPool* pool, InputIt first, InputIt last, OutputIt out,
+		F function);
+
+/**
+ * Folds [@p first, @p last) with @p reduce, which must be associative, starting from
+ * @p init. The elements are folded in chunks and the partial results in order.
+ */
+template<typename It, typename T, typename Reduce>
+T parallelReduce(ThreadPool* pool, It first, It last, T init, Reduce reduce);
+
+/**
+ * Sorts [@p first, @p last) with @p compare: the chunks are sorted in parallel and then
+ * merged pairwise, the pairs of every round in parallel. Not stable.
+ */
+template<typename It, typename Compare>
+void parallelSort(ThreadPool* pool, It first, It last, Compare compare);
+
+template<typename It>
+void parallelSort(ThreadPool* pool, It first, It last);
+
+/**
+ * Sorts the list by a key which caches the first bytes (or characters) of every string
+ * as an integer, so most comparisons don't touch the string data. Strings with equal
+ * prefixes are compared in full.
+ */
+void parallelSort(ThreadPool* pool, ByteArrayList* list);
+void parallelSort(ThreadPool* pool, StringList* list);
+
+/**
+ * Removes all but the first element of every run of equal elements in [@p first,
+ * @p last) like std::unique and returns the new end. The chunks are deduplicated in
+ * parallel and then moved together.
+ */
+template<typename It, typename Equal>
+It parallelUnique(ThreadPool* pool, It first, It last, Equal equal);
+
+template<typename It>
+It parallelUnique(ThreadPool* pool, It first, It last);
+
+/**
+ * Sorts the list as parallelSort() and removes the duplicates. Equal strings are found
+ * on the sort keys, so only the strings which are kept are moved.
+ */
+void parallelSortUnique(ThreadPool* pool, ByteArrayList* list);
+void parallelSortUnique(ThreadPool* pool, StringList* list);
+
+/**
+ * Cuts [@p data, @p data + @p size) into chunks which end right after @p separator (the
+ * last one at the end of the data) and calls @p function(begin, end) for every chunk
+ * concurrently. A record is never split between chunks.
+ */
+template<typename F>
+void parallelForEachChunk(ThreadPool* pool, const char* data, size_t size, char separator,
+		F&& function);
+
+/**
+ * Calls @p function(begin, length) for every record of the data terminated by
+ * @p separator, without the separator. The last record may be unterminated. Records are
+ * passed concurrently and in no particular order.
+ */
+template<typename F>
+void parallelForEachRecord(ThreadPool* pool, const char* data, size_t size,
+		char separator, F&& function);
+
+template<typename F>
+void parallelForEachRecord(ThreadPool* pool, const ByteArray& buffer, char separator,
+		F&& function);
+
+
+namespace internal {
+
+
+static const size_t kParallelChunksPerThread = 4;
+static const size_t kParallelMinChunkSize = 4096;
+static const size_t kParallelMinSortChunkSize = 16384;
+static const size_t kParallelMinBufferChunkSize = 256 * 1024;
+
+
+inline
+size_t parallelChunkCount(const ThreadPool* pool, size_t count, size_t minChunkSize)
+{
+	size_t maxChunkCount = pool->threadCount() * kParallelChunksPerThread;
+	size_t chunkCount = count / (minChunkSize ? minChunkSize : 1);
+	return std::max<size_t>(1, std::min(chunkCount, maxChunkCount));
+}
+
+
+// Calls @p function(chunk, begin, end) for @p chunkCount even chunks of [0, @p count)
+template<typename F>
+void forEachChunk(ThreadPool* pool, size_t count, size_t chunkCount, F& function)
+{
+	if(chunkCount <= 1) {
+		if(count)
+			function(size_t(0), size_t(0), count);
+
+		return;
+	}
+
+	ThreadPool::Group group;
+
+	for(size_t i = 0; i + 1 < chunkCount; ++i) {
+		size_t begin = count * i / chunkCount;
+		size_t end = count * (i + 1) / chunkCount;
+		pool->submit(&group, [&function, i, begin, end]() { function(i, begin, end); });
+	}
+
+	function(chunkCount - 1, count * (chunkCount - 1) / chunkCount, count);
+	pool->wait(&group);
+}
+
+
+} // namespace internal
+
+
+template<typename F>
+void parallelFor(ThreadPool* pool, size_t count, size_t minChunkSize, F&& function)
+{
+	auto chunk = [&function](size_t index, size_t begin, size_t end) {
+		UNUSED(index);
+		function(begin, end);
+	};
+
+	internal::forEachChunk(pool, count,
+			internal::parallelChunkCount(pool, count, minChunkSize), chunk);
+}
+
+
+template<typename InputIt, typename OutputIt, typename F>
+void parallelTransform(ThreadPool* pool, InputIt first, InputIt last, OutputIt out,
+		F function)
+{
+	size_t count = static_cast<size_t>(last - first);
+
+	parallelFor(pool, count, internal::kParallelMinChunkSize,
+			[first, out, &function](size_t begin, size_t end) {
+				std::transform(first + begin, first + end, out + begin, function);
+			});
+}
+
+
+template<typename It, typename T, typename Reduce>
+T parallelReduce(ThreadPool* pool, It first, It last, T init, Reduce reduce)
+{
+	size_t count = static_cast<size_t>(last - first);
+	size_t chunkCount = internal::parallelChunkCount(pool, count,
+			internal::kParallelMinChunkSize);
+
+	// Chunks are never empty, so every partial result starts from the first element
+	std::vector<T> partials(chunkCount, init);
+
+	auto chunk = [first, &reduce, &partials](size_t index, size_t begin, size_t end) {
+		partials[index] = std::accumulate(first + begin + 1, first + end,
+				T(first[begin]), reduce);
+	};
+
+	internal::forEachChunk(pool, count, chunkCount, chunk);
+
+	if(count == 0)
+		return init;
+
+	for(auto& partial : partials)
+		init = reduce(std::move(init), std::move(partial));
+
+	return init;
+}
+
+
+template<typename It, typename Compare>
+void parallelSort(ThreadPool* pool, It first, It last, Compare compare)
+{
+	size_t count = static_cast<size_t>(last - first);
+	size_t chunkCount = internal::parallelChunkCount(pool, count,
+			internal::kParallelMinSortChunkSize);
+
+	std::vector<size_t> bounds(chunkCount + 1);
+	for(size_t i = 0; i <= chunkCount; ++i)
+		bounds[i] = count * i / chunkCount;
+
+	auto sortChunk = [first, &compare](size_t index, size_t begin, size_t end) {
+		UNUSED(index);
+		std::sort(first + begin, first + end, compare);
+	};
+
+	internal::forEachChunk(pool, count, chunkCount, sortChunk);
+
+	// Runs of width chunks are merged pairwise, until one run is left
+	for(size_t width = 1; width < chunkCount; width *= 2) {
+		size_t pairCount = (chunkCount + 2 * width - 1) / (2 * width);
+
+		auto mergePair = [first, &compare, &bounds, width, chunkCount](size_t index,
+				size_t begin, size_t end) {
+			UNUSED(begin);
+			UNUSED(end);
+
+			size_t left = index * 2 * width;
+			size_t middle = left + width;
+			size_t right = std::min(middle + width, chunkCount);
+
+			if(middle < chunkCount) {
+				std::inplace_merge(first + bounds[left], first + bounds[middle],
+						first + bounds[right], compare);
+			}
+		};
+
+		internal::forEachChunk(pool, pairCount, pairCount, mergePair);
+	}
+}
+
+
+template<typename It>
+void parallelSort(ThreadPool* pool, It first, It last)
+{
+	using Value = typename std::iterator_traits<It>::value_type;
+	parallelSort(pool, first, last, [](const Value& a, const Value& b) { return a < b; });
+}
+
+
+template<typename It, typename Equal>
+It parallelUnique(ThreadPool* pool, It first, It last, Equal equal)
+{
+	size_t count = static_cast<size_t>(last - first);
+	size_t chunkCount = internal::parallelChunkCount(pool, count,
+			internal::kParallelMinChunkSize);
+
+	// A run crossing a boundary is kept by the previous chunk. Its continuation is
+	// skipped before any chunk is changed, since the element before the chunk is read.
+	std::vector<size_t> starts(chunkCount);
+	std::vector<size_t> ends(chunkCount);
+
+	auto skipRun = [first, &equal, &starts](size_t index, size_t begin, size_t end) {
+		size_t start = begin;
+
+		while(start != end && start != 0 && equal(first[begin - 1], first[start]))
+			++start;
+
+		starts[index] = start;
+	};
+
+	auto uniqueChunk = [first, &equal, &starts, &ends](size_t index, size_t begin,
+			size_t end) {
+		UNUSED(begin);
+		ends[index] = static_cast<size_t>(std::unique(first + starts[index], first + end,
+				equal) - first);
+	};
+
+	internal::forEachChunk(pool, count, chunkCount, skipRun);
+	internal::forEachChunk(pool, count, chunkCount, uniqueChunk);
+
+	// The kept elements only move towards the beginning, so the chunks are moved in order
+	It result = count ? first + ends[0] : first;
+
+	for(size_t i = 1; i < chunkCount && count; ++i) {
+		if(result == first + starts[i])
+			result = first + ends[i];
+		else
+			result = std::move(first + starts[i], first + ends[i], result);
+	}
+
+	return result;
+}
+
+
+template<typename It>
+It parallelUnique(ThreadPool* pool, It first, It last)
+{
+	using Value = typename std::iterator_traits<It>::value_type;
+	return parallelUnique(pool, first, last,
+			[](const Value& a, const Value& b) { return a == b; });
+}
+
+
+template<typename F>
+void parallelForEachChunk(ThreadPool* pool, const char* data, size_t size, char separator,
+		F&& function)
+{
+	size_t chunkCount = internal::parallelChunkCount(pool, size,
+			internal::kParallelMinBufferChunkSize);
+
+	// Every cut is moved forward to the next separator, which takes a short scan
+	std::vector<size_t> bounds;
+	bounds.reserve(chunkCount + 1);
+	bounds.push_back(0);
+
+	for(size_t i = 1; i < chunkCount; ++i) {
+		size_t target = std::max(size * i / chunkCount, bounds.back());
+		const void* found = std::memchr(data + target, separator, size - target);
+		size_t cut = found ? static_cast<const char*>(found) - data + 1 : size;
+
+		if(cut != bounds.back() && cut != size)
+			bounds.push_back(cut);
+	}
+
+	bounds.push_back(size);
+
+	auto chunk = [data, &bounds, &function](size_t index, size_t begin, size_t end) {
+		UNUSED(begin);
+		UNUSED(end);
+		function(data + bounds[index], data + bounds[index + 1]);
+	};
+
+	if(size)
+		internal::forEachChunk(pool, bounds.size() - 1, bounds.size() - 1, chunk);
+}
+
+
+template<typename F>
+void parallelForEachRecord(ThreadPool* pool, const char* data, size_t size,
+		char separator, F&& function)
+{
+	parallelForEachChunk(pool, data, size, separator,
+			[separator, &function](const char* begin, const char* end) {
+				while(begin != end) {
+					const void* found = std::memchr(begin, separator,
+							static_cast<size_t>(end - begin));
+					const char* recordEnd = found ? static_cast<const char*>(found) : end;
+
+					function(begin, static_cast<size_t>(recordEnd - begin));
+					begin = found ? recordEnd + 1 : end;
+				}
+			});
+}
+
+
+template<typename F>
+void parallelForEachRecord(ThreadPool* pool, const ByteArray& buffer, char separator,
+		F&& function)
+{
+	parallelForEachRecord(pool, buffer.constData(), buffer.length(), separator,
+			std::forward<F>(function));
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_PARALLEL_H
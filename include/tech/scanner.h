@@ -0,0 +1,236 @@
+#ifndef TECH_SCANNER_H
+#define TECH_SCANNER_H
+
+#include <tech/string.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+/**
+ * Результат разбора входных данных функцией Scanner::scan().
+ */
+class ScanResult {
+public:
+	ScanResult(bool isValid, size_t count, size_t position);
+
+	/**
+	 * Возвращает @c true, если входные данные полностью соответствуют шаблону.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Возвращает количество аргументов, которым были присвоены значения. В случае
+	 * ошибки аргументы, расположенные до места ошибки, остаются измененными.
+	 */
+	size_t count() const;
+
+	/**
+	 * Возвращает позицию во входных данных (в единицах кодировки входных данных), на
+	 * которой был остановлен разбор. В случае успешного разбора совпадает с длиной
+	 * входных данных.
+	 */
+	size_t position() const;
+
+	/**
+	 * Возвращает @c true, если входные данные полностью соответствуют шаблону.
+	 */
+	explicit operator bool() const;
+
+private:
+	bool isValid_;
+	size_t count_;
+	size_t position_;
+};
+
+
+class Scanner {
+public:
+	/**
+	 * Описание аргумента, в который сохраняется значение разобранного поля. Используется
+	 * для передачи типизированных указателей в нешаблонную реализацию разбора.
+	 */
+	struct Argument {
+		enum Type {
+			kNone,      ///< Значение поля пропускается
+			kBool,      ///< bool
+			kSigned,    ///< Знаковое целое число размером size байт
+			kUnsigned,  ///< Беззнаковое целое число размером size байт
+			kFloat,     ///< float
+			kDouble,    ///< double
+			kChar,      ///< Char
+			kByte,      ///< char
+			kString,    ///< String
+			kByteArray  ///< ByteArray
+		};
+
+		Type type;
+		uint size;
+		void* target;
+	};
+
+	/**
+	 * Разбирает строку @p input в соответствии с шаблоном @p pattern и сохраняет
+	 * значения полей в @p args. Является обратной операцией к Formatter::format() и
+	 * использует ту же грамматику подстановочных полей:
+	 *
+	 * placeholder ::=  '{' [index] [':' format_spec] '}'
+	 * format_spec ::=  [[fill]align][sign][#][0][width][.precision][type]
+	 *
+	 * Символы шаблона вне подстановочных полей должны в точности совпадать с входными
+	 * данными ("{{" соответствует символу '{'). Поле без соответствующего аргумента
+	 * (индекс больше количества аргументов) разбирается как строка и пропускается.
+	 *
+	 * Значения извлекаются непосредственно из входных данных без создания
+	 * промежуточных строк. Строковые поля (String для строки, ByteArray для байтового
+	 * массива) разделяют буфер с @p input и не требуют копирования данных.
+	 *
+	 * Строковое поле продолжается до первого символа литерала, следующего в шаблоне за
+	 * полем, до конца входных данных (если поле последнее), либо до пробела (если
+	 * сразу за полем следует другое поле). Спецификатор формата учитывается следующим
+	 * образом:
+	 * - width ограничивает максимальное количество символов поля;
+	 * - при наличии align пропускаются символы заполнения fill до и после значения;
+	 * - type задает систему счисления целых чисел ('b', 'o', 'd', 'x', 'X');
+	 * - '#' разрешает префикс системы счисления ("0b", "0o", "0x").
+	 *
+	 * Разбор считается успешным только если шаблон и входные данные были исчерпаны
+	 * одновременно.
+	 *
+	 * Пример:
+	 * String host;
+	 * int port, ms;
+	 * Scanner::scan(line, "{}:{} took {}ms", &host, &port, &ms);
+	 */
+	template<typename ...Args>
+	static ScanResult scan(const String& input, const char* pattern, Args*... args);
+
+	/**
+	 * Аналогична функции выше, шаблон @p pattern задается строкой.
+	 */
+	template<typename ...Args>
+	static ScanResult scan(const String& input, const String& pattern, Args*... args);
+
+	/**
+	 * Разбирает байтовый массив @p input в кодировке UTF-8 в соответствии с шаблоном
+	 * @p pattern (также в кодировке UTF-8). Поведение аналогично функции выше.
+	 */
+	template<typename ...Args>
+	static ScanResult scan(const ByteArray& input, const char* pattern, Args*... args);
+
+private:
+	static Argument makeArgument(bool* target);
+	static Argument makeArgument(float* target);
+	static Argument makeArgument(double* target);
+	static Argument makeArgument(Char* target);
+	static Argument makeArgument(char* target);
+	static Argument makeArgument(String* target);
+	static Argument makeArgument(ByteArray* target);
+
+	template<typename T, EnableIf<
+			IsInteger<T>,
+			Not<std::is_same<T, char>>,
+			Not<std::is_same<T, wchar_t>>,
+			Not<std::is_same<T, ch16>>,
+			Not<std::is_same<T, ch32>>>...>
+	static Argument makeArgument(T* target);
+
+	static ScanResult doScan(const String& input, const char* pattern, Argument* args,
+			size_t count);
+
+	static ScanResult doScan(const String& input, const String& pattern, Argument* args,
+			size_t count);
+
+	static ScanResult doScan(const ByteArray& input, const char* pattern, Argument* args,
+			size_t count);
+};
+
+
+//
+// ScanResult
+//
+inline
+ScanResult::ScanResult(bool isValid, size_t count, size_t position) :
+	isValid_(isValid),
+	count_(count),
+	position_(position)
+{
+}
+
+
+inline
+bool ScanResult::isValid() const
+{
+	return isValid_;
+}
+
+
+inline
+size_t ScanResult::count() const
+{
+	return count_;
+}
+
+
+inline
+size_t ScanResult::position() const
+{
+	return position_;
+}
+
+
+inline
+ScanResult::operator bool() const
+{
+	return isValid_;
+}
+
+
+//
+// Scanner
+//
+template<typename ...Args>
+ScanResult Scanner::scan(const String& input, const char* pattern, Args*... args)
+{
+	// Дополнительный элемент исключает массив нулевого размера при отсутствии аргументов
+	Argument arguments[sizeof...(Args) + 1] = { makeArgument(args)... };
+	return doScan(input, pattern, arguments, sizeof...(Args));
+}
+
+
+template<typename ...Args>
+ScanResult Scanner::scan(const String& input, const String& pattern, Args*... args)
+{
+	Argument arguments[sizeof...(Args) + 1] = { makeArgument(args)... };
+	return doScan(input, pattern, arguments, sizeof...(Args));
+}
+
+
+template<typename ...Args>
+ScanResult Scanner::scan(const ByteArray& input, const char* pattern, Args*... args)
+{
+	Argument arguments[sizeof...(Args) + 1] = { makeArgument(args)... };
+	return doScan(input, pattern, arguments, sizeof...(Args));
+}
+
+
+template<typename T, EnableIf<
+		IsInteger<T>,
+		Not<std::is_same<T, char>>,
+		Not<std::is_same<T, wchar_t>>,
+		Not<std::is_same<T, ch16>>,
+		Not<std::is_same<T, ch32>>>...>
+Scanner::Argument Scanner::makeArgument(T* target)
+{
+	Argument::Type type = std::is_signed<T>::value ? Argument::kSigned :
+			Argument::kUnsigned;
+
+	return Argument{ type, sizeof(T), target };
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_SCANNER_H
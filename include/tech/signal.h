@@ -1,8 +1,10 @@
 #ifndef TECH_SIGNAL_H
 #define TECH_SIGNAL_H
 
+#include <atomic>
 #include <vector>
 #include <tech/delegate.h>
+#include <tech/taskqueue.h>
 
 #ifdef signals
 #undef signals
@@ -13,16 +15,79 @@
 namespace Tech {
 
 
+class Trackable;
 class TrackableWatcher;
 
 
+namespace internal {
+
+
+/**
+ * Данные соединения сигнала с функцией. Разделяются между сигналом, описателями
+ * Connection и отслеживаемым (Trackable) объектом, с методом которого установлено
+ * соединение. Хранят индекс соединения в сигнале, поэтому разрыв соединения через
+ * описатель или при уничтожении Trackable объекта выполняется за O(1).
+ */
+class ConnectionData {
+public:
+	ConnectionData(TrackableWatcher* watcher, size_t index, Trackable* trackable);
+
+	ConnectionData(const ConnectionData&) = delete;
+	ConnectionData& operator=(const ConnectionData&) = delete;
+
+	void addRef();
+	void release();
+
+	bool isConnected() const;
+
+	/**
+	 * Разрывает соединение, если оно еще существует.
+	 */
+	void disconnect();
+
+	TrackableWatcher* watcher() const;
+	void setWatcher(TrackableWatcher* watcher);
+
+	size_t index() const;
+	void setIndex(size_t index);
+
+	/**
+	 * Позиция в списке соединений Trackable объекта.
+	 */
+	u32 trackableIndex() const;
+	void setTrackableIndex(u32 index);
+
+	/**
+	 * Вызывается сигналом при удалении соединения: отменяет регистрацию в Trackable
+	 * объекте и освобождает ссылку сигнала.
+	 */
+	void detach();
+
+	/**
+	 * Вызывается Trackable объектом при его перемещении по адресу @p trackable.
+	 */
+	void moveTrackable(Trackable* trackable);
+
+private:
+	int refs_;
+	u32 trackableIndex_;
+	TrackableWatcher* watcher_;
+	size_t index_;
+	Trackable* trackable_;
+};
+
+
+} // namespace internal
+
+
 /**
  * Классы, наследующие Trackable, при своем перемещении или уничтожении уведомляют об
  * этом подключенные к их методам сигналы и таким образом позволяют автоматизировать
- * обработку этих событий. При перемещении или удалении объектов классов, не наследующих
- * Trackable, требуется вручную отслеживать подключенные к их методам сигналы. В
- * противном случае, генерация подключенного к более невалидному объекту сигнала приведет
- * к undefined behaviour.
+ * обработку этих событий: при уничтожении объекта соединения разрываются, а при
+ * перемещении перепривязываются к новому адресу объекта. При перемещении или удалении
+ * объектов классов, не наследующих Trackable, требуется вручную отслеживать подключенные
+ * к их методам сигналы. В противном случае, генерация подключенного к более невалидному
+ * объекту сигнала приведет к undefined behaviour.
  */
 class Trackable {
 public:
@@ -36,37 +101,152 @@ public:
 
 	Trackable& operator=(const Trackable& other);
 
-	void registerWatcher(TrackableWatcher* watcher);
+private:
+	friend class internal::ConnectionData;
 
-	void unregisterWatcher(TrackableWatcher* watcher);
+	// Обычно объект подключен к небольшому числу сигналов, поэтому первые
+	// kInlineCapacity соединений хранятся в самом объекте без выделения памяти. Каждое
+	// соединение знает свою позицию в списке, поэтому удаление выполняется за O(1)
+	// перестановкой последнего элемента на место удаляемого.
+	static const u32 kInlineCapacity = 2;
 
-	void updateWatcher(TrackableWatcher* old, TrackableWatcher* watcher);
+	u32 connectionCount_ = 0;
+	u32 capacity_ = kInlineCapacity;
 
-private:
-	std::map<TrackableWatcher*, int> watchers_;
+	union {
+		internal::ConnectionData* inlineConnections_[kInlineCapacity];
+		internal::ConnectionData** heapConnections_;
+	};
+
+	internal::ConnectionData** connections();
+
+	void registerConnection(internal::ConnectionData* connection);
+	void unregisterConnection(internal::ConnectionData* connection);
 };
 
 
 /**
- * Наблюдатель за объектами-потомками Trackable.
+ * Владелец соединений (сигнал), которому ConnectionData передает запросы на разрыв
+ * соединения и перепривязку к перемещенному Trackable объекту.
  */
 class TrackableWatcher {
 public:
 	virtual ~TrackableWatcher() = default;
-	virtual void destroyEvent(Trackable* trackable) = 0;
-	virtual void moveEvent(Trackable* old, Trackable* trackable) = 0;
+
+	/**
+	 * Разрывает соединение с индексом @p index.
+	 */
+	virtual void disconnectSlot(size_t index) = 0;
+
+	/**
+	 * Перепривязывает соединение с индексом @p index к объекту, перемещенному на
+	 * @p offset байт.
+	 */
+	virtual void moveSlot(size_t index, iptr offset) = 0;
 };
 
 
+template<typename T, typename K = void>
+class Signal;
+
+
+/**
+ * Описатель соединения, которое возвращают функции Signal::connect(). Позволяет за O(1)
+ * разорвать соединение, в том числе из вызванной сигналом функции. Описатель можно
+ * копировать и хранить дольше сигнала: после разрыва соединения или уничтожения сигнала
+ * isConnected() возвращает @c false.
+ */
+class Connection {
+public:
+	/**
+	 * Создает пустой описатель, не связанный с соединением.
+	 */
+	Connection();
+
+	Connection(const Connection& other);
+	Connection(Connection&& other);
+	~Connection();
+
+	Connection& operator=(const Connection& other);
+	Connection& operator=(Connection&& other);
+
+	/**
+	 * Возвращает @c true, если соединение существует.
+	 */
+	bool isConnected() const;
+
+	/**
+	 * Разрывает соединение. Повторный вызов ничего не делает.
+	 */
+	void disconnect();
+
+private:
+	template<typename T, typename K>
+	friend class Signal;
+
+	internal::ConnectionData* data_;
+
+	explicit Connection(internal::ConnectionData* data);
+};
+
+
+namespace internal {
+
+
+/**
+ * Соединение, вызов по которому выполняется асинхронно в потоке очереди задач. При
+ * генерации сигнала аргументы копируются в задачу, которая помещается в очередь. Объект
+ * соединения удаляется, когда сигнал отключен от него и все поставленные в очередь
+ * задачи выполнены или уничтожены.
+ */
+template<typename R, typename ...A>
+class QueuedSlot {
+public:
+	QueuedSlot(TaskQueue* queue, const Delegate<R(A...)>& delegate);
+
+	QueuedSlot(const QueuedSlot&) = delete;
+	QueuedSlot& operator=(const QueuedSlot&) = delete;
+
+	void post(A... args);
+
+	/**
+	 * Отключает соединение: задачи, которые еще находятся в очереди, не будут вызывать
+	 * функцию.
+	 */
+	void disconnect();
+
+	/**
+	 * Перепривязывает соединение к объекту, перемещенному на @p offset байт. Объект
+	 * должен перемещаться в потоке очереди задач.
+	 */
+	void moveTarget(iptr offset);
+
+private:
+	class Call;
+
+	std::atomic<int> refs_;
+	std::atomic<bool> isConnected_;
+	TaskQueue* queue_;
+	Delegate<R(A...)> delegate_;
+
+	void release();
+};
+
+
+} // namespace internal
+
+
 /**
  * @tparam T Сигнатура функции, к которой будет подключаться сигнал.
  * @tparam K Ключ доступа (Key<TypeName>), с помощью которого можно ограничить список
  *           типов, которым разрешено делать генерацию сигнала.
+ *
+ * Подключенные функции вызываются в порядке подключения. Во время генерации сигнала
+ * вызванные функции могут подключать и отключать функции этого же сигнала: отключенные
+ * функции больше не вызываются, а подключенные будут вызваны со следующей генерации.
+ * Отключенные соединения помечаются как удаленные и убираются из списка позже, когда
+ * их становится больше половины, поэтому массовое отключение занимает линейное время.
  */
-template<typename T, typename K = void>
-class Signal;
-
-
 template<typename R, typename K, typename ...A>
 class Signal<R(A...), K> : public TrackableWatcher {
 public:
@@ -146,42 +326,42 @@ public:
 
 	/**
 	 * Подключает статическую функцию @p function.
+	 *
+	 * Во всех функциях connect() можно задать очередь задач @p queue, в этом случае
+	 * подключенная функция вызывается асинхронно в потоке, который обрабатывает очередь
+	 * (например, в цикле обработки событий WindowSystem). Аргументы сигнала при этом
+	 * копируются, а возвращаемое значение функции игнорируется. Если соединение разорвано
+	 * до выполнения задачи (в том числе при удалении Trackable объекта в потоке очереди),
+	 * функция не вызывается. Сам сигнал не является потокобезопасным: подключения и
+	 * отключения не должны выполняться одновременно с его генерацией.
 	 */
-	void connect(R(*function)(A...));
-
-	/**
-	 * Подключает неконстантную функцию-член @p function объекта @p target.
-	 */
-	template<typename T, typename B, EnableIf<
-			Not<std::is_base_of<Trackable, T>>,
-			std::is_base_of<B, T>>...>
-	void connect(T* target, R(B::*function)(A...));
+	Connection connect(R(*function)(A...), TaskQueue* queue = nullptr);
 
 	/**
-	 * Подключает константную функцию-член @p function объекта @p target.
+	 * Подключает неконстантную функцию-член @p function объекта @p target. Если объект
+	 * наследует Trackable, соединение разрывается при его уничтожении.
 	 */
 	template<typename T, typename B, EnableIf<
-			std::is_base_of<Trackable, T>,
 			std::is_base_of<B, T>>...>
-	void connect(T* target, R(B::*function)(A...) const);
+	Connection connect(T* target, R(B::*function)(A...), TaskQueue* queue = nullptr);
 
 	/**
-	 * Подключает неконстантную функцию-член @p function отслеживаемого (Trackable)
-	 * объекта @p target.
+	 * Подключает константную функцию-член @p function объекта @p target. Если объект
+	 * наследует Trackable, соединение разрывается при его уничтожении.
 	 */
 	template<typename T, typename B, EnableIf<
-			std::is_base_of<Trackable, T>,
 			std::is_base_of<B, T>>...>
-	void connect(T* target, R(B::*function)(A...));
+	Connection connect(T* target, R(B::*function)(A...) const,
+			TaskQueue* queue = nullptr);
 
 	/**
-	 * Подключает константную функцию-член @p function отслеживаемого (Trackable) объекта
-	 * @p target.
+	 * Подключает функциональный объект @p functor (например, лямбда-функцию с захватом),
+	 * ограничения на объект описаны в Delegate. Такое соединение разрывается через
+	 * описатель Connection или отключением всех функций.
 	 */
-	template<typename T, typename B, EnableIf<
-			Not<std::is_base_of<Trackable, T>>,
-			std::is_base_of<B, T>>...>
-	void connect(T* target, R(B::*function)(A...) const);
+	template<typename F, EnableIf<
+			std::is_class<F>>...>
+	Connection connect(const F& functor, TaskQueue* queue = nullptr);
 
 	/**
 	 * Отключает все подключенные функции.
@@ -214,31 +394,187 @@ public:
 private:
 	using DelegateType = Delegate<R(A...)>;
 	using SignalType = Signal<R(A...), K>;
+	using QueuedSlotType = internal::QueuedSlot<R, A...>;
 
-	struct Info {
-		int isTrackable : 1;  // Признак связанности с методом потомка Trackable
-		int adjustment  : 15; // Смещение до начала структуры Trackable
+	struct Slot {
+		DelegateType delegate;
+		internal::ConnectionData* connection; // nullptr для удаленного соединения
+		QueuedSlotType* queued;               // Соединение через очередь или nullptr
 	};
 
-	std::vector<Pair<DelegateType, Info>> slots_;
-
 	/**
-	 * Анализирует соединение с индексом @p index и, если это возможно, выполняет
-	 * пеобразование и возвращает указатель на объект отслеживаемого класса (Trackable).
-	 * В случае, если соединение с индексом @p index не является соединением с методом
-	 * отслеживаемого класса (Trackable), возвращается @c nullptr.
-	 * Проверка корректности значения @p index не производится, т.к. эта функция не
-	 * является частью публичного интерфейса.
+	 * Увеличивает счетчик вложенных генераций сигнала на время вызова функций, чтобы
+	 * список соединений не уплотнялся и не перераспределялся, пока по нему идет
+	 * перебор. При выходе из внешней генерации переносит отложенные соединения.
 	 */
-	Trackable* getTrackable(int index) const;
+	class EmitGuard {
+	public:
+		explicit EmitGuard(const SignalType* signal);
+		~EmitGuard();
+
+	private:
+		const SignalType* signal_;
+	};
+
+	std::vector<Slot> slots_;
+	std::vector<Slot> pendingSlots_; // Подключенные во время генерации
+	size_t removedCount_ = 0;
+	mutable int emitDepth_ = 0;
+
+	template<typename T, EnableIf<
+			std::is_base_of<Trackable, T>>...>
+	static Trackable* trackableOf(T* target);
+
+	template<typename T, EnableIf<
+			Not<std::is_base_of<Trackable, T>>>...>
+	static Trackable* trackableOf(T* target);
+
+	Connection doConnect(const DelegateType& delegate, Trackable* trackable,
+			TaskQueue* queue);
 
 	void doDisconnect(const Delegate<R(A...)>& delegate);
 
-	void destroyEvent(Trackable* trackable);
-	void moveEvent(Trackable* old, Trackable* newTrackable);
+	/**
+	 * Возвращает соединение с индексом @p index. Индексы соединений, подключенных во
+	 * время генерации, продолжают индексы slots_.
+	 */
+	Slot& slotAt(size_t index);
+	size_t slotCount() const;
+
+	/**
+	 * Переносит соединения, подключенные во время генерации, в конец slots_.
+	 */
+	void mergePendingSlots();
+
+	/**
+	 * Помечает соединение с индексом @p index как удаленное, отменяя наблюдение за
+	 * Trackable объектом и отключая соединение через очередь задач.
+	 */
+	void eraseSlot(size_t index);
+
+	/**
+	 * Убирает удаленные соединения из списка, если их больше половины и сигнал не
+	 * генерируется в данный момент.
+	 */
+	void compact();
+
+	void disconnectSlot(size_t index) override;
+	void moveSlot(size_t index, iptr offset) override;
 };
 
 
+namespace internal {
+
+
+inline
+ConnectionData::ConnectionData(TrackableWatcher* watcher, size_t index,
+		Trackable* trackable) :
+	refs_(1),
+	trackableIndex_(0),
+	watcher_(watcher),
+	index_(index),
+	trackable_(trackable)
+{
+	if(trackable_)
+		trackable_->registerConnection(this);
+}
+
+
+inline
+void ConnectionData::addRef()
+{
+	++refs_;
+}
+
+
+inline
+bool ConnectionData::isConnected() const
+{
+	return watcher_ != nullptr;
+}
+
+
+inline
+void ConnectionData::disconnect()
+{
+	// Сигнал вызывает detach(), который может освободить последнюю ссылку на объект,
+	// поэтому после вызова обращаться к членам класса нельзя
+	if(watcher_)
+		watcher_->disconnectSlot(index_);
+}
+
+
+inline
+TrackableWatcher* ConnectionData::watcher() const
+{
+	return watcher_;
+}
+
+
+inline
+void ConnectionData::setWatcher(TrackableWatcher* watcher)
+{
+	watcher_ = watcher;
+}
+
+
+inline
+size_t ConnectionData::index() const
+{
+	return index_;
+}
+
+
+inline
+void ConnectionData::setIndex(size_t index)
+{
+	index_ = index;
+}
+
+
+inline
+u32 ConnectionData::trackableIndex() const
+{
+	return trackableIndex_;
+}
+
+
+inline
+void ConnectionData::setTrackableIndex(u32 index)
+{
+	trackableIndex_ = index;
+}
+
+
+inline
+void ConnectionData::detach()
+{
+	if(trackable_) {
+		trackable_->unregisterConnection(this);
+		trackable_ = nullptr;
+	}
+
+	watcher_ = nullptr;
+	release();
+}
+
+
+inline
+void ConnectionData::moveTrackable(Trackable* trackable)
+{
+	// Объект, с методом которого связано соединение, перемещается вместе со своей
+	// базовой частью Trackable, поэтому смещение у них одинаковое
+	iptr offset = reinterpret_cast<u8*>(trackable) - reinterpret_cast<u8*>(trackable_);
+	trackable_ = trackable;
+
+	if(watcher_)
+		watcher_->moveSlot(index_, offset);
+}
+
+
+} // namespace internal
+
+
 inline
 Trackable::Trackable(const Trackable&)
 {
@@ -248,25 +584,38 @@ Trackable::Trackable(const Trackable&)
 
 
 inline
-Trackable::Trackable(Trackable&& other)
+Trackable::Trackable(Trackable&& other) :
+	connectionCount_(other.connectionCount_),
+	capacity_(other.capacity_)
 {
-	// При перемещении уведомляем все подключенные сигналы об изменении нашего адреса
-	for(auto& it : other.watchers_)
-		it.first->moveEvent(&other, this);
+	// При перемещении забираем список соединений и перепривязываем их к нашему адресу
+	if(capacity_ > kInlineCapacity) {
+		heapConnections_ = other.heapConnections_;
+		other.capacity_ = kInlineCapacity;
+	}
+	else {
+		for(u32 i = 0; i < connectionCount_; ++i)
+			inlineConnections_[i] = other.inlineConnections_[i];
+	}
+
+	other.connectionCount_ = 0;
 
-	watchers_.swap(other.watchers_);
+	internal::ConnectionData** list = connections();
+	for(u32 i = 0; i < connectionCount_; ++i)
+		list[i]->moveTrackable(this);
 }
 
 
 inline
 Trackable::~Trackable()
 {
-	while(!watchers_.empty()) {
-		auto it = watchers_.begin();
+	// Разрыв соединения производит вызов unregisterConnection(), последний элемент
+	// удаляется без перестановок
+	while(connectionCount_)
+		connections()[connectionCount_ - 1]->disconnect();
 
-		// watcher->destroyEvent() производит вызов unregisterWatcher()
-		it->first->destroyEvent(this);
-	}
+	if(capacity_ > kInlineCapacity)
+		delete[] heapConnections_;
 }
 
 
@@ -280,37 +629,226 @@ Trackable& Trackable::operator=(const Trackable&)
 
 
 inline
-void Trackable::registerWatcher(TrackableWatcher* watcher)
+internal::ConnectionData** Trackable::connections()
 {
-	auto it = watchers_.find(watcher);
-	if(it == watchers_.end())
-		watchers_.emplace(std::make_pair(watcher, 1));
-	else
-		it->second++;
+	return capacity_ > kInlineCapacity ? heapConnections_ : inlineConnections_;
 }
 
 
 inline
-void Trackable::unregisterWatcher(TrackableWatcher* watcher)
+void Trackable::registerConnection(internal::ConnectionData* connection)
 {
-	auto it = watchers_.find(watcher);
-	if(it != watchers_.end()) {
-		it->second--;
-		if(it->second == 0)
-			watchers_.erase(it);
+	if(connectionCount_ == capacity_) {
+		u32 capacity = capacity_ * 2;
+		internal::ConnectionData** list = new internal::ConnectionData*[capacity];
+		internal::ConnectionData** old = connections();
+
+		for(u32 i = 0; i < connectionCount_; ++i)
+			list[i] = old[i];
+
+		if(capacity_ > kInlineCapacity)
+			delete[] heapConnections_;
+
+		heapConnections_ = list;
+		capacity_ = capacity;
 	}
+
+	connection->setTrackableIndex(connectionCount_);
+	connections()[connectionCount_++] = connection;
+}
+
+
+inline
+void Trackable::unregisterConnection(internal::ConnectionData* connection)
+{
+	internal::ConnectionData** list = connections();
+	internal::ConnectionData* last = list[--connectionCount_];
+
+	list[connection->trackableIndex()] = last;
+	last->setTrackableIndex(connection->trackableIndex());
+}
+
+
+inline
+Connection::Connection() :
+	data_(nullptr)
+{
+}
+
+
+inline
+Connection::Connection(internal::ConnectionData* data) :
+	data_(data)
+{
+	data_->addRef();
+}
+
+
+inline
+Connection::Connection(const Connection& other) :
+	data_(other.data_)
+{
+	if(data_)
+		data_->addRef();
+}
+
+
+inline
+Connection::Connection(Connection&& other) :
+	data_(other.data_)
+{
+	other.data_ = nullptr;
+}
+
+
+inline
+Connection::~Connection()
+{
+	if(data_)
+		data_->release();
+}
+
+
+inline
+Connection& Connection::operator=(const Connection& other)
+{
+	if(other.data_)
+		other.data_->addRef();
+
+	if(data_)
+		data_->release();
+
+	data_ = other.data_;
+	return *this;
 }
 
 
 inline
-void Trackable::updateWatcher(TrackableWatcher* old, TrackableWatcher* watcher)
+Connection& Connection::operator=(Connection&& other)
 {
-	auto it = watchers_.find(old);
-	if(it != watchers_.end()) {
-		int count = it->second;
-		watchers_.erase(it);
-		watchers_.emplace(std::make_pair(watcher, count));
+	if(this != &other) {
+		if(data_)
+			data_->release();
+
+		data_ = other.data_;
+		other.data_ = nullptr;
 	}
+
+	return *this;
+}
+
+
+inline
+bool Connection::isConnected() const
+{
+	return data_ && data_->isConnected();
+}
+
+
+inline
+void Connection::disconnect()
+{
+	if(data_)
+		data_->disconnect();
+}
+
+
+namespace internal {
+
+
+template<typename R, typename ...A>
+class QueuedSlot<R, A...>::Call final : public TaskQueue::Task {
+public:
+	template<typename ...Args>
+	Call(QueuedSlot* slot, Args&&... args) :
+		slot_(slot),
+		arguments_(std::forward<Args>(args)...)
+	{
+	}
+
+	~Call() override
+	{
+		slot_->release();
+	}
+
+	void run() override
+	{
+		if(slot_->isConnected_.load(std::memory_order_acquire))
+			invoke(std::index_sequence_for<A...>());
+	}
+
+private:
+	QueuedSlot* slot_;
+	Tuple<typename std::decay<A>::type...> arguments_;
+
+	template<size_t ...I>
+	void invoke(std::index_sequence<I...>)
+	{
+		slot_->delegate_(std::get<I>(arguments_)...);
+	}
+};
+
+
+template<typename R, typename ...A>
+QueuedSlot<R, A...>::QueuedSlot(TaskQueue* queue, const Delegate<R(A...)>& delegate) :
+	refs_(1),
+	isConnected_(true),
+	queue_(queue),
+	delegate_(delegate)
+{
+}
+
+
+template<typename R, typename ...A>
+void QueuedSlot<R, A...>::post(A... args)
+{
+	// Каждая задача в очереди владеет ссылкой на соединение
+	refs_.fetch_add(1, std::memory_order_relaxed);
+	queue_->post<Call>(this, args...);
+}
+
+
+template<typename R, typename ...A>
+void QueuedSlot<R, A...>::disconnect()
+{
+	isConnected_.store(false, std::memory_order_release);
+	release();
+}
+
+
+template<typename R, typename ...A>
+void QueuedSlot<R, A...>::moveTarget(iptr offset)
+{
+	delegate_.moveTarget(offset);
+}
+
+
+template<typename R, typename ...A>
+void QueuedSlot<R, A...>::release()
+{
+	if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete this;
+}
+
+
+} // namespace internal
+
+
+template<typename R, typename K, typename ...A>
+Signal<R(A...), K>::EmitGuard::EmitGuard(const SignalType* signal) :
+	signal_(signal)
+{
+	++signal_->emitDepth_;
+}
+
+
+template<typename R, typename K, typename ...A>
+Signal<R(A...), K>::EmitGuard::~EmitGuard()
+{
+	// Отложенные соединения появляются только через неконстантный connect(), поэтому
+	// сам сигнал не является константным объектом
+	if(--signal_->emitDepth_ == 0 && !signal_->pendingSlots_.empty())
+		const_cast<SignalType*>(signal_)->mergePendingSlots();
 }
 
 
@@ -325,15 +863,17 @@ Signal<R(A...), K>::Signal(const Signal<R(A...), K>&)
 template<typename R, typename K, typename ...A>
 Signal<R(A...), K>::Signal(Signal<R(A...), K>&& other)
 {
-	// При перемещении уведомляем все подключенные trackable объекты об изменении адреса
-	// сигнала
-	for(int i = 0; i < slots_.size(); ++i) {
-		Trackable* trackable = getTrackable(i);
-		if(trackable)
-			trackable->updateWatcher(&other, this);
-	}
-
+	// При перемещении сообщаем всем соединениям новый адрес сигнала
 	slots_.swap(other.slots_);
+	pendingSlots_.swap(other.pendingSlots_);
+	std::swap(removedCount_, other.removedCount_);
+
+	for(size_t i = 0; i < slotCount(); ++i) {
+		Slot& slot = slotAt(i);
+
+		if(slot.connection)
+			slot.connection->setWatcher(this);
+	}
 }
 
 
@@ -358,8 +898,22 @@ template<typename T1, typename T2, EnableIf<
 		std::is_void<T2>>...>
 void Signal<R(A...), K>::operator()(A... args) const
 {
-	for(auto& slot : slots_)
-		slot.first(args...);
+	// Функции, подключенные во время генерации, не вызываются: они попадают в
+	// pendingSlots_, поэтому вектор соединений не перераспределяется и функтор
+	// вызывается на месте, сохраняя изменения своего состояния.
+	EmitGuard guard(this);
+
+	for(size_t i = 0, count = slots_.size(); i < count; ++i) {
+		const Slot& slot = slots_[i];
+
+		if(!slot.connection)
+			continue;
+
+		if(slot.queued)
+			slot.queued->post(args...);
+		else
+			slot.delegate(args...);
+	}
 }
 
 
@@ -369,10 +923,20 @@ template<typename T1, typename T2, EnableIf<
 		std::is_void<T2>>...>
 R Signal<R(A...), K>::operator()(A... args) const
 {
+	EmitGuard guard(this);
 	R result = R();
 
-	for(auto& slot : slots_)
-		result = slot.first(args...);
+	for(size_t i = 0, count = slots_.size(); i < count; ++i) {
+		const Slot& slot = slots_[i];
+
+		if(!slot.connection)
+			continue;
+
+		if(slot.queued)
+			slot.queued->post(args...);
+		else
+			result = slot.delegate(args...);
+	}
 
 	return result;
 }
@@ -384,8 +948,19 @@ template<typename T1, typename T2, EnableIf<
 		Not<std::is_void<T2>>>...>
 void Signal<R(A...), K>::operator()(T2 key, A... args) const
 {
-	for(auto& slot : slots_)
-		slot.first(args...);
+	EmitGuard guard(this);
+
+	for(size_t i = 0, count = slots_.size(); i < count; ++i) {
+		const Slot& slot = slots_[i];
+
+		if(!slot.connection)
+			continue;
+
+		if(slot.queued)
+			slot.queued->post(args...);
+		else
+			slot.delegate(args...);
+	}
 }
 
 
@@ -395,10 +970,20 @@ template<typename T1, typename T2, EnableIf<
 		Not<std::is_void<T2>>>...>
 R Signal<R(A...), K>::operator()(T2 key, A... args) const
 {
+	EmitGuard guard(this);
 	R result = R();
 
-	for(auto& slot : slots_)
-		result = slot.first(args...);
+	for(size_t i = 0, count = slots_.size(); i < count; ++i) {
+		const Slot& slot = slots_[i];
+
+		if(!slot.connection)
+			continue;
+
+		if(slot.queued)
+			slot.queued->post(args...);
+		else
+			result = slot.delegate(args...);
+	}
 
 	return result;
 }
@@ -407,70 +992,42 @@ R Signal<R(A...), K>::operator()(T2 key, A... args) const
 template<typename R, typename K, typename ...A>
 bool Signal<R(A...), K>::hasConnections() const
 {
-	return !slots_.empty();
+	return slotCount() != removedCount_;
 }
 
 
 template<typename R, typename K, typename ...A>
-void Signal<R(A...), K>::connect(R (*function)(A...))
+Connection Signal<R(A...), K>::connect(R (*function)(A...), TaskQueue* queue)
 {
-	slots_.emplace_back(makePair(DelegateType(function), Info()));
+	return doConnect(DelegateType(function), nullptr, queue);
 }
 
 
 template<typename R, typename K, typename ...A>
 template<typename T, typename B, EnableIf<
-		Not<std::is_base_of<Trackable, T>>,
 		std::is_base_of<B, T>>...>
-void Signal<R(A...), K>::connect(T* target, R(B::*function)(A...))
+Connection Signal<R(A...), K>::connect(T* target, R(B::*function)(A...), TaskQueue* queue)
 {
-	Info info;
-	info.isTrackable = false;
-	slots_.emplace_back(makePair(DelegateType(target, function), info));
+	return doConnect(DelegateType(target, function), trackableOf(target), queue);
 }
 
 
 template<typename R, typename K, typename ...A>
 template<typename T, typename B, EnableIf<
-		Not<std::is_base_of<Trackable, T>>,
 		std::is_base_of<B, T>>...>
-void Signal<R(A...), K>::connect(T* target, R(B::*function)(A...) const)
+Connection Signal<R(A...), K>::connect(T* target, R(B::*function)(A...) const,
+		TaskQueue* queue)
 {
-	Info info;
-	info.isTrackable = false;
-	slots_.emplace_back(makePair(DelegateType(target, function), info));
+	return doConnect(DelegateType(target, function), trackableOf(target), queue);
 }
 
 
 template<typename R, typename K, typename ...A>
-template<typename T, typename B, EnableIf<
-		std::is_base_of<Trackable, T>,
-		std::is_base_of<B, T>>...>
-void Signal<R(A...), K>::connect(T* target, R(B::*function)(A...))
+template<typename F, EnableIf<
+		std::is_class<F>>...>
+Connection Signal<R(A...), K>::connect(const F& functor, TaskQueue* queue)
 {
-	Info info;
-	info.isTrackable = true;
-	info.adjustment = reinterpret_cast<u8*>(static_cast<Trackable*>(target)) -
-			  reinterpret_cast<u8*>(target);
-
-	target->registerWatcher(this);
-	slots_.emplace_back(makePair(DelegateType(target, function), info));
-}
-
-
-template<typename R, typename K, typename ...A>
-template<typename T, typename B, EnableIf<
-		std::is_base_of<Trackable, T>,
-		std::is_base_of<B, T>>...>
-void Signal<R(A...), K>::connect(T* target, R(B::*function)(A...) const)
-{
-	Info info;
-	info.isTrackable = true;
-	info.adjustment = reinterpret_cast<u8*>(static_cast<Trackable*>(target)) -
-					  reinterpret_cast<u8*>(target);
-
-	target->registerWatcher(this);
-	slots_.emplace_back(makePair(DelegateType(target, function), info));
+	return doConnect(DelegateType(functor), nullptr, queue);
 }
 
 
@@ -511,30 +1068,54 @@ void Signal<R(A...), K>::disconnect(T* target)
 	if(!target)
 		return;
 
-	for(int i = 0; i < slots_.size(); ++i) {
-		if(slots_[i].first.target() == target) {
-			Trackable* trackable = getTrackable(i);
-			if(trackable)
-				trackable->unregisterWatcher(this);
+	for(size_t i = 0; i < slotCount(); ++i) {
+		const Slot& slot = slotAt(i);
 
-			slots_.erase(slots_.begin() + i);
-			--i;
-		}
+		if(slot.connection && slot.delegate.target() == target)
+			eraseSlot(i);
 	}
+
+	compact();
+}
+
+
+template<typename R, typename K, typename ...A>
+template<typename T, EnableIf<
+		std::is_base_of<Trackable, T>>...>
+Trackable* Signal<R(A...), K>::trackableOf(T* target)
+{
+	return target;
 }
 
 
 template<typename R, typename K, typename ...A>
-Trackable* Signal<R(A...), K>::getTrackable(int index) const
+template<typename T, EnableIf<
+		Not<std::is_base_of<Trackable, T>>>...>
+Trackable* Signal<R(A...), K>::trackableOf(T* target)
 {
-	void* target = slots_[index].first.target();
-	const Info& info = slots_[index].second;
+	UNUSED(target);
+	return nullptr;
+}
+
+
+template<typename R, typename K, typename ...A>
+Connection Signal<R(A...), K>::doConnect(const DelegateType& delegate,
+		Trackable* trackable, TaskQueue* queue)
+{
+	compact();
+
+	Slot slot;
+	slot.delegate = delegate;
+	slot.connection = new internal::ConnectionData(this, slotCount(), trackable);
+	slot.queued = queue ? new QueuedSlotType(queue, delegate) : nullptr;
 
-	if(!info.isTrackable)
-		return nullptr;
+	// Во время генерации slots_ не перераспределяется: вызываемые функторы хранятся в нем
+	if(emitDepth_)
+		pendingSlots_.push_back(slot);
+	else
+		slots_.push_back(slot);
 
-	void* result = static_cast<u8*>(target) + info.adjustment;
-	return static_cast<Trackable*>(result);
+	return Connection(slot.connection);
 }
 
 
@@ -543,43 +1124,104 @@ void Signal<R(A...), K>::doDisconnect(const Delegate<R(A...)>& delegate)
 {
 	bool isDisconnectAll = delegate.isNull();
 
-	for(uint i = 0; i < slots_.size(); ++i) {
-		if(isDisconnectAll || slots_[i].first == delegate) {
-			Trackable* trackable = getTrackable(i);
-			if(trackable)
-				trackable->unregisterWatcher(this);
+	for(size_t i = 0; i < slotCount(); ++i) {
+		const Slot& slot = slotAt(i);
 
-			slots_.erase(slots_.begin() + i);
-			--i;
-		}
+		if(slot.connection && (isDisconnectAll || slot.delegate == delegate))
+			eraseSlot(i);
 	}
+
+	compact();
 }
 
 
 template<typename R, typename K, typename ...A>
-void Signal<R(A...), K>::destroyEvent(Trackable* trackable)
+typename Signal<R(A...), K>::Slot& Signal<R(A...), K>::slotAt(size_t index)
 {
-	for(uint i = 0; i < slots_.size(); ++i) {
-		Trackable* t = getTrackable(i);
-		if(t == trackable) {
-			trackable->unregisterWatcher(this);
-			slots_.erase(slots_.begin() + i);
-			--i;
-		}
+	if(index < slots_.size())
+		return slots_[index];
+
+	return pendingSlots_[index - slots_.size()];
+}
+
+
+template<typename R, typename K, typename ...A>
+size_t Signal<R(A...), K>::slotCount() const
+{
+	return slots_.size() + pendingSlots_.size();
+}
+
+
+template<typename R, typename K, typename ...A>
+void Signal<R(A...), K>::mergePendingSlots()
+{
+	// Индексы отложенных соединений уже продолжают slots_, удаленные соединения
+	// переносятся вместе с остальными и учтены в removedCount_
+	slots_.insert(slots_.end(), pendingSlots_.begin(), pendingSlots_.end());
+	pendingSlots_.clear();
+	compact();
+}
+
+
+template<typename R, typename K, typename ...A>
+void Signal<R(A...), K>::eraseSlot(size_t index)
+{
+	Slot& slot = slotAt(index);
+
+	slot.connection->detach();
+	slot.connection = nullptr;
+
+	if(slot.queued) {
+		slot.queued->disconnect();
+		slot.queued = nullptr;
 	}
+
+	++removedCount_;
 }
 
 
 template<typename R, typename K, typename ...A>
-void Signal<R(A...), K>::moveEvent(Trackable* old, Trackable* newTrackable)
+void Signal<R(A...), K>::compact()
 {
-	for(uint i = 0; i < slots_.size(); ++i) {
-		Trackable* trackable = getTrackable(i);
-		if(trackable == old) {
-			// TODO
-			break;
+	if(emitDepth_ || removedCount_ * 2 <= slots_.size())
+		return;
+
+	size_t count = 0;
+
+	for(size_t i = 0; i < slots_.size(); ++i) {
+		if(!slots_[i].connection)
+			continue;
+
+		if(i != count) {
+			slots_[count] = slots_[i];
+			slots_[count].connection->setIndex(count);
 		}
+
+		++count;
 	}
+
+	slots_.erase(slots_.begin() + count, slots_.end());
+	removedCount_ = 0;
+}
+
+
+template<typename R, typename K, typename ...A>
+void Signal<R(A...), K>::disconnectSlot(size_t index)
+{
+	eraseSlot(index);
+	compact();
+}
+
+
+template<typename R, typename K, typename ...A>
+void Signal<R(A...), K>::moveSlot(size_t index, iptr offset)
+{
+	Slot& slot = slotAt(index);
+
+	slot.delegate.moveTarget(offset);
+
+	if(slot.queued)
+		slot.queued->moveTarget(offset);
 }
 
 
@@ -0,0 +1,266 @@
+#ifndef TECH_SPSCQUEUE_H
+#define TECH_SPSCQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tech/types.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+/**
+ * Bounded lock-free queue for a single producer thread and a single consumer thread.
+ *
+ * The ring buffer is indexed by two counters on separate cache lines. Each side keeps a
+ * cached copy of the other side's counter and rereads the shared one only when the cached
+ * value says the ring is full (or empty), so in the steady state an operation touches no
+ * cache line written by the other thread except the element itself. pushBatch() and
+ * popBatch() publish a whole batch with a single store.
+ *
+ * Values may be move-only. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscQueue {
+public:
+	using ValueType = T;
+
+	explicit SpscQueue(size_t capacity);
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/**
+	 * Destroys the values left in the queue.
+	 */
+	~SpscQueue();
+
+	size_t capacity() const;
+
+	/**
+	 * Constructs the value from @p args at the tail. Returns @c false if the queue is
+	 * full. Producer only.
+	 */
+	template<typename ...Args>
+	bool tryEmplace(Args&&... args);
+
+	bool tryPush(const T& value);
+	bool tryPush(T&& value);
+
+	/**
+	 * Moves up to @p count values from @p first to the queue and returns their number.
+	 * Producer only.
+	 */
+	template<typename InputIt>
+	size_t pushBatch(InputIt first, size_t count);
+
+	/**
+	 * Moves the head value to @p value. Returns @c false if the queue is empty. Consumer
+	 * only.
+	 */
+	bool tryPop(T* value);
+
+	/**
+	 * Moves up to @p maxCount values to @p out and returns their number. Consumer only.
+	 */
+	template<typename OutputIt>
+	size_t popBatch(OutputIt out, size_t maxCount);
+
+	/**
+	 * Returns @c true if the queue has no values. Exact only when called by the
+	 * consumer.
+	 */
+	bool isEmpty() const;
+
+private:
+	static const size_t kCacheLineSize = 64;
+
+	using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	size_t mask_;
+	Box<Slot[]> slots_;
+
+	u8 padding1_[kCacheLineSize];
+	std::atomic<size_t> tail_;
+	size_t cachedHead_;
+	u8 padding2_[kCacheLineSize];
+	std::atomic<size_t> head_;
+	size_t cachedTail_;
+	u8 padding3_[kCacheLineSize];
+
+	T* slot(size_t position);
+
+	// Returns the number of free slots for the producer, or of values for the consumer,
+	// rereading the other side's counter if the cached one allows less than @p wanted
+	size_t freeCount(size_t tail, size_t wanted);
+	size_t readyCount(size_t head, size_t wanted);
+};
+
+
+template<typename T>
+SpscQueue<T>::SpscQueue(size_t capacity) :
+	mask_(ceilToPowerOfTwo(static_cast<u64>(std::max<size_t>(capacity, 2))) - 1),
+	slots_(new Slot[mask_ + 1]),
+	tail_(0),
+	cachedHead_(0),
+	head_(0),
+	cachedTail_(0)
+{
+}
+
+
+template<typename T>
+SpscQueue<T>::~SpscQueue()
+{
+	size_t tail = tail_.load(std::memory_order_acquire);
+
+	for(size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head)
+		slot(head)->~T();
+}
+
+
+template<typename T>
+size_t SpscQueue<T>::capacity() const
+{
+	return mask_ + 1;
+}
+
+
+template<typename T>
+template<typename ...Args>
+bool SpscQueue<T>::tryEmplace(Args&&... args)
+{
+	size_t tail = tail_.load(std::memory_order_relaxed);
+
+	if(freeCount(tail, 1) == 0)
+		return false;
+
+	new(slot(tail)) T(std::forward<Args>(args)...);
+	tail_.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T>
+bool SpscQueue<T>::tryPush(const T& value)
+{
+	return tryEmplace(value);
+}
+
+
+template<typename T>
+bool SpscQueue<T>::tryPush(T&& value)
+{
+	return tryEmplace(std::move(value));
+}
+
+
+template<typename T>
+template<typename InputIt>
+size_t SpscQueue<T>::pushBatch(InputIt first, size_t count)
+{
+	size_t tail = tail_.load(std::memory_order_relaxed);
+	size_t free = freeCount(tail, count);
+
+	if(count > free)
+		count = free;
+
+	for(size_t i = 0; i < count; ++i, ++first)
+		new(slot(tail + i)) T(std::move(*first));
+
+	if(count)
+		tail_.store(tail + count, std::memory_order_release);
+
+	return count;
+}
+
+
+template<typename T>
+bool SpscQueue<T>::tryPop(T* value)
+{
+	size_t head = head_.load(std::memory_order_relaxed);
+
+	if(readyCount(head, 1) == 0)
+		return false;
+
+	T* item = slot(head);
+	*value = std::move(*item);
+	item->~T();
+	head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T>
+template<typename OutputIt>
+size_t SpscQueue<T>::popBatch(OutputIt out, size_t maxCount)
+{
+	size_t head = head_.load(std::memory_order_relaxed);
+	size_t count = readyCount(head, maxCount);
+
+	if(count > maxCount)
+		count = maxCount;
+
+	for(size_t i = 0; i < count; ++i, ++out) {
+		T* item = slot(head + i);
+		*out = std::move(*item);
+		item->~T();
+	}
+
+	if(count)
+		head_.store(head + count, std::memory_order_release);
+
+	return count;
+}
+
+
+template<typename T>
+bool SpscQueue<T>::isEmpty() const
+{
+	return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
+
+
+template<typename T>
+T* SpscQueue<T>::slot(size_t position)
+{
+	return reinterpret_cast<T*>(&slots_[position & mask_]);
+}
+
+
+template<typename T>
+size_t SpscQueue<T>::freeCount(size_t tail, size_t wanted)
+{
+	size_t free = capacity() - (tail - cachedHead_);
+
+	if(free < wanted) {
+		cachedHead_ = head_.load(std::memory_order_acquire);
+		free = capacity() - (tail - cachedHead_);
+	}
+
+	return free;
+}
+
+
+template<typename T>
+size_t SpscQueue<T>::readyCount(size_t head, size_t wanted)
+{
+	size_t ready = cachedTail_ - head;
+
+	if(ready < wanted) {
+		cachedTail_ = tail_.load(std::memory_order_acquire);
+		ready = cachedTail_ - head;
+	}
+
+	return ready;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_SPSCQUEUE_H
@@ -0,0 +1,130 @@
+#ifndef TECH_TASKQUEUE_H
+#define TECH_TASKQUEUE_H
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tech/delegate.h>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Queue of tasks which are posted from any thread and run on the thread which owns the
+ * queue, usually by its event loop (see WindowSystem::taskQueue()).
+ *
+ * Tasks are constructed in place in chunks of memory owned by the queue. Drained chunks
+ * are kept for reuse, so in the steady state posting a task doesn't allocate memory.
+ *
+ * The wakeup handler is called by post() only when the queue turns from empty to
+ * non-empty, so a burst of tasks posted before the owner thread reacts costs a single
+ * wakeup and is run by a single processTasks() call. The handler is called from the
+ * posting thread and has to be thread-safe.
+ */
+class TaskQueue {
+public:
+	/**
+	 * Base class of queued tasks. The task is destroyed right after run(), or without
+	 * running when the queue is destroyed.
+	 */
+	class Task {
+	public:
+		virtual ~Task() = default;
+		virtual void run() = 0;
+	};
+
+	using WakeupHandler = Delegate<void()>;
+
+	explicit TaskQueue(const WakeupHandler& wakeupHandler = WakeupHandler());
+
+	TaskQueue(const TaskQueue&) = delete;
+	TaskQueue& operator=(const TaskQueue&) = delete;
+
+	/**
+	 * Destroys pending tasks without running them.
+	 */
+	~TaskQueue();
+
+	/**
+	 * Constructs the task of type @p T from @p args in the queue.
+	 */
+	template<typename T, typename ...Args>
+	void post(Args&&... args);
+
+	/**
+	 * Queues the call of @p delegate.
+	 */
+	void post(const Delegate<void()>& delegate);
+
+	/**
+	 * Runs all tasks queued before the call and returns their number. Tasks posted by
+	 * the running tasks are left for the next call. Must be called from the owner thread.
+	 */
+	size_t processTasks();
+
+	bool isEmpty() const;
+
+private:
+	static const size_t kChunkSize = 16 * 1024;
+	static const size_t kMaxFreeChunks = 4;
+	static const size_t kAlignment = alignof(std::max_align_t);
+
+	struct Chunk {
+		Chunk* next;
+		size_t capacity;
+		size_t used;
+	};
+
+	struct Record {
+		size_t size;
+		Task* task;
+	};
+
+	WakeupHandler wakeupHandler_;
+	mutable std::mutex mutex_;
+	Chunk* head_;
+	Chunk* tail_;
+	Chunk* freeChunks_;
+	size_t freeCount_;
+	size_t count_;
+
+	static size_t alignedSize(size_t size);
+	static u8* chunkData(Chunk* chunk);
+	static void destroyTasks(Chunk* chunk, bool run, size_t* count);
+
+	// Called under the lock: reserves space for the task of @p size bytes and returns
+	// the memory for the task object
+	void* allocate(size_t size, Record** record);
+
+	// Releases the lock and wakes the owner thread if the queue was empty
+	void commit(std::unique_lock<std::mutex>* lock);
+
+	void recycle(Chunk* chunks);
+};
+
+
+template<typename T, typename ...Args>
+void TaskQueue::post(Args&&... args)
+{
+	static_assert(std::is_base_of<Task, T>::value, "T must be derived from TaskQueue::Task");
+	static_assert(alignof(T) <= kAlignment, "Overaligned tasks are not supported");
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	Record* record;
+	void* memory = allocate(sizeof(T), &record);
+
+	// The task is constructed under the lock, so the owner thread never sees a record
+	// without an object
+	record->task = new(memory) T(std::forward<Args>(args)...);
+	commit(&lock);
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_TASKQUEUE_H
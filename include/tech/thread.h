@@ -4,8 +4,10 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 #include <tech/duration.h>
 #include <tech/signal.h>
+#include <tech/string.h>
 #include <tech/types.h>
 
 
@@ -20,14 +22,68 @@ enum class ThreadState {
 };
 
 
+enum class ThreadPolicy {
+	kDefault,   ///< Time sharing, the priority is the nice value (Linux only)
+	kFifo,      ///< Real-time first in, first out, the priority is 1 to 99
+	kRoundRobin ///< Real-time round-robin, the priority is 1 to 99
+};
+
+
+/**
+ * Thread which runs run() of the derived class.
+ *
+ * The name, CPU affinity, scheduling policy and stack size are applied by the next
+ * start(). By default the thread is detached and its end is observed with
+ * waitForFinished(). A joinable thread is joined by join() or by the destructor, which
+ * makes sure that the thread is gone before the object is.
+ *
+ * Affinity, scheduling and stack size take effect on POSIX systems, affinity and nice
+ * values on Linux only. Real-time policies and negative nice values usually need
+ * privileges, start() fails without them. The nice value is set by the new thread, so
+ * start() waits for it to begin when one is given.
+ */
 class Thread : public virtual Trackable {
 public:
 	Thread();
 	virtual ~Thread();
 
-	void start();
+	/**
+	 * Sets the name shown by top and perf. Linux truncates it to 15 bytes.
+	 */
+	void setName(const String& name);
+	String name() const;
+
+	/**
+	 * Pins the thread to @p cpus, an empty list means any CPU.
+	 */
+	void setAffinity(const std::vector<int>& cpus);
+	std::vector<int> affinity() const;
+
+	void setScheduling(ThreadPolicy policy, int priority = 0);
+	ThreadPolicy schedulingPolicy() const;
+	int schedulingPriority() const;
+
+	/**
+	 * Sets the stack size in bytes, zero means the system default.
+	 */
+	void setStackSize(size_t size);
+	size_t stackSize() const;
+
+	void setJoinable(bool joinable);
+	bool isJoinable() const;
+
+	/**
+	 * Starts the thread unless it's running. Returns @c false if the thread can't be
+	 * created with the given settings.
+	 */
+	bool start();
 	void stop();
 
+	/**
+	 * Waits for the end of a thread started as joinable, does nothing otherwise.
+	 */
+	void join();
+
 	bool waitForStarted(const Duration& timeout = Duration());
 	bool waitForFinished(const Duration& timeout = Duration());
 
@@ -39,11 +95,31 @@ protected:
 	virtual void run() = 0;
 
 private:
+	struct Handle;
+
 	std::atomic_flag exitFlag_;
 	std::atomic<ThreadState> state_;
 	mutable std::mutex guard_;
 	std::condition_variable event_;
 
+	String name_;
+	std::vector<int> affinity_;
+	ThreadPolicy policy_;
+	int priority_;
+	size_t stackSize_;
+	bool isJoinable_;
+
+	// Set by the thread if it can't apply the settings, guarded by guard_
+	bool isStartFailed_;
+
+	Box<Handle> handle_;
+
+	bool launch();
+
+	// Applies the settings which can only be changed by the thread itself, returns
+	// @c false if the nice value can't be set
+	bool applySettings();
+
 	static void trampoline(Thread* self);
 };
 
@@ -0,0 +1,230 @@
+#ifndef TECH_THREADPOOL_H
+#define TECH_THREADPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Fixed set of worker threads which run small tasks submitted from any thread.
+ *
+ * Every worker owns a Chase-Lev deque: tasks submitted from a worker are pushed to its
+ * own deque and popped in LIFO order, idle workers steal the oldest tasks from the other
+ * deques. Tasks submitted from other threads go to a shared injection queue. Workers
+ * which find no work spin for a short while and then park on a futex; submission wakes a
+ * parked worker only if there is one, so a busy pool doesn't make system calls.
+ *
+ * Tasks may be tracked by a Group. When a task waits for a group, its worker runs other
+ * tasks meanwhile, so tasks may submit subtasks and wait for them without blocking a
+ * worker.
+ *
+ * Tasks must not throw exceptions.
+ */
+class ThreadPool {
+public:
+	/**
+	 * Counter of unfinished tasks submitted with the group. The group must not be
+	 * destroyed while it has unfinished tasks.
+	 */
+	class Group {
+	public:
+		Group();
+
+		Group(const Group&) = delete;
+		Group& operator=(const Group&) = delete;
+
+		bool isFinished() const;
+
+	private:
+		friend class ThreadPool;
+
+		// Set in pending_ by parked waiters, so that only the completion of a waited
+		// group wakes anybody
+		static const u32 kWorkerWaiterBit = 1u << 31;
+		static const u32 kBlockedWaiterBit = 1u << 30;
+		static const u32 kCountMask = kBlockedWaiterBit - 1;
+
+		std::atomic<u32> pending_;
+	};
+
+	/**
+	 * Starts @p threadCount workers, or defaultThreadCount() workers if it's zero.
+	 */
+	explicit ThreadPool(size_t threadCount = 0);
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Waits for all submitted tasks to finish and stops the workers. Tasks may not be
+	 * submitted from other threads at this point.
+	 */
+	~ThreadPool();
+
+	/**
+	 * Returns the number of hardware threads, at least 1.
+	 */
+	static size_t defaultThreadCount();
+
+	/**
+	 * Returns the pool with defaultThreadCount() workers shared by the library, created
+	 * on the first call and stopped at exit.
+	 */
+	static ThreadPool* shared();
+
+	size_t threadCount() const;
+
+	/**
+	 * Runs @p function, a callable without arguments, on one of the workers.
+	 */
+	template<typename F>
+	void submit(F&& function);
+
+	/**
+	 * Runs @p function on one of the workers as a part of @p group.
+	 */
+	template<typename F>
+	void submit(Group* group, F&& function);
+
+	/**
+	 * Waits until all tasks of @p group finish. A worker of the pool runs other tasks
+	 * meanwhile and parks only when there is nothing to run, other threads just park.
+	 */
+	void wait(Group* group);
+
+private:
+	class Job {
+	public:
+		explicit Job(Group* group);
+		virtual ~Job() = default;
+		virtual void run() = 0;
+
+		Group* group() const;
+
+	private:
+		Group* group_;
+	};
+
+	template<typename F>
+	class FunctionJob;
+
+	class Worker;
+
+	static thread_local Worker* currentWorker_;
+
+	std::vector<Box<Worker>> workers_;
+
+	std::mutex injectionMutex_;
+	std::deque<Job*> injection_;
+	std::atomic<size_t> injectedCount_;
+
+	// Incremented to wake parked workers, which wait on it with a futex
+	std::atomic<u32> epoch_;
+	std::atomic<u32> sleeperCount_;
+
+	// Threads outside the pool waiting for a group don't take tasks, they wait on a
+	// separate futex which is incremented only when a waited group finishes
+	std::atomic<u32> finishEpoch_;
+
+	std::atomic<bool> isStopping_;
+
+	void post(Job* job);
+
+	// Own deque first, then the injection queue, then the other workers' deques.
+	// @p worker is null for threads which don't belong to the pool.
+	Job* findJob(Worker* worker);
+	Job* takeInjected();
+	Job* steal(Worker* worker);
+
+	void runJob(Job* job);
+	bool hasWork() const;
+
+	// Parks the calling thread unless there is work, the pool is stopping or @p group
+	// (if not null) is finished
+	void park(Group* group);
+	void wake(int count);
+
+	// Waits for @p group on a thread outside the pool
+	void block(Group* group);
+
+	void workerLoop(Worker* worker);
+};
+
+
+template<typename F>
+class ThreadPool::FunctionJob final : public Job {
+public:
+	template<typename T>
+	FunctionJob(Group* group, T&& function) :
+		Job(group),
+		function_(std::forward<T>(function))
+	{
+	}
+
+	void run() override
+	{
+		function_();
+	}
+
+private:
+	F function_;
+};
+
+
+inline
+ThreadPool::Group::Group() :
+	pending_(0)
+{
+}
+
+
+inline
+bool ThreadPool::Group::isFinished() const
+{
+	return (pending_.load(std::memory_order_acquire) & kCountMask) == 0;
+}
+
+
+inline
+ThreadPool::Job::Job(Group* group) :
+	group_(group)
+{
+}
+
+
+inline
+ThreadPool::Group* ThreadPool::Job::group() const
+{
+	return group_;
+}
+
+
+template<typename F>
+void ThreadPool::submit(F&& function)
+{
+	submit(nullptr, std::forward<F>(function));
+}
+
+
+template<typename F>
+void ThreadPool::submit(Group* group, F&& function)
+{
+	if(group)
+		group->pending_.fetch_add(1, std::memory_order_relaxed);
+
+	post(new FunctionJob<typename std::decay<F>::type>(group, std::forward<F>(function)));
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_THREADPOOL_H
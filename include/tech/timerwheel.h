@@ -0,0 +1,163 @@
+#ifndef TECH_TIMERWHEEL_H
+#define TECH_TIMERWHEEL_H
+
+#include <vector>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Hierarchical timing wheel for a large number of timers with millisecond resolution.
+ *
+ * Each of the kLevelCount levels has 64 slots, a slot of level N covers 64^N ticks
+ * (milliseconds). A timer is put to the lowest level on which its deadline falls into the
+ * current span of the wheel, into an intrusive list, so start() and stop() are O(1) and
+ * allocate nothing once the timer is created. When the time reaches a slot of an upper
+ * level, its timers are moved to the lower levels. Every level keeps a bitmap of the
+ * occupied slots, so nextDeadline() and advance() skip empty time in a few instructions.
+ *
+ * Times are arbitrary monotonic milliseconds chosen by the owner, usually
+ * CLOCK_MONOTONIC. The wheel isn't thread-safe.
+ */
+class TimerWheel {
+public:
+	using Handle = u32;
+	static const Handle kInvalidHandle = 0;
+
+	/**
+	 * Creates the wheel with the current time @p now.
+	 */
+	explicit TimerWheel(i64 now = 0);
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	/**
+	 * Creates an inactive timer. Handles of destroyed timers are reused.
+	 */
+	Handle create();
+	void destroy(Handle handle);
+
+	/**
+	 * Schedules the timer to expire @p timeout milliseconds after @p now, and then every
+	 * @p timeout milliseconds if @p periodic is @c true. Restarts an active timer.
+	 * Deadlines which have already passed for the wheel expire on the next advance().
+	 */
+	void start(Handle handle, i64 now, i64 timeout, bool periodic = false);
+	void stop(Handle handle);
+
+	bool isActive(Handle handle) const;
+	bool isPeriodic(Handle handle) const;
+
+	/**
+	 * Returns the timeout given to start().
+	 */
+	i64 interval(Handle handle) const;
+
+	/**
+	 * Returns the number of active timers.
+	 */
+	size_t activeCount() const;
+
+	/**
+	 * Returns the time processed by the last advance().
+	 */
+	i64 currentTime() const;
+
+	/**
+	 * Returns the earliest time at which advance() has to be called, or -1 if no timer is
+	 * active. When the nearest timer is on an upper level this is the time its slot is
+	 * moved down, so a wakeup may find nothing to expire and then the next deadline is
+	 * nearer.
+	 */
+	i64 nextDeadline() const;
+
+	/**
+	 * Moves the wheel to @p now and calls @p handler(handle) for every expired timer in
+	 * the order of deadlines. A periodic timer is rescheduled before its call and expires
+	 * once per call even if several periods have passed. The handler may create, start,
+	 * stop and destroy timers; timers started with a zero timeout by the handler expire
+	 * in the same call only if @p now is past the current tick. Returns the number of
+	 * expired timers.
+	 */
+	template<typename F>
+	size_t advance(i64 now, F&& handler);
+
+private:
+	static const int kLevelBits = 6;
+	static const int kSlotCount = 1 << kLevelBits;
+	static const int kLevelCount = 8;
+
+	// Longer timeouts are shortened to fit the wheel (about 35 years)
+	static const i64 kMaxTimeout = i64(1) << 40;
+
+	static const u16 kInactive = 0xFFFF;
+
+	struct Entry {
+		i64 deadline;
+		i64 interval;
+		Handle prev;
+		Handle next;
+		u16 slot;
+		bool isPeriodic;
+		bool isUsed;
+	};
+
+	std::vector<Entry> entries_;
+	std::vector<Handle> freeHandles_;
+	Handle heads_[kLevelCount * kSlotCount];
+	u64 occupied_[kLevelCount];
+	i64 current_;
+	size_t activeCount_;
+
+	Entry& entry(Handle handle);
+	const Entry& entry(Handle handle) const;
+
+	void link(Handle handle, i64 deadline);
+	void unlink(Handle handle);
+
+	// Returns the first level with active timers, or kLevelCount
+	int firstOccupiedLevel() const;
+	i64 levelDeadline(int level) const;
+
+	// Removes and returns the next timer expired at @p now, moving the wheel towards
+	// @p now as needed
+	Handle takeExpired(i64 now);
+};
+
+
+inline
+TimerWheel::Entry& TimerWheel::entry(Handle handle)
+{
+	return entries_[handle - 1];
+}
+
+
+inline
+const TimerWheel::Entry& TimerWheel::entry(Handle handle) const
+{
+	return entries_[handle - 1];
+}
+
+
+template<typename F>
+size_t TimerWheel::advance(i64 now, F&& handler)
+{
+	size_t count = 0;
+
+	for(Handle handle = takeExpired(now); handle != kInvalidHandle;
+			handle = takeExpired(now)) {
+		handler(handle);
+		++count;
+	}
+
+	return count;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_TIMERWHEEL_H
@@ -0,0 +1,442 @@
+#include <tech/asynclogger.h>
+
+#include <climits>
+#include <cstring>
+#include <thread>
+#include "futex.h"
+
+
+namespace Tech {
+
+
+class AsyncLogger::Writer final : public Thread {
+public:
+	explicit Writer(AsyncLogger* logger) :
+		logger_(logger)
+	{
+		setName("AsyncLogger");
+		setJoinable(true);
+	}
+
+	~Writer() override
+	{
+		waitForStarted();
+		stop();
+		logger_->wakeup_.post();
+		waitForFinished();
+	}
+
+protected:
+	void run() override
+	{
+		while(state() == ThreadState::kRunning) {
+			if(!logger_->processBatch())
+				logger_->waitForRecords();
+		}
+
+		// Flush on shutdown: everything queued before the destructor has to be written
+		while(logger_->processBatch()) {
+		}
+	}
+
+private:
+	AsyncLogger* logger_;
+};
+
+
+AsyncLogger::AsyncLogger(const LogMessageHandler& sink, size_t capacity,
+		OverflowPolicy policy, const Delegate<void()>& drainHandler) :
+	sink_(sink),
+	drainHandler_(drainHandler),
+	policy_(policy),
+	mask_(ceilToPowerOfTwo(static_cast<u64>(std::max<size_t>(capacity, 2))) - 1),
+	cells_(new Cell[mask_ + 1]),
+	enqueuePos_(0),
+	dequeuePos_(0),
+	completed_(0),
+	dropped_(0),
+	isWriterSleeping_(false),
+	flushWaiters_(0),
+	flushEpoch_(0),
+	writer_(new Writer(this)),
+	lastFileName_(nullptr),
+	undrainedCount_(0)
+{
+	for(size_t i = 0; i <= mask_; ++i) {
+		cells_[i].sequence.store(i, std::memory_order_relaxed);
+		cells_[i].record.type = RecordType::kMessage;
+	}
+
+	writer_->start();
+	writer_->waitForStarted();
+}
+
+
+AsyncLogger::~AsyncLogger()
+{
+	// Writer destructor drains the buffer before the thread exits
+	writer_.reset();
+}
+
+
+void AsyncLogger::post(LogLevel level, const String& file, int line,
+		const String& message)
+{
+	size_t pos;
+	Cell* cell = reserve(&pos);
+
+	if(!cell)
+		return;
+
+	Record& record = cell->record;
+	record.type = RecordType::kMessage;
+	record.level = level;
+	record.line = line;
+	record.file = file;
+	record.message = message;
+	publish(cell, pos);
+}
+
+
+bool AsyncLogger::postDeferred(LogLevel level, const char* fileName, int line,
+		const DeferredMessage& message)
+{
+	if(message.size > kMaxDeferredSize || message.alignment > alignof(std::max_align_t))
+		return false;
+
+	size_t pos;
+	Cell* cell = reserve(&pos);
+
+	if(!cell)
+		return true;
+
+	Record& record = cell->record;
+	record.type = RecordType::kDeferred;
+	record.level = level;
+	record.line = line;
+	record.fileName = fileName;
+	record.format = message.format;
+	record.proc = message.proc;
+	message.proc(DeferredMessage::kConstruct, record.arguments, message.source,
+			nullptr, nullptr);
+	publish(cell, pos);
+	return true;
+}
+
+
+bool AsyncLogger::postFields(LogLevel level, const char* fileName, int line,
+		const char* message, const LogFields& fields)
+{
+	if(fields.size() > kMaxDeferredSize)
+		return false;
+
+	size_t pos;
+	Cell* cell = reserve(&pos);
+
+	if(!cell)
+		return true;
+
+	Record& record = cell->record;
+	record.type = RecordType::kFields;
+	record.level = level;
+	record.line = line;
+	record.fileName = fileName;
+	record.format = message;
+	record.fieldsSize = fields.size();
+	std::memcpy(record.arguments, fields.data(), fields.size());
+	publish(cell, pos);
+	return true;
+}
+
+
+void AsyncLogger::setRecordHandler(const LogRecordHandler& handler)
+{
+	recordHandler_ = handler;
+}
+
+
+void AsyncLogger::flush()
+{
+	size_t target = enqueuePos_.load(std::memory_order_acquire);
+
+	if(completed_.load(std::memory_order_acquire) >= target)
+		return;
+
+	// Registration pairs with the check in complete(): either the writer sees the waiter
+	// or we see the completed records. The epoch is read before the check, so that its
+	// advance between the check and the wait isn't missed.
+	flushWaiters_.fetch_add(1);
+	wakeWriter();
+
+	while(true) {
+		u32 epoch = flushEpoch_.load(std::memory_order_acquire);
+
+		if(completed_.load() >= target)
+			break;
+
+		waitOnAddress(&flushEpoch_, epoch);
+	}
+
+	flushWaiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+size_t AsyncLogger::capacity() const
+{
+	return mask_ + 1;
+}
+
+
+AsyncLogger::OverflowPolicy AsyncLogger::overflowPolicy() const
+{
+	return policy_;
+}
+
+
+u64 AsyncLogger::droppedCount() const
+{
+	return dropped_.load(std::memory_order_relaxed);
+}
+
+
+AsyncLogger::Cell* AsyncLogger::tryReserve(size_t* pos)
+{
+	// Bounded MPMC queue by Dmitry Vyukov: every cell has a sequence number which tells
+	// whether the cell is free for the producer with a given position or contains the
+	// value for the consumer with a given position
+	size_t position = enqueuePos_.load(std::memory_order_relaxed);
+
+	while(true) {
+		Cell* cell = &cells_[position & mask_];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		iptr diff = static_cast<iptr>(sequence) - static_cast<iptr>(position);
+
+		if(diff == 0) {
+			if(enqueuePos_.compare_exchange_weak(position, position + 1)) {
+				*pos = position;
+				return cell;
+			}
+		}
+		else if(diff < 0) {
+			return nullptr;
+		}
+		else {
+			position = enqueuePos_.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+
+AsyncLogger::Cell* AsyncLogger::reserve(size_t* pos)
+{
+	Cell* cell = tryReserve(pos);
+
+	if(cell)
+		return cell;
+
+	switch(policy_) {
+	case OverflowPolicy::kBlock:
+		do {
+			wakeWriter();
+			std::this_thread::yield();
+		} while(!(cell = tryReserve(pos)));
+		break;
+
+	case OverflowPolicy::kDrop:
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		break;
+
+	case OverflowPolicy::kDropOldest:
+		do {
+			size_t oldestPos;
+			Cell* oldest = tryAcquire(&oldestPos);
+
+			if(oldest) {
+				Record& record = oldest->record;
+
+				if(record.type == RecordType::kDeferred) {
+					record.proc(DeferredMessage::kDestroy, record.arguments, nullptr,
+							nullptr, nullptr);
+					record.type = RecordType::kMessage;
+				}
+
+				release(oldest, oldestPos);
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				complete(1);
+			}
+		} while(!(cell = tryReserve(pos)));
+		break;
+	}
+
+	return cell;
+}
+
+
+void AsyncLogger::publish(Cell* cell, size_t pos)
+{
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	wakeWriter();
+}
+
+
+AsyncLogger::Cell* AsyncLogger::tryAcquire(size_t* pos)
+{
+	size_t position = dequeuePos_.load(std::memory_order_relaxed);
+
+	while(true) {
+		Cell* cell = &cells_[position & mask_];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		iptr diff = static_cast<iptr>(sequence) - static_cast<iptr>(position + 1);
+
+		if(diff == 0) {
+			if(dequeuePos_.compare_exchange_weak(position, position + 1,
+					std::memory_order_relaxed)) {
+				*pos = position;
+				return cell;
+			}
+		}
+		else if(diff < 0) {
+			return nullptr;
+		}
+		else {
+			position = dequeuePos_.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+
+void AsyncLogger::release(Cell* cell, size_t pos)
+{
+	cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+}
+
+
+void AsyncLogger::wakeWriter()
+{
+	// Pairs with the sequentially consistent store in waitForRecords(): either the
+	// writer sees the new enqueue position or we see that the writer is sleeping
+	if(isWriterSleeping_.load() && isWriterSleeping_.exchange(false))
+		wakeup_.post();
+}
+
+
+void AsyncLogger::complete(size_t count)
+{
+	completed_.fetch_add(count);
+
+	if(flushWaiters_.load() != 0) {
+		flushEpoch_.fetch_add(1, std::memory_order_release);
+		wakeByAddress(&flushEpoch_, INT_MAX);
+	}
+}
+
+
+const String& AsyncLogger::fileOf(const Record& record)
+{
+	if(record.fileName != lastFileName_) {
+		lastFileName_ = record.fileName;
+		lastFile_ = String(record.fileName);
+	}
+
+	return lastFile_;
+}
+
+
+void AsyncLogger::write(Record* record)
+{
+	switch(record->type) {
+	case RecordType::kMessage:
+		sink_(record->level, record->file, record->line, record->message);
+		break;
+
+	case RecordType::kDeferred: {
+		String message;
+		record->proc(DeferredMessage::kFormat, record->arguments, nullptr, record->format,
+				&message);
+		record->proc(DeferredMessage::kDestroy, record->arguments, nullptr, nullptr,
+				nullptr);
+		record->type = RecordType::kMessage;
+
+		sink_(record->level, fileOf(*record), record->line, message);
+		break;
+	}
+
+	case RecordType::kFields: {
+		LogFields fields(record->arguments, record->fieldsSize);
+
+		if(!recordHandler_.isNull()) {
+			recordHandler_(record->level, fileOf(*record), record->line, record->format,
+					fields);
+		}
+		else {
+			renderBuffer_.clear();
+			renderLogRecord(LogFieldFormat::kText, record->format, fields, &renderBuffer_);
+			sink_(record->level, fileOf(*record), record->line,
+					String::fromUtf8(renderBuffer_.data(), renderBuffer_.size()));
+		}
+
+		break;
+	}
+	}
+}
+
+
+bool AsyncLogger::processBatch()
+{
+	// Records are written in place: the cell stays acquired while the sink runs, so the
+	// arguments of deferred messages are never copied once more
+	size_t count = 0;
+	size_t pos;
+	bool isEmpty = false;
+
+	while(count < kBatchSize) {
+		Cell* cell = tryAcquire(&pos);
+
+		if(!cell) {
+			isEmpty = true;
+			break;
+		}
+
+		write(&cell->record);
+		release(cell, pos);
+		++count;
+	}
+
+	// Records are marked as completed after the drain handler, so that flush() returns
+	// when buffering sinks have written them. Under constant load the handler is called
+	// every kMaxUndrainedCount records.
+	undrainedCount_ += count;
+	bool hasDrainHandler = !drainHandler_.isNull();
+
+	if(undrainedCount_ &&
+			(isEmpty || undrainedCount_ >= kMaxUndrainedCount || !hasDrainHandler)) {
+		if(hasDrainHandler)
+			drainHandler_();
+
+		complete(undrainedCount_);
+		undrainedCount_ = 0;
+	}
+
+	return count != 0;
+}
+
+
+void AsyncLogger::waitForRecords()
+{
+	static const Duration kIdleTimeout(100);
+
+	isWriterSleeping_.store(true);
+
+	if(enqueuePos_.load() != dequeuePos_.load(std::memory_order_relaxed)) {
+		// A producer has claimed a cell but may not have published it yet
+		isWriterSleeping_.store(false, std::memory_order_relaxed);
+		std::this_thread::yield();
+		return;
+	}
+
+	wakeup_.wait(kIdleTimeout);
+	isWriterSleeping_.store(false, std::memory_order_relaxed);
+}
+
+
+} // namespace Tech
@@ -0,0 +1,473 @@
+#include <tech/eventloop.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+// Epoll data of the internal descriptors, watches have a generation below 2^31
+const u64 kWakeupData = ~u64(0);
+const u64 kTimerData = ~u64(0) - 1;
+
+const u32 kGenerationMask = 0x7FFFFFFF;
+
+
+const i64 kNanosecondsPerMillisecond = 1000000;
+
+
+i64 monotonicTime()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<i64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+
+u32 toEpollEvents(IoEvents events)
+{
+	u32 result = 0;
+
+	if(events & IoEvent::kRead)
+		result |= EPOLLIN | EPOLLRDHUP;
+
+	if(events & IoEvent::kWrite)
+		result |= EPOLLOUT;
+
+	return result;
+}
+
+
+IoEvents fromEpollEvents(u32 events)
+{
+	IoEvents result;
+
+	if(events & (EPOLLIN | EPOLLPRI))
+		result |= IoEvent::kRead;
+
+	if(events & EPOLLOUT)
+		result |= IoEvent::kWrite;
+
+	if(events & EPOLLERR)
+		result |= IoEvent::kError;
+
+	if(events & (EPOLLHUP | EPOLLRDHUP))
+		result |= IoEvent::kHangup;
+
+	return result;
+}
+
+
+} // namespace
+
+
+const EventLoop::TimerHandle EventLoop::kInvalidTimer;
+
+
+EventLoop::EventLoop() :
+	epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+	wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	timerFd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+	timerWheel_(monotonicTime() / kNanosecondsPerMillisecond),
+	armedDeadline_(-1),
+	runningTimer_(kInvalidTimer),
+	taskQueue_(TaskQueue::WakeupHandler(this, &EventLoop::wakeup)),
+	quitRequested_(false),
+	exitCode_(0),
+	isRunning_(false),
+	lastIteration_(),
+	statistics_()
+{
+	if(epollFd_ == -1)
+		return;
+
+	if(wakeupFd_ != -1 && !addToEpoll(wakeupFd_, kWakeupData, EPOLLIN)) {
+		close(wakeupFd_);
+		wakeupFd_ = -1;
+	}
+
+	if(timerFd_ != -1 && !addToEpoll(timerFd_, kTimerData, EPOLLIN)) {
+		close(timerFd_);
+		timerFd_ = -1;
+	}
+}
+
+
+EventLoop::~EventLoop()
+{
+	if(timerFd_ != -1)
+		close(timerFd_);
+
+	if(wakeupFd_ != -1)
+		close(wakeupFd_);
+
+	if(epollFd_ != -1)
+		close(epollFd_);
+}
+
+
+EventLoop* EventLoop::instance()
+{
+	static thread_local EventLoop instance;
+	return &instance;
+}
+
+
+bool EventLoop::isValid() const
+{
+	return epollFd_ != -1 && wakeupFd_ != -1 && timerFd_ != -1;
+}
+
+
+bool EventLoop::watch(int fd, IoEvents events, const IoHandler& handler)
+{
+	if(fd < 0 || isWatched(fd))
+		return false;
+
+	if(static_cast<size_t>(fd) >= watches_.size())
+		watches_.resize(static_cast<size_t>(fd) + 1, Watch{IoHandler(), IoEvent::kNone, 0,
+				false});
+
+	Watch& watch = watches_[static_cast<size_t>(fd)];
+	u32 generation = (watch.generation + 1) & kGenerationMask;
+	u64 data = static_cast<u64>(generation) << 32 | static_cast<u32>(fd);
+
+	if(!addToEpoll(fd, data, toEpollEvents(events)))
+		return false;
+
+	watch.handler = handler;
+	watch.events = events;
+	watch.generation = generation;
+	watch.isActive = true;
+	return true;
+}
+
+
+bool EventLoop::modifyWatch(int fd, IoEvents events)
+{
+	if(!isWatched(fd))
+		return false;
+
+	Watch& watch = watches_[static_cast<size_t>(fd)];
+
+	epoll_event event;
+	event.events = toEpollEvents(events);
+	event.data.u64 = static_cast<u64>(watch.generation) << 32 | static_cast<u32>(fd);
+
+	if(epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == -1)
+		return false;
+
+	watch.events = events;
+	return true;
+}
+
+
+void EventLoop::unwatch(int fd)
+{
+	if(!isWatched(fd))
+		return;
+
+	epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+
+	Watch& watch = watches_[static_cast<size_t>(fd)];
+	watch.handler = IoHandler();
+	watch.isActive = false;
+}
+
+
+bool EventLoop::isWatched(int fd) const
+{
+	return fd >= 0 && static_cast<size_t>(fd) < watches_.size() &&
+			watches_[static_cast<size_t>(fd)].isActive;
+}
+
+
+EventLoop::TimerHandle EventLoop::createTimer(const TimerHandler& handler)
+{
+	if(timerFd_ == -1)
+		return kInvalidTimer;
+
+	TimerHandle handle = timerWheel_.create();
+	if(handle > timerHandlers_.size())
+		timerHandlers_.resize(handle);
+
+	timerHandlers_[handle - 1] = handler;
+	return handle;
+}
+
+
+void EventLoop::destroyTimer(TimerHandle handle)
+{
+	if(handle == kInvalidTimer || handle > timerHandlers_.size())
+		return;
+
+	if(handle == runningTimer_)
+		runningTimer_ = kInvalidTimer;
+
+	timerWheel_.destroy(handle);
+	timerHandlers_[handle - 1] = TimerHandler();
+}
+
+
+void EventLoop::startTimer(TimerHandle handle, const Duration& timeout, bool periodic)
+{
+	i64 now = monotonicTime() / kNanosecondsPerMillisecond;
+	timerWheel_.start(handle, now, timeout.mseconds(), periodic);
+	armTimerFd();
+}
+
+
+void EventLoop::stopTimer(TimerHandle handle)
+{
+	timerWheel_.stop(handle);
+}
+
+
+bool EventLoop::isTimerActive(TimerHandle handle) const
+{
+	return timerWheel_.isActive(handle);
+}
+
+
+Duration EventLoop::timerInterval(TimerHandle handle) const
+{
+	return Duration(timerWheel_.interval(handle));
+}
+
+
+TaskQueue* EventLoop::taskQueue()
+{
+	return &taskQueue_;
+}
+
+
+int EventLoop::run()
+{
+	isRunning_ = true;
+
+	while(!quitRequested_.load(std::memory_order_acquire))
+		dispatch(-1);
+
+	quitRequested_.store(false, std::memory_order_relaxed);
+	isRunning_ = false;
+	return exitCode_.load(std::memory_order_relaxed);
+}
+
+
+size_t EventLoop::processEvents()
+{
+	return dispatch(-1);
+}
+
+
+size_t EventLoop::processEvents(const Duration& timeout)
+{
+	i64 msecs = timeout.mseconds();
+	return dispatch(static_cast<int>(msecs < 0 ? 0 : msecs > INT_MAX ? INT_MAX : msecs));
+}
+
+
+void EventLoop::quit(int code)
+{
+	exitCode_.store(code, std::memory_order_relaxed);
+	quitRequested_.store(true, std::memory_order_release);
+	wakeup();
+}
+
+
+void EventLoop::wakeup()
+{
+	u64 value = 1;
+	ssize_t result = write(wakeupFd_, &value, sizeof(value));
+	UNUSED(result);
+}
+
+
+bool EventLoop::isRunning() const
+{
+	return isRunning_;
+}
+
+
+const EventLoop::Statistics& EventLoop::lastIteration() const
+{
+	return lastIteration_;
+}
+
+
+const EventLoop::Statistics& EventLoop::statistics() const
+{
+	return statistics_;
+}
+
+
+void EventLoop::resetStatistics()
+{
+	statistics_ = Statistics();
+}
+
+
+bool EventLoop::addToEpoll(int fd, u64 data, u32 events)
+{
+	epoll_event event;
+	event.events = events;
+	event.data.u64 = data;
+	return epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+
+size_t EventLoop::dispatch(int timeout)
+{
+	epoll_event events[kMaxEvents];
+	Statistics& stats = lastIteration_;
+	stats = Statistics();
+	stats.iterations = 1;
+
+	i64 start = monotonicTime();
+	int count = epoll_wait(epollFd_, events, kMaxEvents, timeout);
+	i64 time = monotonicTime();
+	stats.waitTime = time - start;
+
+	bool hasWakeup = false;
+	bool hasTimers = false;
+
+	for(int i = 0; i < count; ++i) {
+		u64 data = events[i].data.u64;
+
+		if(data == kWakeupData) {
+			hasWakeup = true;
+			continue;
+		}
+
+		if(data == kTimerData) {
+			hasTimers = true;
+			continue;
+		}
+
+		// A handler called earlier in the batch may have removed the watch or replaced
+		// it with a watch of a reused descriptor
+		int fd = static_cast<int>(data & 0xFFFFFFFF);
+		u32 generation = static_cast<u32>(data >> 32);
+
+		if(!isWatched(fd) || watches_[static_cast<size_t>(fd)].generation != generation)
+			continue;
+
+		// The handler may change the watches and so the vector, a copy is called and its
+		// state is stored back if the watch survived the call
+		IoHandler handler = watches_[static_cast<size_t>(fd)].handler;
+		handler(fd, fromEpollEvents(events[i].events));
+		++stats.ioEvents;
+
+		if(isWatched(fd) && watches_[static_cast<size_t>(fd)].generation == generation)
+			watches_[static_cast<size_t>(fd)].handler = handler;
+	}
+
+	if(stats.ioEvents != 0) {
+		start = time;
+		time = monotonicTime();
+		stats.ioTime = time - start;
+	}
+
+	if(hasTimers) {
+		start = time;
+		stats.timers = processTimers(time / kNanosecondsPerMillisecond);
+		time = monotonicTime();
+		stats.timerTime = time - start;
+	}
+
+	if(hasWakeup) {
+		start = time;
+		stats.tasks = processWakeup();
+		time = monotonicTime();
+		stats.taskTime = time - start;
+	}
+
+	statistics_.iterations += 1;
+	statistics_.ioEvents += stats.ioEvents;
+	statistics_.timers += stats.timers;
+	statistics_.tasks += stats.tasks;
+	statistics_.waitTime += stats.waitTime;
+	statistics_.ioTime += stats.ioTime;
+	statistics_.timerTime += stats.timerTime;
+	statistics_.taskTime += stats.taskTime;
+
+	return static_cast<size_t>(stats.ioEvents + stats.timers + stats.tasks);
+}
+
+
+size_t EventLoop::processWakeup()
+{
+	// A single read resets the counter of all wakeups since the last one, and the queue
+	// runs all tasks posted before it
+	u64 value;
+	ssize_t result = read(wakeupFd_, &value, sizeof(value));
+	UNUSED(result);
+
+	return taskQueue_.processTasks();
+}
+
+
+size_t EventLoop::processTimers(i64 now)
+{
+	u64 expirations;
+	ssize_t result = read(timerFd_, &expirations, sizeof(expirations));
+	UNUSED(result);
+
+	// Timers started by the handlers are armed once after the pass, the fd is disarmed
+	// after it has fired
+	armedDeadline_ = 0;
+
+	// The handler may create timers and so reallocate the vector, a copy is called and
+	// its state is stored back unless the handler has destroyed the timer, whose handle
+	// could be reused by a new one
+	size_t count = timerWheel_.advance(now, [this](TimerHandle handle) {
+		TimerHandler handler = timerHandlers_[handle - 1];
+		runningTimer_ = handle;
+		handler();
+
+		if(runningTimer_ == handle)
+			timerHandlers_[handle - 1] = handler;
+
+		runningTimer_ = kInvalidTimer;
+	});
+
+	armedDeadline_ = -1;
+	armTimerFd();
+	return count;
+}
+
+
+void EventLoop::armTimerFd()
+{
+	// The fd is re-armed only for a nearer deadline, so most starts make no syscall.
+	// Stopping a timer leaves the fd armed, the wakeup then finds nothing to expire.
+	i64 deadline = timerWheel_.nextDeadline();
+	if(deadline < 0 || (armedDeadline_ >= 0 && armedDeadline_ <= deadline))
+		return;
+
+	itimerspec data;
+	std::memset(&data, 0, sizeof(data));
+	data.it_value.tv_sec = static_cast<time_t>(deadline / 1000);
+	data.it_value.tv_nsec = static_cast<long>(deadline % 1000) * 1000000;
+
+	// A zero value would disarm the fd
+	if(deadline == 0)
+		data.it_value.tv_nsec = 1;
+
+	if(timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &data, nullptr) == 0)
+		armedDeadline_ = deadline;
+}
+
+
+} // namespace Tech
@@ -0,0 +1,865 @@
+#include <tech/fileio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <tech/utils.h>
+#include "iouring.h"
+
+
+namespace Tech {
+
+
+namespace internal {
+
+
+/**
+ * Request of FileIo. With io_uring an operation may consist of several steps, each of
+ * them is an entry of the submission ring. With the thread pool the whole operation runs
+ * in perform().
+ */
+class FileOperation {
+public:
+	FileOperation() :
+		next(nullptr),
+		result(0)
+	{
+	}
+
+	virtual ~FileOperation() = default;
+
+	/**
+	 * Fills the submission entry of the current step.
+	 */
+	virtual void prepare(io_uring_sqe* sqe) = 0;
+
+	/**
+	 * Runs the operation with blocking calls on a thread of the pool and returns the
+	 * result passed to complete().
+	 */
+	virtual i64 perform() = 0;
+
+	/**
+	 * Takes the result of the current step, a negated errno on failure. Returns
+	 * @c false if the next step is submitted.
+	 */
+	virtual bool complete(FileIo* io, i64 result) = 0;
+
+	// Link in the backlog or in the list of completions
+	FileOperation* next;
+
+	// Result of perform()
+	i64 result;
+
+protected:
+	static bool submitNext(FileIo* io, FileOperation* operation)
+	{
+		return io->submit(operation);
+	}
+};
+
+
+} // namespace internal
+
+
+namespace {
+
+
+using internal::FileOperation;
+
+
+const u32 kRingEntries = 256;
+
+// Larger requests are split, io_uring takes 32-bit lengths
+const size_t kMaxChunkSize = 1 << 30;
+
+// Buffer for files which report no size, such as the ones in /proc
+const size_t kInitialFileSize = 64 * 1024;
+
+const u32 kStatusMask = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME;
+
+
+template<typename F>
+i64 systemCall(F&& function)
+{
+	i64 result;
+
+	do {
+		result = static_cast<i64>(function());
+	} while(result == -1 && errno == EINTR);
+
+	return result == -1 ? -errno : result;
+}
+
+
+int toOpenFlags(FileOpenFlags flags)
+{
+	int result = O_CLOEXEC;
+
+	if((flags & FileOpenFlag::kRead) && (flags & FileOpenFlag::kWrite))
+		result |= O_RDWR;
+	else if(flags & FileOpenFlag::kWrite)
+		result |= O_WRONLY;
+	else
+		result |= O_RDONLY;
+
+	if(flags & FileOpenFlag::kCreate)
+		result |= O_CREAT;
+
+	if(flags & FileOpenFlag::kTruncate)
+		result |= O_TRUNC;
+
+	if(flags & FileOpenFlag::kAppend)
+		result |= O_APPEND;
+
+	return result;
+}
+
+
+FileResult toFileResult(i64 result)
+{
+	if(result < 0)
+		return FileResult{static_cast<int>(-result), -1};
+
+	return FileResult{0, result};
+}
+
+
+u64 toAddress(const void* pointer)
+{
+	return static_cast<u64>(reinterpret_cast<uintptr_t>(pointer));
+}
+
+
+bool supportsFileOperations(const IoUring& ring)
+{
+	return ring.isSupported(IORING_OP_OPENAT) && ring.isSupported(IORING_OP_CLOSE) &&
+			ring.isSupported(IORING_OP_READ) && ring.isSupported(IORING_OP_WRITE) &&
+			ring.isSupported(IORING_OP_STATX);
+}
+
+
+class OpenOperation final : public FileOperation {
+public:
+	OpenOperation(const String& path, int flags, u32 mode) :
+		path_(path.toUtf8()),
+		flags_(flags),
+		mode_(mode)
+	{
+	}
+
+	Future<FileResult> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		sqe->opcode = IORING_OP_OPENAT;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = toAddress(path_.constData());
+		sqe->len = mode_;
+		sqe->open_flags = static_cast<u32>(flags_);
+	}
+
+	i64 perform() override
+	{
+		return systemCall([this]() {
+			return ::open(path_.constData(), flags_, static_cast<mode_t>(mode_));
+		});
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		UNUSED(io);
+		promise_.setValue(toFileResult(result));
+		return true;
+	}
+
+private:
+	ByteArray path_;
+	int flags_;
+	u32 mode_;
+	Promise<FileResult> promise_;
+};
+
+
+class CloseOperation final : public FileOperation {
+public:
+	explicit CloseOperation(int fd) :
+		fd_(fd)
+	{
+	}
+
+	Future<FileResult> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		sqe->opcode = IORING_OP_CLOSE;
+		sqe->fd = fd_;
+	}
+
+	i64 perform() override
+	{
+		// The descriptor is released even if close() is interrupted, so no retry
+		return ::close(fd_) == -1 ? -errno : 0;
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		UNUSED(io);
+		promise_.setValue(toFileResult(result));
+		return true;
+	}
+
+private:
+	int fd_;
+	Promise<FileResult> promise_;
+};
+
+
+class ReadOperation final : public FileOperation {
+public:
+	ReadOperation(int fd, u64 offset, size_t size) :
+		fd_(fd),
+		offset_(offset)
+	{
+		data_.resize(std::min(size, kMaxChunkSize));
+	}
+
+	Future<FileData> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd_;
+		sqe->addr = toAddress(data_.data());
+		sqe->len = static_cast<u32>(data_.length());
+		sqe->off = offset_;
+	}
+
+	i64 perform() override
+	{
+		return systemCall([this]() {
+			off_t offset = static_cast<off_t>(offset_);
+			return ::pread(fd_, data_.data(), data_.length(), offset);
+		});
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		UNUSED(io);
+
+		if(result < 0) {
+			promise_.setValue(FileData{static_cast<int>(-result), ByteArray()});
+		}
+		else {
+			data_.resize(static_cast<size_t>(result));
+			promise_.setValue(FileData{0, data_});
+		}
+
+		return true;
+	}
+
+private:
+	int fd_;
+	u64 offset_;
+	ByteArray data_;
+	Promise<FileData> promise_;
+};
+
+
+class WriteOperation final : public FileOperation {
+public:
+	WriteOperation(int fd, u64 offset, const ByteArray& data) :
+		fd_(fd),
+		offset_(offset),
+		data_(data)
+	{
+	}
+
+	Future<FileResult> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd_;
+		sqe->addr = toAddress(data_.constData());
+		sqe->len = static_cast<u32>(std::min(data_.length(), kMaxChunkSize));
+		sqe->off = offset_;
+	}
+
+	i64 perform() override
+	{
+		return systemCall([this]() {
+			size_t size = std::min(data_.length(), kMaxChunkSize);
+			return ::pwrite(fd_, data_.constData(), size, static_cast<off_t>(offset_));
+		});
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		UNUSED(io);
+		promise_.setValue(toFileResult(result));
+		return true;
+	}
+
+private:
+	int fd_;
+	u64 offset_;
+	ByteArray data_;
+	Promise<FileResult> promise_;
+};
+
+
+class StatusOperation final : public FileOperation {
+public:
+	explicit StatusOperation(const String& path) :
+		path_(path.toUtf8()),
+		status_()
+	{
+	}
+
+	Future<FileStatus> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		sqe->opcode = IORING_OP_STATX;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = toAddress(path_.constData());
+		sqe->len = kStatusMask;
+		sqe->off = toAddress(&status_);
+	}
+
+	i64 perform() override
+	{
+		return systemCall([this]() {
+			return ::statx(AT_FDCWD, path_.constData(), 0, kStatusMask, &status_);
+		});
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		UNUSED(io);
+
+		if(result < 0) {
+			promise_.setValue(FileStatus{static_cast<int>(-result), 0, 0, Duration()});
+			return true;
+		}
+
+		i64 time = status_.stx_mtime.tv_sec * 1000 + status_.stx_mtime.tv_nsec / 1000000;
+		promise_.setValue(FileStatus{0, status_.stx_size, status_.stx_mode,
+				Duration(time)});
+
+		return true;
+	}
+
+private:
+	ByteArray path_;
+	struct statx status_;
+	Promise<FileStatus> promise_;
+};
+
+
+/**
+ * Opens the file, takes its size, reads it in one or more requests and closes it. Files
+ * which report no size are read into a growing buffer until the end.
+ */
+class ReadFileOperation final : public FileOperation {
+public:
+	explicit ReadFileOperation(const String& path) :
+		path_(path.toUtf8()),
+		step_(Step::kOpen),
+		fd_(-1),
+		error_(0),
+		status_(),
+		size_(0),
+		hasKnownSize_(false)
+	{
+	}
+
+	~ReadFileOperation() override
+	{
+		if(fd_ != -1)
+			::close(fd_);
+	}
+
+	Future<FileData> future()
+	{
+		return promise_.future();
+	}
+
+	void prepare(io_uring_sqe* sqe) override
+	{
+		static const char kEmptyPath[] = "";
+
+		switch(step_) {
+		case Step::kOpen:
+			sqe->opcode = IORING_OP_OPENAT;
+			sqe->fd = AT_FDCWD;
+			sqe->addr = toAddress(path_.constData());
+			sqe->open_flags = O_RDONLY | O_CLOEXEC;
+			break;
+
+		case Step::kStatus:
+			sqe->opcode = IORING_OP_STATX;
+			sqe->fd = fd_;
+			sqe->addr = toAddress(kEmptyPath);
+			sqe->len = STATX_SIZE;
+			sqe->off = toAddress(&status_);
+			sqe->statx_flags = AT_EMPTY_PATH;
+			break;
+
+		case Step::kRead:
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = fd_;
+			sqe->addr = toAddress(data_.data() + size_);
+			sqe->len = static_cast<u32>(std::min(data_.length() - size_, kMaxChunkSize));
+			sqe->off = size_;
+			break;
+
+		case Step::kClose:
+			sqe->opcode = IORING_OP_CLOSE;
+			sqe->fd = fd_;
+			break;
+
+		case Step::kDone:
+			break;
+		}
+	}
+
+	i64 perform() override
+	{
+		fd_ = static_cast<int>(systemCall([this]() {
+			return ::open(path_.constData(), O_RDONLY | O_CLOEXEC);
+		}));
+
+		if(fd_ < 0) {
+			error_ = -fd_;
+			fd_ = -1;
+		}
+		else {
+			struct stat status;
+			if(fstat(fd_, &status) == 0)
+				allocate(static_cast<u64>(status.st_size));
+			else
+				error_ = errno;
+
+			while(error_ == 0) {
+				i64 result = systemCall([this]() {
+					return ::pread(fd_, data_.data() + size_, readSize(),
+							static_cast<off_t>(size_));
+				});
+
+				if(!takeRead(result))
+					break;
+			}
+
+			::close(fd_);
+			fd_ = -1;
+		}
+
+		step_ = Step::kDone;
+		return 0;
+	}
+
+	bool complete(FileIo* io, i64 result) override
+	{
+		switch(step_) {
+		case Step::kOpen:
+			if(result < 0) {
+				error_ = static_cast<int>(-result);
+				break;
+			}
+
+			fd_ = static_cast<int>(result);
+			return !submitStep(io, Step::kStatus);
+
+		case Step::kStatus:
+			if(result < 0) {
+				error_ = static_cast<int>(-result);
+				return !submitStep(io, Step::kClose);
+			}
+
+			allocate(status_.stx_size);
+			return !submitStep(io, Step::kRead);
+
+		case Step::kRead:
+			return !submitStep(io, takeRead(result) ? Step::kRead : Step::kClose);
+
+		case Step::kClose:
+			fd_ = -1;
+			break;
+
+		case Step::kDone:
+			break;
+		}
+
+		if(error_ == 0) {
+			data_.resize(size_);
+			promise_.setValue(FileData{0, data_});
+		}
+		else {
+			promise_.setValue(FileData{error_, ByteArray()});
+		}
+
+		return true;
+	}
+
+private:
+	enum class Step {
+		kOpen,
+		kStatus,
+		kRead,
+		kClose,
+		kDone
+	};
+
+	ByteArray path_;
+	Step step_;
+	int fd_;
+	int error_;
+	struct statx status_;
+	ByteArray data_;
+	size_t size_;
+	bool hasKnownSize_;
+	Promise<FileData> promise_;
+
+	void allocate(u64 size)
+	{
+		hasKnownSize_ = size != 0;
+		data_.resize(hasKnownSize_ ? static_cast<size_t>(size) : kInitialFileSize);
+	}
+
+	size_t readSize() const
+	{
+		return std::min(data_.length() - size_, kMaxChunkSize);
+	}
+
+	// Returns @c true if there is more to read
+	bool takeRead(i64 result)
+	{
+		if(result < 0) {
+			error_ = static_cast<int>(-result);
+			return false;
+		}
+
+		size_ += static_cast<size_t>(result);
+
+		if(result == 0 || (hasKnownSize_ && size_ == data_.length()))
+			return false;
+
+		if(size_ == data_.length())
+			data_.resize(data_.length() * 2);
+
+		return true;
+	}
+
+	// Returns @c false if FileIo is closing, the descriptor is then closed right away
+	bool submitStep(FileIo* io, Step step)
+	{
+		step_ = step;
+
+		if(submitNext(io, this))
+			return true;
+
+		if(fd_ != -1) {
+			::close(fd_);
+			fd_ = -1;
+		}
+
+		if(error_ == 0)
+			error_ = ECANCELED;
+
+		step_ = Step::kDone;
+		return false;
+	}
+};
+
+
+} // namespace
+
+
+FileIo::FileIo(EventLoop* loop, ThreadPool* pool, Backend backend) :
+	loop_(loop),
+	pool_(pool),
+	eventFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	backlogHead_(nullptr),
+	backlogTail_(nullptr),
+	inFlight_(0),
+	pendingCount_(0),
+	isDispatching_(false),
+	isClosing_(false),
+	completed_(nullptr)
+{
+	if(backend == Backend::kUring && eventFd_ != -1) {
+		ring_ = makeBox<IoUring>(kRingEntries);
+
+		if(!ring_->isValid() || !supportsFileOperations(*ring_) ||
+				!ring_->registerEventFd(eventFd_)) {
+			ring_.reset();
+		}
+	}
+
+	loop_->watch(eventFd_, IoEvent::kRead,
+			EventLoop::IoHandler(this, &FileIo::processCompletions));
+}
+
+
+FileIo::~FileIo()
+{
+	isClosing_ = true;
+
+	while(backlogHead_) {
+		FileOperation* operation = backlogHead_;
+		backlogHead_ = operation->next;
+		finish(operation, -ECANCELED);
+	}
+
+	backlogTail_ = nullptr;
+
+	while(ring_ && inFlight_ != 0) {
+		flush();
+		ring_->waitCompletions(1);
+		processCompletions(eventFd_, IoEvent::kRead);
+	}
+
+	pool_->wait(&group_);
+	processCompletions(eventFd_, IoEvent::kRead);
+
+	loop_->unwatch(eventFd_);
+
+	if(eventFd_ != -1)
+		::close(eventFd_);
+}
+
+
+FileIo::Backend FileIo::backend() const
+{
+	return ring_ ? Backend::kUring : Backend::kThreadPool;
+}
+
+
+Future<FileResult> FileIo::open(const String& path, FileOpenFlags flags, u32 mode)
+{
+	OpenOperation* operation = new OpenOperation(path, toOpenFlags(flags), mode);
+	Future<FileResult> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+Future<FileResult> FileIo::close(int fd)
+{
+	CloseOperation* operation = new CloseOperation(fd);
+	Future<FileResult> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+Future<FileData> FileIo::read(int fd, u64 offset, size_t size)
+{
+	ReadOperation* operation = new ReadOperation(fd, offset, size);
+	Future<FileData> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+Future<FileResult> FileIo::write(int fd, u64 offset, const ByteArray& data)
+{
+	WriteOperation* operation = new WriteOperation(fd, offset, data);
+	Future<FileResult> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+Future<FileStatus> FileIo::status(const String& path)
+{
+	StatusOperation* operation = new StatusOperation(path);
+	Future<FileStatus> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+Future<FileData> FileIo::readFile(const String& path)
+{
+	ReadFileOperation* operation = new ReadFileOperation(path);
+	Future<FileData> result = operation->future();
+	start(operation);
+	return result;
+}
+
+
+size_t FileIo::pendingCount() const
+{
+	return pendingCount_;
+}
+
+
+void FileIo::start(FileOperation* operation)
+{
+	// The promise is broken by the deletion
+	if(isClosing_) {
+		delete operation;
+		return;
+	}
+
+	++pendingCount_;
+	submit(operation);
+}
+
+
+bool FileIo::submit(FileOperation* operation)
+{
+	if(isClosing_)
+		return false;
+
+	if(!ring_) {
+		pool_->submit(&group_, [this, operation]() {
+			operation->result = operation->perform();
+			pushCompleted(operation);
+		});
+
+		return true;
+	}
+
+	operation->next = nullptr;
+
+	if(backlogTail_)
+		backlogTail_->next = operation;
+	else
+		backlogHead_ = operation;
+
+	backlogTail_ = operation;
+	submitBacklog();
+
+	// Requests made by completion handlers are submitted by processCompletions()
+	if(!isDispatching_)
+		flush();
+
+	return true;
+}
+
+
+void FileIo::submitBacklog()
+{
+	// In-flight requests are limited by the completion ring, so that the kernel never
+	// has to keep completions aside
+	while(backlogHead_ && inFlight_ < ring_->completionCapacity()) {
+		io_uring_sqe* sqe = ring_->nextEntry();
+		if(!sqe) {
+			flush();
+			sqe = ring_->nextEntry();
+			if(!sqe)
+				break;
+		}
+
+		FileOperation* operation = backlogHead_;
+		backlogHead_ = operation->next;
+		if(!backlogHead_)
+			backlogTail_ = nullptr;
+
+		operation->prepare(sqe);
+		sqe->user_data = toAddress(operation);
+		++inFlight_;
+	}
+}
+
+
+void FileIo::flush()
+{
+	if(ring_)
+		ring_->submit();
+}
+
+
+void FileIo::pushCompleted(FileOperation* operation)
+{
+	FileOperation* head = completed_.load(std::memory_order_relaxed);
+
+	do {
+		operation->next = head;
+	} while(!completed_.compare_exchange_weak(head, operation, std::memory_order_release,
+			std::memory_order_relaxed));
+
+	// The loop is woken once per batch of completions
+	if(!head) {
+		u64 value = 1;
+		ssize_t result = ::write(eventFd_, &value, sizeof(value));
+		UNUSED(result);
+	}
+}
+
+
+void FileIo::processCompletions(int fd, IoEvents events)
+{
+	UNUSED(fd);
+	UNUSED(events);
+
+	u64 value;
+	ssize_t result = ::read(eventFd_, &value, sizeof(value));
+	UNUSED(result);
+
+	isDispatching_ = true;
+
+	if(ring_) {
+		ring_->forEachCompletion([this](const io_uring_cqe& cqe) {
+			--inFlight_;
+			uintptr_t address = static_cast<uintptr_t>(cqe.user_data);
+			finish(reinterpret_cast<FileOperation*>(address), cqe.res);
+		});
+
+		submitBacklog();
+	}
+
+	// The list is in reverse order of completion
+	FileOperation* reversed = completed_.exchange(nullptr, std::memory_order_acquire);
+	FileOperation* operations = nullptr;
+
+	while(reversed) {
+		FileOperation* operation = reversed;
+		reversed = operation->next;
+		operation->next = operations;
+		operations = operation;
+	}
+
+	while(operations) {
+		FileOperation* operation = operations;
+		operations = operation->next;
+		finish(operation, operation->result);
+	}
+
+	isDispatching_ = false;
+	flush();
+}
+
+
+void FileIo::finish(FileOperation* operation, i64 result)
+{
+	if(operation->complete(this, result)) {
+		delete operation;
+		--pendingCount_;
+	}
+}
+
+
+} // namespace Tech
@@ -0,0 +1,433 @@
+#include <tech/filelogsink.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "utf8.h"
+
+
+namespace Tech {
+
+
+namespace {
+
+
+// Timestamp, level, line number and separators
+const size_t kMaxPrefixSize = 64;
+
+
+i64 realtimeMsecs(timespec* time)
+{
+	clock_gettime(CLOCK_REALTIME, time);
+	return static_cast<i64>(time->tv_sec) * Duration::kMsecsPerSecond +
+			time->tv_nsec / 1000000;
+}
+
+
+i64 monotonicMsecs()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<i64>(time.tv_sec) * Duration::kMsecsPerSecond +
+			time.tv_nsec / 1000000;
+}
+
+
+} // namespace
+
+
+FileLogSink::FileLogSink(const String& fileName, size_t bufferSize) :
+	fileName_(fileName),
+	fd_(-1),
+	lastError_(0),
+	maxFileSize_(0),
+	rotationInterval_(0),
+	maxBackupCount_(5),
+	syncPolicy_(SyncPolicy::kNever),
+	syncInterval_(Duration::kMsecsPerSecond),
+	recordFormat_(LogFieldFormat::kText),
+	currentChunk_(0),
+	pendingSize_(0),
+	pendingLines_(0),
+	fileSize_(0),
+	rotationTime_(0),
+	lastSyncTime_(monotonicMsecs()),
+	linesWritten_(0),
+	bytesWritten_(0)
+{
+	ByteArray path = fileName.toUtf8();
+	path_.assign(path.constData(), path.length());
+
+	size_t count = bound<size_t>(1, bufferSize / kChunkSize, size_t(kMaxChunkCount));
+	chunks_.resize(count);
+
+	for(Chunk& chunk : chunks_) {
+		chunk.data.resize(kChunkSize);
+		chunk.size = 0;
+	}
+
+	timespec time;
+	open(realtimeMsecs(&time));
+}
+
+
+FileLogSink::~FileLogSink()
+{
+	flush();
+	close();
+}
+
+
+String FileLogSink::fileName() const
+{
+	return fileName_;
+}
+
+
+bool FileLogSink::isOpen() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return fd_ != -1;
+}
+
+
+int FileLogSink::lastError() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return lastError_;
+}
+
+
+void FileLogSink::setMaxFileSize(u64 size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	maxFileSize_ = size;
+}
+
+
+void FileLogSink::setRotationInterval(const Duration& interval)
+{
+	timespec time;
+	i64 now = realtimeMsecs(&time);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	rotationInterval_ = interval.mseconds();
+	rotationTime_ = now + rotationInterval_;
+}
+
+
+void FileLogSink::setMaxBackupCount(int count)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	maxBackupCount_ = count;
+}
+
+
+void FileLogSink::setSyncPolicy(SyncPolicy policy, const Duration& interval)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	syncPolicy_ = policy;
+	syncInterval_ = interval.mseconds();
+}
+
+
+void FileLogSink::setTimestampClock(LogTimestampFormatter::Clock clock)
+{
+	timestamp_.setClock(clock);
+}
+
+
+void FileLogSink::setRecordFormat(LogFieldFormat format)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	recordFormat_ = format;
+}
+
+
+void FileLogSink::write(LogLevel level, const String& file, int line,
+		const String& message)
+{
+	char timestamp[LogTimestampFormatter::kLength];
+	i64 now = timestamp_.format(timestamp);
+
+	// The longest UTF-8 sequence for a single UTF-16 code unit is 3 bytes long
+	size_t maxSize = kMaxPrefixSize + (file.length() + message.length()) * 3 + 1;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(isRotationNeeded(now, maxSize))
+		doRotate(now);
+
+	char* begin = reserve(maxSize);
+	char* pos = writePrefix(begin, timestamp, level, file, line);
+	pos = encodeUtf8(message, pos);
+	*pos++ = '\n';
+
+	commit(pos - begin);
+}
+
+
+void FileLogSink::writeRecord(LogLevel level, const String& file, int line,
+		const char* message, const LogFields& fields)
+{
+	char timestamp[LogTimestampFormatter::kLength];
+	i64 now = timestamp_.format(timestamp);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	recordBuffer_.clear();
+	renderLogRecord(recordFormat_, message, fields, &recordBuffer_);
+
+	size_t maxSize = kMaxPrefixSize + file.length() * 3 + recordBuffer_.size() + 1;
+
+	if(isRotationNeeded(now, maxSize))
+		doRotate(now);
+
+	char* begin = reserve(maxSize);
+	char* pos = writePrefix(begin, timestamp, level, file, line);
+	std::memcpy(pos, recordBuffer_.data(), recordBuffer_.size());
+	pos += recordBuffer_.size();
+	*pos++ = '\n';
+
+	commit(pos - begin);
+}
+
+
+void FileLogSink::flush()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	writeBuffers();
+
+	if(syncPolicy_ == SyncPolicy::kEveryFlush ||
+			(syncPolicy_ == SyncPolicy::kPeriodic &&
+			monotonicMsecs() - lastSyncTime_ >= syncInterval_))
+		sync();
+}
+
+
+void FileLogSink::rotate()
+{
+	timespec time;
+	i64 now = realtimeMsecs(&time);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	doRotate(now);
+}
+
+
+u64 FileLogSink::linesWritten() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return linesWritten_;
+}
+
+
+u64 FileLogSink::bytesWritten() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return bytesWritten_;
+}
+
+
+void FileLogSink::open(i64 now)
+{
+	fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+	if(fd_ == -1) {
+		lastError_ = errno;
+		return;
+	}
+
+	struct stat status;
+	fileSize_ = ::fstat(fd_, &status) == 0 ? status.st_size : 0;
+	rotationTime_ = now + rotationInterval_;
+}
+
+
+void FileLogSink::close()
+{
+	if(fd_ != -1) {
+		::close(fd_);
+		fd_ = -1;
+	}
+}
+
+
+void FileLogSink::renameBackups()
+{
+	if(maxBackupCount_ <= 0) {
+		::unlink(path_.c_str());
+		return;
+	}
+
+	// rename() replaces the target, so the oldest backup is dropped by the first call
+	for(int i = maxBackupCount_ - 1; i > 0; --i)
+		::rename(backupPath(i).c_str(), backupPath(i + 1).c_str());
+
+	if(::rename(path_.c_str(), backupPath(1).c_str()) == -1)
+		lastError_ = errno;
+}
+
+
+std::string FileLogSink::backupPath(int index) const
+{
+	return path_ + '.' + std::to_string(index);
+}
+
+
+char* FileLogSink::writePrefix(char* pos, const char* timestamp, LogLevel level,
+		const String& file, int line)
+{
+	std::memcpy(pos, timestamp, LogTimestampFormatter::kLength);
+	pos += LogTimestampFormatter::kLength;
+	pos += std::snprintf(pos, kMaxPrefixSize, " [%s] ", logLevelName(level));
+
+	pos = encodeUtf8(file, pos);
+	pos += std::snprintf(pos, kMaxPrefixSize, ":%d: ", line);
+	return pos;
+}
+
+
+char* FileLogSink::reserve(size_t size)
+{
+	Chunk* chunk = &chunks_[currentChunk_];
+
+	if(chunk->data.size() - chunk->size < size) {
+		// Chunks after the current one are always empty
+		if(currentChunk_ + 1 < chunks_.size() && chunk->size != 0)
+			++currentChunk_;
+		else
+			writeBuffers();
+
+		chunk = &chunks_[currentChunk_];
+
+		// A line larger than a chunk gets a chunk of its own
+		if(chunk->data.size() < size)
+			chunk->data.resize(size);
+	}
+
+	return chunk->data.data() + chunk->size;
+}
+
+
+void FileLogSink::commit(size_t size)
+{
+	chunks_[currentChunk_].size += size;
+	pendingSize_ += size;
+	++pendingLines_;
+}
+
+
+void FileLogSink::writeBuffers()
+{
+	if(!pendingSize_)
+		return;
+
+	if(fd_ == -1) {
+		timespec time;
+		open(realtimeMsecs(&time));
+	}
+
+	iovec vectors[kMaxChunkCount];
+	size_t count = 0;
+
+	for(size_t i = 0; i <= currentChunk_; ++i) {
+		if(chunks_[i].size) {
+			vectors[count].iov_base = chunks_[i].data.data();
+			vectors[count].iov_len = chunks_[i].size;
+			++count;
+		}
+
+		chunks_[i].size = 0;
+	}
+
+	iovec* vector = vectors;
+	bool isFailed = fd_ == -1;
+
+	while(count && !isFailed) {
+		ssize_t written = ::writev(fd_, vector, count);
+
+		if(written == -1) {
+			if(errno == EINTR)
+				continue;
+
+			// Lines which can't be written are discarded, logging must go on
+			lastError_ = errno;
+			isFailed = true;
+			break;
+		}
+
+		fileSize_ += written;
+		bytesWritten_ += written;
+
+		// Skip the written vectors after a partial write
+		size_t size = written;
+
+		while(count && size >= vector->iov_len) {
+			size -= vector->iov_len;
+			++vector;
+			--count;
+		}
+
+		if(count) {
+			vector->iov_base = static_cast<char*>(vector->iov_base) + size;
+			vector->iov_len -= size;
+		}
+	}
+
+	if(!isFailed)
+		linesWritten_ += pendingLines_;
+
+	currentChunk_ = 0;
+	pendingSize_ = 0;
+	pendingLines_ = 0;
+}
+
+
+void FileLogSink::sync()
+{
+	if(fd_ == -1)
+		return;
+
+#ifdef PLATFORM_LINUX
+	int result = ::fdatasync(fd_);
+#else
+	int result = ::fsync(fd_);
+#endif
+
+	if(result == -1)
+		lastError_ = errno;
+
+	lastSyncTime_ = monotonicMsecs();
+}
+
+
+bool FileLogSink::isRotationNeeded(i64 now, size_t lineSize) const
+{
+	if(rotationInterval_ > 0 && now >= rotationTime_)
+		return true;
+
+	u64 size = fileSize_ + pendingSize_;
+	return maxFileSize_ && size && size + lineSize > maxFileSize_;
+}
+
+
+void FileLogSink::doRotate(i64 now)
+{
+	writeBuffers();
+
+	if(syncPolicy_ != SyncPolicy::kNever)
+		sync();
+
+	close();
+	renameBackups();
+	open(now);
+}
+
+
+} // namespace Tech
@@ -0,0 +1,99 @@
+#include "futex.h"
+
+#include <tech/platform.h>
+#include <tech/utils.h>
+
+#ifdef PLATFORM_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+
+namespace Tech {
+
+
+#ifdef PLATFORM_LINUX
+
+void waitOnAddress(std::atomic<u32>* address, u32 value)
+{
+	::syscall(SYS_futex, reinterpret_cast<u32*>(address), FUTEX_WAIT_PRIVATE, value,
+			nullptr, nullptr, 0);
+}
+
+
+void waitOnAddress(std::atomic<u32>* address, u32 value,
+		std::chrono::nanoseconds timeout)
+{
+	if(timeout.count() <= 0)
+		return;
+
+	timespec relative;
+	relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+	relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+
+	::syscall(SYS_futex, reinterpret_cast<u32*>(address), FUTEX_WAIT_PRIVATE, value,
+			&relative, nullptr, 0);
+}
+
+
+void wakeByAddress(std::atomic<u32>* address, int count)
+{
+	::syscall(SYS_futex, reinterpret_cast<u32*>(address), FUTEX_WAKE_PRIVATE, count,
+			nullptr, nullptr, 0);
+}
+
+#else
+
+namespace {
+
+
+// Platforms without futexes share a single condition variable
+std::mutex parkingMutex;
+std::condition_variable parkingCondition;
+
+
+} // namespace
+
+
+void waitOnAddress(std::atomic<u32>* address, u32 value)
+{
+	std::unique_lock<std::mutex> lock(parkingMutex);
+
+	while(address->load() == value)
+		parkingCondition.wait(lock);
+}
+
+
+void waitOnAddress(std::atomic<u32>* address, u32 value,
+		std::chrono::nanoseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(parkingMutex);
+	parkingCondition.wait_for(lock, timeout, [address, value]() {
+		return address->load() != value;
+	});
+}
+
+
+void wakeByAddress(std::atomic<u32>* address, int count)
+{
+	UNUSED(address);
+	UNUSED(count);
+
+	// The value is changed before the call, taking the mutex guarantees that a waiter
+	// has either seen the new value or is blocked on the condition variable
+	{
+		std::lock_guard<std::mutex> lock(parkingMutex);
+	}
+
+	parkingCondition.notify_all();
+}
+
+#endif
+
+
+} // namespace Tech
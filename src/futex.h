@@ -0,0 +1,54 @@
+#ifndef TECH_FUTEX_H
+#define TECH_FUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <tech/types.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+namespace Tech {
+
+
+static_assert(sizeof(std::atomic<u32>) == sizeof(u32), "Futex word must be 32-bit");
+
+
+/**
+ * Hints the processor that the thread is spinning.
+ */
+inline
+void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#endif
+}
+
+
+/**
+ * Blocks the calling thread while @p address holds @p value, until wakeByAddress() is
+ * called for it. May return spuriously, so the caller rechecks the value. Uses futexes
+ * on Linux and a shared condition variable elsewhere.
+ */
+void waitOnAddress(std::atomic<u32>* address, u32 value);
+
+/**
+ * Same as above, but returns after @p timeout at the latest.
+ */
+void waitOnAddress(std::atomic<u32>* address, u32 value,
+		std::chrono::nanoseconds timeout);
+
+/**
+ * Wakes up to @p count threads waiting on @p address. The value is changed before the
+ * call.
+ */
+void wakeByAddress(std::atomic<u32>* address, int count);
+
+
+} // namespace Tech
+
+
+#endif // TECH_FUTEX_H
@@ -0,0 +1,236 @@
+#include "iouring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+static_assert(sizeof(std::atomic<u32>) == sizeof(u32), "Ring indices must be 32-bit");
+
+
+int setup(u32 entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+
+int enter(int fd, u32 toSubmit, u32 minComplete, u32 flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+			nullptr, 0));
+}
+
+
+int registerResource(int fd, u32 opcode, void* argument, u32 count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, argument, count));
+}
+
+
+void* mapRing(int fd, size_t size, u64 offset)
+{
+	void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			fd, static_cast<off_t>(offset));
+
+	return result == MAP_FAILED ? nullptr : result;
+}
+
+
+template<typename T>
+T* ringField(void* ring, u32 offset)
+{
+	return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+
+} // namespace
+
+
+IoUring::IoUring(u32 entries) :
+	fd_(-1),
+	supportedOps_(),
+	sqRing_(nullptr),
+	sqRingSize_(0),
+	cqRing_(nullptr),
+	cqRingSize_(0),
+	sqes_(nullptr),
+	sqesSize_(0),
+	sqHead_(nullptr),
+	sqTail_(nullptr),
+	sqMask_(0),
+	sqArray_(nullptr),
+	cqHead_(nullptr),
+	cqTail_(nullptr),
+	cqMask_(0),
+	cqes_(nullptr),
+	pendingTail_(0)
+{
+	std::memset(&params_, 0, sizeof(params_));
+	params_.flags = IORING_SETUP_CLAMP;
+
+	fd_ = setup(entries, &params_);
+	if(fd_ == -1)
+		return;
+
+	if(!mapRings()) {
+		close(fd_);
+		fd_ = -1;
+		return;
+	}
+
+	probe();
+}
+
+
+IoUring::~IoUring()
+{
+	if(sqes_)
+		munmap(sqes_, sqesSize_);
+
+	if(cqRing_ && cqRing_ != sqRing_)
+		munmap(cqRing_, cqRingSize_);
+
+	if(sqRing_)
+		munmap(sqRing_, sqRingSize_);
+
+	if(fd_ != -1)
+		close(fd_);
+}
+
+
+bool IoUring::isValid() const
+{
+	return fd_ != -1;
+}
+
+
+bool IoUring::isSupported(u8 opcode) const
+{
+	return (supportedOps_[opcode / 64] & (u64(1) << (opcode % 64))) != 0;
+}
+
+
+bool IoUring::registerEventFd(int fd)
+{
+	return registerResource(fd_, IORING_REGISTER_EVENTFD, &fd, 1) == 0;
+}
+
+
+u32 IoUring::completionCapacity() const
+{
+	return params_.cq_entries;
+}
+
+
+io_uring_sqe* IoUring::nextEntry()
+{
+	if(pendingTail_ - sqHead_->load(std::memory_order_acquire) >= params_.sq_entries)
+		return nullptr;
+
+	u32 index = pendingTail_ & sqMask_;
+	sqArray_[index] = index;
+	++pendingTail_;
+
+	io_uring_sqe* sqe = &sqes_[index];
+	std::memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+
+int IoUring::submit()
+{
+	sqTail_->store(pendingTail_, std::memory_order_release);
+
+	// Entries left by an interrupted call are submitted again
+	u32 count = pendingTail_ - sqHead_->load(std::memory_order_acquire);
+	if(count == 0)
+		return 0;
+
+	int result = enter(fd_, count, 0, 0);
+	return result == -1 ? -errno : result;
+}
+
+
+int IoUring::waitCompletions(u32 count)
+{
+	int result = enter(fd_, 0, count, IORING_ENTER_GETEVENTS);
+	return result == -1 ? -errno : result;
+}
+
+
+bool IoUring::mapRings()
+{
+	sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(u32);
+	cqRingSize_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+
+	// Since 5.4 both rings share one mapping
+	if(params_.features & IORING_FEAT_SINGLE_MMAP) {
+		if(cqRingSize_ > sqRingSize_)
+			sqRingSize_ = cqRingSize_;
+
+		cqRingSize_ = sqRingSize_;
+	}
+
+	sqRing_ = mapRing(fd_, sqRingSize_, IORING_OFF_SQ_RING);
+	if(!sqRing_)
+		return false;
+
+	if(params_.features & IORING_FEAT_SINGLE_MMAP) {
+		cqRing_ = sqRing_;
+	}
+	else {
+		cqRing_ = mapRing(fd_, cqRingSize_, IORING_OFF_CQ_RING);
+		if(!cqRing_)
+			return false;
+	}
+
+	sqesSize_ = params_.sq_entries * sizeof(io_uring_sqe);
+	sqes_ = static_cast<io_uring_sqe*>(mapRing(fd_, sqesSize_, IORING_OFF_SQES));
+	if(!sqes_)
+		return false;
+
+	sqHead_ = ringField<std::atomic<u32>>(sqRing_, params_.sq_off.head);
+	sqTail_ = ringField<std::atomic<u32>>(sqRing_, params_.sq_off.tail);
+	sqMask_ = *ringField<u32>(sqRing_, params_.sq_off.ring_mask);
+	sqArray_ = ringField<u32>(sqRing_, params_.sq_off.array);
+
+	cqHead_ = ringField<std::atomic<u32>>(cqRing_, params_.cq_off.head);
+	cqTail_ = ringField<std::atomic<u32>>(cqRing_, params_.cq_off.tail);
+	cqMask_ = *ringField<u32>(cqRing_, params_.cq_off.ring_mask);
+	cqes_ = ringField<io_uring_cqe>(cqRing_, params_.cq_off.cqes);
+
+	pendingTail_ = sqTail_->load(std::memory_order_relaxed);
+	return true;
+}
+
+
+void IoUring::probe()
+{
+	// Probing appeared in 5.6 together with most file operations, older kernels report
+	// nothing as supported
+	const u32 kOpCount = 256;
+	size_t size = sizeof(io_uring_probe) + kOpCount * sizeof(io_uring_probe_op);
+
+	std::unique_ptr<char[]> storage(new char[size]());
+	io_uring_probe* result = reinterpret_cast<io_uring_probe*>(storage.get());
+
+	if(registerResource(fd_, IORING_REGISTER_PROBE, result, kOpCount) != 0)
+		return;
+
+	for(u32 i = 0; i < result->ops_len && i < kOpCount; ++i) {
+		if(result->ops[i].flags & IO_URING_OP_SUPPORTED)
+			supportedOps_[result->ops[i].op / 64] |= u64(1) << (result->ops[i].op % 64);
+	}
+}
+
+
+} // namespace Tech
@@ -0,0 +1,130 @@
+#ifndef TECH_IOURING_H
+#define TECH_IOURING_H
+
+#include <atomic>
+#include <linux/io_uring.h>
+#include <tech/types.h>
+
+
+namespace Tech {
+
+
+/**
+ * Minimal io_uring instance driven by the raw system calls, so liburing isn't required.
+ *
+ * Submission entries are filled after nextEntry() and passed to the kernel in one
+ * system call by submit(). Completions are taken from the shared ring without system
+ * calls by forEachCompletion(). The instance isn't thread-safe.
+ */
+class IoUring {
+public:
+	/**
+	 * Creates the rings with at least @p entries submission entries.
+	 */
+	explicit IoUring(u32 entries);
+
+	IoUring(const IoUring&) = delete;
+	IoUring& operator=(const IoUring&) = delete;
+
+	~IoUring();
+
+	/**
+	 * Returns @c false if io_uring isn't available, e.g. on kernels before 5.1 or when
+	 * it's disabled by the system.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Returns @c true if the kernel supports @p opcode.
+	 */
+	bool isSupported(u8 opcode) const;
+
+	/**
+	 * Makes the kernel signal the eventfd @p fd on every completion.
+	 */
+	bool registerEventFd(int fd);
+
+	/**
+	 * Returns the size of the completion ring. No more requests should be in flight,
+	 * otherwise completions have to be buffered by the kernel.
+	 */
+	u32 completionCapacity() const;
+
+	/**
+	 * Returns a cleared submission entry to fill, or @c nullptr if the submission ring is
+	 * full and submit() has to be called first.
+	 */
+	io_uring_sqe* nextEntry();
+
+	/**
+	 * Submits the entries filled since the last call. Returns the number of submitted
+	 * entries or a negated errno.
+	 */
+	int submit();
+
+	/**
+	 * Blocks until at least @p count completions are available.
+	 */
+	int waitCompletions(u32 count);
+
+	/**
+	 * Calls @p handler(cqe) for every available completion and returns their number. The
+	 * handler may fill and submit new entries.
+	 */
+	template<typename F>
+	size_t forEachCompletion(F&& handler);
+
+private:
+	int fd_;
+	io_uring_params params_;
+	u64 supportedOps_[4];
+
+	void* sqRing_;
+	size_t sqRingSize_;
+	void* cqRing_;
+	size_t cqRingSize_;
+	io_uring_sqe* sqes_;
+	size_t sqesSize_;
+
+	std::atomic<u32>* sqHead_;
+	std::atomic<u32>* sqTail_;
+	u32 sqMask_;
+	u32* sqArray_;
+
+	std::atomic<u32>* cqHead_;
+	std::atomic<u32>* cqTail_;
+	u32 cqMask_;
+	io_uring_cqe* cqes_;
+
+	// Tail of the filled entries, published to the kernel by submit()
+	u32 pendingTail_;
+
+	bool mapRings();
+	void probe();
+};
+
+
+template<typename F>
+size_t IoUring::forEachCompletion(F&& handler)
+{
+	size_t count = 0;
+	u32 head = cqHead_->load(std::memory_order_relaxed);
+
+	while(head != cqTail_->load(std::memory_order_acquire)) {
+		// The entry is copied, so that its slot can be released before the handler
+		// submits new requests
+		io_uring_cqe cqe = cqes_[head & cqMask_];
+		cqHead_->store(++head, std::memory_order_release);
+
+		handler(cqe);
+		++count;
+	}
+
+	return count;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_IOURING_H
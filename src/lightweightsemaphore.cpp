@@ -0,0 +1,117 @@
+#include <tech/lightweightsemaphore.h>
+
+#include <thread>
+#include "futex.h"
+
+
+namespace Tech {
+
+
+namespace {
+
+
+// Attempts to take the counter before parking, about a microsecond
+const int kSpinCount = 64;
+
+
+// On a single core the poster can't run while the waiter spins
+int spinCount()
+{
+	static const int count = std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+	return count;
+}
+
+
+} // namespace
+
+
+bool LightweightSemaphore::wait(const Duration& duration)
+{
+	int count = spinCount();
+
+	for(int i = 0; i < count; ++i) {
+		if(tryWait())
+			return true;
+
+		cpuRelax();
+	}
+
+	if(duration.isNull())
+		return park(nullptr);
+
+	auto deadline = std::chrono::steady_clock::now() +
+			std::chrono::milliseconds(duration.mseconds());
+	return park(&deadline);
+}
+
+
+bool LightweightSemaphore::waitUntil(const Duration& timestamp)
+{
+	Duration remaining = timestamp - Duration::fromEpoch();
+
+	// A null duration would mean waiting without a time limit
+	if(remaining <= Duration())
+		return tryWait();
+
+	return wait(remaining);
+}
+
+
+bool LightweightSemaphore::park(const std::chrono::steady_clock::time_point* deadline)
+{
+	if(count_.fetch_sub(1, std::memory_order_acquire) > 0)
+		return true;
+
+	for(;;) {
+		if(takeWakeup())
+			return true;
+
+		if(!deadline) {
+			waitOnAddress(&wakeups_, 0);
+			continue;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if(now >= *deadline)
+			break;
+
+		waitOnAddress(&wakeups_, 0, *deadline - now);
+	}
+
+	// Timed out: unregister, unless a post() has already counted on this waiter
+	i32 count = count_.load(std::memory_order_relaxed);
+
+	while(count < 0) {
+		if(count_.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+			return false;
+	}
+
+	while(!takeWakeup())
+		waitOnAddress(&wakeups_, 0);
+
+	return true;
+}
+
+
+bool LightweightSemaphore::takeWakeup()
+{
+	u32 wakeups = wakeups_.load(std::memory_order_relaxed);
+
+	while(wakeups != 0) {
+		if(wakeups_.compare_exchange_weak(wakeups, wakeups - 1, std::memory_order_acquire,
+				std::memory_order_relaxed))
+			return true;
+	}
+
+	return false;
+}
+
+
+void LightweightSemaphore::wake()
+{
+	wakeups_.fetch_add(1, std::memory_order_release);
+	wakeByAddress(&wakeups_, 1);
+}
+
+
+} // namespace Tech
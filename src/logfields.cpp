@@ -0,0 +1,491 @@
+#include <tech/logfields.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "utf8.h"
+
+
+namespace Tech {
+
+
+namespace {
+
+
+const size_t kMaxKeyLength = 0xFF;
+const size_t kMaxVarintSize = 10;
+
+
+u64 zigzagEncode(i64 value)
+{
+	return (static_cast<u64>(value) << 1) ^ static_cast<u64>(value >> 63);
+}
+
+
+i64 zigzagDecode(u64 value)
+{
+	return static_cast<i64>(value >> 1) ^ -static_cast<i64>(value & 1);
+}
+
+
+void appendInteger(std::string* result, i64 value)
+{
+	char buffer[24];
+	int size = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+	result->append(buffer, size);
+}
+
+
+void appendUnsigned(std::string* result, u64 value)
+{
+	char buffer[24];
+	int size = std::snprintf(buffer, sizeof(buffer), "%llu",
+			static_cast<unsigned long long>(value));
+	result->append(buffer, size);
+}
+
+
+void appendDouble(std::string* result, double value, bool isJson)
+{
+	// JSON has no representation for infinities and NaN
+	if(isJson && !std::isfinite(value)) {
+		result->append("null");
+		return;
+	}
+
+	char buffer[32];
+	int size = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+	result->append(buffer, size);
+}
+
+
+void appendEscaped(std::string* result, const char* string, size_t length)
+{
+	static const char kHexDigits[] = "0123456789abcdef";
+
+	result->push_back('"');
+
+	for(size_t i = 0; i < length; ++i) {
+		unsigned char c = static_cast<unsigned char>(string[i]);
+
+		switch(c) {
+		case '"':
+			result->append("\\\"");
+			break;
+
+		case '\\':
+			result->append("\\\\");
+			break;
+
+		case '\n':
+			result->append("\\n");
+			break;
+
+		case '\r':
+			result->append("\\r");
+			break;
+
+		case '\t':
+			result->append("\\t");
+			break;
+
+		default:
+			if(c < 0x20) {
+				char escape[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4], kHexDigits[c & 0xF]};
+				result->append(escape, sizeof(escape));
+			}
+			else {
+				result->push_back(static_cast<char>(c));
+			}
+		}
+	}
+
+	result->push_back('"');
+}
+
+
+// Text values are quoted only if they can't be told apart from the separators
+void appendTextValue(std::string* result, const char* string, size_t length)
+{
+	bool isPlain = length != 0;
+
+	for(size_t i = 0; i < length && isPlain; ++i) {
+		unsigned char c = static_cast<unsigned char>(string[i]);
+		isPlain = c > ' ' && c != '"' && c != '=' && c != '\\';
+	}
+
+	if(isPlain) {
+		result->append(string, length);
+	}
+	else {
+		appendEscaped(result, string, length);
+	}
+}
+
+
+} // namespace
+
+
+const u8* LogFields::data() const
+{
+	return data_;
+}
+
+
+size_t LogFields::size() const
+{
+	return size_;
+}
+
+
+bool LogFields::isEmpty() const
+{
+	return size_ == 0;
+}
+
+
+LogFieldWriter::LogFieldWriter() :
+	data_(inline_),
+	size_(0),
+	capacity_(kInlineCapacity)
+{
+}
+
+
+LogFieldWriter::~LogFieldWriter()
+{
+	if(data_ != inline_)
+		delete[] data_;
+}
+
+
+void LogFieldWriter::add(const char* key, bool value)
+{
+	addKey(value ? LogFieldType::kTrue : LogFieldType::kFalse, key, 0);
+}
+
+
+void LogFieldWriter::add(const char* key, double value)
+{
+	addKey(LogFieldType::kDouble, key, sizeof(value));
+	std::memcpy(data_ + size_, &value, sizeof(value));
+	size_ += sizeof(value);
+}
+
+
+void LogFieldWriter::add(const char* key, const char* value)
+{
+	// Null is written as an empty string
+	if(!value)
+		value = "";
+
+	size_t length = std::strlen(value);
+
+	addKey(LogFieldType::kString, key, kMaxVarintSize + length);
+	addVarint(length);
+	std::memcpy(data_ + size_, value, length);
+	size_ += length;
+}
+
+
+void LogFieldWriter::add(const char* key, const String& value)
+{
+	size_t length = utf8Length(value);
+
+	addKey(LogFieldType::kString, key, kMaxVarintSize + length);
+	addVarint(length);
+	encodeUtf8(value, reinterpret_cast<char*>(data_ + size_));
+	size_ += length;
+}
+
+
+void LogFieldWriter::add(const char* key, const Duration& value)
+{
+	addKey(LogFieldType::kDuration, key, kMaxVarintSize);
+	addVarint(zigzagEncode(value.mseconds()));
+}
+
+
+LogFields LogFieldWriter::fields() const
+{
+	return LogFields(data_, size_);
+}
+
+
+void LogFieldWriter::addInt(const char* key, i64 value)
+{
+	addKey(LogFieldType::kInt, key, kMaxVarintSize);
+	addVarint(zigzagEncode(value));
+}
+
+
+void LogFieldWriter::addUInt(const char* key, u64 value)
+{
+	addKey(LogFieldType::kUInt, key, kMaxVarintSize);
+	addVarint(value);
+}
+
+
+void LogFieldWriter::addKey(LogFieldType type, const char* key, size_t valueSize)
+{
+	size_t length = std::min(std::strlen(key), kMaxKeyLength);
+
+	reserve(2 + length + valueSize);
+	data_[size_++] = static_cast<u8>(type);
+	data_[size_++] = static_cast<u8>(length);
+	std::memcpy(data_ + size_, key, length);
+	size_ += length;
+}
+
+
+void LogFieldWriter::addVarint(u64 value)
+{
+	while(value >= 0x80) {
+		data_[size_++] = static_cast<u8>(value | 0x80);
+		value >>= 7;
+	}
+
+	data_[size_++] = static_cast<u8>(value);
+}
+
+
+void LogFieldWriter::reserve(size_t size)
+{
+	if(size_ + size <= capacity_)
+		return;
+
+	size_t capacity = std::max(capacity_ * 2, size_ + size);
+	u8* data = new u8[capacity];
+	std::memcpy(data, data_, size_);
+
+	if(data_ != inline_)
+		delete[] data_;
+
+	data_ = data;
+	capacity_ = capacity;
+}
+
+
+LogFieldReader::LogFieldReader(const LogFields& fields) :
+	pos_(fields.data()),
+	end_(fields.data() + fields.size()),
+	type_(LogFieldType::kFalse),
+	key_(nullptr),
+	keyLength_(0),
+	string_(nullptr),
+	uint_(0)
+{
+}
+
+
+bool LogFieldReader::next()
+{
+	if(end_ - pos_ < 2)
+		return false;
+
+	type_ = static_cast<LogFieldType>(pos_[0]);
+	keyLength_ = pos_[1];
+	pos_ += 2;
+
+	if(static_cast<size_t>(end_ - pos_) < keyLength_)
+		return false;
+
+	key_ = reinterpret_cast<const char*>(pos_);
+	pos_ += keyLength_;
+
+	switch(type_) {
+	case LogFieldType::kFalse:
+	case LogFieldType::kTrue:
+		return true;
+
+	case LogFieldType::kInt:
+	case LogFieldType::kDuration:
+		if(!readVarint(&uint_))
+			return false;
+
+		int_ = zigzagDecode(uint_);
+		return true;
+
+	case LogFieldType::kUInt:
+		return readVarint(&uint_);
+
+	case LogFieldType::kDouble:
+		if(static_cast<size_t>(end_ - pos_) < sizeof(double_))
+			return false;
+
+		std::memcpy(&double_, pos_, sizeof(double_));
+		pos_ += sizeof(double_);
+		return true;
+
+	case LogFieldType::kString:
+		if(!readVarint(&uint_) || static_cast<u64>(end_ - pos_) < uint_)
+			return false;
+
+		string_ = reinterpret_cast<const char*>(pos_);
+		pos_ += uint_;
+		return true;
+	}
+
+	// Unknown type: the size of the value is unknown as well
+	pos_ = end_;
+	return false;
+}
+
+
+LogFieldType LogFieldReader::type() const
+{
+	return type_;
+}
+
+
+const char* LogFieldReader::key() const
+{
+	return key_;
+}
+
+
+size_t LogFieldReader::keyLength() const
+{
+	return keyLength_;
+}
+
+
+bool LogFieldReader::toBool() const
+{
+	return type_ == LogFieldType::kTrue;
+}
+
+
+i64 LogFieldReader::toInt() const
+{
+	return int_;
+}
+
+
+u64 LogFieldReader::toUInt() const
+{
+	return uint_;
+}
+
+
+double LogFieldReader::toDouble() const
+{
+	return double_;
+}
+
+
+Duration LogFieldReader::toDuration() const
+{
+	return Duration(int_);
+}
+
+
+const char* LogFieldReader::string() const
+{
+	return string_;
+}
+
+
+size_t LogFieldReader::stringLength() const
+{
+	return static_cast<size_t>(uint_);
+}
+
+
+bool LogFieldReader::readVarint(u64* value)
+{
+	u64 result = 0;
+
+	for(int shift = 0; shift < 64 && pos_ != end_; shift += 7) {
+		u8 byte = *pos_++;
+		result |= static_cast<u64>(byte & 0x7F) << shift;
+
+		if(!(byte & 0x80)) {
+			*value = result;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void renderLogRecord(LogFieldFormat format, const char* message, const LogFields& fields,
+		std::string* result)
+{
+	bool isJson = format == LogFieldFormat::kJson;
+	LogFieldReader reader(fields);
+
+	if(isJson) {
+		result->append("{\"message\":");
+		appendEscaped(result, message, std::strlen(message));
+	}
+	else {
+		result->append(message);
+	}
+
+	while(reader.next()) {
+		if(isJson) {
+			result->push_back(',');
+			appendEscaped(result, reader.key(), reader.keyLength());
+			result->push_back(':');
+		}
+		else {
+			result->push_back(' ');
+			result->append(reader.key(), reader.keyLength());
+			result->push_back('=');
+		}
+
+		switch(reader.type()) {
+		case LogFieldType::kFalse:
+			result->append("false");
+			break;
+
+		case LogFieldType::kTrue:
+			result->append("true");
+			break;
+
+		case LogFieldType::kInt:
+			appendInteger(result, reader.toInt());
+			break;
+
+		case LogFieldType::kUInt:
+			appendUnsigned(result, reader.toUInt());
+			break;
+
+		case LogFieldType::kDouble:
+			appendDouble(result, reader.toDouble(), isJson);
+			break;
+
+		case LogFieldType::kString:
+			if(isJson) {
+				appendEscaped(result, reader.string(), reader.stringLength());
+			}
+			else {
+				appendTextValue(result, reader.string(), reader.stringLength());
+			}
+			break;
+
+		case LogFieldType::kDuration:
+			appendInteger(result, reader.toDuration().mseconds());
+
+			if(!isJson)
+				result->append("ms");
+			break;
+		}
+	}
+
+	if(isJson)
+		result->push_back('}');
+}
+
+
+String formatLogRecord(LogFieldFormat format, const char* message, const LogFields& fields)
+{
+	std::string result;
+	renderLogRecord(format, message, fields, &result);
+	return String::fromUtf8(result.data(), result.size());
+}
+
+
+} // namespace Tech
@@ -1,22 +1,248 @@
 #include <tech/logger.h>
 
+#include <chrono>
+#include <map>
+#include <mutex>
+
 
 namespace Tech {
 
 
+namespace {
+
+
+struct LogConfiguration {
+	std::mutex mutex;
+	LogLevel level = LogLevel::kInfo;
+	std::map<String, LogLevel> moduleLevels;
+	std::map<String, LogLevel> fileLevels;
+};
+
+
+LogConfiguration& configuration()
+{
+	static LogConfiguration configuration;
+	return configuration;
+}
+
+
+LogLevel threshold(LogConfiguration& config, const char* fileName, const char* module)
+{
+	auto it = config.fileLevels.find(fileName + basenameIndex(fileName));
+
+	if(it != config.fileLevels.end())
+		return it->second;
+
+	if(*module) {
+		it = config.moduleLevels.find(module);
+
+		if(it != config.moduleLevels.end())
+			return it->second;
+	}
+
+	return config.level;
+}
+
+
+} // namespace
+
+
 static LogMessageHandler logMessageHandler;
+static LogRecordHandler logRecordHandler;
+static std::atomic<DeferredLogSink*> deferredSink(nullptr);
+static std::atomic<bool> hasReceiver(false);
+
+std::atomic<u32> LogSite::generation_(1);
+
+
+bool LogSite::atMostEvery(i64 milliseconds)
+{
+	i64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	i64 next = nextTime_.load(std::memory_order_relaxed);
+
+	// Only one of the threads which see the expired interval wins the exchange
+	return now >= next && nextTime_.compare_exchange_strong(next, now + milliseconds,
+			std::memory_order_relaxed);
+}
+
+
+void LogSite::invalidateAll()
+{
+	generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+bool LogSite::refresh()
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	// Generation is read under the lock: a concurrent change either happens before it,
+	// or invalidates the result once more
+	u32 generation = generation_.load(std::memory_order_relaxed) & 0x7FFFFFFF;
+	bool isEnabled = hasReceiver.load(std::memory_order_relaxed) &&
+			level_ >= threshold(config, file_, module_);
+
+	state_.store(generation << 1 | (isEnabled ? 1 : 0), std::memory_order_relaxed);
+	return isEnabled;
+}
+
+
+const char* logLevelName(LogLevel level)
+{
+	switch(level) {
+	case LogLevel::kTrace:
+		return "trace";
+
+	case LogLevel::kDebug:
+		return "debug";
+
+	case LogLevel::kInfo:
+		return "info";
+
+	case LogLevel::kWarning:
+		return "warning";
+
+	case LogLevel::kError:
+		return "error";
+
+	case LogLevel::kOff:
+		break;
+	}
+
+	return "off";
+}
+
+
+void setLogLevel(LogLevel level)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	config.level = level;
+	LogSite::invalidateAll();
+}
+
+
+void setModuleLogLevel(const String& module, LogLevel level)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	config.moduleLevels[module] = level;
+	LogSite::invalidateAll();
+}
+
+
+void setFileLogLevel(const String& fileName, LogLevel level)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	config.fileLevels[fileName] = level;
+	LogSite::invalidateAll();
+}
+
+
+void resetLogLevels()
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	config.level = LogLevel::kInfo;
+	config.moduleLevels.clear();
+	config.fileLevels.clear();
+	LogSite::invalidateAll();
+}
+
+
+bool isLogEnabled(LogLevel level, const char* fileName, const char* module)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	return hasReceiver.load(std::memory_order_relaxed) &&
+			level >= threshold(config, fileName, module);
+}
 
 
 void setLogMessageHandler(const LogMessageHandler& handler)
 {
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
 	logMessageHandler = handler;
+	hasReceiver.store(!handler.isNull() || !logRecordHandler.isNull() ||
+			deferredSink.load(), std::memory_order_relaxed);
+	LogSite::invalidateAll();
 }
 
 
-void logMessage(const char* fileName, int line, const String& message)
+void logMessage(LogLevel level, const char* fileName, int line, const String& message)
 {
 	if(!logMessageHandler.isNull())
-		logMessageHandler(fileName, line, message);
+		logMessageHandler(level, fileName, line, message);
+}
+
+
+void setLogRecordHandler(const LogRecordHandler& handler)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	logRecordHandler = handler;
+	hasReceiver.store(!logMessageHandler.isNull() || !handler.isNull() ||
+			deferredSink.load(), std::memory_order_relaxed);
+	LogSite::invalidateAll();
+}
+
+
+void logFields(LogLevel level, const char* fileName, int line, const char* message,
+		const LogFields& fields)
+{
+	DeferredLogSink* sink = deferredLogSink();
+
+	if(sink && sink->postFields(level, fileName, line, message, fields))
+		return;
+
+	if(!logRecordHandler.isNull()) {
+		logRecordHandler(level, fileName, line, message, fields);
+	}
+	else if(!logMessageHandler.isNull()) {
+		logMessageHandler(level, fileName, line,
+				formatLogRecord(LogFieldFormat::kText, message, fields));
+	}
+}
+
+
+void setDeferredLogSink(DeferredLogSink* sink)
+{
+	LogConfiguration& config = configuration();
+	std::lock_guard<std::mutex> lock(config.mutex);
+
+	deferredSink.store(sink, std::memory_order_release);
+	hasReceiver.store(!logMessageHandler.isNull() || !logRecordHandler.isNull() || sink,
+			std::memory_order_relaxed);
+	LogSite::invalidateAll();
+}
+
+
+bool DeferredLogSink::postFields(LogLevel level, const char* fileName, int line,
+		const char* message, const LogFields& fields)
+{
+	UNUSED(level);
+	UNUSED(fileName);
+	UNUSED(line);
+	UNUSED(message);
+	UNUSED(fields);
+	return false;
+}
+
+
+DeferredLogSink* deferredLogSink()
+{
+	return deferredSink.load(std::memory_order_acquire);
 }
 
 
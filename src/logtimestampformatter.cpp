@@ -0,0 +1,172 @@
+#include <tech/logtimestampformatter.h>
+
+#include <cstring>
+#include <ctime>
+#include <tech/duration.h>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+void writeDigits(char* buffer, int value, int count)
+{
+	for(int i = count - 1; i >= 0; --i) {
+		buffer[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+}
+
+
+// Floor division, so that times before the Epoch get the right second
+i64 secondOf(i64 msecs)
+{
+	if(msecs >= 0)
+		return msecs / Duration::kMsecsPerSecond;
+
+	return (msecs - Duration::kMsecsPerSecond + 1) / Duration::kMsecsPerSecond;
+}
+
+
+} // namespace
+
+
+LogTimestampFormatter::LogTimestampFormatter(Clock clock, TimeZone zone) :
+	clock_(clock),
+	zone_(zone),
+	version_(0),
+	second_(0),
+	prefix_{}
+{
+	// Second 0 is a valid time, so the cache starts with its rendering
+	char buffer[kWordCount * sizeof(u64)] = {};
+	renderPrefix(0, buffer);
+
+	for(size_t i = 0; i < kWordCount; ++i) {
+		u64 word;
+		std::memcpy(&word, buffer + i * sizeof(word), sizeof(word));
+		prefix_[i].store(word, std::memory_order_relaxed);
+	}
+}
+
+
+LogTimestampFormatter::Clock LogTimestampFormatter::clock() const
+{
+	return clock_.load(std::memory_order_relaxed);
+}
+
+
+void LogTimestampFormatter::setClock(Clock clock)
+{
+	clock_.store(clock, std::memory_order_relaxed);
+}
+
+
+LogTimestampFormatter::TimeZone LogTimestampFormatter::timeZone() const
+{
+	return zone_;
+}
+
+
+i64 LogTimestampFormatter::format(char* buffer)
+{
+	i64 msecs = now();
+	format(msecs, buffer);
+	return msecs;
+}
+
+
+void LogTimestampFormatter::format(i64 msecs, char* buffer)
+{
+	i64 second = secondOf(msecs);
+	int msecond = static_cast<int>(msecs - second * Duration::kMsecsPerSecond);
+	char prefix[kWordCount * sizeof(u64)];
+
+	u32 version = version_.load(std::memory_order_acquire);
+
+	if(!(version & 1) && second_.load(std::memory_order_relaxed) == second) {
+		for(size_t i = 0; i < kWordCount; ++i) {
+			u64 word = prefix_[i].load(std::memory_order_relaxed);
+			std::memcpy(prefix + i * sizeof(word), &word, sizeof(word));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if(version_.load(std::memory_order_relaxed) == version) {
+			std::memcpy(buffer, prefix, kPrefixLength);
+			writeDigits(buffer + kPrefixLength, msecond, 3);
+			return;
+		}
+	}
+
+	// Cache miss: a new second or a concurrent update
+	renderPrefix(second, prefix);
+	std::memcpy(buffer, prefix, kPrefixLength);
+	writeDigits(buffer + kPrefixLength, msecond, 3);
+
+	// Only one thread updates the cache, the others just use their own rendering. The
+	// cache never goes back in time, since messages from several threads may come with
+	// slightly unordered timestamps.
+	if((version & 1) || second <= second_.load(std::memory_order_relaxed))
+		return;
+
+	if(!version_.compare_exchange_strong(version, version + 1, std::memory_order_relaxed))
+		return;
+
+	std::atomic_thread_fence(std::memory_order_release);
+	second_.store(second, std::memory_order_relaxed);
+
+	for(size_t i = 0; i < kWordCount; ++i) {
+		u64 word;
+		std::memcpy(&word, prefix + i * sizeof(word), sizeof(word));
+		prefix_[i].store(word, std::memory_order_relaxed);
+	}
+
+	version_.store(version + 2, std::memory_order_release);
+}
+
+
+i64 LogTimestampFormatter::now() const
+{
+	timespec time;
+
+#ifdef CLOCK_REALTIME_COARSE
+	clock_gettime(clock() == Clock::kCoarse ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME,
+			&time);
+#else
+	clock_gettime(CLOCK_REALTIME, &time);
+#endif
+
+	return static_cast<i64>(time.tv_sec) * Duration::kMsecsPerSecond +
+			time.tv_nsec / 1000000;
+}
+
+
+void LogTimestampFormatter::renderPrefix(i64 second, char* buffer) const
+{
+	time_t time = static_cast<time_t>(second);
+	tm calendar;
+
+	if(zone_ == TimeZone::kUtc)
+		gmtime_r(&time, &calendar);
+	else
+		localtime_r(&time, &calendar);
+
+	writeDigits(buffer, calendar.tm_year + 1900, 4);
+	buffer[4] = '-';
+	writeDigits(buffer + 5, calendar.tm_mon + 1, 2);
+	buffer[7] = '-';
+	writeDigits(buffer + 8, calendar.tm_mday, 2);
+	buffer[10] = ' ';
+	writeDigits(buffer + 11, calendar.tm_hour, 2);
+	buffer[13] = ':';
+	writeDigits(buffer + 14, calendar.tm_min, 2);
+	buffer[16] = ':';
+	writeDigits(buffer + 17, calendar.tm_sec, 2);
+	buffer[19] = '.';
+}
+
+
+} // namespace Tech
@@ -0,0 +1,450 @@
+#include <tech/mappedlogsink.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "utf8.h"
+
+
+namespace Tech {
+
+
+namespace {
+
+
+const u32 kMagic = MAKE_MAGIC('T', 'L', 'O', 'G');
+const u32 kVersion = 1;
+const size_t kMinCapacity = 4096;
+
+
+// Header of the ring file. Positions are logical byte offsets which grow monotonically,
+// the physical offset in the ring is position % capacity.
+struct RingHeader {
+	u32 magic;
+	u32 version;
+	u64 capacity;
+	std::atomic<u64> tail;     // Position of the oldest record
+	std::atomic<u64> head;     // Position past the newest record
+	std::atomic<u64> sequence; // Sequence number of the next record
+	u8 reserved[24];
+};
+
+static_assert(sizeof(RingHeader) == 64, "unexpected ring header size");
+
+
+enum RecordKind : u8 {
+	kMessageRecord = 1,
+	kPaddingRecord = 2
+};
+
+
+// Record is followed by the file name and the message in UTF-8 and padded to 8 bytes.
+// A gap at the end of the ring which is shorter than the header is skipped implicitly.
+struct RecordHeader {
+	u32 size;
+	u32 checksum;
+	u64 sequence;
+	i64 time;
+	i32 line;
+	u32 messageSize;
+	u16 fileSize;
+	u8 level;
+	u8 kind;
+	u32 reserved;
+};
+
+static_assert(sizeof(RecordHeader) == 40, "unexpected record header size");
+
+
+u64 alignedSize(u64 size)
+{
+	return (size + 7) & ~u64(7);
+}
+
+
+// FNV-1a style hash of the header (with zero checksum) and the payload, which consumes
+// 8 bytes per step
+u32 checksum(const RecordHeader& header, const u8* payload, size_t size)
+{
+	static const u64 kPrime = 1099511628211ull;
+
+	RecordHeader copy = header;
+	copy.checksum = 0;
+
+	u64 hash = 14695981039346656037ull;
+	u64 word;
+
+	for(size_t i = 0; i < sizeof(copy); i += sizeof(word)) {
+		std::memcpy(&word, reinterpret_cast<const u8*>(&copy) + i, sizeof(word));
+		hash = (hash ^ word) * kPrime;
+	}
+
+	size_t i = 0;
+
+	for(; i + sizeof(word) <= size; i += sizeof(word)) {
+		std::memcpy(&word, payload + i, sizeof(word));
+		hash = (hash ^ word) * kPrime;
+	}
+
+	if(i < size) {
+		word = 0;
+		std::memcpy(&word, payload + i, size - i);
+		hash = (hash ^ word) * kPrime;
+	}
+
+	return static_cast<u32>(hash ^ (hash >> 32));
+}
+
+
+RingHeader* ringHeader(u8* mapping)
+{
+	return reinterpret_cast<RingHeader*>(mapping);
+}
+
+
+} // namespace
+
+
+MappedLogSink::MappedLogSink(const String& fileName, size_t capacity) :
+	fd_(-1),
+	mapping_(nullptr),
+	mappingSize_(0),
+	data_(nullptr),
+	capacity_(alignedSize(std::max(capacity, kMinCapacity)))
+{
+	ByteArray path = fileName.toUtf8();
+	std::string pathString(path.constData(), path.length());
+
+	fd_ = ::open(pathString.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+	if(fd_ == -1)
+		return;
+
+	mappingSize_ = sizeof(RingHeader) + capacity_;
+
+	if(::ftruncate(fd_, mappingSize_) == -1) {
+		::close(fd_);
+		fd_ = -1;
+		return;
+	}
+
+	void* mapping = ::mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd_, 0);
+
+	if(mapping == MAP_FAILED) {
+		::close(fd_);
+		fd_ = -1;
+		return;
+	}
+
+	mapping_ = static_cast<u8*>(mapping);
+	data_ = mapping_ + sizeof(RingHeader);
+
+	if(!isRingValid())
+		reset();
+}
+
+
+MappedLogSink::~MappedLogSink()
+{
+	if(mapping_)
+		::munmap(mapping_, mappingSize_);
+
+	if(fd_ != -1)
+		::close(fd_);
+}
+
+
+bool MappedLogSink::isOpen() const
+{
+	return mapping_ != nullptr;
+}
+
+
+size_t MappedLogSink::capacity() const
+{
+	return capacity_;
+}
+
+
+void MappedLogSink::write(LogLevel level, const String& file, int line,
+		const String& message)
+{
+	timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+
+	const String* text = &message;
+	String truncated;
+	size_t fullFileSize = utf8Length(file);
+	size_t messageSize = utf8Length(message);
+
+	// A record takes at most a quarter of the ring, the file name at most an eighth
+	size_t maxRecordSize = capacity_ / 4;
+	size_t fileSize = std::min<size_t>({fullFileSize, capacity_ / 8, 0xFFFF});
+	size_t maxMessageSize = maxRecordSize > sizeof(RecordHeader) + fileSize ?
+			maxRecordSize - sizeof(RecordHeader) - fileSize : 0;
+
+	if(messageSize > maxMessageSize) {
+		truncated = message.left(maxMessageSize / 3);
+		text = &truncated;
+		messageSize = utf8Length(truncated);
+	}
+
+	u64 size = alignedSize(sizeof(RecordHeader) + fileSize + messageSize);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(!mapping_)
+		return;
+
+	RingHeader* ring = ringHeader(mapping_);
+	u64 head = ring->head.load(std::memory_order_relaxed);
+	u64 rest = capacity_ - head % capacity_;
+
+	// Records are contiguous: the rest of the ring is skipped if the record doesn't fit
+	if(rest < size) {
+		makeRoom(head, rest);
+
+		if(rest >= sizeof(RecordHeader)) {
+			RecordHeader padding = {};
+			padding.size = static_cast<u32>(rest);
+			padding.kind = kPaddingRecord;
+			std::memcpy(data_ + head % capacity_, &padding, sizeof(padding));
+		}
+
+		head += rest;
+		ring->head.store(head, std::memory_order_release);
+	}
+
+	makeRoom(head, size);
+
+	u8* record = data_ + head % capacity_;
+	u8* payload = record + sizeof(RecordHeader);
+	u64 sequence = ring->sequence.load(std::memory_order_relaxed);
+
+	RecordHeader header = {};
+	header.size = static_cast<u32>(size);
+	header.sequence = sequence;
+	header.time = static_cast<i64>(time.tv_sec) * Duration::kMsecsPerSecond +
+			time.tv_nsec / 1000000;
+	header.line = line;
+	header.messageSize = static_cast<u32>(messageSize);
+	header.fileSize = static_cast<u16>(fileSize);
+	header.level = static_cast<u8>(level);
+	header.kind = kMessageRecord;
+
+	if(fileSize == fullFileSize) {
+		encodeUtf8(file, reinterpret_cast<char*>(payload));
+	}
+	else {
+		// Unreasonably long file name, which can't be truncated in place
+		std::memset(payload, '?', fileSize);
+	}
+
+	encodeUtf8(*text, reinterpret_cast<char*>(payload + fileSize));
+	header.checksum = checksum(header, payload, fileSize + messageSize);
+	std::memcpy(record, &header, sizeof(header));
+
+	// Publishing the new head makes the record visible to the reader
+	ring->sequence.store(sequence + 1, std::memory_order_relaxed);
+	ring->head.store(head + size, std::memory_order_release);
+}
+
+
+void MappedLogSink::sync()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(mapping_)
+		::msync(mapping_, mappingSize_, MS_SYNC);
+}
+
+
+void MappedLogSink::reset()
+{
+	RingHeader* ring = ringHeader(mapping_);
+
+	ring->magic = kMagic;
+	ring->version = kVersion;
+	ring->capacity = capacity_;
+	ring->tail.store(0, std::memory_order_relaxed);
+	ring->head.store(0, std::memory_order_relaxed);
+	ring->sequence.store(0, std::memory_order_relaxed);
+	std::memset(ring->reserved, 0, sizeof(ring->reserved));
+}
+
+
+bool MappedLogSink::isRingValid() const
+{
+	const RingHeader* ring = ringHeader(mapping_);
+
+	if(ring->magic != kMagic || ring->version != kVersion || ring->capacity != capacity_)
+		return false;
+
+	u64 tail = ring->tail.load(std::memory_order_relaxed);
+	u64 head = ring->head.load(std::memory_order_relaxed);
+
+	if(head < tail || head - tail > capacity_)
+		return false;
+
+	// Sizes of the records are needed to overwrite them later
+	while(tail < head) {
+		u64 size = recordSize(tail);
+
+		if(size == 0 || size % 8 || size > capacity_ - tail % capacity_)
+			return false;
+
+		tail += size;
+	}
+
+	return tail == head;
+}
+
+
+u64 MappedLogSink::recordSize(u64 position) const
+{
+	u64 offset = position % capacity_;
+	u64 rest = capacity_ - offset;
+
+	if(rest < sizeof(RecordHeader))
+		return rest;
+
+	RecordHeader header;
+	std::memcpy(&header, data_ + offset, sizeof(header));
+	return header.size;
+}
+
+
+void MappedLogSink::makeRoom(u64 head, u64 size)
+{
+	RingHeader* ring = ringHeader(mapping_);
+	u64 tail = ring->tail.load(std::memory_order_relaxed);
+
+	if(head + size - tail <= capacity_)
+		return;
+
+	while(head + size - tail > capacity_)
+		tail += recordSize(tail);
+
+	// The tail is moved before the oldest records are overwritten
+	ring->tail.store(tail, std::memory_order_release);
+}
+
+
+MappedLogReader::MappedLogReader(const String& fileName) :
+	isValid_(false)
+{
+	ByteArray path = fileName.toUtf8();
+	std::ifstream file(std::string(path.constData(), path.length()),
+			std::ios::binary | std::ios::ate);
+
+	if(!file)
+		return;
+
+	content_.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+
+	if(!file.read(reinterpret_cast<char*>(content_.data()), content_.size()))
+		return;
+
+	if(content_.size() < sizeof(RingHeader))
+		return;
+
+	const RingHeader* ring = ringHeader(content_.data());
+	u64 capacity = ring->capacity;
+
+	if(ring->magic != kMagic || ring->version != kVersion || capacity == 0 ||
+			content_.size() < sizeof(RingHeader) + capacity)
+		return;
+
+	u64 tail = ring->tail.load(std::memory_order_relaxed);
+	u64 head = ring->head.load(std::memory_order_relaxed);
+
+	if(head < tail || head - tail > capacity)
+		return;
+
+	isValid_ = true;
+
+	const u8* data = content_.data() + sizeof(RingHeader);
+	u64 position = tail;
+
+	while(position < head) {
+		u64 offset = position % capacity;
+		u64 rest = capacity - offset;
+
+		if(rest < sizeof(RecordHeader)) {
+			position += rest;
+			continue;
+		}
+
+		RecordHeader header;
+		std::memcpy(&header, data + offset, sizeof(header));
+
+		// A broken record means that the sizes of the following ones are unknown
+		if(header.size < sizeof(RecordHeader) || header.size % 8 || header.size > rest)
+			break;
+
+		size_t payloadSize = header.fileSize + header.messageSize;
+
+		if(header.kind == kMessageRecord &&
+				sizeof(RecordHeader) + payloadSize <= header.size &&
+				header.checksum == checksum(header, data + offset + sizeof(RecordHeader),
+					payloadSize))
+			offsets_.push_back(sizeof(RingHeader) + offset);
+
+		position += header.size;
+	}
+}
+
+
+bool MappedLogReader::isValid() const
+{
+	return isValid_;
+}
+
+
+std::vector<MappedLogReader::Record> MappedLogReader::lastRecords(size_t count) const
+{
+	std::vector<Record> result;
+	size_t first = offsets_.size() > count ? offsets_.size() - count : 0;
+
+	result.reserve(offsets_.size() - first);
+
+	for(size_t i = first; i < offsets_.size(); ++i)
+		result.push_back(decode(offsets_[i]));
+
+	return result;
+}
+
+
+std::vector<MappedLogReader::Record> MappedLogReader::records() const
+{
+	return lastRecords(offsets_.size());
+}
+
+
+MappedLogReader::Record MappedLogReader::decode(size_t offset) const
+{
+	RecordHeader header;
+	std::memcpy(&header, content_.data() + offset, sizeof(header));
+
+	const char* payload =
+			reinterpret_cast<const char*>(content_.data() + offset + sizeof(header));
+
+	Record record;
+	record.sequence = header.sequence;
+	record.time = Duration(header.time);
+	record.level = static_cast<LogLevel>(header.level);
+	record.file = String::fromUtf8(payload, header.fileSize);
+	record.line = header.line;
+	record.message = String::fromUtf8(payload + header.fileSize, header.messageSize);
+	return record;
+}
+
+
+} // namespace Tech
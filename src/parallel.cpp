@@ -0,0 +1,120 @@
+#include <tech/parallel.h>
+
+#include <climits>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+template<typename T>
+struct SortKey {
+	u64 prefix;
+	T* item;
+};
+
+
+// ByteArray compares bytes as char, so signed bytes are flipped to keep the order
+inline
+u64 bytePrefix(const ByteArray& array)
+{
+	const u8* data = reinterpret_cast<const u8*>(array.constData());
+	size_t size = std::min<size_t>(array.length(), 8);
+	u8 flip = CHAR_MIN < 0 ? 0x80 : 0;
+	u64 prefix = 0;
+
+	for(size_t i = 0; i < size; ++i)
+		prefix |= static_cast<u64>(data[i] ^ flip) << (56 - i * 8);
+
+	return prefix;
+}
+
+
+inline
+u64 charPrefix(const String& string)
+{
+	const Char* data = string.constData();
+	size_t size = std::min<size_t>(string.length(), 4);
+	u64 prefix = 0;
+
+	for(size_t i = 0; i < size; ++i)
+		prefix |= static_cast<u64>(data[i].unicode()) << (48 - i * 16);
+
+	return prefix;
+}
+
+
+// A shorter string is padded with zeros, so equal prefixes don't mean equal strings
+// and the tie is broken by the full comparison
+template<typename T, typename Prefix>
+void sortByPrefix(ThreadPool* pool, std::vector<T>* list, Prefix prefix, bool isUnique)
+{
+	size_t count = list->size();
+	std::vector<SortKey<T>> keys(count);
+
+	parallelFor(pool, count, internal::kParallelMinChunkSize,
+			[list, &keys, &prefix](size_t begin, size_t end) {
+				for(size_t i = begin; i < end; ++i)
+					keys[i] = {prefix((*list)[i]), &(*list)[i]};
+			});
+
+	parallelSort(pool, keys.begin(), keys.end(),
+			[](const SortKey<T>& a, const SortKey<T>& b) {
+				if(a.prefix != b.prefix)
+					return a.prefix < b.prefix;
+
+				return *a.item < *b.item;
+			});
+
+	if(isUnique) {
+		auto end = parallelUnique(pool, keys.begin(), keys.end(),
+				[](const SortKey<T>& a, const SortKey<T>& b) {
+					return a.prefix == b.prefix && *a.item == *b.item;
+				});
+
+		keys.erase(end, keys.end());
+		count = keys.size();
+	}
+
+	std::vector<T> sorted(count);
+
+	parallelFor(pool, count, internal::kParallelMinChunkSize,
+			[&sorted, &keys](size_t begin, size_t end) {
+				for(size_t i = begin; i < end; ++i)
+					sorted[i].swap(*keys[i].item);
+			});
+
+	list->swap(sorted);
+}
+
+
+} // namespace
+
+
+void parallelSort(ThreadPool* pool, ByteArrayList* list)
+{
+	sortByPrefix(pool, list, bytePrefix, false);
+}
+
+
+void parallelSort(ThreadPool* pool, StringList* list)
+{
+	sortByPrefix(pool, list, charPrefix, false);
+}
+
+
+void parallelSortUnique(ThreadPool* pool, ByteArrayList* list)
+{
+	sortByPrefix(pool, list, bytePrefix, true);
+}
+
+
+void parallelSortUnique(ThreadPool* pool, StringList* list)
+{
+	sortByPrefix(pool, list, charPrefix, true);
+}
+
+
+} // namespace Tech
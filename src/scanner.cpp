@@ -0,0 +1,713 @@
+#include <tech/scanner.h>
+
+#include <cstdlib>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+// Разобранный спецификатор формата подстановочного поля
+struct ScanSpec {
+	u32 fill;
+	bool hasAlignment;
+	bool showBasePrefix;
+	size_t width;
+	int base;
+	char type;
+};
+
+
+// Признак окончания строкового поля
+struct FieldStop {
+	enum Kind {
+		kEnd,      // Поле является последним в шаблоне и продолжается до конца данных
+		kLiteral,  // Поле продолжается до символа unit
+		kSpace     // За полем сразу следует другое поле, граница - пробельный символ
+	};
+
+	Kind kind;
+	u32 unit;
+};
+
+
+inline
+bool isSpaceUnit(u32 unit)
+{
+	return unit == ' ' || unit == '\t';
+}
+
+
+inline
+int digitValue(u32 unit, int base)
+{
+	int digit;
+
+	if(unit >= '0' && unit <= '9') {
+		digit = unit - '0';
+	}
+	else if(unit >= 'a' && unit <= 'z') {
+		digit = unit - 'a' + 10;
+	}
+	else if(unit >= 'A' && unit <= 'Z') {
+		digit = unit - 'A' + 10;
+	}
+	else {
+		return -1;
+	}
+
+	return digit < base ? digit : -1;
+}
+
+
+// Считывает из шаблона один символ литерала и преобразует его в кодировку входных
+// данных. Возвращает количество единиц кодировки, записанных в out.
+inline
+int readLiteral(const char** pos, const char* end, char* out)
+{
+	UNUSED(end);
+
+	*out = *(*pos)++;
+	return 1;
+}
+
+
+inline
+int readLiteral(const ch16** pos, const ch16* end, ch16* out)
+{
+	UNUSED(end);
+
+	*out = *(*pos)++;
+	return 1;
+}
+
+
+int readLiteral(const char** pos, const char* end, ch16* out)
+{
+	const u8* p = reinterpret_cast<const u8*>(*pos);
+	const u8* e = reinterpret_cast<const u8*>(end);
+	u32 code = *p++;
+	int extra = 0;
+
+	if(code >= 0xF0) {
+		code &= 0x07;
+		extra = 3;
+	}
+	else if(code >= 0xE0) {
+		code &= 0x0F;
+		extra = 2;
+	}
+	else if(code >= 0xC0) {
+		code &= 0x1F;
+		extra = 1;
+	}
+
+	while(extra-- && p < e)
+		code = (code << 6) | (*p++ & 0x3F);
+
+	*pos = reinterpret_cast<const char*>(p);
+
+	if(code < 0x10000) {
+		out[0] = code;
+		return 1;
+	}
+
+	code -= 0x10000;
+	out[0] = 0xD800 + (code >> 10);
+	out[1] = 0xDC00 + (code & 0x3FF);
+	return 2;
+}
+
+
+// Декодирует один символ UTF-8 из входных данных, не выходящий за пределы BMP
+inline
+bool readChar(const char** pos, const char* end, ch16* result)
+{
+	const char* p = *pos;
+	ch16 units[2];
+
+	if(readLiteral(&p, end, units) != 1)
+		return false;
+
+	*pos = p;
+	*result = units[0];
+	return true;
+}
+
+
+inline
+bool readChar(const ch16** pos, const ch16* end, ch16* result)
+{
+	UNUSED(end);
+
+	*result = *(*pos)++;
+	return true;
+}
+
+
+template<typename P>
+const P* parseSpec(const P* pos, const P* end, ScanSpec* spec)
+{
+	auto isAlignment = [](u32 unit) {
+		return unit == '<' || unit == '>' || unit == '^' || unit == '=';
+	};
+
+	if(end - pos > 1 && *pos != '}' && isAlignment(pos[1])) {
+		spec->fill = static_cast<u32>(*pos);
+		spec->hasAlignment = true;
+		pos += 2;
+	}
+	else if(pos < end && isAlignment(*pos)) {
+		spec->hasAlignment = true;
+		++pos;
+	}
+
+	if(pos < end && (*pos == '+' || *pos == '-' || *pos == ' '))
+		++pos;
+
+	if(pos < end && *pos == '#') {
+		spec->showBasePrefix = true;
+		++pos;
+	}
+
+	if(pos < end && *pos == '0') {
+		spec->fill = '0';
+		spec->hasAlignment = true;
+		++pos;
+	}
+
+	while(pos < end && *pos >= '0' && *pos <= '9')
+		spec->width = spec->width * 10 + (*pos++ - '0');
+
+	if(pos < end && *pos == '.') {
+		++pos;
+
+		while(pos < end && *pos >= '0' && *pos <= '9')
+			++pos;
+	}
+
+	if(pos < end && *pos != '}') {
+		spec->type = static_cast<char>(*pos++);
+
+		switch(spec->type) {
+		case 'b':
+			spec->base = 2;
+			break;
+
+		case 'o':
+			spec->base = 8;
+			break;
+
+		case 'x':
+		case 'X':
+			spec->base = 16;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return pos;
+}
+
+
+template<typename I>
+bool parseInteger(const I** pos, const I* end, const ScanSpec& spec, bool isSigned,
+		u64* value, bool* isNegative)
+{
+	const I* p = *pos;
+	int base = spec.base;
+
+	*isNegative = false;
+
+	if(p < end && (*p == '-' || *p == '+')) {
+		*isNegative = *p == '-';
+		++p;
+
+		if(*isNegative && !isSigned)
+			return false;
+	}
+
+	if(spec.showBasePrefix && end - p > 2 && *p == '0') {
+		u32 prefix = static_cast<u32>(p[1]) | 0x20;
+
+		if((prefix == 'x' && (base == 16 || spec.type == 0)) ||
+				(prefix == 'b' && (base == 2 || spec.type == 0)) ||
+				(prefix == 'o' && (base == 8 || spec.type == 0))) {
+			base = prefix == 'x' ? 16 : (prefix == 'b' ? 2 : 8);
+			p += 2;
+		}
+	}
+
+	const I* digits = p;
+	u64 result = 0;
+
+	while(p < end) {
+		int digit = digitValue(static_cast<u32>(*p), base);
+		if(digit == -1)
+			break;
+
+		if(result > (Limits<u64>::max() - digit) / base)
+			return false;
+
+		result = result * base + digit;
+		++p;
+	}
+
+	if(p == digits)
+		return false;
+
+	*pos = p;
+	*value = result;
+	return true;
+}
+
+
+bool storeInteger(const Scanner::Argument& arg, u64 value, bool isNegative)
+{
+	uint bits = arg.size * 8;
+
+	if(arg.type == Scanner::Argument::kSigned) {
+		u64 limit = (u64(1) << (bits - 1)) - (isNegative ? 0 : 1);
+		if(value > limit)
+			return false;
+
+		i64 result = isNegative ? -static_cast<i64>(value - 1) - 1 :
+				static_cast<i64>(value);
+
+		switch(arg.size) {
+		case 1:
+			*static_cast<i8*>(arg.target) = static_cast<i8>(result);
+			break;
+
+		case 2:
+			*static_cast<i16*>(arg.target) = static_cast<i16>(result);
+			break;
+
+		case 4:
+			*static_cast<i32*>(arg.target) = static_cast<i32>(result);
+			break;
+
+		default:
+			*static_cast<i64*>(arg.target) = result;
+			break;
+		}
+
+		return true;
+	}
+
+	if(bits < 64 && value > (u64(1) << bits) - 1)
+		return false;
+
+	switch(arg.size) {
+	case 1:
+		*static_cast<u8*>(arg.target) = static_cast<u8>(value);
+		break;
+
+	case 2:
+		*static_cast<u16*>(arg.target) = static_cast<u16>(value);
+		break;
+
+	case 4:
+		*static_cast<u32*>(arg.target) = static_cast<u32>(value);
+		break;
+
+	default:
+		*static_cast<u64*>(arg.target) = value;
+		break;
+	}
+
+	return true;
+}
+
+
+template<typename I>
+bool parseFloatingPoint(const I** pos, const I* end, const Scanner::Argument& arg)
+{
+	// Вещественное число копируется во временный буфер на стеке, т.к. strtod()
+	// требует завершенную нулем C-строку
+	static const size_t kMaxLength = 64;
+
+	char buffer[kMaxLength + 1];
+	size_t length = 0;
+	const I* p = *pos;
+
+	auto accept = [&](bool condition) -> bool {
+		if(!condition || p >= end || length == kMaxLength)
+			return false;
+
+		buffer[length++] = static_cast<char>(*p++);
+		return true;
+	};
+
+	auto isDigit = [&]() {
+		return p < end && *p >= '0' && *p <= '9';
+	};
+
+	accept(p < end && (*p == '-' || *p == '+'));
+
+	bool hasDigits = false;
+	while(accept(isDigit()))
+		hasDigits = true;
+
+	if(accept(p < end && *p == '.')) {
+		while(accept(isDigit()))
+			hasDigits = true;
+	}
+
+	if(!hasDigits)
+		return false;
+
+	if(p < end && (*p == 'e' || *p == 'E')) {
+		const I* mantissaEnd = p;
+		size_t mantissaLength = length;
+
+		accept(true);
+		accept(p < end && (*p == '-' || *p == '+'));
+
+		if(!isDigit()) {
+			p = mantissaEnd;
+			length = mantissaLength;
+		}
+
+		while(accept(isDigit())) {
+		}
+	}
+
+	if(length == kMaxLength)
+		return false;
+
+	buffer[length] = '\0';
+
+	if(arg.type == Scanner::Argument::kFloat) {
+		*static_cast<float*>(arg.target) = std::strtof(buffer, nullptr);
+	}
+	else {
+		*static_cast<double*>(arg.target) = std::strtod(buffer, nullptr);
+	}
+
+	*pos = p;
+	return true;
+}
+
+
+template<typename I>
+bool parseBool(const I** pos, const I* end, bool* value)
+{
+	auto match = [&](const char* word) -> bool {
+		const I* p = *pos;
+
+		while(*word) {
+			if(p == end || static_cast<u32>(*p) != static_cast<u8>(*word))
+				return false;
+
+			++p;
+			++word;
+		}
+
+		*pos = p;
+		return true;
+	};
+
+	if(match("true") || match("1")) {
+		*value = true;
+		return true;
+	}
+
+	if(match("false") || match("0")) {
+		*value = false;
+		return true;
+	}
+
+	return false;
+}
+
+
+inline
+void assignString(const String& source, size_t from, size_t count,
+		const Scanner::Argument& arg)
+{
+	if(arg.type == Scanner::Argument::kString) {
+		*static_cast<String*>(arg.target) = source.middle(from, count);
+	}
+	else {
+		*static_cast<ByteArray*>(arg.target) = source.middle(from, count).toUtf8();
+	}
+}
+
+
+inline
+void assignString(const ByteArray& source, size_t from, size_t count,
+		const Scanner::Argument& arg)
+{
+	if(arg.type == Scanner::Argument::kString) {
+		*static_cast<String*>(arg.target) = String::fromUtf8(source.constData() + from,
+				count);
+	}
+	else {
+		*static_cast<ByteArray*>(arg.target) = source.middleRef(from, count);
+	}
+}
+
+
+template<typename I, typename S>
+bool parseField(const I** pos, const I* end, const S& source, const I* begin,
+		const ScanSpec& spec, const FieldStop& stop, const Scanner::Argument& arg)
+{
+	const I* fieldEnd = end;
+	if(spec.width && static_cast<size_t>(end - *pos) > spec.width)
+		fieldEnd = *pos + spec.width;
+
+	switch(arg.type) {
+	case Scanner::Argument::kSigned:
+	case Scanner::Argument::kUnsigned: {
+		u64 value;
+		bool isNegative;
+
+		if(!parseInteger(pos, fieldEnd, spec, arg.type == Scanner::Argument::kSigned,
+				&value, &isNegative)) {
+			return false;
+		}
+
+		return storeInteger(arg, value, isNegative); }
+
+	case Scanner::Argument::kFloat:
+	case Scanner::Argument::kDouble:
+		return parseFloatingPoint(pos, fieldEnd, arg);
+
+	case Scanner::Argument::kBool:
+		return parseBool(pos, fieldEnd, static_cast<bool*>(arg.target));
+
+	case Scanner::Argument::kChar:
+	case Scanner::Argument::kByte: {
+		ch16 ch;
+
+		if(*pos == fieldEnd || !readChar(pos, fieldEnd, &ch))
+			return false;
+
+		if(arg.type == Scanner::Argument::kChar) {
+			*static_cast<Char*>(arg.target) = ch;
+		}
+		else if(ch < 0x80) {
+			*static_cast<char*>(arg.target) = static_cast<char>(ch);
+		}
+		else {
+			return false;
+		}
+
+		return true; }
+
+	default:
+		break;
+	}
+
+	// Строковое поле (или пропускаемое поле без аргумента)
+	const I* p = *pos;
+
+	if(stop.kind == FieldStop::kLiteral) {
+		while(p < fieldEnd && static_cast<u32>(*p) != stop.unit)
+			++p;
+	}
+	else if(stop.kind == FieldStop::kSpace) {
+		while(p < fieldEnd && !isSpaceUnit(static_cast<u32>(*p)))
+			++p;
+	}
+	else {
+		p = fieldEnd;
+	}
+
+	const I* valueEnd = p;
+	if(spec.hasAlignment) {
+		while(valueEnd > *pos && static_cast<u32>(valueEnd[-1]) == spec.fill)
+			--valueEnd;
+	}
+
+	if(arg.type == Scanner::Argument::kString ||
+			arg.type == Scanner::Argument::kByteArray) {
+		assignString(source, *pos - begin, valueEnd - *pos, arg);
+	}
+
+	*pos = p;
+	return true;
+}
+
+
+template<typename I, typename P, typename S>
+ScanResult scanImpl(const S& source, const I* begin, const I* end, const P* pattern,
+		const P* patternEnd, Scanner::Argument* args, size_t count)
+{
+	const I* pos = begin;
+	const P* p = pattern;
+	size_t nextIndex = 0;
+	size_t assigned = 0;
+
+	auto failure = [&]() {
+		return ScanResult(false, assigned, pos - begin);
+	};
+
+	while(p < patternEnd) {
+		if(*p == '{' && (patternEnd - p < 2 || p[1] != '{')) {
+			++p;
+
+			size_t index = 0;
+			if(p < patternEnd && *p >= '0' && *p <= '9') {
+				while(p < patternEnd && *p >= '0' && *p <= '9')
+					index = index * 10 + (*p++ - '0');
+			}
+			else {
+				index = nextIndex;
+			}
+
+			ScanSpec spec{ ' ', false, false, 0, 10, 0 };
+			if(p < patternEnd && *p == ':')
+				p = parseSpec(p + 1, patternEnd, &spec);
+
+			// Некорректное подстановочное поле
+			if(p == patternEnd || *p != '}')
+				return failure();
+
+			++p;
+
+			FieldStop stop{ FieldStop::kEnd, 0 };
+			if(p < patternEnd) {
+				if(*p == '{' && (patternEnd - p < 2 || p[1] != '{')) {
+					stop.kind = FieldStop::kSpace;
+				}
+				else {
+					const P* next = p;
+					I units[2];
+					readLiteral(&next, patternEnd, units);
+
+					stop.kind = FieldStop::kLiteral;
+					stop.unit = static_cast<u32>(units[0]);
+				}
+			}
+
+			if(spec.hasAlignment) {
+				while(pos < end && static_cast<u32>(*pos) == spec.fill)
+					++pos;
+			}
+
+			Scanner::Argument skip{ Scanner::Argument::kNone, 0, nullptr };
+			const Scanner::Argument& arg = index < count ? args[index] : skip;
+
+			if(!parseField(&pos, end, source, begin, spec, stop, arg))
+				return failure();
+
+			if(spec.hasAlignment &&
+					!(stop.kind == FieldStop::kLiteral && stop.unit == spec.fill)) {
+				while(pos < end && static_cast<u32>(*pos) == spec.fill)
+					++pos;
+			}
+
+			if(arg.type != Scanner::Argument::kNone)
+				++assigned;
+
+			nextIndex = index + 1;
+			continue;
+		}
+
+		// "{{" и "}}" соответствуют одиночным символам '{' и '}'
+		if((*p == '{' || *p == '}') && patternEnd - p > 1 && p[1] == *p)
+			++p;
+
+		I units[2];
+		int length = readLiteral(&p, patternEnd, units);
+
+		for(int i = 0; i < length; ++i) {
+			if(pos == end || *pos != units[i])
+				return failure();
+
+			++pos;
+		}
+	}
+
+	if(pos != end)
+		return failure();
+
+	return ScanResult(true, assigned, pos - begin);
+}
+
+
+} // namespace
+
+
+Scanner::Argument Scanner::makeArgument(bool* target)
+{
+	return Argument{ Argument::kBool, sizeof(bool), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(float* target)
+{
+	return Argument{ Argument::kFloat, sizeof(float), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(double* target)
+{
+	return Argument{ Argument::kDouble, sizeof(double), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(Char* target)
+{
+	return Argument{ Argument::kChar, sizeof(Char), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(char* target)
+{
+	return Argument{ Argument::kByte, sizeof(char), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(String* target)
+{
+	return Argument{ Argument::kString, sizeof(String), target };
+}
+
+
+Scanner::Argument Scanner::makeArgument(ByteArray* target)
+{
+	return Argument{ Argument::kByteArray, sizeof(ByteArray), target };
+}
+
+
+ScanResult Scanner::doScan(const String& input, const char* pattern, Argument* args,
+		size_t count)
+{
+	auto begin = reinterpret_cast<const ch16*>(input.constData());
+	size_t patternLength = std::char_traits<char>::length(pattern);
+
+	return scanImpl(input, begin, begin + input.length(), pattern,
+			pattern + patternLength, args, count);
+}
+
+
+ScanResult Scanner::doScan(const String& input, const String& pattern, Argument* args,
+		size_t count)
+{
+	auto begin = reinterpret_cast<const ch16*>(input.constData());
+	auto patternBegin = reinterpret_cast<const ch16*>(pattern.constData());
+
+	return scanImpl(input, begin, begin + input.length(), patternBegin,
+			patternBegin + pattern.length(), args, count);
+}
+
+
+ScanResult Scanner::doScan(const ByteArray& input, const char* pattern, Argument* args,
+		size_t count)
+{
+	const char* begin = input.constData();
+	size_t patternLength = std::char_traits<char>::length(pattern);
+
+	return scanImpl(input, begin, begin + input.length(), pattern,
+			pattern + patternLength, args, count);
+}
+
+
+} // namespace Tech
@@ -0,0 +1,25 @@
+#include <tech/signal.h>
+
+
+namespace Tech {
+
+
+namespace internal {
+
+
+// Определена вне заголовка: после встраивания нескольких вызовов для одного объекта
+// компилятор не может доказать, что удаление происходит только в последнем из них, и
+// выдает ложное предупреждение об использовании освобожденной памяти
+void ConnectionData::release()
+{
+	int refs = --refs_;
+
+	if(refs == 0)
+		delete this;
+}
+
+
+} // namespace internal
+
+
+} // namespace Tech
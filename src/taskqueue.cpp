@@ -0,0 +1,202 @@
+#include <tech/taskqueue.h>
+
+
+namespace Tech {
+
+
+namespace {
+
+
+class DelegateTask final : public TaskQueue::Task {
+public:
+	explicit DelegateTask(const Delegate<void()>& delegate) :
+		delegate_(delegate)
+	{
+	}
+
+	void run() override
+	{
+		delegate_();
+	}
+
+private:
+	Delegate<void()> delegate_;
+};
+
+
+} // namespace
+
+
+TaskQueue::TaskQueue(const WakeupHandler& wakeupHandler) :
+	wakeupHandler_(wakeupHandler),
+	head_(nullptr),
+	tail_(nullptr),
+	freeChunks_(nullptr),
+	freeCount_(0),
+	count_(0)
+{
+}
+
+
+TaskQueue::~TaskQueue()
+{
+	size_t count = 0;
+	destroyTasks(head_, false, &count);
+
+	Chunk* chunk = head_;
+	while(chunk) {
+		Chunk* next = chunk->next;
+		::operator delete(chunk);
+		chunk = next;
+	}
+
+	chunk = freeChunks_;
+	while(chunk) {
+		Chunk* next = chunk->next;
+		::operator delete(chunk);
+		chunk = next;
+	}
+}
+
+
+void TaskQueue::post(const Delegate<void()>& delegate)
+{
+	post<DelegateTask>(delegate);
+}
+
+
+size_t TaskQueue::processTasks()
+{
+	Chunk* chunks;
+
+	{
+		// The whole list is taken at once, so producers contend with the owner thread
+		// only once per batch
+		std::lock_guard<std::mutex> lock(mutex_);
+		chunks = head_;
+		head_ = nullptr;
+		tail_ = nullptr;
+		count_ = 0;
+	}
+
+	size_t count = 0;
+	destroyTasks(chunks, true, &count);
+	recycle(chunks);
+	return count;
+}
+
+
+bool TaskQueue::isEmpty() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return count_ == 0;
+}
+
+
+size_t TaskQueue::alignedSize(size_t size)
+{
+	return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+
+u8* TaskQueue::chunkData(Chunk* chunk)
+{
+	return reinterpret_cast<u8*>(chunk) + alignedSize(sizeof(Chunk));
+}
+
+
+void TaskQueue::destroyTasks(Chunk* chunk, bool run, size_t* count)
+{
+	for(; chunk; chunk = chunk->next) {
+		u8* data = chunkData(chunk);
+		size_t offset = 0;
+
+		while(offset < chunk->used) {
+			Record* record = reinterpret_cast<Record*>(data + offset);
+
+			if(record->task) {
+				if(run)
+					record->task->run();
+
+				record->task->~Task();
+				++*count;
+			}
+
+			offset += record->size;
+		}
+	}
+}
+
+
+void* TaskQueue::allocate(size_t size, Record** record)
+{
+	size_t recordSize = alignedSize(sizeof(Record)) + alignedSize(size);
+
+	if(!tail_ || tail_->capacity - tail_->used < recordSize) {
+		Chunk* chunk;
+
+		if(freeChunks_ && recordSize <= kChunkSize) {
+			chunk = freeChunks_;
+			freeChunks_ = chunk->next;
+			--freeCount_;
+		}
+		else {
+			// Tasks larger than a chunk get a dedicated one, which isn't reused
+			size_t capacity = recordSize > kChunkSize ? recordSize : kChunkSize;
+			chunk = static_cast<Chunk*>(::operator new(alignedSize(sizeof(Chunk)) + capacity));
+			chunk->capacity = capacity;
+		}
+
+		chunk->next = nullptr;
+		chunk->used = 0;
+
+		if(tail_)
+			tail_->next = chunk;
+		else
+			head_ = chunk;
+
+		tail_ = chunk;
+	}
+
+	u8* data = chunkData(tail_) + tail_->used;
+	tail_->used += recordSize;
+
+	*record = reinterpret_cast<Record*>(data);
+	(*record)->size = recordSize;
+	(*record)->task = nullptr;
+	return data + alignedSize(sizeof(Record));
+}
+
+
+void TaskQueue::commit(std::unique_lock<std::mutex>* lock)
+{
+	bool wasEmpty = count_++ == 0;
+	lock->unlock();
+
+	if(wasEmpty && !wakeupHandler_.isNull())
+		wakeupHandler_();
+}
+
+
+void TaskQueue::recycle(Chunk* chunks)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	while(chunks) {
+		Chunk* next = chunks->next;
+
+		if(chunks->capacity == kChunkSize && freeCount_ < kMaxFreeChunks) {
+			chunks->next = freeChunks_;
+			freeChunks_ = chunks;
+			++freeCount_;
+		}
+		else {
+			::operator delete(chunks);
+		}
+
+		chunks = next;
+	}
+}
+
+
+} // namespace Tech
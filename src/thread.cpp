@@ -1,14 +1,114 @@
 #include <tech/thread.h>
 
+#include <climits>
+#include <string>
 #include <thread>
+#include <tech/utils.h>
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_OSX)
+#define THREAD_POSIX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef PLATFORM_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 
 namespace Tech {
 
 
+#ifdef THREAD_POSIX
+
+struct Thread::Handle {
+	pthread_t thread;
+	bool isJoinable = false;
+};
+
+#else
+
+struct Thread::Handle {
+	std::thread thread;
+	bool isJoinable = false;
+};
+
+#endif
+
+
+namespace {
+
+
+#ifdef PLATFORM_LINUX
+// Maximum length of a thread name without the terminating zero
+const size_t kMaxNameLength = 15;
+#endif
+
+
+#ifdef THREAD_POSIX
+
+bool setAttributes(pthread_attr_t* attributes, const std::vector<int>& affinity,
+		ThreadPolicy policy, int priority, size_t stackSize)
+{
+	if(stackSize != 0) {
+		size_t minimum = static_cast<size_t>(PTHREAD_STACK_MIN);
+		if(stackSize < minimum)
+			stackSize = minimum;
+
+		if(pthread_attr_setstacksize(attributes, stackSize) != 0)
+			return false;
+	}
+
+	if(policy != ThreadPolicy::kDefault) {
+		sched_param parameters = {};
+		parameters.sched_priority = priority;
+
+		if(pthread_attr_setinheritsched(attributes, PTHREAD_EXPLICIT_SCHED) != 0 ||
+				pthread_attr_setschedpolicy(attributes,
+						policy == ThreadPolicy::kFifo ? SCHED_FIFO : SCHED_RR) != 0 ||
+				pthread_attr_setschedparam(attributes, &parameters) != 0)
+			return false;
+	}
+
+#ifdef PLATFORM_LINUX
+	if(!affinity.empty()) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+
+		for(int cpu : affinity) {
+			if(cpu < 0 || cpu >= CPU_SETSIZE)
+				return false;
+
+			CPU_SET(cpu, &cpus);
+		}
+
+		if(pthread_attr_setaffinity_np(attributes, sizeof(cpus), &cpus) != 0)
+			return false;
+	}
+#else
+	UNUSED(affinity);
+#endif
+
+	return true;
+}
+
+#endif
+
+
+} // namespace
+
+
 Thread::Thread() :
 	exitFlag_(ATOMIC_FLAG_INIT),
-	state_(ThreadState::kStopped)
+	state_(ThreadState::kStopped),
+	policy_(ThreadPolicy::kDefault),
+	priority_(0),
+	stackSize_(0),
+	isJoinable_(false),
+	isStartFailed_(false),
+	handle_(new Handle())
 {
 }
 
@@ -22,16 +122,109 @@ Thread::~Thread()
 
 	waitForStarted();
 	stop();
+	join();
+}
+
+
+void Thread::setName(const String& name)
+{
+	name_ = name;
+}
+
+
+String Thread::name() const
+{
+	return name_;
+}
+
+
+void Thread::setAffinity(const std::vector<int>& cpus)
+{
+	affinity_ = cpus;
+}
+
+
+std::vector<int> Thread::affinity() const
+{
+	return affinity_;
+}
+
+
+void Thread::setScheduling(ThreadPolicy policy, int priority)
+{
+	policy_ = policy;
+	priority_ = priority;
+}
+
+
+ThreadPolicy Thread::schedulingPolicy() const
+{
+	return policy_;
+}
+
+
+int Thread::schedulingPriority() const
+{
+	return priority_;
+}
+
+
+void Thread::setStackSize(size_t size)
+{
+	stackSize_ = size;
+}
+
+
+size_t Thread::stackSize() const
+{
+	return stackSize_;
 }
 
 
-void Thread::start()
+void Thread::setJoinable(bool joinable)
 {
-	if(state_ == ThreadState::kStopped) {
-		state_ = ThreadState::kStarting;
-		std::thread thread = std::thread(trampoline, this);
-		thread.detach();
+	isJoinable_ = joinable;
+}
+
+
+bool Thread::isJoinable() const
+{
+	return isJoinable_;
+}
+
+
+bool Thread::start()
+{
+	if(state_ != ThreadState::kStopped)
+		return false;
+
+	// A finished joinable thread is joined before it's started again
+	join();
+	state_ = ThreadState::kStarting;
+	isStartFailed_ = false;
+
+	if(!launch()) {
+		state_ = ThreadState::kStopped;
+		return false;
 	}
+
+#ifdef PLATFORM_LINUX
+	// The nice value is set by the thread itself, so its result is waited for
+	if(policy_ == ThreadPolicy::kDefault && priority_ != 0) {
+		std::unique_lock<std::mutex> locker(guard_);
+
+		while(state_ == ThreadState::kStarting)
+			event_.wait(locker);
+
+		if(isStartFailed_) {
+			locker.unlock();
+			join();
+			return false;
+		}
+	}
+#endif
+
+	return true;
 }
 
 
@@ -42,6 +235,21 @@ void Thread::stop()
 }
 
 
+void Thread::join()
+{
+	if(!handle_->isJoinable)
+		return;
+
+#ifdef THREAD_POSIX
+	pthread_join(handle_->thread, nullptr);
+#else
+	handle_->thread.join();
+#endif
+
+	handle_->isJoinable = false;
+}
+
+
 bool Thread::waitForStarted(const Duration& timeout)
 {
 	if(state_ == ThreadState::kStopping || state_ == ThreadState::kStopped)
@@ -107,22 +315,132 @@ ThreadState Thread::state() const
 }
 
 
+#ifdef THREAD_POSIX
+
+bool Thread::launch()
+{
+	pthread_attr_t attributes;
+	if(pthread_attr_init(&attributes) != 0)
+		return false;
+
+	auto entry = [](void* self) -> void* {
+		trampoline(static_cast<Thread*>(self));
+		return nullptr;
+	};
+
+	// The mode is read by the thread itself at the end
+	handle_->isJoinable = isJoinable_;
+
+	int detachState = isJoinable_ ? PTHREAD_CREATE_JOINABLE : PTHREAD_CREATE_DETACHED;
+	bool isCreated =
+			setAttributes(&attributes, affinity_, policy_, priority_, stackSize_) &&
+			pthread_attr_setdetachstate(&attributes, detachState) == 0 &&
+			pthread_create(&handle_->thread, &attributes, entry, this) == 0;
+
+	pthread_attr_destroy(&attributes);
+
+	if(!isCreated)
+		handle_->isJoinable = false;
+
+	return isCreated;
+}
+
+
+bool Thread::applySettings()
+{
+	if(!name_.isEmpty()) {
+		ByteArray name = name_.toUtf8();
+
+#ifdef PLATFORM_LINUX
+		size_t length = name.length();
+
+		// Names are truncated on a character boundary
+		if(length > kMaxNameLength) {
+			length = kMaxNameLength;
+			while(length > 0 && (name.constData()[length] & 0xC0) == 0x80)
+				--length;
+		}
+
+		std::string truncated(name.constData(), length);
+		pthread_setname_np(pthread_self(), truncated.c_str());
+#else
+		pthread_setname_np(std::string(name.constData(), name.length()).c_str());
+#endif
+	}
+
+#ifdef PLATFORM_LINUX
+	// Nice values are per thread on Linux. Lowering the value needs CAP_SYS_NICE or
+	// RLIMIT_NICE.
+	if(policy_ == ThreadPolicy::kDefault && priority_ != 0) {
+		id_t id = static_cast<id_t>(::syscall(SYS_gettid));
+
+		if(setpriority(PRIO_PROCESS, id, priority_) != 0)
+			return false;
+	}
+#endif
+
+	return true;
+}
+
+#else
+
+bool Thread::launch()
+{
+	handle_->isJoinable = isJoinable_;
+	handle_->thread = std::thread(trampoline, this);
+
+	if(!isJoinable_)
+		handle_->thread.detach();
+
+	return true;
+}
+
+
+bool Thread::applySettings()
+{
+	return true;
+}
+
+#endif
+
+
 void Thread::trampoline(Thread* self)
 {
+	// A detached thread can't touch the object once the state is stopped
+	bool isJoinable = self->handle_->isJoinable;
+	bool isApplied = self->applySettings();
+
 	std::unique_lock<std::mutex> locker(self->guard_);
-	self->state_ = ThreadState::kRunning;
-	self->event_.notify_all();
 
-	locker.unlock();
+	// The thread which failed to apply the settings stops without running
+	if(isApplied) {
+		self->state_ = ThreadState::kRunning;
+		self->event_.notify_all();
+
+		locker.unlock();
+
+		// We can't call run() function if destructor is already called before we
+		// reached this point. The flag is cleared afterwards, so that a restarted thread
+		// runs again.
+		if(!self->exitFlag_.test_and_set()) {
+			self->run();
+			self->exitFlag_.clear();
+		}
 
-	// We can't call run() function if destructor is already called before we reached
-	// this point
-	if(!self->exitFlag_.test_and_set())
-		self->run();
+		locker.lock();
+	}
+	else {
+		self->isStartFailed_ = true;
+	}
 
-	locker.lock();
 	self->state_ = ThreadState::kStopped;
-	std::notify_all_at_thread_exit(self->event_, std::move(locker));
+
+	// A detached thread may outlive the object right after the notification, so it's
+	// sent when the thread has released everything. A joinable one is kept by join().
+	if(isJoinable)
+		self->event_.notify_all();
+	else
+		std::notify_all_at_thread_exit(self->event_, std::move(locker));
 }
 
 
@@ -0,0 +1,486 @@
+#include <tech/threadpool.h>
+
+#include <climits>
+#include <functional>
+#include <thread>
+#include "futex.h"
+
+
+namespace Tech {
+
+
+namespace {
+
+
+const size_t kCacheLineSize = 64;
+const size_t kInitialDequeCapacity = 256;
+
+// Attempts to find work before parking
+const int kSpinCount = 64;
+
+
+// Xorshift generator for the choice of the first victim of stealing
+inline
+u32 nextRandom()
+{
+	static thread_local u32 state = 0;
+
+	if(state == 0) {
+		state = static_cast<u32>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+		state |= 1;
+	}
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+/**
+ * Chase-Lev work-stealing deque in the formulation of Le, Pop, Cohen and Zappa Nardelli
+ * ("Correct and Efficient Work-Stealing for Weak Memory Models"), with sequentially
+ * consistent operations in place of the fences. push() and pop() are called by the
+ * owner only, steal() by any thread. Replaced arrays are kept until destruction, because
+ * stealers may still read them.
+ */
+template<typename T>
+class WorkStealingDeque {
+public:
+	WorkStealingDeque() :
+		top_(0),
+		bottom_(0)
+	{
+		arrays_.emplace_back(new Array(kInitialDequeCapacity));
+		array_.store(arrays_.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	void push(T* item)
+	{
+		i64 bottom = bottom_.load(std::memory_order_relaxed);
+		i64 top = top_.load(std::memory_order_acquire);
+		Array* array = array_.load(std::memory_order_relaxed);
+
+		if(bottom - top >= static_cast<i64>(array->capacity()))
+			array = grow(array, top, bottom);
+
+		array->put(bottom, item);
+		bottom_.store(bottom + 1, std::memory_order_release);
+	}
+
+	T* pop()
+	{
+		i64 bottom = bottom_.load(std::memory_order_relaxed) - 1;
+		Array* array = array_.load(std::memory_order_relaxed);
+		bottom_.store(bottom, std::memory_order_seq_cst);
+		i64 top = top_.load(std::memory_order_seq_cst);
+
+		if(top > bottom) {
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T* item = array->get(bottom);
+
+		// The last item, stealers compete for it
+		if(top == bottom) {
+			if(!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+					std::memory_order_relaxed)) {
+				item = nullptr;
+			}
+
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return item;
+	}
+
+	T* steal()
+	{
+		i64 top = top_.load(std::memory_order_seq_cst);
+		i64 bottom = bottom_.load(std::memory_order_seq_cst);
+
+		if(top >= bottom)
+			return nullptr;
+
+		Array* array = array_.load(std::memory_order_acquire);
+		T* item = array->get(top);
+
+		if(!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+				std::memory_order_relaxed)) {
+			return nullptr;
+		}
+
+		return item;
+	}
+
+	bool isEmpty() const
+	{
+		return top_.load(std::memory_order_seq_cst) >=
+				bottom_.load(std::memory_order_seq_cst);
+	}
+
+private:
+	class Array {
+	public:
+		explicit Array(size_t capacity) :
+			mask_(capacity - 1),
+			items_(new std::atomic<T*>[capacity])
+		{
+		}
+
+		size_t capacity() const
+		{
+			return mask_ + 1;
+		}
+
+		T* get(i64 index) const
+		{
+			return items_[static_cast<size_t>(index) & mask_].load(
+					std::memory_order_relaxed);
+		}
+
+		void put(i64 index, T* item)
+		{
+			items_[static_cast<size_t>(index) & mask_].store(item,
+					std::memory_order_relaxed);
+		}
+
+	private:
+		size_t mask_;
+		Box<std::atomic<T*>[]> items_;
+	};
+
+	// Stealers update top_, the owner updates bottom_, keep them on different lines
+	u8 padding1_[kCacheLineSize];
+	std::atomic<i64> top_;
+	u8 padding2_[kCacheLineSize];
+	std::atomic<i64> bottom_;
+	std::atomic<Array*> array_;
+	std::vector<Box<Array>> arrays_;
+	u8 padding3_[kCacheLineSize];
+
+	Array* grow(Array* array, i64 top, i64 bottom)
+	{
+		Box<Array> bigger(new Array(array->capacity() * 2));
+
+		for(i64 i = top; i < bottom; ++i)
+			bigger->put(i, array->get(i));
+
+		Array* result = bigger.get();
+		arrays_.push_back(std::move(bigger));
+		array_.store(result, std::memory_order_release);
+		return result;
+	}
+};
+
+
+} // namespace
+
+
+class ThreadPool::Worker {
+public:
+	explicit Worker(ThreadPool* pool) :
+		pool(pool)
+	{
+	}
+
+	ThreadPool* pool;
+	WorkStealingDeque<Job> deque;
+	std::thread thread;
+};
+
+
+thread_local ThreadPool::Worker* ThreadPool::currentWorker_ = nullptr;
+
+
+ThreadPool::ThreadPool(size_t threadCount) :
+	injectedCount_(0),
+	epoch_(0),
+	sleeperCount_(0),
+	finishEpoch_(0),
+	isStopping_(false)
+{
+	if(threadCount == 0)
+		threadCount = defaultThreadCount();
+
+	// Workers steal from each other, so all of them exist before the first one starts
+	for(size_t i = 0; i < threadCount; ++i)
+		workers_.emplace_back(new Worker(this));
+
+	for(auto& worker : workers_)
+		worker->thread = std::thread(&ThreadPool::workerLoop, this, worker.get());
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	isStopping_.store(true, std::memory_order_seq_cst);
+	epoch_.fetch_add(1, std::memory_order_release);
+	wakeByAddress(&epoch_, INT_MAX);
+
+	for(auto& worker : workers_)
+		worker->thread.join();
+}
+
+
+size_t ThreadPool::defaultThreadCount()
+{
+	size_t count = std::thread::hardware_concurrency();
+	return count ? count : 1;
+}
+
+
+ThreadPool* ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return &pool;
+}
+
+
+size_t ThreadPool::threadCount() const
+{
+	return workers_.size();
+}
+
+
+void ThreadPool::wait(Group* group)
+{
+	// Tasks taken by a waiting thread nest on its stack. A worker starts with its own
+	// deque, where the subtasks of the waiting task are, other threads would run
+	// unrelated tasks from the injection queue nesting without bound.
+	Worker* worker = currentWorker_;
+	if(!worker || worker->pool != this) {
+		block(group);
+		return;
+	}
+
+	bool isParked = false;
+	int spins = 0;
+
+	while(!group->isFinished()) {
+		Job* job = findJob(worker);
+
+		if(job) {
+			runJob(job);
+			spins = 0;
+		}
+		else if(spins < kSpinCount) {
+			++spins;
+			cpuRelax();
+		}
+		else {
+			park(group);
+			isParked = true;
+			spins = 0;
+		}
+	}
+
+	if(isParked) {
+		group->pending_.fetch_and(~Group::kWorkerWaiterBit, std::memory_order_relaxed);
+
+		// The wakeup which ended parking may have been meant for a new task
+		if(hasWork())
+			wake(1);
+	}
+}
+
+
+void ThreadPool::post(Job* job)
+{
+	Worker* worker = currentWorker_;
+
+	if(worker && worker->pool == this) {
+		worker->deque.push(job);
+	}
+	else {
+		std::lock_guard<std::mutex> lock(injectionMutex_);
+		injection_.push_back(job);
+		injectedCount_.store(injection_.size(), std::memory_order_relaxed);
+	}
+
+	wake(1);
+}
+
+
+auto ThreadPool::findJob(Worker* worker) -> Job*
+{
+	if(worker) {
+		if(Job* job = worker->deque.pop())
+			return job;
+	}
+
+	if(injectedCount_.load(std::memory_order_relaxed) != 0) {
+		if(Job* job = takeInjected())
+			return job;
+	}
+
+	return steal(worker);
+}
+
+
+auto ThreadPool::takeInjected() -> Job*
+{
+	std::lock_guard<std::mutex> lock(injectionMutex_);
+
+	if(injection_.empty())
+		return nullptr;
+
+	Job* job = injection_.front();
+	injection_.pop_front();
+	injectedCount_.store(injection_.size(), std::memory_order_relaxed);
+	return job;
+}
+
+
+auto ThreadPool::steal(Worker* worker) -> Job*
+{
+	size_t count = workers_.size();
+	size_t start = nextRandom() % count;
+
+	for(size_t i = 0; i < count; ++i) {
+		Worker* victim = workers_[(start + i) % count].get();
+
+		if(victim == worker)
+			continue;
+
+		if(Job* job = victim->deque.steal())
+			return job;
+	}
+
+	return nullptr;
+}
+
+
+void ThreadPool::runJob(Job* job)
+{
+	Group* group = job->group();
+	job->run();
+	delete job;
+
+	if(!group)
+		return;
+
+	// The group may be destroyed by its waiter right after the counter reaches zero
+	u32 previous = group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+	if((previous & Group::kCountMask) != 1)
+		return;
+
+	if(previous & Group::kWorkerWaiterBit) {
+		epoch_.fetch_add(1, std::memory_order_release);
+		wakeByAddress(&epoch_, INT_MAX);
+	}
+
+	if(previous & Group::kBlockedWaiterBit) {
+		finishEpoch_.fetch_add(1, std::memory_order_release);
+		wakeByAddress(&finishEpoch_, INT_MAX);
+	}
+}
+
+
+bool ThreadPool::hasWork() const
+{
+	if(injectedCount_.load(std::memory_order_seq_cst) != 0)
+		return true;
+
+	for(auto& worker : workers_) {
+		if(!worker->deque.isEmpty())
+			return true;
+	}
+
+	return false;
+}
+
+
+void ThreadPool::park(Group* group)
+{
+	u32 epoch = epoch_.load(std::memory_order_acquire);
+
+	// Registered sleepers see the work posted after this point in wake(), and the work
+	// posted before it is found by the check below. The same goes for the waiter bit
+	// and the completion of the group.
+	sleeperCount_.fetch_add(1, std::memory_order_seq_cst);
+	bool isFinished = false;
+
+	if(group) {
+		u32 pending = group->pending_.fetch_or(Group::kWorkerWaiterBit,
+				std::memory_order_seq_cst);
+
+		isFinished = (pending & Group::kCountMask) == 0;
+	}
+
+	if(!isFinished && !hasWork() && !isStopping_.load(std::memory_order_seq_cst))
+		waitOnAddress(&epoch_, epoch);
+
+	sleeperCount_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void ThreadPool::block(Group* group)
+{
+	int spins = 0;
+
+	while(!group->isFinished()) {
+		if(spins < kSpinCount) {
+			++spins;
+			cpuRelax();
+			continue;
+		}
+
+		u32 epoch = finishEpoch_.load(std::memory_order_acquire);
+		u32 pending = group->pending_.fetch_or(Group::kBlockedWaiterBit,
+				std::memory_order_seq_cst);
+
+		if((pending & Group::kCountMask) != 0)
+			waitOnAddress(&finishEpoch_, epoch);
+	}
+
+	group->pending_.fetch_and(~Group::kBlockedWaiterBit, std::memory_order_relaxed);
+}
+
+
+void ThreadPool::wake(int count)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if(sleeperCount_.load(std::memory_order_relaxed) == 0)
+		return;
+
+	epoch_.fetch_add(1, std::memory_order_release);
+	wakeByAddress(&epoch_, count);
+}
+
+
+void ThreadPool::workerLoop(Worker* worker)
+{
+	currentWorker_ = worker;
+	int spins = 0;
+
+	for(;;) {
+		Job* job = findJob(worker);
+
+		if(job) {
+			runJob(job);
+			spins = 0;
+		}
+		else if(isStopping_.load(std::memory_order_acquire)) {
+			break;
+		}
+		else if(spins < kSpinCount) {
+			++spins;
+			cpuRelax();
+		}
+		else {
+			park(nullptr);
+			spins = 0;
+		}
+	}
+
+	currentWorker_ = nullptr;
+}
+
+
+} // namespace Tech
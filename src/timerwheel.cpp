@@ -0,0 +1,267 @@
+#include <tech/timerwheel.h>
+
+#include <algorithm>
+#include <tech/utils.h>
+
+
+namespace Tech {
+
+
+const TimerWheel::Handle TimerWheel::kInvalidHandle;
+const i64 TimerWheel::kMaxTimeout;
+
+
+TimerWheel::TimerWheel(i64 now) :
+	heads_(),
+	occupied_(),
+	current_(now),
+	activeCount_(0)
+{
+}
+
+
+TimerWheel::Handle TimerWheel::create()
+{
+	Handle handle;
+
+	if(freeHandles_.empty()) {
+		entries_.push_back(Entry());
+		handle = static_cast<Handle>(entries_.size());
+	}
+	else {
+		handle = freeHandles_.back();
+		freeHandles_.pop_back();
+	}
+
+	Entry& e = entry(handle);
+	e.deadline = 0;
+	e.interval = 0;
+	e.prev = kInvalidHandle;
+	e.next = kInvalidHandle;
+	e.slot = kInactive;
+	e.isPeriodic = false;
+	e.isUsed = true;
+	return handle;
+}
+
+
+void TimerWheel::destroy(Handle handle)
+{
+	if(handle == kInvalidHandle || handle > entries_.size() || !entry(handle).isUsed)
+		return;
+
+	stop(handle);
+	entry(handle).isUsed = false;
+	freeHandles_.push_back(handle);
+}
+
+
+void TimerWheel::start(Handle handle, i64 now, i64 timeout, bool periodic)
+{
+	if(handle == kInvalidHandle || handle > entries_.size() || !entry(handle).isUsed)
+		return;
+
+	Entry& e = entry(handle);
+	if(e.slot == kInactive)
+		++activeCount_;
+	else
+		unlink(handle);
+
+	e.interval = std::min(std::max<i64>(timeout, 0), kMaxTimeout);
+	e.isPeriodic = periodic;
+
+	// The tick of current_ has been processed already
+	i64 deadline = std::max(now + e.interval, current_ + 1);
+	link(handle, std::min(deadline, current_ + kMaxTimeout));
+}
+
+
+void TimerWheel::stop(Handle handle)
+{
+	if(!isActive(handle))
+		return;
+
+	unlink(handle);
+	--activeCount_;
+}
+
+
+bool TimerWheel::isActive(Handle handle) const
+{
+	if(handle == kInvalidHandle || handle > entries_.size())
+		return false;
+
+	const Entry& e = entry(handle);
+	return e.isUsed && e.slot != kInactive;
+}
+
+
+bool TimerWheel::isPeriodic(Handle handle) const
+{
+	if(handle == kInvalidHandle || handle > entries_.size())
+		return false;
+
+	return entry(handle).isPeriodic;
+}
+
+
+i64 TimerWheel::interval(Handle handle) const
+{
+	if(handle == kInvalidHandle || handle > entries_.size())
+		return 0;
+
+	return entry(handle).interval;
+}
+
+
+size_t TimerWheel::activeCount() const
+{
+	return activeCount_;
+}
+
+
+i64 TimerWheel::currentTime() const
+{
+	return current_;
+}
+
+
+i64 TimerWheel::nextDeadline() const
+{
+	int level = firstOccupiedLevel();
+	if(level == kLevelCount)
+		return -1;
+
+	return levelDeadline(level);
+}
+
+
+void TimerWheel::link(Handle handle, i64 deadline)
+{
+	// The level is the one of the highest bit in which the deadline differs from the
+	// current time, so the timer lies within the current span of that level
+	int level = mostSignificantBit(static_cast<u64>(deadline ^ current_)) / kLevelBits;
+	if(level < 0)
+		level = 0;
+
+	int index = static_cast<int>(deadline >> (level * kLevelBits)) & (kSlotCount - 1);
+	int slot = level * kSlotCount + index;
+
+	Entry& e = entry(handle);
+	e.deadline = deadline;
+	e.slot = static_cast<u16>(slot);
+	e.prev = kInvalidHandle;
+	e.next = heads_[slot];
+
+	if(e.next != kInvalidHandle)
+		entry(e.next).prev = handle;
+
+	heads_[slot] = handle;
+	occupied_[level] |= u64(1) << index;
+}
+
+
+void TimerWheel::unlink(Handle handle)
+{
+	Entry& e = entry(handle);
+
+	if(e.prev != kInvalidHandle)
+		entry(e.prev).next = e.next;
+	else
+		heads_[e.slot] = e.next;
+
+	if(e.next != kInvalidHandle)
+		entry(e.next).prev = e.prev;
+
+	if(heads_[e.slot] == kInvalidHandle)
+		occupied_[e.slot / kSlotCount] &= ~(u64(1) << (e.slot % kSlotCount));
+
+	e.slot = kInactive;
+}
+
+
+int TimerWheel::firstOccupiedLevel() const
+{
+	int level = 0;
+	while(level < kLevelCount && occupied_[level] == 0)
+		++level;
+
+	return level;
+}
+
+
+i64 TimerWheel::levelDeadline(int level) const
+{
+	// Occupied slots always follow the current one: the slots before it have been moved
+	// down or expired. The current slot of level 0 is still being expired by advance().
+	int shift = level * kLevelBits;
+	int index = static_cast<int>(current_ >> shift) & (kSlotCount - 1);
+	u64 mask = level == 0 ? ~u64(0) << index : (~u64(0) << index) << 1;
+	u64 bits = occupied_[level] & mask;
+
+	if(bits == 0)
+		return -1;
+
+	i64 span = i64(1) << (shift + kLevelBits);
+	i64 base = current_ & ~(span - 1);
+	return base + (static_cast<i64>(mostSignificantBit(bits & (~bits + 1))) << shift);
+}
+
+
+TimerWheel::Handle TimerWheel::takeExpired(i64 now)
+{
+	for(;;) {
+		int index = static_cast<int>(current_) & (kSlotCount - 1);
+		Handle handle = heads_[index];
+
+		if(handle != kInvalidHandle) {
+			unlink(handle);
+
+			Entry& e = entry(handle);
+			if(e.isPeriodic) {
+				// Periods missed by a late advance() are skipped, as by timerfd
+				i64 interval = std::max<i64>(e.interval, 1);
+				i64 deadline = e.deadline + interval;
+
+				if(deadline <= now)
+					deadline += ((now - deadline) / interval + 1) * interval;
+
+				link(handle, deadline);
+			}
+			else {
+				--activeCount_;
+			}
+
+			return handle;
+		}
+
+		i64 next = nextDeadline();
+		if(next < 0 || next > now) {
+			current_ = std::max(current_, now);
+			return kInvalidHandle;
+		}
+
+		// Nothing happens between the current time and the next deadline. If it starts a
+		// slot of an upper level, the timers of that slot are moved down, from the top
+		// level so they may cascade further.
+		current_ = next;
+
+		for(int level = kLevelCount - 1; level > 0; --level) {
+			int shift = level * kLevelBits;
+			if((current_ & ((i64(1) << shift) - 1)) != 0)
+				continue;
+
+			int slot = level * kSlotCount + (static_cast<int>(current_ >> shift) &
+					(kSlotCount - 1));
+
+			while(heads_[slot] != kInvalidHandle) {
+				Handle moved = heads_[slot];
+				unlink(moved);
+				link(moved, entry(moved).deadline);
+			}
+		}
+	}
+}
+
+
+} // namespace Tech
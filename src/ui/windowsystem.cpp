@@ -33,6 +33,12 @@ void WindowSystem::stopEventProcessing()
 }
 
 
+TaskQueue* WindowSystem::taskQueue()
+{
+	return impl()->taskQueue();
+}
+
+
 void WindowSystem::sync()
 {
 	impl()->sync();
@@ -3,6 +3,7 @@
 
 #include <tech/pimpl.h>
 #include <tech/string.h>
+#include <tech/taskqueue.h>
 #include <tech/types.h>
 #include <tech/ui/rect.h>
 #include <tech/ui/timer.h>
@@ -22,6 +23,13 @@ public:
 	void processEvents();
 	void stopEventProcessing();
 
+	/**
+	 * Returns the queue of tasks which are run by processEvents() on the thread of this
+	 * window system. Tasks and queued signal connections may be posted to it from any
+	 * thread.
+	 */
+	TaskQueue* taskQueue();
+
 	void sync();
 
 	Widget::Handle createWindow(Widget* widget,
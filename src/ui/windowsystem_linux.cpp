@@ -1,10 +1,8 @@
 #include "windowsystem_linux.h"
 
-#include <fcntl.h>
 #include <unistd.h>
-#include <sys/epoll.h>
-#include <sys/timerfd.h>
 #include <tech/logger.h>
+#include <tech/utils.h>
 #include <xcb/xcb_icccm.h>
 #include <xcb/xcb.h>
 #include <tech/ui/painter.h>
@@ -13,59 +11,40 @@
 namespace Tech {
 
 
-WindowSystemPrivate::WindowSystemPrivate()
+WindowSystemPrivate::WindowSystemPrivate() :
+	loop_(EventLoop::instance()),
+	connection_(nullptr),
+	screen_(nullptr),
+	xcbFd_(-1)
 {
-	connection_ = xcb_connect(nullptr, nullptr);
-	if(xcb_connection_has_error(connection_) != 0) {
+	xcb_connection_t* connection = xcb_connect(nullptr, nullptr);
+	if(xcb_connection_has_error(connection) != 0) {
 		LOG("Unable to initialize XCB widget system: cannot open display");
-		connection_ = nullptr;
+		xcb_disconnect(connection);
 		return;
 	}
 
-	screen_ = xcb_setup_roots_iterator(xcb_get_setup(connection_)).data;
-	xcbFd_ = xcb_get_file_descriptor(connection_);
-
-	epollFd_ = epoll_create(1);
-	if(epollFd_ == -1) {
-		LOG("Unable to initialize XCB widget system: cannot create epoll instance");
-		xcb_disconnect(connection_);
-		return;
-	}
-
-	epoll_event ev;
-	ev.data.fd = xcbFd_;
-	ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+	int fd = xcb_get_file_descriptor(connection);
+	EventLoop::IoHandler handler(this, &WindowSystemPrivate::processWindowEvents);
 
-	if(epoll_ctl(epollFd_, EPOLL_CTL_ADD, xcbFd_, &ev) == -1 && errno != EEXIST) {
-		LOG("epoll_ctl call failed: {0}", ::strerror(errno));
-		close(epollFd_);
-		xcb_disconnect(connection_);
+	if(!loop_->watch(fd, IoEvent::kRead, handler)) {
+		LOG("Unable to initialize XCB widget system: cannot watch display connection");
+		xcb_disconnect(connection);
 		return;
 	}
 
-	pipe(pipeFds_);
-
-	int flags = fcntl(pipeFds_[0], F_GETFL, 0);
-	fcntl(pipeFds_[1], F_SETFL, flags | O_NONBLOCK);
-
-	ev.data.fd = pipeFds_[0];
-	ev.events = EPOLLIN;
-	if(epoll_ctl(epollFd_, EPOLL_CTL_ADD, pipeFds_[0], &ev) == -1 && errno != EEXIST) {
-		LOG("epoll_ctl call failed: {0}", ::strerror(errno));
-		close(epollFd_);
-		xcb_disconnect(connection_);
-		return;
-	}
+	connection_ = connection;
+	screen_ = xcb_setup_roots_iterator(xcb_get_setup(connection_)).data;
+	xcbFd_ = fd;
 }
 
 
 WindowSystemPrivate::~WindowSystemPrivate()
 {
-	if(epollFd_ != -1)
-		close(epollFd_);
-
-	if(connection_)
+	if(connection_) {
+		loop_->unwatch(xcbFd_);
 		xcb_disconnect(connection_);
+	}
 }
 
 
@@ -311,10 +290,9 @@ void WindowSystemPrivate::enqueueWidgetRepaint(Widget* widget)
 {
 	repaintQueue_.insert(widget);
 
-	if(repaintQueue_.size() == 1) {
-		Command command = Command::kRepaintWidgets;
-		write(pipeFds_[1], &command, sizeof(command));
-	}
+	if(repaintQueue_.size() == 1)
+		loop_->taskQueue()->post(Delegate<void()>(this,
+				&WindowSystemPrivate::repaintWidgets));
 }
 
 
@@ -322,87 +300,54 @@ void WindowSystemPrivate::enqueueWidgetDeletion(Widget* widget)
 {
 	deletionQueue_.insert(widget);
 
-	if(deletionQueue_.size() == 1) {
-		Command command = Command::kDeleteWidgets;
-		write(pipeFds_[1], &command, sizeof(command));
-	}
+	if(deletionQueue_.size() == 1)
+		loop_->taskQueue()->post(Delegate<void()>(this,
+				&WindowSystemPrivate::deleteWidgets));
 }
 
 
 Timer::Handle WindowSystemPrivate::createTimer(Timer* timer)
 {
-	Timer::Handle handle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-	if(handle == -1) {
-		LOG("timerfd_create failed");
-		return Timer::kInvalidHandle;
-	}
-
-	epoll_event ev;
-	ev.data.fd = handle;
-	ev.events = EPOLLIN | EPOLLET;
-
-	if(epoll_ctl(epollFd_, EPOLL_CTL_ADD, handle, &ev) == -1 && errno != EEXIST) {
-		LOG("epoll_ctl call failed: %s", ::strerror(errno));
-		close(handle);
+	EventLoop::TimerHandle handle = loop_->createTimer(EventLoop::TimerHandler([timer]() {
+		timer->timeout({});
+	}));
+	if(handle == EventLoop::kInvalidTimer) {
+		LOG("Unable to create timer");
 		return Timer::kInvalidHandle;
 	}
 
-	timerByHandle_.emplace(makePair(handle, timer));
-	return handle;
+	return static_cast<Timer::Handle>(handle);
 }
 
 
 void WindowSystemPrivate::destroyTimer(Timer::Handle handle)
 {
-	timerByHandle_.erase(handle);
-	close(handle);
+	loop_->destroyTimer(static_cast<EventLoop::TimerHandle>(handle));
 }
 
 
 void WindowSystemPrivate::startTimer(Timer::Handle handle, Duration timeout,
 		bool periodic)
 {
-	itimerspec data;
-	std::memset(&data, 0, sizeof(data));
-
-	data.it_value.tv_sec = timeout.seconds();
-	data.it_value.tv_nsec = (timeout.mseconds() - data.it_value.tv_sec * 1000) * 1000000;
-
-	if(periodic)
-		data.it_interval = data.it_value;
-
-	timerfd_settime(handle, 0, &data, nullptr);
+	loop_->startTimer(static_cast<EventLoop::TimerHandle>(handle), timeout, periodic);
 }
 
 
 void WindowSystemPrivate::stopTimer(Timer::Handle handle)
 {
-	itimerspec data;
-	std::memset(&data, 0, sizeof(data));
-	timerfd_settime(handle, 0, &data, nullptr);
+	loop_->stopTimer(static_cast<EventLoop::TimerHandle>(handle));
 }
 
 
 bool WindowSystemPrivate::isTimerActive(Timer::Handle handle) const
 {
-	itimerspec data;
-
-	if(timerfd_gettime(handle, &data) != 0)
-		return false;
-
-	return data.it_interval.tv_nsec != 0 && data.it_value.tv_nsec != 0 &&
-		   data.it_interval.tv_sec != 0 && data.it_value.tv_sec != 0;
+	return loop_->isTimerActive(static_cast<EventLoop::TimerHandle>(handle));
 }
 
 
 Duration WindowSystemPrivate::timerInterval(Timer::Handle handle) const
 {
-	itimerspec data;
-
-	if(timerfd_gettime(handle, &data) != 0)
-		return Duration();
-
-	return Duration(data.it_interval.tv_sec * 1000 + data.it_interval.tv_nsec / 1000000);
+	return loop_->timerInterval(static_cast<EventLoop::TimerHandle>(handle));
 }
 
 
@@ -422,71 +367,58 @@ bool WindowSystemPrivate::isHandleValid(Widget::Handle handle) const
 }
 
 
+TaskQueue* WindowSystemPrivate::taskQueue()
+{
+	return loop_->taskQueue();
+}
+
+
 void WindowSystemPrivate::processEvents()
 {
-	epoll_event event;
-	bool running = true;
+	loop_->run();
 
-	while(running) {
-		int count = epoll_wait(epollFd_, &event, 1, -1);
-		if(count < 0 && errno != EINTR) {
-			LOG("epoll_wait call failed: {0}", ::strerror(errno));
-			break;
-		}
+	// Widgets scheduled for deletion before the loop stopped
+	deleteWidgets();
+}
 
-		int fd = event.data.fd;
-		if(fd == xcbFd_) {
-			processWindowEvents();
-		}
-		else if(fd == pipeFds_[0]) {
-			Command command;
-			read(fd, &command, sizeof(command));
-
-			if(command == Command::kStopProcessing) {
-				while(!deletionQueue_.empty()) {
-					auto it = deletionQueue_.begin();
-					delete (*it);
-					deletionQueue_.erase(it);
-				}
 
-				running = false;
-			}
-			else if(command == Command::kRepaintWidgets) {
-				while(!repaintQueue_.empty()) {
-					auto it = repaintQueue_.begin();
-					(*it)->repaint();
-					repaintQueue_.erase(it);
-				}
-			}
-			else if(command == Command::kDeleteWidgets) {
-				while(!deletionQueue_.empty()) {
-					auto it = deletionQueue_.begin();
-					delete (*it);
-					deletionQueue_.erase(it);
-				}
-			}
-		}
-		else {
-			u64 value;
-			read(fd, &value, sizeof(value));
+void WindowSystemPrivate::stopEventProcessing()
+{
+	loop_->quit();
+}
 
-			const Timer* timer = timerByHandle(fd);
-			if(timer)
-				timer->timeout({});
-		}
+
+void WindowSystemPrivate::repaintWidgets()
+{
+	while(!repaintQueue_.empty()) {
+		auto it = repaintQueue_.begin();
+		(*it)->repaint();
+		repaintQueue_.erase(it);
 	}
 }
 
 
-void WindowSystemPrivate::stopEventProcessing()
+void WindowSystemPrivate::deleteWidgets()
 {
-	Command command = Command::kStopProcessing;
-	write(pipeFds_[1], &command, sizeof(command));
+	while(!deletionQueue_.empty()) {
+		auto it = deletionQueue_.begin();
+		delete (*it);
+		deletionQueue_.erase(it);
+	}
 }
 
 
-void WindowSystemPrivate::processWindowEvents()
+void WindowSystemPrivate::processWindowEvents(int fd, IoEvents events)
 {
+	UNUSED(fd);
+
+	if(events & IoEvent::kHangup) {
+		LOG("XCB display connection is closed");
+		loop_->unwatch(xcbFd_);
+		loop_->quit();
+		return;
+	}
+
 	while(xcb_generic_event_t* event = xcb_poll_for_event(connection_)) {
 		switch(event->response_type & ~0x80) {
 		case XCB_MAP_NOTIFY: {
@@ -766,16 +698,6 @@ WindowSystemPrivate::dataByHandle(Widget::Handle handle) const
 }
 
 
-Timer* WindowSystemPrivate::timerByHandle(Timer::Handle handle)
-{
-	auto it = timerByHandle_.find(handle);
-	if(it == timerByHandle_.end())
-		return nullptr;
-
-	return it->second;
-}
-
-
 MouseButton WindowSystemPrivate::translateMouseButton(u8 button)
 {
 	switch(button) {
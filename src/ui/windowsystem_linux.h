@@ -5,7 +5,9 @@
 #include <unordered_set>
 #include <cairo.h>
 #include <cairo-xcb.h>
+#include <tech/eventloop.h>
 #include <tech/string.h>
+#include <tech/taskqueue.h>
 #include <tech/timecounter.h>
 #include <tech/ui/events.h>
 #include <tech/ui/timer.h>
@@ -51,14 +53,19 @@ public:
 	bool isTimerActive(Timer::Handle handle) const;
 	Duration timerInterval(Timer::Handle handle) const;
 
+	TaskQueue* taskQueue();
+
 	void processEvents();
 	void stopEventProcessing();
 
 private:
+	// The loop of the thread, the display connection is one of its watched descriptors.
+	// Timers, tasks and deferred deletion work without a display.
+	EventLoop* loop_;
+
 	xcb_connection_t* connection_;
 	xcb_screen_t* screen_;
 	int xcbFd_;
-	int epollFd_;
 
 	struct WindowData {
 		Widget* widget;
@@ -67,25 +74,18 @@ private:
 	};
 
 	std::unordered_map<Widget::Handle, WindowData> dataByHandle_;
-	std::unordered_map<Timer::Handle, Timer*> timerByHandle_;
 	MouseButtons mouseButtons_;
 
-	enum class Command {
-		kStopProcessing,
-		kRepaintWidgets,
-		kDeleteWidgets
-	};
-
-	int pipeFds_[2];
 	std::unordered_set<Widget*> repaintQueue_;
 	std::unordered_set<Widget*> deletionQueue_;
 
-	void processWindowEvents();
+	void processWindowEvents(int fd, IoEvents events);
+	void repaintWidgets();
+	void deleteWidgets();
 
 	bool isHandleValid(Widget::Handle handle) const;
 
 	const WindowData* dataByHandle(Widget::Handle handle) const;
-	Timer* timerByHandle(Timer::Handle handle);
 	static MouseButton translateMouseButton(u8 button);
 	static KeyModifiers translateKeyModifier(u16 state);
 	static bool checkWheelEvent(u8 detail, bool* vertical, int* delta);
@@ -9,12 +9,14 @@
 #define WM_STOP_PROCESSING (WM_USER + 0)
 #define WM_REPAINT_WIDGETS (WM_USER + 1)
 #define WM_DELETE_WIDGETS  (WM_USER + 2)
+#define WM_PROCESS_TASKS   (WM_USER + 3)
 
 
 namespace Tech {
 
 
-WindowSystemPrivate::WindowSystemPrivate()
+WindowSystemPrivate::WindowSystemPrivate() :
+	taskQueue_(TaskQueue::WakeupHandler(this, &WindowSystemPrivate::wakeupTaskQueue))
 {
 	module_ = GetModuleHandle(nullptr);
 
@@ -253,6 +255,12 @@ Duration WindowSystemPrivate::timerInterval(Timer::Handle handle) const
 }
 
 
+TaskQueue* WindowSystemPrivate::taskQueue()
+{
+	return &taskQueue_;
+}
+
+
 void WindowSystemPrivate::processEvents()
 {
 	MSG message;
@@ -309,6 +317,12 @@ std::string WindowSystemPrivate::errorString()
 }
 
 
+void WindowSystemPrivate::wakeupTaskQueue()
+{
+	PostMessage(commandHwnd_, WM_PROCESS_TASKS, 0, 0);
+}
+
+
 LRESULT CALLBACK WindowSystemPrivate::commandProc(HWND hwnd, UINT message, WPARAM wParam,
 		LPARAM lParam)
 {
@@ -361,6 +375,10 @@ LRESULT CALLBACK WindowSystemPrivate::commandProc(HWND hwnd, UINT message, WPARA
 
 		return 0;
 
+	case WM_PROCESS_TASKS:
+		self->taskQueue_.processTasks();
+		return 0;
+
 	case WM_TIMER:
 		auto it = self->timerByHandle_.find(wParam);
 		if(it != self->timerByHandle_.end())
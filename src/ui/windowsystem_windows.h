@@ -5,6 +5,7 @@
 #include <unordered_set>
 #include <windows.h>
 #include <tech/string.h>
+#include <tech/taskqueue.h>
 #include <tech/timecounter.h>
 #include <tech/version.h>
 #include <tech/ui/events.h>
@@ -51,6 +52,8 @@ public:
 	bool isTimerActive(Timer::Handle handle) const;
 	Duration timerInterval(Timer::Handle handle) const;
 
+	TaskQueue* taskQueue();
+
 	void processEvents();
 	void stopEventProcessing();
 
@@ -71,9 +74,11 @@ private:
 
 	std::unordered_set<Widget*> repaintQueue_;
 	std::unordered_set<Widget*> deletionQueue_;
+	TaskQueue taskQueue_;
 
 	const WindowData* dataByHandle(Widget::Handle handle) const;
 	static std::string errorString();
+	void wakeupTaskQueue();
 
 	static LRESULT CALLBACK	commandProc(HWND hwnd, UINT message, WPARAM wParam,
 			LPARAM lParam);
@@ -0,0 +1,98 @@
+#ifndef TECH_UTF8_H
+#define TECH_UTF8_H
+
+#include <tech/string.h>
+
+
+namespace Tech {
+
+
+/**
+ * Returns the size of UTF-8 representation of @p string, as written by encodeUtf8().
+ */
+inline
+size_t utf8Length(const String& string)
+{
+	const Char* pos = string.constData();
+	const Char* end = pos + string.length();
+	size_t length = 0;
+
+	while(pos != end) {
+		u32 code = pos->unicode();
+		++pos;
+
+		if(code < 0x80) {
+			length += 1;
+		}
+		else if(code < 0x800) {
+			length += 2;
+		}
+		else if(code >= 0xD800 && code <= 0xDBFF && pos != end &&
+				pos->unicode() >= 0xDC00 && pos->unicode() <= 0xDFFF) {
+			length += 4;
+			++pos;
+		}
+		else {
+			length += 3;
+		}
+	}
+
+	return length;
+}
+
+
+/**
+ * Writes UTF-8 representation of @p string to @p out and returns the pointer past the
+ * last written byte. The buffer must have space for 3 bytes per UTF-16 code unit or for
+ * utf8Length() bytes. Unpaired surrogates are replaced with U+FFFD.
+ */
+inline
+char* encodeUtf8(const String& string, char* out)
+{
+	const Char* pos = string.constData();
+	const Char* end = pos + string.length();
+
+	while(pos != end) {
+		u32 code = pos->unicode();
+		++pos;
+
+		if(code >= 0xD800 && code <= 0xDFFF) {
+			u32 low = pos != end ? pos->unicode() : 0;
+
+			if(code <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF) {
+				code = 0x10000 + ((code & 0x03FF) << 10) + (low & 0x03FF);
+				++pos;
+			}
+			else {
+				code = 0xFFFD;
+			}
+		}
+
+		if(code < 0x80) {
+			*out++ = static_cast<char>(code);
+		}
+		else if(code < 0x800) {
+			*out++ = static_cast<char>(0xC0 | (code >> 6));
+			*out++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else if(code < 0x10000) {
+			*out++ = static_cast<char>(0xE0 | (code >> 12));
+			*out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else {
+			*out++ = static_cast<char>(0xF0 | (code >> 18));
+			*out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			*out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+
+	return out;
+}
+
+
+} // namespace Tech
+
+
+#endif // TECH_UTF8_H
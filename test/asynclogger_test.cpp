@@ -0,0 +1,315 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/asynclogger.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+std::vector<int> receivedLines;
+std::vector<String> receivedMessages;
+std::thread::id writerThreadId;
+std::atomic<int> writtenCount;
+
+
+void recordingSink(LogLevel level, const String& file, int line, const String& message)
+{
+	UNUSED(level);
+	UNUSED(file);
+	UNUSED(message);
+
+	writerThreadId = std::this_thread::get_id();
+	receivedLines.push_back(line);
+}
+
+
+void blockingSink(LogLevel level, const String& file, int line, const String& message)
+{
+	recordingSink(level, file, line, message);
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+
+void countingSink(LogLevel level, const String& file, int line, const String& message)
+{
+	UNUSED(level);
+	UNUSED(file);
+	UNUSED(line);
+	UNUSED(message);
+
+	writtenCount.fetch_add(1);
+}
+
+
+void messageSink(LogLevel level, const String& file, int line, const String& message)
+{
+	UNUSED(level);
+	UNUSED(file);
+	UNUSED(line);
+
+	writerThreadId = std::this_thread::get_id();
+	receivedMessages.push_back(message);
+}
+
+
+void fieldsSink(LogLevel level, const String& file, int line, const char* message,
+		const LogFields& fields)
+{
+	UNUSED(level);
+	UNUSED(line);
+
+	writerThreadId = std::this_thread::get_id();
+	receivedMessages.push_back(file + ": " +
+			formatLogRecord(LogFieldFormat::kJson, message, fields));
+}
+
+
+} // namespace
+
+
+TEST(AsyncLoggerTest, PreservesOrder)
+{
+	receivedLines.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&recordingSink), 16);
+		ASSERT_EQ(logger.capacity(), 16);
+
+		for(int i = 0; i < 1000; ++i)
+			logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+
+		logger.flush();
+		ASSERT_EQ(receivedLines.size(), 1000);
+		ASSERT_NE(writerThreadId, std::this_thread::get_id());
+	}
+
+	for(int i = 0; i < 1000; ++i)
+		ASSERT_EQ(receivedLines[i], i);
+}
+
+
+TEST(AsyncLoggerTest, FlushOnShutdown)
+{
+	receivedLines.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&blockingSink), 64);
+
+		for(int i = 0; i < 50; ++i)
+			logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+	}
+
+	ASSERT_EQ(receivedLines.size(), 50);
+}
+
+
+TEST(AsyncLoggerTest, OverflowPolicies)
+{
+	receivedLines.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&blockingSink), 4,
+				AsyncLogger::OverflowPolicy::kDrop);
+
+		for(int i = 0; i < 100; ++i)
+			logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+
+		logger.flush();
+		ASSERT_GT(logger.droppedCount(), 0);
+		ASSERT_EQ(receivedLines.size() + logger.droppedCount(), 100);
+	}
+
+	receivedLines.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&blockingSink), 4,
+				AsyncLogger::OverflowPolicy::kDropOldest);
+
+		for(int i = 0; i < 100; ++i)
+			logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+
+		logger.flush();
+		ASSERT_GT(logger.droppedCount(), 0);
+		ASSERT_EQ(receivedLines.size() + logger.droppedCount(), 100);
+
+		// The newest message is never discarded
+		ASSERT_EQ(receivedLines.back(), 99);
+	}
+}
+
+
+TEST(AsyncLoggerTest, ConcurrentProducers)
+{
+	receivedLines.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&recordingSink), 128);
+		std::vector<std::thread> threads;
+
+		for(int t = 0; t < 4; ++t) {
+			threads.emplace_back([&logger]() {
+				for(int i = 0; i < 5000; ++i)
+					logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+			});
+		}
+
+		for(auto& thread : threads)
+			thread.join();
+	}
+
+	ASSERT_EQ(receivedLines.size(), 20000);
+}
+
+
+TEST(AsyncLoggerTest, ConcurrentFlushes)
+{
+	writtenCount = 0;
+
+	AsyncLogger logger(LogMessageHandler(&countingSink), 64);
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < 4; ++t) {
+		threads.emplace_back([&logger]() {
+			for(int i = 1; i <= 2000; ++i) {
+				logger.post(LogLevel::kInfo, "file.cpp", i, "message");
+
+				// Messages of the other threads may be written as well
+				if(i % 100 == 0) {
+					logger.flush();
+					ASSERT_GE(writtenCount.load(), i);
+				}
+			}
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	logger.flush();
+	ASSERT_EQ(writtenCount.load(), 8000);
+}
+
+
+TEST(AsyncLoggerTest, DeferredFormatting)
+{
+	receivedMessages.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&messageSink), 16);
+		setDeferredLogSink(&logger);
+
+		String name = "widget";
+		char buffer[16] = "temporary";
+		LOG("{} at {}, {}", name, 1, static_cast<u64>(2));
+		LOG("{}", buffer);
+		LOG("no arguments");
+
+		// Arguments are copied: changing them after the call doesn't affect the message
+		name = "changed";
+		buffer[0] = 'T';
+
+		logger.flush();
+		setDeferredLogSink(nullptr);
+
+		ASSERT_NE(writerThreadId, std::this_thread::get_id());
+	}
+
+	ASSERT_EQ(receivedMessages.size(), 3);
+	ASSERT_EQ(receivedMessages[0], "widget at 1, 2");
+	ASSERT_EQ(receivedMessages[1], "temporary");
+	ASSERT_EQ(receivedMessages[2], "no arguments");
+}
+
+
+TEST(AsyncLoggerTest, DeferredFallback)
+{
+	receivedMessages.clear();
+
+	AsyncLogger logger(LogMessageHandler(&recordingSink), 16);
+	setLogMessageHandler(LogMessageHandler(&messageSink));
+	setDeferredLogSink(&logger);
+
+	// Six strings don't fit into the cell, so the message is formatted by the caller and
+	// passed to the regular handler
+	String s = "s";
+	LOG("{}{}{}{}{}{}", s, s, s, s, s, s);
+
+	setDeferredLogSink(nullptr);
+	setLogMessageHandler(LogMessageHandler());
+
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedMessages[0], "ssssss");
+	ASSERT_EQ(writerThreadId, std::this_thread::get_id());
+}
+
+
+TEST(AsyncLoggerTest, RuntimeFormatNotDeferred)
+{
+	receivedMessages.clear();
+
+	AsyncLogger logger(LogMessageHandler(&recordingSink), 16);
+	setLogMessageHandler(LogMessageHandler(&messageSink));
+	setDeferredLogSink(&logger);
+
+	// The format of logMessage() may be a temporary buffer, so the message is formatted
+	// by the caller even while the deferred sink is installed
+	char format[16] = "value {}";
+	logMessage(LogLevel::kInfo, "file.cpp", 1, format, 5);
+	char message[16] = "no arguments";
+	logMessage(LogLevel::kInfo, "file.cpp", 2, message);
+	format[0] = 'V';
+	message[0] = 'N';
+
+	setDeferredLogSink(nullptr);
+	setLogMessageHandler(LogMessageHandler());
+
+	ASSERT_EQ(receivedMessages.size(), 2);
+	ASSERT_EQ(receivedMessages[0], "value 5");
+	ASSERT_EQ(receivedMessages[1], "no arguments");
+	ASSERT_EQ(writerThreadId, std::this_thread::get_id());
+}
+
+
+TEST(AsyncLoggerTest, StructuredRecords)
+{
+	receivedMessages.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&messageSink), 16);
+		logger.setRecordHandler(LogRecordHandler(&fieldsSink));
+		setDeferredLogSink(&logger);
+
+		logFields(LogLevel::kInfo, "file.cpp", 1, "frame", "id", 1, "ok", true);
+
+		// Fields which don't fit into the cell are handled by the caller
+		std::string text(AsyncLogger::kMaxDeferredSize, 'x');
+		logFields(LogLevel::kInfo, "file.cpp", 2, "large", "text", text.c_str());
+
+		logger.flush();
+		setDeferredLogSink(nullptr);
+
+		ASSERT_NE(writerThreadId, std::this_thread::get_id());
+	}
+
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedMessages[0], "file.cpp: {\"message\":\"frame\",\"id\":1,\"ok\":true}");
+
+	// Without the record handler the writer thread renders the fields as text
+	receivedMessages.clear();
+
+	{
+		AsyncLogger logger(LogMessageHandler(&messageSink), 16);
+		setDeferredLogSink(&logger);
+		logFields(LogLevel::kInfo, "file.cpp", 1, "frame", "id", 1, "name", "main");
+		logger.flush();
+		setDeferredLogSink(nullptr);
+	}
+
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedMessages[0], "frame id=1 name=main");
+}
@@ -0,0 +1,64 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/blockingqueue.h>
+#include <tech/mpmcqueue.h>
+#include <tech/spscqueue.h>
+
+
+using namespace Tech;
+
+
+TEST(BlockingQueueTest, TryAndTimeout)
+{
+	BlockingQueue<SpscQueue<Box<int>>> queue(2);
+	Box<int> value;
+
+	ASSERT_FALSE(queue.tryPop(&value));
+	ASSERT_FALSE(queue.pop(&value, Duration(10)));
+
+	ASSERT_TRUE(queue.tryEmplace(new int(1)));
+	queue.push(Box<int>(new int(2)));
+	ASSERT_FALSE(queue.tryPush(Box<int>(new int(3))));
+
+	queue.pop(&value);
+	ASSERT_EQ(*value, 1);
+	ASSERT_TRUE(queue.pop(&value, Duration(10)));
+	ASSERT_EQ(*value, 2);
+}
+
+
+TEST(BlockingQueueTest, ProducersAndConsumers)
+{
+	static const int kThreadCount = 3;
+	static const u64 kCountPerThread = 20000;
+
+	// A small capacity makes both sides block
+	BlockingQueue<MpmcQueue<u64>> queue(4);
+	std::atomic<u64> sum(0);
+	std::vector<std::thread> threads;
+
+	for(int i = 0; i < kThreadCount; ++i) {
+		threads.emplace_back([&queue]() {
+			for(u64 j = 1; j <= kCountPerThread; ++j)
+				queue.push(j);
+		});
+
+		threads.emplace_back([&queue, &sum]() {
+			for(u64 j = 0; j < kCountPerThread; ++j) {
+				u64 value;
+				queue.pop(&value);
+				sum.fetch_add(value, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	ASSERT_EQ(sum.load(), kThreadCount * kCountPerThread * (kCountPerThread + 1) / 2);
+
+	u64 value;
+	ASSERT_FALSE(queue.tryPop(&value));
+}
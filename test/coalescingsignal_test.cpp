@@ -0,0 +1,174 @@
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/coalescingsignal.h>
+#include <tech/passkey.h>
+#include <tech/string.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Receiver : public Trackable {
+public:
+	void slot(const String& text, int value)
+	{
+		calls.emplace_back(text, value);
+	}
+
+	std::vector<Pair<String, int>> calls;
+};
+
+
+class Emitter {
+public:
+	explicit Emitter(TaskQueue* queue) :
+		changed(queue)
+	{
+	}
+
+	void change(int value)
+	{
+		changed({}, value);
+	}
+
+signals:
+	CoalescingSignal<void(int), PassKey<Emitter>> changed;
+};
+
+
+// Re-emits the signal from its slot
+class Repeater {
+public:
+	void slot(int value)
+	{
+		values.push_back(value);
+
+		if(value < 3)
+			(*signal)(value + 1);
+	}
+
+	CoalescingSignal<void(int)>* signal = nullptr;
+	std::vector<int> values;
+};
+
+
+} // namespace
+
+
+TEST(CoalescingSignalTest, DeliversLatestArguments)
+{
+	TaskQueue queue;
+	CoalescingSignal<void(const String&, int)> signal(&queue);
+	Receiver receiver;
+
+	signal.connect(&receiver, &Receiver::slot);
+	ASSERT_FALSE(signal.isPending());
+
+	signal(String("first"), 1);
+	signal(String("second"), 2);
+	signal(String("third"), 3);
+
+	ASSERT_TRUE(signal.isPending());
+	ASSERT_TRUE(receiver.calls.empty());
+
+	ASSERT_EQ(queue.processTasks(), 1u);
+	ASSERT_FALSE(signal.isPending());
+	ASSERT_EQ(receiver.calls.size(), 1u);
+	ASSERT_EQ(receiver.calls[0].first, String("third"));
+	ASSERT_EQ(receiver.calls[0].second, 3);
+
+	// The next emission starts a new delivery
+	signal(String("fourth"), 4);
+	queue.processTasks();
+	ASSERT_EQ(receiver.calls.size(), 2u);
+	ASSERT_EQ(receiver.calls[1].second, 4);
+}
+
+
+TEST(CoalescingSignalTest, Reducer)
+{
+	TaskQueue queue;
+	CoalescingSignal<void(int)> signal(&queue, [](Tuple<int>* pending, int delta) {
+		std::get<0>(*pending) += delta;
+	});
+
+	std::vector<int> values;
+	signal.connect([&values](int value) { values.push_back(value); });
+
+	for(int i = 1; i <= 4; ++i)
+		signal(i);
+
+	queue.processTasks();
+	signal(5);
+	queue.processTasks();
+
+	ASSERT_EQ(values, std::vector<int>({10, 5}));
+}
+
+
+TEST(CoalescingSignalTest, FlushAndCancel)
+{
+	std::vector<int> values;
+	auto append = [&values](int value) { values.push_back(value); };
+
+	{
+		TaskQueue queue;
+		Emitter emitter(&queue);
+		emitter.changed.connect(append);
+
+		// Immediate delivery leaves a stale task which does nothing
+		emitter.change(1);
+		emitter.changed.flush();
+		ASSERT_EQ(values, std::vector<int>({1}));
+		emitter.change(2);
+		ASSERT_EQ(queue.processTasks(), 2u);
+		ASSERT_EQ(values, std::vector<int>({1, 2}));
+
+		// Destruction of the queue discards the pending emission
+		emitter.change(3);
+	}
+
+	{
+		TaskQueue queue;
+
+		{
+			CoalescingSignal<void(int)> signal(&queue);
+			signal.connect(append);
+			signal(4);
+		}
+
+		// The task of the destroyed signal does nothing
+		ASSERT_EQ(queue.processTasks(), 1u);
+	}
+
+	ASSERT_EQ(values, std::vector<int>({1, 2}));
+}
+
+
+TEST(CoalescingSignalTest, EmissionFromSlot)
+{
+	TaskQueue queue;
+	CoalescingSignal<void(int)> signal(&queue);
+	Repeater repeater;
+
+	repeater.signal = &signal;
+	signal.connect(&repeater, &Repeater::slot);
+
+	signal(0);
+	signal(1);
+
+	// Every emission from the slot is delivered by the next processing of the queue
+	ASSERT_EQ(queue.processTasks(), 1u);
+	ASSERT_EQ(repeater.values, std::vector<int>({1}));
+	ASSERT_TRUE(signal.isPending());
+
+	while(!queue.isEmpty())
+		queue.processTasks();
+
+	ASSERT_EQ(repeater.values, std::vector<int>({1, 2, 3}));
+	ASSERT_FALSE(signal.isPending());
+}
@@ -0,0 +1,159 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/concurrentsignal.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+int staticCallCount = 0;
+
+
+void staticSlot(int value)
+{
+	staticCallCount += value;
+}
+
+
+class Counter {
+public:
+	void add(int value)
+	{
+		count_.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	int value(int multiplier) const
+	{
+		return count_.load(std::memory_order_relaxed) * multiplier;
+	}
+
+	int count() const
+	{
+		return count_.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int> count_{0};
+};
+
+
+} // namespace
+
+
+TEST(ConcurrentSignalTest, ConnectAndDisconnect)
+{
+	ConcurrentSignal<void(int)> signal;
+	Counter counter1;
+	Counter counter2;
+
+	ASSERT_FALSE(signal.hasConnections());
+	signal(1);
+
+	staticCallCount = 0;
+	signal.connect(&staticSlot);
+	signal.connect(&counter1, &Counter::add);
+	signal.connect(&counter2, &Counter::add);
+	ASSERT_TRUE(signal.hasConnections());
+
+	signal(2);
+	ASSERT_EQ(staticCallCount, 2);
+	ASSERT_EQ(counter1.count(), 2);
+	ASSERT_EQ(counter2.count(), 2);
+
+	signal.disconnect(&counter1, &Counter::add);
+	signal.disconnect(&staticSlot);
+	signal(3);
+	ASSERT_EQ(staticCallCount, 2);
+	ASSERT_EQ(counter1.count(), 2);
+	ASSERT_EQ(counter2.count(), 5);
+
+	signal.disconnect(&counter2);
+	ASSERT_FALSE(signal.hasConnections());
+	signal(4);
+	ASSERT_EQ(counter2.count(), 5);
+
+	ConcurrentSignal<int(int)> valueSignal;
+	ASSERT_EQ(valueSignal(2), 0);
+
+	valueSignal.connect(&counter1, &Counter::value);
+	valueSignal.connect(&counter2, &Counter::value);
+	ASSERT_EQ(valueSignal(2), 10);
+
+	valueSignal.disconnect();
+	ASSERT_FALSE(valueSignal.hasConnections());
+}
+
+
+TEST(ConcurrentSignalTest, ChangesDuringEmission)
+{
+	ConcurrentSignal<void(int)> signal;
+	Counter counter;
+
+	// The emission in progress uses its own snapshot, so the slot connected from the
+	// slot is called by the next emission only
+	struct Reconnector {
+		ConcurrentSignal<void(int)>* signal;
+		Counter* counter;
+
+		void slot(int value)
+		{
+			signal->disconnect(this, &Reconnector::slot);
+			signal->connect(counter, &Counter::add);
+			counter->add(value);
+		}
+	} reconnector{&signal, &counter};
+
+	signal.connect(&reconnector, &Reconnector::slot);
+	signal(1);
+	ASSERT_EQ(counter.count(), 1);
+
+	signal(10);
+	ASSERT_EQ(counter.count(), 11);
+}
+
+
+TEST(ConcurrentSignalTest, ConcurrentEmission)
+{
+	ConcurrentSignal<void(int)> signal;
+	Counter permanent;
+	std::vector<Counter> transient(16);
+	std::atomic<bool> isDone(false);
+
+	signal.connect(&permanent, &Counter::add);
+
+	std::vector<std::thread> emitters;
+	std::vector<int> emitCounts(4, 0);
+
+	for(int i = 0; i < 4; ++i) {
+		emitters.emplace_back([&signal, &isDone, &emitCounts, i]() {
+			while(!isDone.load(std::memory_order_relaxed)) {
+				signal(1);
+				++emitCounts[i];
+			}
+		});
+	}
+
+	for(int i = 0; i < 2000; ++i) {
+		Counter& counter = transient[i % transient.size()];
+		signal.connect(&counter, &Counter::add);
+		signal.disconnect(&counter, &Counter::add);
+	}
+
+	isDone.store(true);
+
+	for(auto& thread : emitters)
+		thread.join();
+
+	// Every emission calls the permanent slot exactly once
+	int total = 0;
+
+	for(int count : emitCounts)
+		total += count;
+
+	ASSERT_EQ(permanent.count(), total);
+}
@@ -171,6 +171,11 @@ TEST(DelegateTest, StaticFunction)
 	ASSERT_FALSE(delegate6.isNull());
 	ASSERT_EQ(delegate6(), 5);
 
+	Delegate<int()> delegate9 = Delegate<int()>();
+	ASSERT_TRUE(delegate9.isNull());
+	delegate6 = delegate9;
+	ASSERT_TRUE(delegate6.isNull());
+
 	Delegate<int()> delegate7([]() -> int { return 201; });
 	ASSERT_FALSE(delegate7.isNull());
 	ASSERT_EQ(delegate7(), 201);
@@ -272,3 +277,58 @@ TEST(DelegateTest, VirtualInheritanceMember)
 	ASSERT_FALSE(delegate4.isNull());
 	ASSERT_EQ(delegate4(), 4);
 }
+
+
+TEST(DelegateTest, Functor)
+{
+	int base = 10;
+	int calls = 0;
+
+	Delegate<int(int)> delegate1([base](int value) { return base + value; });
+	ASSERT_FALSE(delegate1.isNull());
+	ASSERT_EQ(delegate1.target(), nullptr);
+	ASSERT_EQ(delegate1(5), 15);
+
+	// Captured references and state of mutable lambdas are kept by the copies
+	Delegate<void()> delegate2([&calls]() { ++calls; });
+	Delegate<void()> copy = delegate2;
+	delegate2();
+	copy();
+	ASSERT_EQ(calls, 2);
+
+	Delegate<int()> delegate3([calls]() mutable { return ++calls; });
+	ASSERT_EQ(delegate3(), 3);
+	ASSERT_EQ(delegate3(), 4);
+
+	// Capture of three pointers fits into the inline buffer
+	A a;
+	C c;
+	int* pointer = &base;
+	Delegate<int(int)> delegate4([&a, &c, pointer](int value) {
+		return a.m3(value) + c.m2() + *pointer;
+	});
+
+	ASSERT_EQ(delegate4(1), a.m3(1) + c.m2() + 10);
+	ASSERT_TRUE(delegate4 == Delegate<int(int)>(delegate4));
+	ASSERT_FALSE(delegate4 == delegate1);
+
+	struct Functor {
+		int operator()(int value) const
+		{
+			return value * factor;
+		}
+
+		int factor;
+	};
+
+	Delegate<int(int)> delegate5(Functor{3});
+	ASSERT_EQ(delegate5(7), 21);
+
+	// Lambdas with the same captures are different functors
+	Delegate<void()> increment([pointer]() { ++*pointer; });
+	Delegate<void()> add([pointer]() { *pointer += 100; });
+	ASSERT_FALSE(increment == add);
+	ASSERT_TRUE(increment < add || add < increment);
+	ASSERT_TRUE(increment == Delegate<void()>(increment));
+	ASSERT_FALSE(increment < Delegate<void()>(increment));
+}
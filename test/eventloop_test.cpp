@@ -0,0 +1,265 @@
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <tech/eventloop.h>
+#include <tech/utils.h>
+
+
+using namespace Tech;
+
+
+TEST(EventLoopTest, WatchesDescriptors)
+{
+	EventLoop loop;
+	ASSERT_TRUE(loop.isValid());
+
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+
+	std::vector<char> received;
+	auto onRead = [&loop, &received](int fd, IoEvents events) {
+		if(events & IoEvent::kHangup) {
+			loop.unwatch(fd);
+			loop.quit(7);
+			return;
+		}
+
+		char value;
+		if(read(fd, &value, 1) == 1)
+			received.push_back(value);
+	};
+
+	ASSERT_TRUE(loop.watch(fds[0], IoEvent::kRead, EventLoop::IoHandler(onRead)));
+	ASSERT_TRUE(loop.isWatched(fds[0]));
+	ASSERT_FALSE(loop.watch(fds[0], IoEvent::kRead, EventLoop::IoHandler(onRead)));
+
+	// Nothing is ready
+	ASSERT_EQ(loop.processEvents(Duration()), 0u);
+
+	ASSERT_EQ(write(fds[1], "ab", 2), 2);
+	ASSERT_EQ(loop.processEvents(), 1u);
+	ASSERT_EQ(loop.processEvents(), 1u);
+	ASSERT_EQ(received, std::vector<char>({'a', 'b'}));
+
+	// The handler removes its own watch on hangup
+	close(fds[1]);
+	ASSERT_EQ(loop.run(), 7);
+	ASSERT_FALSE(loop.isWatched(fds[0]));
+	close(fds[0]);
+
+	// Wakeup left by quit() runs no tasks
+	ASSERT_EQ(loop.processEvents(Duration()), 0u);
+
+	// A reused descriptor gets a new watch
+	ASSERT_EQ(pipe(fds), 0);
+	bool isWritable = false;
+	auto onWrite = [&isWritable](int fd, IoEvents events) {
+		UNUSED(fd);
+		isWritable = events & IoEvent::kWrite;
+	};
+
+	ASSERT_TRUE(loop.watch(fds[1], IoEvent::kRead, EventLoop::IoHandler(onWrite)));
+	ASSERT_EQ(loop.processEvents(Duration()), 0u);
+	ASSERT_TRUE(loop.modifyWatch(fds[1], IoEvent::kWrite));
+	ASSERT_EQ(loop.processEvents(Duration()), 1u);
+	ASSERT_TRUE(isWritable);
+
+	loop.unwatch(fds[1]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+TEST(EventLoopTest, RunsTimers)
+{
+	EventLoop loop;
+	int singleCount = 0;
+	int periodicCount = 0;
+
+	EventLoop::TimerHandle single = EventLoop::kInvalidTimer;
+	EventLoop::TimerHandle periodic = EventLoop::kInvalidTimer;
+	EventLoop::TimerHandle stopped = EventLoop::kInvalidTimer;
+
+	single = loop.createTimer(EventLoop::TimerHandler([&]() {
+		++singleCount;
+	}));
+
+	periodic = loop.createTimer(EventLoop::TimerHandler([&]() {
+		if(++periodicCount == 3) {
+			loop.stopTimer(periodic);
+			loop.quit();
+		}
+	}));
+
+	stopped = loop.createTimer(EventLoop::TimerHandler([&]() {
+		FAIL() << "stopped timer expired";
+	}));
+
+	ASSERT_NE(single, EventLoop::kInvalidTimer);
+	ASSERT_NE(periodic, EventLoop::kInvalidTimer);
+
+	loop.startTimer(single, Duration(5));
+	loop.startTimer(periodic, Duration(10), true);
+	loop.startTimer(stopped, Duration(1));
+	ASSERT_TRUE(loop.isTimerActive(stopped));
+	ASSERT_EQ(loop.timerInterval(periodic).mseconds(), 10);
+	loop.stopTimer(stopped);
+
+	ASSERT_EQ(loop.run(), 0);
+	ASSERT_EQ(singleCount, 1);
+	ASSERT_EQ(periodicCount, 3);
+	ASSERT_FALSE(loop.isTimerActive(single));
+	ASSERT_FALSE(loop.isTimerActive(periodic));
+
+	loop.destroyTimer(single);
+	loop.destroyTimer(periodic);
+	loop.destroyTimer(stopped);
+}
+
+
+TEST(EventLoopTest, MutableHandlersKeepState)
+{
+	EventLoop loop;
+	int timerValue = 0;
+	int* timerOut = &timerValue;
+
+	EventLoop::TimerHandle timer = loop.createTimer(EventLoop::TimerHandler(
+			[timerOut, n = 0]() mutable { *timerOut = ++n; }));
+
+	loop.startTimer(timer, Duration(1), true);
+	for(int i = 0; i < 3; ++i)
+		loop.processEvents();
+
+	ASSERT_EQ(timerValue, 3);
+	loop.destroyTimer(timer);
+
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+
+	int watchValue = 0;
+	int* watchOut = &watchValue;
+	auto onRead = [watchOut, n = 0](int fd, IoEvents events) mutable {
+		UNUSED(events);
+		char value;
+		if(read(fd, &value, 1) == 1)
+			*watchOut = ++n;
+	};
+
+	ASSERT_TRUE(loop.watch(fds[0], IoEvent::kRead, EventLoop::IoHandler(onRead)));
+
+	for(int i = 0; i < 3; ++i) {
+		ASSERT_EQ(write(fds[1], "x", 1), 1);
+		ASSERT_EQ(loop.processEvents(), 1u);
+	}
+
+	ASSERT_EQ(watchValue, 3);
+
+	loop.unwatch(fds[0]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+TEST(EventLoopTest, RunsPostedTasks)
+{
+	EventLoop loop;
+	std::vector<int> values;
+
+	// Quit requested before run() isn't lost
+	loop.quit(3);
+	ASSERT_EQ(loop.run(), 3);
+
+	std::thread thread([&loop, &values]() {
+		for(int i = 0; i < 1000; ++i) {
+			loop.taskQueue()->post(Delegate<void()>([&values, i]() {
+				values.push_back(i);
+			}));
+		}
+
+		loop.taskQueue()->post(Delegate<void()>([&loop]() { loop.quit(); }));
+	});
+
+	ASSERT_EQ(loop.run(), 0);
+	thread.join();
+
+	ASSERT_EQ(values.size(), 1000u);
+	for(int i = 0; i < 1000; ++i)
+		ASSERT_EQ(values[static_cast<size_t>(i)], i);
+
+	ASSERT_EQ(loop.statistics().tasks, 1001u);
+	ASSERT_EQ(loop.statistics().ioEvents, 0u);
+
+	// quit() from another thread interrupts the wait
+	std::thread quitter([&loop]() { loop.quit(5); });
+	ASSERT_EQ(loop.run(), 5);
+	quitter.join();
+}
+
+
+TEST(EventLoopTest, DispatchesBatches)
+{
+	static const int kPipeCount = 8;
+
+	EventLoop loop;
+	int fds[kPipeCount][2];
+	int handledCount = 0;
+
+	// Every handler removes all watches, the events of the other pipes harvested by the
+	// same wait must be dropped
+	auto onRead = [&loop, &fds, &handledCount](int fd, IoEvents events) {
+		UNUSED(fd);
+		UNUSED(events);
+		++handledCount;
+
+		for(int i = 0; i < kPipeCount; ++i)
+			loop.unwatch(fds[i][0]);
+	};
+
+	for(int i = 0; i < kPipeCount; ++i) {
+		ASSERT_EQ(pipe(fds[i]), 0);
+		ASSERT_TRUE(loop.watch(fds[i][0], IoEvent::kRead, EventLoop::IoHandler(onRead)));
+		ASSERT_EQ(write(fds[i][1], "x", 1), 1);
+	}
+
+	ASSERT_EQ(loop.processEvents(Duration()), 1u);
+	ASSERT_EQ(handledCount, 1);
+
+	// All ready descriptors are handled by a single iteration
+	auto onDrain = [](int fd, IoEvents events) {
+		UNUSED(events);
+		char value;
+		ASSERT_EQ(read(fd, &value, 1), 1);
+	};
+
+	for(int i = 0; i < kPipeCount; ++i)
+		ASSERT_TRUE(loop.watch(fds[i][0], IoEvent::kRead, EventLoop::IoHandler(onDrain)));
+
+	loop.resetStatistics();
+	ASSERT_EQ(loop.processEvents(Duration()), static_cast<size_t>(kPipeCount));
+	ASSERT_EQ(loop.lastIteration().iterations, 1u);
+	ASSERT_EQ(loop.lastIteration().ioEvents, static_cast<u64>(kPipeCount));
+	ASSERT_GE(loop.lastIteration().ioTime, 0);
+	ASSERT_EQ(loop.processEvents(Duration()), 0u);
+	ASSERT_EQ(loop.statistics().iterations, 2u);
+	ASSERT_EQ(loop.statistics().ioEvents, static_cast<u64>(kPipeCount));
+
+	for(int i = 0; i < kPipeCount; ++i) {
+		loop.unwatch(fds[i][0]);
+		close(fds[i][0]);
+		close(fds[i][1]);
+	}
+}
+
+
+TEST(EventLoopTest, InstancePerThread)
+{
+	EventLoop* loop = EventLoop::instance();
+	ASSERT_EQ(EventLoop::instance(), loop);
+
+	EventLoop* other = nullptr;
+	std::thread thread([&other]() { other = EventLoop::instance(); });
+	thread.join();
+
+	ASSERT_NE(other, loop);
+}
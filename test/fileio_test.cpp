@@ -0,0 +1,182 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <tech/fileio.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+const FileIo::Backend kBackends[] = {FileIo::Backend::kUring, FileIo::Backend::kThreadPool};
+
+
+String temporaryFileName()
+{
+	char path[] = "/tmp/tech-fileio-XXXXXX";
+	int fd = ::mkstemp(path);
+
+	if(fd != -1)
+		::close(fd);
+
+	return String::fromUtf8(path);
+}
+
+
+void removeFile(const String& fileName)
+{
+	::unlink(fileName.toUtf8().constData());
+}
+
+
+// Runs the loop until the future is complete
+template<typename T>
+T await(EventLoop* loop, Future<T> future)
+{
+	while(!future.isReady())
+		loop->processEvents();
+
+	return future.get();
+}
+
+
+} // namespace
+
+
+TEST(FileIoTest, WritesAndReads)
+{
+	String fileName = temporaryFileName();
+	EventLoop loop;
+
+	for(FileIo::Backend backend : kBackends) {
+		FileIo io(&loop, ThreadPool::shared(), backend);
+		auto flags = FileOpenFlag::kWrite | FileOpenFlag::kCreate | FileOpenFlag::kTruncate;
+
+		FileResult file = await(&loop, io.open(fileName, flags));
+		ASSERT_EQ(file.error, 0);
+		int fd = static_cast<int>(file.value);
+
+		FileResult written = await(&loop, io.write(fd, 0, "hello world"));
+		ASSERT_EQ(written.error, 0);
+		ASSERT_EQ(written.value, 11);
+		ASSERT_EQ(await(&loop, io.close(fd)).error, 0);
+
+		FileStatus status = await(&loop, io.status(fileName));
+		ASSERT_EQ(status.error, 0);
+		ASSERT_EQ(status.size, 11u);
+		ASSERT_TRUE(S_ISREG(status.mode));
+
+		FileData data = await(&loop, io.readFile(fileName));
+		ASSERT_EQ(data.error, 0);
+		ASSERT_EQ(data.data, "hello world");
+
+		file = await(&loop, io.open(fileName, FileOpenFlag::kRead));
+		ASSERT_EQ(file.error, 0);
+		fd = static_cast<int>(file.value);
+
+		data = await(&loop, io.read(fd, 6, 100));
+		ASSERT_EQ(data.error, 0);
+		ASSERT_EQ(data.data, "world");
+		ASSERT_TRUE(await(&loop, io.read(fd, 11, 100)).data.isEmpty());
+		ASSERT_EQ(await(&loop, io.close(fd)).error, 0);
+
+		String missing = fileName;
+		missing += ".missing";
+		ASSERT_EQ(await(&loop, io.open(missing, FileOpenFlag::kRead)).error, ENOENT);
+		ASSERT_EQ(await(&loop, io.status(missing)).error, ENOENT);
+		ASSERT_EQ(await(&loop, io.readFile(missing)).error, ENOENT);
+		ASSERT_EQ(io.pendingCount(), 0u);
+	}
+
+	removeFile(fileName);
+}
+
+
+TEST(FileIoTest, ReadsWholeFiles)
+{
+	String fileName = temporaryFileName();
+	ByteArray content;
+
+	for(int i = 0; i < 300000; ++i)
+		content += static_cast<char>('a' + i % 26);
+
+	int fd = ::open(fileName.toUtf8().constData(), O_WRONLY | O_TRUNC);
+	ASSERT_EQ(::write(fd, content.constData(), content.length()),
+			static_cast<ssize_t>(content.length()));
+	::close(fd);
+
+	EventLoop loop;
+
+	for(FileIo::Backend backend : kBackends) {
+		FileIo io(&loop, ThreadPool::shared(), backend);
+
+		FileData data = await(&loop, io.readFile(fileName));
+		ASSERT_EQ(data.error, 0);
+		ASSERT_EQ(data.data, content);
+
+		// Files in /proc report no size and are read until the end
+		data = await(&loop, io.readFile("/proc/self/maps"));
+		ASSERT_EQ(data.error, 0);
+		ASSERT_GT(data.data.length(), 0u);
+		ASSERT_EQ(data.data.at(data.data.length() - 1), '\n');
+	}
+
+	removeFile(fileName);
+}
+
+
+TEST(FileIoTest, QueuesRequestsBeyondRing)
+{
+	String fileName = temporaryFileName();
+	EventLoop loop;
+
+	for(FileIo::Backend backend : kBackends) {
+		FileIo io(&loop, ThreadPool::shared(), backend);
+		std::vector<Future<FileStatus>> futures;
+
+		for(int i = 0; i < 2000; ++i)
+			futures.push_back(io.status(fileName));
+
+		ASSERT_EQ(io.pendingCount(), 2000u);
+
+		int completed = 0;
+		for(auto& future : futures) {
+			future.then([&completed](FileStatus&& status) {
+				if(status.error == 0)
+					++completed;
+			});
+		}
+
+		while(io.pendingCount() != 0)
+			loop.processEvents();
+
+		ASSERT_EQ(completed, 2000);
+	}
+
+	removeFile(fileName);
+}
+
+
+TEST(FileIoTest, DestructorCompletesRequests)
+{
+	EventLoop loop;
+
+	for(FileIo::Backend backend : kBackends) {
+		Future<FileData> data;
+		Future<FileStatus> status;
+
+		{
+			FileIo io(&loop, ThreadPool::shared(), backend);
+			data = io.readFile("/proc/self/maps");
+			status = io.status("/");
+		}
+
+		ASSERT_TRUE(data.isReady());
+		ASSERT_TRUE(status.isReady());
+		ASSERT_FALSE(status.isBroken());
+		ASSERT_EQ(status.get().error, 0);
+	}
+}
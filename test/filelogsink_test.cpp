@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <tech/asynclogger.h>
+#include <tech/filelogsink.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+std::string makeTemporaryDirectory()
+{
+	char path[] = "/tmp/tech-filelogsink-XXXXXX";
+	return ::mkdtemp(path) ? path : "";
+}
+
+
+std::string readFile(const std::string& path)
+{
+	std::ifstream file(path);
+	std::stringstream stream;
+	stream << file.rdbuf();
+	return stream.str();
+}
+
+
+bool fileExists(const std::string& path)
+{
+	return ::access(path.c_str(), F_OK) == 0;
+}
+
+
+size_t lineCount(const std::string& text)
+{
+	return std::count(text.begin(), text.end(), '\n');
+}
+
+
+} // namespace
+
+
+TEST(FileLogSinkTest, WritesLines)
+{
+	std::string directory = makeTemporaryDirectory();
+	std::string path = directory + "/app.log";
+
+	{
+		FileLogSink sink(String::fromUtf8(path.c_str()));
+		ASSERT_TRUE(sink.isOpen());
+
+		sink.write(LogLevel::kInfo, "window.cpp", 42, "hello");
+		sink.write(LogLevel::kError, "window.cpp", 43, String::fromUtf8("привет"));
+
+		// Lines are buffered until flush
+		ASSERT_EQ(readFile(path), "");
+
+		sink.flush();
+		ASSERT_EQ(sink.linesWritten(), 2);
+		ASSERT_EQ(sink.bytesWritten(), readFile(path).size());
+	}
+
+	std::string text = readFile(path);
+	ASSERT_EQ(lineCount(text), 2);
+	ASSERT_NE(text.find(" [info] window.cpp:42: hello\n"), std::string::npos);
+	ASSERT_NE(text.find(" [error] window.cpp:43: привет\n"), std::string::npos);
+
+	::unlink(path.c_str());
+	::rmdir(directory.c_str());
+}
+
+
+TEST(FileLogSinkTest, WritesRecords)
+{
+	std::string directory = makeTemporaryDirectory();
+	std::string path = directory + "/app.log";
+
+	{
+		FileLogSink sink(String::fromUtf8(path.c_str()));
+		LogFieldWriter writer;
+		writer.add("id", 7);
+		writer.add("widget", "button");
+
+		sink.writeRecord(LogLevel::kInfo, "window.cpp", 42, "clicked", writer.fields());
+		sink.setRecordFormat(LogFieldFormat::kJson);
+		sink.writeRecord(LogLevel::kInfo, "window.cpp", 43, "clicked", writer.fields());
+	}
+
+	std::string text = readFile(path);
+	ASSERT_EQ(lineCount(text), 2);
+	ASSERT_NE(text.find(" [info] window.cpp:42: clicked id=7 widget=button\n"),
+			std::string::npos);
+	ASSERT_NE(text.find(" [info] window.cpp:43: "
+			"{\"message\":\"clicked\",\"id\":7,\"widget\":\"button\"}\n"), std::string::npos);
+
+	::unlink(path.c_str());
+	::rmdir(directory.c_str());
+}
+
+
+TEST(FileLogSinkTest, SizeRotation)
+{
+	std::string directory = makeTemporaryDirectory();
+	std::string path = directory + "/app.log";
+
+	{
+		FileLogSink sink(String::fromUtf8(path.c_str()));
+		sink.setMaxFileSize(1000);
+		sink.setMaxBackupCount(2);
+
+		for(int i = 0; i < 100; ++i)
+			sink.write(LogLevel::kInfo, "file.cpp", i, "rotated message");
+
+		sink.flush();
+		ASSERT_EQ(sink.linesWritten(), 100);
+	}
+
+	ASSERT_TRUE(fileExists(path));
+	ASSERT_TRUE(fileExists(path + ".1"));
+	ASSERT_TRUE(fileExists(path + ".2"));
+	ASSERT_FALSE(fileExists(path + ".3"));
+
+	ASSERT_LE(readFile(path).size(), 1000);
+	ASSERT_LE(readFile(path + ".1").size(), 1000);
+
+	// The newest lines are in the current file
+	ASSERT_NE(readFile(path).find("file.cpp:99: rotated message\n"), std::string::npos);
+
+	for(const char* suffix : {"", ".1", ".2"})
+		::unlink((path + suffix).c_str());
+
+	::rmdir(directory.c_str());
+}
+
+
+TEST(FileLogSinkTest, AsyncLoggerDrain)
+{
+	std::string directory = makeTemporaryDirectory();
+	std::string path = directory + "/app.log";
+
+	{
+		FileLogSink sink(String::fromUtf8(path.c_str()));
+		sink.setSyncPolicy(FileLogSink::SyncPolicy::kEveryFlush);
+
+		AsyncLogger logger(LogMessageHandler(&sink, &FileLogSink::write), 64,
+				AsyncLogger::OverflowPolicy::kBlock,
+				Delegate<void()>(&sink, &FileLogSink::flush));
+
+		for(int i = 0; i < 1000; ++i)
+			logger.post(LogLevel::kWarning, "file.cpp", i, "message");
+
+		// The writer thread passes the buffered lines to the file when it drains the queue
+		logger.flush();
+		ASSERT_EQ(lineCount(readFile(path)), 1000);
+	}
+
+	::unlink(path.c_str());
+	::rmdir(directory.c_str());
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <tech/flags.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+enum class Option {
+	kNone   = 0x00,
+	kFirst  = 0x01,
+	kSecond = 0x02,
+	kThird  = 0x04
+};
+
+using Options = Flags<Option>;
+DECLARE_FLAG_OPERATORS(Option)
+
+
+} // namespace
+
+
+TEST(FlagsTest, Operators)
+{
+	Options options = Option::kFirst | Option::kSecond;
+	EXPECT_EQ(options.rawValue(), 0x03);
+
+	EXPECT_TRUE(options & Option::kFirst);
+	EXPECT_TRUE(options & Option::kSecond);
+	EXPECT_FALSE(options & Option::kThird);
+	EXPECT_TRUE(Option::kSecond & options);
+	EXPECT_EQ((options & Options(Option::kSecond)).rawValue(), 0x02);
+
+	EXPECT_EQ((options | Option::kThird).rawValue(), 0x07);
+	EXPECT_EQ((options ^ Option::kFirst).rawValue(), 0x02);
+	EXPECT_EQ((options ^ Options(Option::kThird)).rawValue(), 0x07);
+	EXPECT_EQ((options & ~Options(Option::kFirst)).rawValue(), 0x02);
+
+	options &= Option::kFirst;
+	EXPECT_TRUE(options == Option::kFirst);
+	EXPECT_FALSE(!options);
+	EXPECT_TRUE(!Options());
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/future.h>
+
+
+using namespace Tech;
+
+
+TEST(FutureTest, ValueAndContinuations)
+{
+	Promise<int> promise;
+	Future<int> future = promise.future();
+
+	ASSERT_TRUE(future.isValid());
+	ASSERT_FALSE(future.isReady());
+
+	std::vector<int> order;
+	Future<std::string> result = future
+		.then([&order](int&& value) {
+			order.push_back(value);
+			return value * 2;
+		})
+		.then([&order](int&& value) {
+			order.push_back(value);
+			return std::to_string(value);
+		});
+
+	ASSERT_FALSE(future.isValid());
+	ASSERT_FALSE(result.isReady());
+
+	promise.setValue(21);
+	ASSERT_TRUE(result.isReady());
+	ASSERT_FALSE(result.isBroken());
+	ASSERT_EQ(result.get(), "42");
+	ASSERT_EQ(order, (std::vector<int>{21, 42}));
+
+	// A continuation of a ready future runs right away
+	Promise<void> ready;
+	ready.setValue();
+
+	bool isCalled = false;
+	Future<void> done = ready.future().then([&isCalled]() { isCalled = true; });
+	ASSERT_TRUE(isCalled);
+	ASSERT_TRUE(done.isReady());
+	done.get();
+
+	// Move-only values are passed through
+	Promise<Box<int>> boxed;
+	Future<int> unboxed = boxed.future().then([](Box<int>&& value) { return *value; });
+	boxed.setValue(new int(7));
+	ASSERT_EQ(unboxed.get(), 7);
+}
+
+
+TEST(FutureTest, BrokenPromise)
+{
+	bool isCalled = false;
+	Future<void> result;
+
+	{
+		Promise<int> promise;
+		result = promise.future().then([&isCalled](int&&) { isCalled = true; });
+		ASSERT_FALSE(result.isReady());
+	}
+
+	ASSERT_TRUE(result.isReady());
+	ASSERT_TRUE(result.isBroken());
+	ASSERT_FALSE(isCalled);
+
+	// The continuation is destroyed along with the task queue which never ran it
+	Future<int> dropped;
+
+	{
+		TaskQueue queue;
+		Promise<int> promise;
+		dropped = promise.future().then(&queue, [](int&& value) { return value; });
+		promise.setValue(1);
+		ASSERT_FALSE(dropped.isReady());
+	}
+
+	ASSERT_TRUE(dropped.isBroken());
+}
+
+
+TEST(FutureTest, Executors)
+{
+	ThreadPool pool(2);
+	TaskQueue queue;
+	std::thread::id mainThread = std::this_thread::get_id();
+	std::atomic<bool> isDecodedOnPool(false);
+	std::atomic<bool> isShownOnQueue(false);
+
+	// Decodes on the pool, then hands the result over to the thread of the queue
+	Promise<std::string> data;
+	Future<int> shown = data.future()
+		.then(&pool, [&isDecodedOnPool, mainThread](std::string&& value) {
+			isDecodedOnPool = std::this_thread::get_id() != mainThread;
+			return static_cast<int>(value.size());
+		})
+		.then(&queue, [&isShownOnQueue, mainThread](int&& size) {
+			isShownOnQueue = std::this_thread::get_id() == mainThread;
+			return size;
+		});
+
+	std::thread producer([&data]() { data.setValue("image"); });
+
+	while(!shown.isReady())
+		queue.processTasks();
+
+	producer.join();
+	ASSERT_EQ(shown.get(), 5);
+	ASSERT_TRUE(isDecodedOnPool);
+	ASSERT_TRUE(isShownOnQueue);
+
+	// Blocking wait from outside the pool
+	Promise<int> promise;
+	Future<int> squared = promise.future().then(&pool, [](int&& value) {
+		return value * value;
+	});
+
+	pool.submit([&promise]() { promise.setValue(12); });
+	ASSERT_EQ(squared.get(), 144);
+}
+
+
+TEST(FutureTest, WhenAllAndWhenAny)
+{
+	ThreadPool pool(4);
+	std::vector<Promise<int>> promises(16);
+	std::vector<Future<int>> futures;
+
+	for(auto& promise : promises)
+		futures.push_back(promise.future());
+
+	Future<int> sum = whenAll(std::move(futures)).then(
+		[](std::vector<Future<int>>&& results) {
+			int sum = 0;
+			for(auto& result : results) {
+				if(!result.isBroken())
+					sum += result.get();
+			}
+
+			return sum;
+		});
+
+	for(size_t i = 0; i < promises.size(); ++i) {
+		Promise<int>* promise = &promises[i];
+
+		if(i == 3) {
+			pool.submit([promise]() { Promise<int> broken = std::move(*promise); });
+			continue;
+		}
+
+		pool.submit([promise, i]() { promise->setValue(static_cast<int>(i)); });
+	}
+
+	ASSERT_EQ(sum.get(), 120 - 3);
+	ASSERT_TRUE(whenAll(std::vector<Future<int>>()).isReady());
+
+	Promise<int> slow;
+	Promise<int> fast;
+	std::vector<Future<int>> race;
+	race.push_back(slow.future());
+	race.push_back(fast.future());
+
+	Future<WhenAnyResult<int>> first = whenAny(std::move(race));
+	ASSERT_FALSE(first.isReady());
+
+	fast.setValue(2);
+	ASSERT_TRUE(first.isReady());
+	ASSERT_EQ(first.get().index, 1u);
+	ASSERT_EQ(first.get().futures[1].get(), 2);
+	ASSERT_FALSE(first.get().futures[0].isReady());
+
+	slow.setValue(1);
+	ASSERT_EQ(first.get().futures[0].get(), 1);
+	ASSERT_EQ(whenAny(std::vector<Future<int>>()).get().index, size_t(-1));
+}
@@ -0,0 +1,78 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/lightweightsemaphore.h>
+
+
+using namespace Tech;
+
+
+TEST(LightweightSemaphoreTest, Counting)
+{
+	LightweightSemaphore semaphore(2);
+
+	ASSERT_TRUE(semaphore.tryWait());
+	ASSERT_TRUE(semaphore.wait());
+	ASSERT_FALSE(semaphore.tryWait());
+
+	semaphore.post();
+	semaphore.post();
+	ASSERT_TRUE(semaphore.wait(Duration(10)));
+	ASSERT_TRUE(semaphore.waitUntil(Duration::fromEpoch() + Duration(10)));
+	ASSERT_FALSE(semaphore.tryWait());
+}
+
+
+TEST(LightweightSemaphoreTest, Timeout)
+{
+	LightweightSemaphore semaphore;
+
+	auto start = std::chrono::steady_clock::now();
+	ASSERT_FALSE(semaphore.wait(Duration(20)));
+	ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+	ASSERT_FALSE(semaphore.waitUntil(Duration::fromEpoch() + Duration(20)));
+	ASSERT_FALSE(semaphore.waitUntil(Duration::fromEpoch() - Duration(20)));
+
+	// A parked waiter is woken before the timeout
+	std::thread poster([&semaphore]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		semaphore.post();
+	});
+
+	ASSERT_TRUE(semaphore.wait(Duration::seconds(10)));
+	poster.join();
+}
+
+
+TEST(LightweightSemaphoreTest, ProducersAndConsumers)
+{
+	static const int kItemsPerThread = 20000;
+
+	LightweightSemaphore items;
+	std::atomic<int> consumed(0);
+	std::vector<std::thread> threads;
+
+	for(int i = 0; i < 3; ++i) {
+		threads.emplace_back([&items, &consumed]() {
+			for(int j = 0; j < kItemsPerThread; ++j) {
+				items.wait();
+				consumed.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	for(int i = 0; i < 3; ++i) {
+		threads.emplace_back([&items]() {
+			for(int j = 0; j < kItemsPerThread; ++j)
+				items.post();
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	ASSERT_EQ(consumed.load(), 3 * kItemsPerThread);
+	ASSERT_FALSE(items.tryWait());
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include <gtest/gtest.h>
+#include <tech/logfields.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+std::string render(LogFieldFormat format, const char* message, const LogFieldWriter& writer)
+{
+	std::string result;
+	renderLogRecord(format, message, writer.fields(), &result);
+	return result;
+}
+
+
+} // namespace
+
+
+TEST(LogFieldsTest, Encoding)
+{
+	LogFieldWriter writer;
+	writer.add("id", 42);
+	writer.add("offset", -3);
+	writer.add("size", static_cast<u64>(300));
+	writer.add("ok", true);
+	writer.add("ratio", 0.5);
+	writer.add("name", "button");
+	writer.add("title", String::fromUtf8("привет"));
+	writer.add("elapsed", Duration(16));
+
+	// Every field takes two bytes and the key, small integers take a single byte
+	LogFields fields = writer.fields();
+	ASSERT_EQ(fields.size(), 84);
+
+	LogFieldReader reader(fields);
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kInt);
+	ASSERT_EQ(std::string(reader.key(), reader.keyLength()), "id");
+	ASSERT_EQ(reader.toInt(), 42);
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kInt);
+	ASSERT_EQ(reader.toInt(), -3);
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kUInt);
+	ASSERT_EQ(reader.toUInt(), 300);
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kTrue);
+	ASSERT_TRUE(reader.toBool());
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kDouble);
+	ASSERT_EQ(reader.toDouble(), 0.5);
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kString);
+	ASSERT_EQ(std::string(reader.string(), reader.stringLength()), "button");
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(std::string(reader.string(), reader.stringLength()), "привет");
+
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kDuration);
+	ASSERT_EQ(reader.toDuration().mseconds(), 16);
+
+	ASSERT_FALSE(reader.next());
+}
+
+
+TEST(LogFieldsTest, Limits)
+{
+	LogFieldWriter writer;
+	writer.add("min", std::numeric_limits<i64>::min());
+	writer.add("max", std::numeric_limits<u64>::max());
+
+	// Fields larger than the inline buffer are moved to the heap
+	std::string text(LogFieldWriter::kInlineCapacity * 2, 'x');
+	writer.add("text", text.c_str());
+
+	const char* null = nullptr;
+	writer.add("null", null);
+
+	LogFieldReader reader(writer.fields());
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.toInt(), std::numeric_limits<i64>::min());
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.toUInt(), std::numeric_limits<u64>::max());
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(std::string(reader.string(), reader.stringLength()), text);
+	ASSERT_TRUE(reader.next());
+	ASSERT_EQ(reader.type(), LogFieldType::kString);
+	ASSERT_EQ(reader.stringLength(), 0);
+	ASSERT_FALSE(reader.next());
+
+	// Truncated data is detected rather than read past the end
+	LogFieldReader truncated(LogFields(writer.fields().data(), writer.fields().size() - 1));
+	ASSERT_TRUE(truncated.next());
+	ASSERT_TRUE(truncated.next());
+	ASSERT_TRUE(truncated.next());
+	ASSERT_FALSE(truncated.next());
+}
+
+
+TEST(LogFieldsTest, Rendering)
+{
+	LogFieldWriter writer;
+	writer.add("id", 42);
+	writer.add("widget", "main button");
+	writer.add("visible", false);
+	writer.add("elapsed", Duration(16));
+	writer.add("quote", "a\"b");
+
+	ASSERT_EQ(render(LogFieldFormat::kText, "clicked", writer),
+			"clicked id=42 widget=\"main button\" visible=false elapsed=16ms quote=\"a\\\"b\"");
+	ASSERT_EQ(render(LogFieldFormat::kJson, "clicked", writer),
+			"{\"message\":\"clicked\",\"id\":42,\"widget\":\"main button\",\"visible\":false,"
+			"\"elapsed\":16,\"quote\":\"a\\\"b\"}");
+
+	LogFieldWriter special;
+	special.add("ratio", std::nan(""));
+	special.add("line", "a\nb");
+
+	ASSERT_EQ(render(LogFieldFormat::kJson, "m", special),
+			"{\"message\":\"m\",\"ratio\":null,\"line\":\"a\\nb\"}");
+	ASSERT_EQ(formatLogRecord(LogFieldFormat::kText, "empty", LogFields()), "empty");
+}
@@ -0,0 +1,181 @@
+// Trace messages are removed from this file at compile time
+#define TECH_MIN_LOG_LEVEL 1
+#define TECH_LOG_MODULE "test"
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/logger.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+std::vector<LogLevel> receivedLevels;
+std::vector<String> receivedMessages;
+int evaluationCount = 0;
+std::vector<String> receivedRecords;
+
+
+void recordingHandler(LogLevel level, const String& file, int line,
+		const String& message)
+{
+	UNUSED(file);
+	UNUSED(line);
+
+	receivedLevels.push_back(level);
+	receivedMessages.push_back(message);
+}
+
+
+void fieldsHandler(LogLevel level, const String& file, int line, const char* message,
+		const LogFields& fields)
+{
+	UNUSED(level);
+	UNUSED(file);
+	UNUSED(line);
+
+	receivedRecords.push_back(formatLogRecord(LogFieldFormat::kJson, message, fields));
+}
+
+
+int evaluate()
+{
+	return ++evaluationCount;
+}
+
+
+class LoggerTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		receivedLevels.clear();
+		receivedMessages.clear();
+		receivedRecords.clear();
+		evaluationCount = 0;
+		resetLogLevels();
+		setLogMessageHandler(LogMessageHandler(&recordingHandler));
+	}
+
+	void TearDown() override
+	{
+		setLogMessageHandler(LogMessageHandler());
+		resetLogLevels();
+	}
+};
+
+
+} // namespace
+
+
+TEST_F(LoggerTest, Levels)
+{
+	LOG_DEBUG("debug {}", 1);
+	LOG("info {}", 2);
+	LOG_WARNING("warning {}", 3);
+	LOG_ERROR("error {}", 4);
+
+	ASSERT_EQ(receivedMessages.size(), 3);
+	ASSERT_EQ(receivedMessages[0], "info 2");
+	ASSERT_EQ(receivedLevels[0], LogLevel::kInfo);
+	ASSERT_EQ(receivedLevels[1], LogLevel::kWarning);
+	ASSERT_EQ(receivedLevels[2], LogLevel::kError);
+
+	setLogLevel(LogLevel::kDebug);
+	LOG_DEBUG("debug {}", 5);
+	ASSERT_EQ(receivedMessages.back(), "debug 5");
+
+	setLogLevel(LogLevel::kOff);
+	LOG_ERROR("error {}", 6);
+	ASSERT_EQ(receivedMessages.size(), 4);
+	ASSERT_STREQ(logLevelName(LogLevel::kWarning), "warning");
+}
+
+
+TEST_F(LoggerTest, DisabledArgumentsAreNotEvaluated)
+{
+	LOG_DEBUG("{}", evaluate());
+	ASSERT_EQ(evaluationCount, 0);
+
+	setLogLevel(LogLevel::kTrace);
+	LOG_TRACE("{}", evaluate());
+	ASSERT_EQ(evaluationCount, 0);
+
+	setLogMessageHandler(LogMessageHandler());
+	LOG_ERROR("{}", evaluate());
+	ASSERT_EQ(evaluationCount, 0);
+
+	setLogMessageHandler(LogMessageHandler(&recordingHandler));
+	LOG_ERROR("{}", evaluate());
+	ASSERT_EQ(evaluationCount, 1);
+	ASSERT_EQ(receivedMessages.size(), 1);
+}
+
+
+TEST_F(LoggerTest, FileAndModuleThresholds)
+{
+	setModuleLogLevel("test", LogLevel::kDebug);
+	LOG_DEBUG("module");
+	ASSERT_EQ(receivedMessages.size(), 1);
+
+	setFileLogLevel("logger_test.cpp", LogLevel::kError);
+	LOG_WARNING("file");
+	LOG_ERROR("file");
+	ASSERT_EQ(receivedMessages.size(), 2);
+
+	ASSERT_TRUE(isLogEnabled(LogLevel::kDebug, "src/window.cpp", "test"));
+	ASSERT_FALSE(isLogEnabled(LogLevel::kDebug, "src/window.cpp", "ui"));
+	ASSERT_FALSE(isLogEnabled(LogLevel::kWarning, "test/logger_test.cpp", "test"));
+
+	resetLogLevels();
+	LOG_DEBUG("reset");
+	LOG_WARNING("reset");
+	ASSERT_EQ(receivedMessages.size(), 3);
+}
+
+
+TEST_F(LoggerTest, RateLimiting)
+{
+	for(int i = 0; i < 100; ++i)
+		LOG_EVERY_N(LogLevel::kInfo, 10, "{}", i);
+
+	ASSERT_EQ(receivedMessages.size(), 10);
+	ASSERT_EQ(receivedMessages[1], "10");
+
+	receivedMessages.clear();
+
+	for(int i = 0; i < 100; ++i)
+		LOG_EVERY_MS(LogLevel::kWarning, 60000, "{}", i);
+
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedMessages[0], "0");
+}
+
+
+TEST_F(LoggerTest, StructuredMessages)
+{
+	String widget = "button";
+
+	// Without a record handler the fields are rendered as text
+	LOG_KV("clicked", "id", 42, "widget", widget);
+	LOG_KV_AT(LogLevel::kDebug, "hidden", "id", evaluate());
+	ASSERT_EQ(evaluationCount, 0);
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedMessages[0], "clicked id=42 widget=button");
+
+	setLogRecordHandler(LogRecordHandler(&fieldsHandler));
+	LOG_KV_AT(LogLevel::kWarning, "slow frame", "elapsed", Duration(40), "dropped", true);
+
+	for(int i = 0; i < 10; ++i)
+		LOG_KV_EVERY_N(LogLevel::kInfo, 5, "tick", "i", i);
+
+	setLogRecordHandler(LogRecordHandler());
+
+	ASSERT_EQ(receivedMessages.size(), 1);
+	ASSERT_EQ(receivedRecords.size(), 3);
+	ASSERT_EQ(receivedRecords[0],
+			"{\"message\":\"slow frame\",\"elapsed\":40,\"dropped\":true}");
+	ASSERT_EQ(receivedRecords[2], "{\"message\":\"tick\",\"i\":5}");
+}
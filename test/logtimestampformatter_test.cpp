@@ -0,0 +1,116 @@
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/logtimestampformatter.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+std::string render(LogTimestampFormatter& formatter, i64 msecs)
+{
+	char buffer[LogTimestampFormatter::kLength];
+	formatter.format(msecs, buffer);
+	return std::string(buffer, sizeof(buffer));
+}
+
+
+std::string renderLocal(i64 msecs)
+{
+	time_t time = static_cast<time_t>(msecs / 1000);
+	tm local;
+	localtime_r(&time, &local);
+
+	// Enough for any values of the fields
+	char buffer[96];
+	std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+			local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour,
+			local.tm_min, local.tm_sec, static_cast<int>(msecs % 1000));
+	return buffer;
+}
+
+
+} // namespace
+
+
+TEST(LogTimestampFormatterTest, Utc)
+{
+	LogTimestampFormatter formatter(LogTimestampFormatter::Clock::kPrecise,
+			LogTimestampFormatter::TimeZone::kUtc);
+
+	ASSERT_EQ(render(formatter, 0), "1970-01-01 00:00:00.000");
+	ASSERT_EQ(render(formatter, 1463493792345), "2016-05-17 14:03:12.345");
+
+	// Same second from the cache, only milliseconds differ
+	ASSERT_EQ(render(formatter, 1463493792007), "2016-05-17 14:03:12.007");
+	ASSERT_EQ(render(formatter, 1463493792999), "2016-05-17 14:03:12.999");
+	ASSERT_EQ(render(formatter, 1463493793000), "2016-05-17 14:03:13.000");
+
+	// Going back in time doesn't break the cache
+	ASSERT_EQ(render(formatter, 1463493792500), "2016-05-17 14:03:12.500");
+	ASSERT_EQ(render(formatter, 1463493793001), "2016-05-17 14:03:13.001");
+
+	ASSERT_EQ(render(formatter, -1), "1969-12-31 23:59:59.999");
+}
+
+
+TEST(LogTimestampFormatterTest, LocalTime)
+{
+	LogTimestampFormatter formatter;
+	i64 now = formatter.now();
+
+	for(i64 msecs = now; msecs < now + 3000; msecs += 250)
+		ASSERT_EQ(render(formatter, msecs), renderLocal(msecs));
+
+	char buffer[LogTimestampFormatter::kLength];
+	i64 msecs = formatter.format(buffer);
+	ASSERT_EQ(std::string(buffer, sizeof(buffer)), renderLocal(msecs));
+}
+
+
+TEST(LogTimestampFormatterTest, CoarseClock)
+{
+	LogTimestampFormatter formatter(LogTimestampFormatter::Clock::kCoarse);
+	ASSERT_EQ(formatter.clock(), LogTimestampFormatter::Clock::kCoarse);
+
+	// The coarse clock lags behind by at most a few ticks
+	timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	i64 precise = static_cast<i64>(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+	ASSERT_LE(std::abs(formatter.now() - precise), 100);
+}
+
+
+TEST(LogTimestampFormatterTest, ConcurrentFormatting)
+{
+	LogTimestampFormatter formatter(LogTimestampFormatter::Clock::kPrecise,
+			LogTimestampFormatter::TimeZone::kUtc);
+	std::vector<std::thread> threads;
+	std::vector<int> errors(4, 0);
+
+	// Threads walk through the seconds at different paces, updating the cache
+	for(int t = 0; t < 4; ++t) {
+		threads.emplace_back([&formatter, &errors, t]() {
+			LogTimestampFormatter reference(LogTimestampFormatter::Clock::kPrecise,
+					LogTimestampFormatter::TimeZone::kUtc);
+
+			for(i64 i = 0; i < 20000; ++i) {
+				i64 msecs = 1463493792000 + i * (t + 1) * 7;
+
+				if(render(formatter, msecs) != render(reference, msecs))
+					++errors[t];
+			}
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	for(int count : errors)
+		ASSERT_EQ(count, 0);
+}
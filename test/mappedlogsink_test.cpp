@@ -0,0 +1,177 @@
+#include <cstdlib>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <tech/mappedlogsink.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+String temporaryFileName()
+{
+	char path[] = "/tmp/tech-mappedlog-XXXXXX";
+	int fd = ::mkstemp(path);
+
+	if(fd != -1)
+		::close(fd);
+
+	return String::fromUtf8(path);
+}
+
+
+void removeFile(const String& fileName)
+{
+	::unlink(fileName.toUtf8().constData());
+}
+
+
+} // namespace
+
+
+TEST(MappedLogSinkTest, LastRecords)
+{
+	String fileName = temporaryFileName();
+
+	{
+		MappedLogSink sink(fileName);
+		ASSERT_TRUE(sink.isOpen());
+
+		for(int i = 0; i < 10; ++i)
+			sink.write(LogLevel::kWarning, "window.cpp", i, Formatter::format("message {}", i));
+
+		sink.write(LogLevel::kError, "window.cpp", 10, String::fromUtf8("сообщение"));
+	}
+
+	MappedLogReader reader(fileName);
+	ASSERT_TRUE(reader.isValid());
+	ASSERT_EQ(reader.records().size(), 11);
+
+	std::vector<MappedLogReader::Record> records = reader.lastRecords(3);
+	ASSERT_EQ(records.size(), 3);
+	ASSERT_EQ(records[0].sequence, 8);
+	ASSERT_EQ(records[0].level, LogLevel::kWarning);
+	ASSERT_EQ(records[0].file, "window.cpp");
+	ASSERT_EQ(records[0].line, 8);
+	ASSERT_EQ(records[0].message, "message 8");
+	ASSERT_EQ(records[2].level, LogLevel::kError);
+	ASSERT_EQ(records[2].message, String::fromUtf8("сообщение"));
+	ASSERT_GT(records[2].time.mseconds(), 0);
+
+	removeFile(fileName);
+}
+
+
+TEST(MappedLogSinkTest, Wraparound)
+{
+	String fileName = temporaryFileName();
+
+	{
+		MappedLogSink sink(fileName, 4096);
+		ASSERT_EQ(sink.capacity(), 4096);
+
+		for(int i = 0; i < 1000; ++i)
+			sink.write(LogLevel::kInfo, "file.cpp", i, Formatter::format("wrapped {}", i));
+
+		// Too long message is truncated, but still fits into the ring
+		sink.write(LogLevel::kInfo, "file.cpp", 1000, String(5000, 'x'));
+	}
+
+	MappedLogReader reader(fileName);
+	std::vector<MappedLogReader::Record> records = reader.records();
+	ASSERT_GT(records.size(), 10);
+	ASSERT_LT(records.size(), 1001);
+
+	for(size_t i = 1; i < records.size(); ++i)
+		ASSERT_EQ(records[i].sequence, records[i - 1].sequence + 1);
+
+	ASSERT_EQ(records.back().sequence, 1000);
+	ASSERT_LT(records.back().message.length(), 1024);
+	ASSERT_EQ(records[records.size() - 2].message, "wrapped 999");
+
+	removeFile(fileName);
+}
+
+
+TEST(MappedLogSinkTest, LongFileName)
+{
+	String fileName = temporaryFileName();
+	String longFile(3000, 'f');
+
+	{
+		MappedLogSink sink(fileName, 4096);
+
+		for(int i = 0; i < 100; ++i)
+			sink.write(LogLevel::kInfo, longFile, i, String(2000, 'x'));
+
+		sink.write(LogLevel::kInfo, "file.cpp", 100, "last");
+	}
+
+	MappedLogReader reader(fileName);
+	ASSERT_TRUE(reader.isValid());
+
+	std::vector<MappedLogReader::Record> records = reader.records();
+	ASSERT_GT(records.size(), 1);
+	ASSERT_EQ(records.back().message, "last");
+
+	// The name is replaced, the record still takes at most a quarter of the ring
+	const MappedLogReader::Record& record = records[records.size() - 2];
+	ASSERT_EQ(record.sequence, 99);
+	ASSERT_EQ(record.file, String(512, '?'));
+	ASSERT_LT(record.file.length() + record.message.length(), 1024);
+
+	removeFile(fileName);
+}
+
+
+TEST(MappedLogSinkTest, AppendsAfterReopen)
+{
+	String fileName = temporaryFileName();
+
+	for(int run = 0; run < 2; ++run) {
+		MappedLogSink sink(fileName, 64 * 1024);
+
+		for(int i = 0; i < 5; ++i)
+			sink.write(LogLevel::kInfo, "file.cpp", run * 5 + i, "message");
+	}
+
+	std::vector<MappedLogReader::Record> records = MappedLogReader(fileName).records();
+	ASSERT_EQ(records.size(), 10);
+	ASSERT_EQ(records.back().sequence, 9);
+	ASSERT_EQ(records.back().line, 9);
+
+	removeFile(fileName);
+}
+
+
+TEST(MappedLogSinkTest, SurvivesCrash)
+{
+	String fileName = temporaryFileName();
+	pid_t pid = ::fork();
+	ASSERT_NE(pid, -1);
+
+	if(pid == 0) {
+		MappedLogSink* sink = new MappedLogSink(fileName, 64 * 1024);
+
+		for(int i = 0; i < 100; ++i)
+			sink->write(LogLevel::kError, "crash.cpp", i, "before crash");
+
+		// Neither destructors nor any other cleanup
+		std::abort();
+	}
+
+	int status = 0;
+	::waitpid(pid, &status, 0);
+	ASSERT_TRUE(WIFSIGNALED(status));
+
+	std::vector<MappedLogReader::Record> records = MappedLogReader(fileName).lastRecords(5);
+	ASSERT_EQ(records.size(), 5);
+	ASSERT_EQ(records.back().line, 99);
+	ASSERT_EQ(records.back().message, "before crash");
+
+	removeFile(fileName);
+}
@@ -0,0 +1,75 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/mpmcqueue.h>
+
+
+using namespace Tech;
+
+
+TEST(MpmcQueueTest, PushPop)
+{
+	MpmcQueue<Box<int>> queue(4);
+	ASSERT_EQ(queue.capacity(), 4u);
+	ASSERT_TRUE(queue.isEmpty());
+
+	for(int i = 0; i < 4; ++i)
+		ASSERT_TRUE(queue.tryEmplace(new int(i)));
+
+	ASSERT_FALSE(queue.tryPush(Box<int>(new int(4))));
+	ASSERT_FALSE(queue.isEmpty());
+
+	Box<int> value;
+	for(int i = 0; i < 4; ++i) {
+		ASSERT_TRUE(queue.tryPop(&value));
+		ASSERT_EQ(*value, i);
+	}
+
+	ASSERT_FALSE(queue.tryPop(&value));
+	ASSERT_TRUE(queue.isEmpty());
+
+	// Values left in the queue are destroyed with it
+	ASSERT_TRUE(queue.tryEmplace(new int(5)));
+}
+
+
+TEST(MpmcQueueTest, Threads)
+{
+	static const int kThreadCount = 4;
+	static const u64 kCountPerThread = 50000;
+
+	MpmcQueue<u64> queue(128);
+	std::atomic<u64> sum(0);
+	std::atomic<u64> popped(0);
+	std::vector<std::thread> threads;
+
+	for(int i = 0; i < kThreadCount; ++i) {
+		threads.emplace_back([&queue]() {
+			for(u64 j = 1; j <= kCountPerThread; ++j) {
+				while(!queue.tryPush(j))
+					std::this_thread::yield();
+			}
+		});
+
+		threads.emplace_back([&queue, &sum, &popped]() {
+			u64 value;
+
+			while(popped.load(std::memory_order_relaxed) < kThreadCount * kCountPerThread) {
+				if(queue.tryPop(&value)) {
+					sum.fetch_add(value, std::memory_order_relaxed);
+					popped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	ASSERT_EQ(sum.load(), kThreadCount * kCountPerThread * (kCountPerThread + 1) / 2);
+	ASSERT_TRUE(queue.isEmpty());
+}
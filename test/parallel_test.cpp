@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/parallel.h>
+
+
+using namespace Tech;
+
+
+TEST(ParallelTest, ForAndTransform)
+{
+	ThreadPool pool(4);
+	std::vector<u64> input(100000);
+	std::iota(input.begin(), input.end(), 0);
+
+	std::vector<std::atomic<int>> visits(input.size());
+	for(auto& visit : visits)
+		visit.store(0);
+
+	parallelFor(&pool, input.size(), 1000, [&visits](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; ++i)
+			visits[i].fetch_add(1, std::memory_order_relaxed);
+	});
+
+	for(auto& visit : visits)
+		ASSERT_EQ(visit.load(), 1);
+
+	std::vector<u64> output(input.size());
+	parallelTransform(&pool, input.begin(), input.end(), output.begin(),
+			[](u64 value) { return value * 2; });
+
+	for(size_t i = 0; i < output.size(); ++i)
+		ASSERT_EQ(output[i], i * 2);
+
+	// Empty ranges don't call the function
+	parallelFor(&pool, 0, 1, [](size_t, size_t) { FAIL(); });
+}
+
+
+TEST(ParallelTest, Reduce)
+{
+	ThreadPool pool(3);
+	std::vector<u64> values(123457);
+	std::iota(values.begin(), values.end(), 1);
+
+	u64 sum = parallelReduce(&pool, values.begin(), values.end(), u64(10),
+			[](u64 a, u64 b) { return a + b; });
+	ASSERT_EQ(sum, 10 + 123457ull * 123458 / 2);
+
+	// The order of the partial results is kept for non-commutative operations
+	std::vector<String> strings(20000, String("ab"));
+	String joined = parallelReduce(&pool, strings.begin(), strings.end(), String("<"),
+			[](String a, const String& b) { return a += b; });
+	ASSERT_EQ(joined.length(), 40001u);
+	ASSERT_TRUE(joined.startsWith("<abab"));
+	ASSERT_TRUE(joined.endsWith("abab"));
+
+	ASSERT_EQ(parallelReduce(&pool, values.begin(), values.begin(), u64(7),
+			[](u64 a, u64 b) { return a + b; }), 7u);
+}
+
+
+TEST(ParallelTest, SortRange)
+{
+	ThreadPool pool(4);
+	std::mt19937 random(42);
+
+	for(size_t size : {0, 1, 1000, 100000, 250001}) {
+		std::vector<u32> values(size);
+		for(auto& value : values)
+			value = random();
+
+		std::vector<u32> expected = values;
+		std::sort(expected.begin(), expected.end());
+
+		parallelSort(&pool, values.begin(), values.end());
+		ASSERT_EQ(values, expected);
+
+		parallelSort(&pool, values.begin(), values.end(), std::greater<u32>());
+		ASSERT_TRUE(std::is_sorted(values.begin(), values.end(), std::greater<u32>()));
+	}
+}
+
+
+TEST(ParallelTest, SortStrings)
+{
+	ThreadPool pool(4);
+	std::mt19937 random(7);
+	ByteArrayList arrays;
+	StringList strings;
+
+	// Short alphabets make many shared prefixes, high bytes check the signed order
+	const char alphabet[] = {'a', 'b', '\x01', '\x80', '\xff'};
+
+	for(int i = 0; i < 60000; ++i) {
+		ByteArray array;
+		String string;
+		size_t length = random() % 12;
+
+		for(size_t j = 0; j < length; ++j) {
+			array.append(alphabet[random() % sizeof(alphabet)]);
+			ch16 ch = static_cast<ch16>(0x61 + random() % 3 + (random() % 2) * 0xff00);
+			string.append(Char(ch));
+		}
+
+		arrays.push_back(array);
+		strings.push_back(string);
+	}
+
+	ByteArrayList expectedArrays = arrays;
+	std::sort(expectedArrays.begin(), expectedArrays.end());
+	parallelSort(&pool, &arrays);
+	ASSERT_EQ(arrays, expectedArrays);
+
+	StringList expectedStrings = strings;
+	std::sort(expectedStrings.begin(), expectedStrings.end());
+	parallelSort(&pool, &strings);
+	ASSERT_EQ(strings, expectedStrings);
+}
+
+
+TEST(ParallelTest, Unique)
+{
+	ThreadPool pool(4);
+	std::mt19937 random(3);
+
+	// Long runs cross the chunk boundaries, a single run covers whole chunks
+	for(size_t size : {0, 1, 1000, 100000, 250001}) {
+		for(size_t runLength : {1, 3, 5000, 100000}) {
+			std::vector<u32> values(size);
+			for(size_t i = 0; i < size; ++i)
+				values[i] = static_cast<u32>(i / runLength) + random() % 2;
+
+			std::vector<u32> expected = values;
+			expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+			auto end = parallelUnique(&pool, values.begin(), values.end());
+			values.erase(end, values.end());
+			ASSERT_EQ(values, expected);
+		}
+	}
+
+	ByteArrayList arrays;
+	StringList strings;
+
+	for(int i = 0; i < 60000; ++i) {
+		ByteArray array;
+		String string;
+		size_t length = random() % 6;
+
+		for(size_t j = 0; j < length; ++j) {
+			array.append(static_cast<char>('a' + random() % 3));
+			string.append(Char(static_cast<ch16>(0x61 + random() % 3)));
+		}
+
+		arrays.push_back(array);
+		strings.push_back(string);
+	}
+
+	ByteArrayList expectedArrays = arrays;
+	std::sort(expectedArrays.begin(), expectedArrays.end());
+	expectedArrays.erase(std::unique(expectedArrays.begin(), expectedArrays.end()),
+			expectedArrays.end());
+	parallelSortUnique(&pool, &arrays);
+	ASSERT_EQ(arrays, expectedArrays);
+
+	StringList expectedStrings = strings;
+	std::sort(expectedStrings.begin(), expectedStrings.end());
+	expectedStrings.erase(std::unique(expectedStrings.begin(), expectedStrings.end()),
+			expectedStrings.end());
+	parallelSortUnique(&pool, &strings);
+	ASSERT_EQ(strings, expectedStrings);
+}
+
+
+TEST(ParallelTest, Records)
+{
+	ThreadPool pool(4);
+	ByteArray buffer;
+	u64 expectedSum = 0;
+
+	for(int i = 0; i < 200000; ++i) {
+		buffer.append(std::to_string(i).c_str());
+		expectedSum += i;
+		buffer.append('\n');
+	}
+
+	// Unterminated last record
+	buffer.append("17");
+	expectedSum += 17;
+
+	std::atomic<u64> sum(0);
+	std::atomic<size_t> count(0);
+
+	parallelForEachRecord(&pool, buffer, '\n', [&sum, &count](const char* data,
+			size_t size) {
+		u64 value = 0;
+		for(size_t i = 0; i < size; ++i)
+			value = value * 10 + static_cast<u64>(data[i] - '0');
+
+		sum.fetch_add(value, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+	});
+
+	ASSERT_EQ(count.load(), 200001u);
+	ASSERT_EQ(sum.load(), expectedSum);
+
+	// Chunks cover the buffer and end after a separator
+	std::atomic<size_t> covered(0);
+	parallelForEachChunk(&pool, buffer.constData(), buffer.length(), '\n',
+			[&covered, &buffer](const char* begin, const char* end) {
+				covered.fetch_add(static_cast<size_t>(end - begin));
+				if(end != buffer.constData() + buffer.length()) {
+					EXPECT_EQ(end[-1], '\n');
+				}
+			});
+
+	ASSERT_EQ(covered.load(), buffer.length());
+
+	// Without separators the whole buffer is one record
+	ByteArray single(1000000, 'x');
+	count.store(0);
+	parallelForEachRecord(&pool, single, '\n', [&count](const char*, size_t size) {
+		EXPECT_EQ(size, 1000000u);
+		count.fetch_add(1);
+	});
+
+	ASSERT_EQ(count.load(), 1u);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <tech/scanner.h>
+
+
+using namespace Tech;
+
+
+TEST(ScannerTest, StructuredLine)
+{
+	String method;
+	String host;
+	int port;
+	u32 duration;
+
+	String line = "GET example.org:8080 took 15ms";
+	ScanResult result = Scanner::scan(line, "{} {}:{} took {}ms", &method, &host, &port,
+			&duration);
+
+	ASSERT_TRUE(result.isValid());
+	ASSERT_EQ(result.count(), 4);
+	ASSERT_EQ(result.position(), line.length());
+	ASSERT_TRUE(method == "GET");
+	ASSERT_TRUE(host == "example.org");
+	ASSERT_EQ(port, 8080);
+	ASSERT_EQ(duration, 15);
+}
+
+
+TEST(ScannerTest, ByteArrayInput)
+{
+	ByteArray name;
+	String value;
+	i64 number;
+	double ratio;
+
+	ByteArray line = "ключ=значение;-9000000000;0.25";
+	ScanResult result = Scanner::scan(line, "{}={};{};{}", &name, &value, &number,
+			&ratio);
+
+	ASSERT_TRUE(result.isValid());
+	ASSERT_TRUE(name == "ключ");
+	ASSERT_TRUE(value == String::fromUtf8("значение"));
+	ASSERT_EQ(number, -9000000000ll);
+	ASSERT_DOUBLE_EQ(ratio, 0.25);
+}
+
+
+TEST(ScannerTest, FailurePosition)
+{
+	int a = 0;
+	int b = 0;
+
+	ScanResult r1 = Scanner::scan(String("12:x4"), "{}:{}", &a, &b);
+	ASSERT_FALSE(r1.isValid());
+	ASSERT_EQ(r1.count(), 1);
+	ASSERT_EQ(r1.position(), 3);
+	ASSERT_EQ(a, 12);
+
+	ScanResult r2 = Scanner::scan(String("12;34"), "{}:{}", &a, &b);
+	ASSERT_FALSE(r2);
+	ASSERT_EQ(r2.position(), 2);
+
+	ScanResult r3 = Scanner::scan(String("12:34 tail"), "{}:{}", &a, &b);
+	ASSERT_FALSE(r3);
+	ASSERT_EQ(r3.position(), 5);
+	ASSERT_EQ(b, 34);
+}
+
+
+TEST(ScannerTest, IntegerRange)
+{
+	u8 small;
+	i16 value;
+	u32 positive;
+
+	ASSERT_TRUE(Scanner::scan(String("255"), "{}", &small));
+	ASSERT_EQ(small, 255);
+	ASSERT_FALSE(Scanner::scan(String("256"), "{}", &small));
+	ASSERT_TRUE(Scanner::scan(String("-32768"), "{}", &value));
+	ASSERT_EQ(value, -32768);
+	ASSERT_FALSE(Scanner::scan(String("32768"), "{}", &value));
+	ASSERT_FALSE(Scanner::scan(String("-1"), "{}", &positive));
+	ASSERT_FALSE(Scanner::scan(String("99999999999999999999"), "{}", &positive));
+}
+
+
+TEST(ScannerTest, FormatSpec)
+{
+	u32 hex;
+	u32 binary;
+	int padded;
+	String name;
+
+	ASSERT_TRUE(Scanner::scan(String("ff 0b101"), "{:x} {:#b}", &hex, &binary));
+	ASSERT_EQ(hex, 0xFF);
+	ASSERT_EQ(binary, 5);
+
+	ASSERT_TRUE(Scanner::scan(String("[    42][ab  ]"), "[{:>6}][{:<4}]", &padded,
+			&name));
+	ASSERT_EQ(padded, 42);
+	ASSERT_TRUE(name == "ab");
+
+	int year, month, day;
+	ASSERT_TRUE(Scanner::scan(String("20160219"), "{:4}{:2}{:2}", &year, &month, &day));
+	ASSERT_EQ(year, 2016);
+	ASSERT_EQ(month, 2);
+	ASSERT_EQ(day, 19);
+}
+
+
+TEST(ScannerTest, IndicesAndSkippedFields)
+{
+	int first;
+	int second;
+	bool flag;
+	Char ch;
+
+	ASSERT_TRUE(Scanner::scan(String("2-1"), "{1}-{0}", &first, &second));
+	ASSERT_EQ(first, 1);
+	ASSERT_EQ(second, 2);
+
+	ScanResult result = Scanner::scan(String("ignored {true} x"), "{2} {{{0}}} {1}",
+			&flag, &ch);
+
+	ASSERT_TRUE(result.isValid());
+	ASSERT_EQ(result.count(), 2);
+	ASSERT_TRUE(flag);
+	ASSERT_TRUE(ch == u'x');
+}
@@ -0,0 +1,328 @@
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/signal.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Receiver : public Trackable {
+public:
+	explicit Receiver(int id = 0) :
+		id(id)
+	{
+	}
+
+	void slot(int value)
+	{
+		values.push_back(value);
+	}
+
+	void slotConst(int value) const
+	{
+		constValues.push_back(value * id);
+	}
+
+	int id;
+	std::vector<int> values;
+	mutable std::vector<int> constValues;
+};
+
+
+class PlainReceiver {
+public:
+	void slot(int value)
+	{
+		sum += value;
+	}
+
+	int sum = 0;
+};
+
+
+// Performs an action on the signal from inside the slot
+class Reentrant {
+public:
+	void disconnectSelf(int value)
+	{
+		values.push_back(value);
+		self.disconnect();
+	}
+
+	void disconnectOther(int value)
+	{
+		values.push_back(value);
+		other.disconnect();
+	}
+
+	void connectOther(int value)
+	{
+		values.push_back(value);
+
+		if(target)
+			signal->connect(target, &Receiver::slot);
+	}
+
+	void destroyOther(int value)
+	{
+		values.push_back(value);
+		owned.reset();
+	}
+
+	Signal<void(int)>* signal = nullptr;
+	Receiver* target = nullptr;
+	Connection self;
+	Connection other;
+	Box<Receiver> owned;
+	std::vector<int> values;
+};
+
+
+} // namespace
+
+
+TEST(SignalTest, ConnectionHandles)
+{
+	Signal<void(int)> signal;
+	Receiver receiver1;
+	Receiver receiver2;
+	PlainReceiver plain;
+
+	Connection connection1 = signal.connect(&receiver1, &Receiver::slot);
+	Connection connection2 = signal.connect(&receiver2, &Receiver::slot);
+	Connection connection3 = signal.connect(&plain, &PlainReceiver::slot);
+	Connection copy = connection2;
+
+	ASSERT_TRUE(connection1.isConnected());
+	ASSERT_TRUE(copy.isConnected());
+	ASSERT_FALSE(Connection().isConnected());
+
+	signal(1);
+	copy.disconnect();
+	ASSERT_FALSE(connection2.isConnected());
+	signal(2);
+
+	// Repeated disconnection and disconnection of an absent slot do nothing
+	connection2.disconnect();
+	signal.disconnect(&receiver2, &Receiver::slot);
+	signal(3);
+
+	ASSERT_EQ(receiver1.values, std::vector<int>({1, 2, 3}));
+	ASSERT_EQ(receiver2.values, std::vector<int>({1}));
+	ASSERT_EQ(plain.sum, 6);
+
+	// Handles survive the move and the destruction of the signal
+	Box<Signal<void(int)>> moved(new Signal<void(int)>(std::move(signal)));
+	ASSERT_FALSE(signal.hasConnections());
+	(*moved)(4);
+	connection3.disconnect();
+	(*moved)(5);
+	ASSERT_EQ(plain.sum, 10);
+	ASSERT_EQ(receiver1.values.back(), 5);
+
+	moved.reset();
+	ASSERT_FALSE(connection1.isConnected());
+	connection1.disconnect();
+}
+
+
+TEST(SignalTest, MassDisconnect)
+{
+	Signal<void(int)> signal;
+	std::vector<Box<Receiver>> receivers;
+
+	for(int i = 0; i < 100; ++i) {
+		receivers.emplace_back(new Receiver(i));
+		signal.connect(receivers.back().get(), &Receiver::slot);
+		signal.connect(receivers.back().get(), &Receiver::slotConst);
+	}
+
+	// Destroy every odd receiver and disconnect the const slots of the rest
+	for(int i = 1; i < 100; i += 2)
+		receivers[i].reset();
+
+	for(int i = 0; i < 100; i += 2)
+		signal.disconnect(receivers[i].get(), &Receiver::slotConst);
+
+	ASSERT_TRUE(signal.hasConnections());
+	signal(1);
+
+	for(int i = 0; i < 100; i += 2) {
+		ASSERT_EQ(receivers[i]->values, std::vector<int>({1}));
+		ASSERT_TRUE(receivers[i]->constValues.empty());
+	}
+
+	for(int i = 0; i < 100; i += 2)
+		signal.disconnect(receivers[i].get());
+
+	ASSERT_FALSE(signal.hasConnections());
+	signal(2);
+	ASSERT_EQ(receivers[0]->values.size(), 1u);
+}
+
+
+TEST(SignalTest, ReentrantEmission)
+{
+	Signal<void(int)> signal;
+	Reentrant reentrant;
+	Receiver receiver;
+	Receiver late;
+
+	reentrant.signal = &signal;
+	reentrant.owned.reset(new Receiver());
+
+	// Slots are called in the connection order
+	reentrant.self = signal.connect(&reentrant, &Reentrant::disconnectSelf);
+	signal.connect(&reentrant, &Reentrant::disconnectOther);
+	signal.connect(&reentrant, &Reentrant::destroyOther);
+	reentrant.other = signal.connect(&receiver, &Receiver::slot);
+	signal.connect(reentrant.owned.get(), &Receiver::slot);
+
+	reentrant.target = &late;
+	signal.connect(&reentrant, &Reentrant::connectOther);
+
+	signal(1);
+	ASSERT_EQ(reentrant.values, std::vector<int>({1, 1, 1, 1}));
+	ASSERT_TRUE(receiver.values.empty());
+	ASSERT_FALSE(reentrant.owned);
+
+	// The slot connected during the emission is called by the next one
+	ASSERT_TRUE(late.values.empty());
+	reentrant.target = nullptr;
+	signal(2);
+	ASSERT_EQ(late.values, std::vector<int>({2}));
+	ASSERT_EQ(reentrant.values, std::vector<int>({1, 1, 1, 1, 2, 2, 2}));
+}
+
+
+TEST(SignalTest, TrackableMove)
+{
+	Signal<void(int)> signal;
+	Box<Receiver> receiver(new Receiver(2));
+
+	Connection connection = signal.connect(receiver.get(), &Receiver::slot);
+	signal.connect(receiver.get(), &Receiver::slotConst);
+	signal(1);
+
+	// Slots follow the moved object, the source is no longer connected
+	Receiver moved(std::move(*receiver));
+	signal(2);
+	receiver.reset();
+	signal(3);
+
+	ASSERT_EQ(moved.values, std::vector<int>({1, 2, 3}));
+	ASSERT_EQ(moved.constValues, std::vector<int>({2, 4, 6}));
+
+	connection.disconnect();
+	signal(4);
+	ASSERT_EQ(moved.values.size(), 3u);
+	ASSERT_EQ(moved.constValues.back(), 8);
+}
+
+
+TEST(SignalTest, TrackableWithManyConnections)
+{
+	std::vector<Signal<void(int)>> emitters(5);
+	std::vector<Connection> connections;
+	Box<Receiver> receiver(new Receiver());
+
+	for(auto& signal : emitters)
+		connections.push_back(signal.connect(receiver.get(), &Receiver::slot));
+
+	// Registrations spill from the inline storage and are removed out of order
+	connections[1].disconnect();
+	connections[4].disconnect();
+	connections.push_back(emitters[1].connect(receiver.get(), &Receiver::slot));
+
+	for(size_t i = 0; i < emitters.size(); ++i)
+		emitters[i](static_cast<int>(i));
+
+	ASSERT_EQ(receiver->values, std::vector<int>({0, 1, 2, 3}));
+
+	Receiver moved(std::move(*receiver));
+	receiver.reset();
+	emitters[2](5);
+	ASSERT_EQ(moved.values.back(), 5);
+
+	{
+		Receiver temporary(std::move(moved));
+	}
+
+	for(auto& signal : emitters)
+		ASSERT_FALSE(signal.hasConnections());
+
+	for(auto& connection : connections)
+		ASSERT_FALSE(connection.isConnected());
+}
+
+
+TEST(SignalTest, Functors)
+{
+	Signal<void(int)> signal;
+	int sum = 0;
+
+	Connection connection = signal.connect([&sum](int value) { sum += value; });
+	signal.connect([&sum](int value) { sum += value * 10; });
+
+	signal(1);
+	ASSERT_EQ(sum, 11);
+
+	connection.disconnect();
+	signal(2);
+	ASSERT_EQ(sum, 31);
+}
+
+
+TEST(SignalTest, FunctorConnectingDuringEmission)
+{
+	Signal<void()> signal;
+	int count = 0;
+	int marker = 0;
+
+	// Connections reallocate the storage of the running functor, its captures must stay
+	// valid
+	signal.connect([&signal, &count, &marker]() {
+		for(int i = 0; i < 64; ++i)
+			signal.connect([&count] { ++count; });
+
+		++marker;
+	});
+
+	signal();
+	ASSERT_EQ(count, 0);
+	ASSERT_EQ(marker, 1);
+
+	signal();
+	ASSERT_EQ(count, 64);
+	ASSERT_EQ(marker, 2);
+}
+
+
+TEST(SignalTest, MutableFunctorKeepsState)
+{
+	Signal<void(int)> signal;
+	int value = 0;
+	int* out = &value;
+
+	signal.connect([out, n = 0](int) mutable { *out = ++n; });
+
+	signal(1);
+	signal(2);
+	signal(3);
+	ASSERT_EQ(value, 3);
+
+	// A connection made during emission doesn't move the running functor
+	signal.connect([&signal, out, n = 0](int) mutable {
+		*out = ++n * 10;
+		signal.connect([](int) {});
+	});
+
+	signal(4);
+	ASSERT_EQ(value, 10);
+	signal(5);
+	ASSERT_EQ(value, 20);
+}
@@ -0,0 +1,87 @@
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/spscqueue.h>
+
+
+using namespace Tech;
+
+
+TEST(SpscQueueTest, PushPop)
+{
+	SpscQueue<Box<int>> queue(3);
+	ASSERT_EQ(queue.capacity(), 4u);
+	ASSERT_TRUE(queue.isEmpty());
+
+	for(int i = 0; i < 4; ++i)
+		ASSERT_TRUE(queue.tryPush(Box<int>(new int(i))));
+
+	ASSERT_FALSE(queue.tryEmplace(new int(4)));
+
+	Box<int> value;
+	ASSERT_TRUE(queue.tryPop(&value));
+	ASSERT_EQ(*value, 0);
+	ASSERT_TRUE(queue.tryEmplace(new int(4)));
+
+	for(int i = 1; i <= 4; ++i) {
+		ASSERT_TRUE(queue.tryPop(&value));
+		ASSERT_EQ(*value, i);
+	}
+
+	ASSERT_FALSE(queue.tryPop(&value));
+	ASSERT_TRUE(queue.isEmpty());
+
+	// Values left in the queue are destroyed with it
+	ASSERT_TRUE(queue.tryEmplace(new int(5)));
+}
+
+
+TEST(SpscQueueTest, Batches)
+{
+	SpscQueue<int> queue(8);
+	std::vector<int> input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+	ASSERT_EQ(queue.pushBatch(input.begin(), input.size()), 8u);
+	ASSERT_EQ(queue.pushBatch(input.begin(), input.size()), 0u);
+
+	std::vector<int> output;
+	ASSERT_EQ(queue.popBatch(std::back_inserter(output), 5), 5u);
+	ASSERT_EQ(queue.pushBatch(input.begin() + 8, 2), 2u);
+	ASSERT_EQ(queue.popBatch(std::back_inserter(output), 100), 5u);
+	ASSERT_EQ(output, input);
+}
+
+
+TEST(SpscQueueTest, Threads)
+{
+	static const u64 kCount = 200000;
+
+	SpscQueue<u64> queue(64);
+	u64 sum = 0;
+
+	std::thread consumer([&queue, &sum]() {
+		u64 values[16];
+		u64 expected = 0;
+
+		while(expected < kCount) {
+			size_t count = queue.popBatch(values, 16);
+
+			for(size_t i = 0; i < count; ++i) {
+				EXPECT_EQ(values[i], expected);
+				sum += values[i];
+				++expected;
+			}
+
+			if(!count)
+				std::this_thread::yield();
+		}
+	});
+
+	for(u64 i = 0; i < kCount; ++i) {
+		while(!queue.tryPush(i))
+			std::this_thread::yield();
+	}
+
+	consumer.join();
+	ASSERT_EQ(sum, kCount * (kCount - 1) / 2);
+}
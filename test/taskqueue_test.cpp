@@ -0,0 +1,207 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/semaphore.h>
+#include <tech/signal.h>
+#include <tech/string.h>
+#include <tech/taskqueue.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Recorder : public Trackable {
+public:
+	void add(int value)
+	{
+		values.push_back(value);
+	}
+
+	void addWithText(const String& text, int value)
+	{
+		texts.push_back(text);
+		values.push_back(value);
+	}
+
+	std::vector<int> values;
+	std::vector<String> texts;
+};
+
+
+class WakeupCounter {
+public:
+	void wakeup()
+	{
+		count.fetch_add(1, std::memory_order_relaxed);
+		semaphore.post();
+	}
+
+	std::atomic<int> count{0};
+	Semaphore semaphore;
+};
+
+
+class DestroyTask final : public TaskQueue::Task {
+public:
+	DestroyTask(int* runCount, int* destroyCount) :
+		runCount_(runCount),
+		destroyCount_(destroyCount)
+	{
+	}
+
+	~DestroyTask() override
+	{
+		++*destroyCount_;
+	}
+
+	void run() override
+	{
+		++*runCount_;
+	}
+
+private:
+	int* runCount_;
+	int* destroyCount_;
+	u8 payload_[20000];
+};
+
+
+} // namespace
+
+
+TEST(TaskQueueTest, RunsTasksInBatches)
+{
+	WakeupCounter wakeup;
+	TaskQueue queue(TaskQueue::WakeupHandler(&wakeup, &WakeupCounter::wakeup));
+	Recorder recorder;
+	Signal<void(int)> signal;
+
+	signal.connect(&recorder, &Recorder::add, &queue);
+	ASSERT_TRUE(queue.isEmpty());
+
+	// Tasks posted before the owner reacts share a single wakeup
+	for(int i = 0; i < 1000; ++i)
+		signal(i);
+
+	ASSERT_EQ(wakeup.count.load(), 1);
+	ASSERT_FALSE(queue.isEmpty());
+	ASSERT_TRUE(recorder.values.empty());
+
+	ASSERT_EQ(queue.processTasks(), 1000u);
+	ASSERT_TRUE(queue.isEmpty());
+	ASSERT_EQ(recorder.values.size(), 1000u);
+
+	for(int i = 0; i < 1000; ++i)
+		ASSERT_EQ(recorder.values[i], i);
+
+	// Reused chunks and tasks larger than a chunk
+	int runCount = 0;
+	int destroyCount = 0;
+	signal(1000);
+	queue.post<DestroyTask>(&runCount, &destroyCount);
+	signal(1001);
+
+	ASSERT_EQ(wakeup.count.load(), 2);
+	ASSERT_EQ(queue.processTasks(), 3u);
+	ASSERT_EQ(runCount, 1);
+	ASSERT_EQ(destroyCount, 1);
+	ASSERT_EQ(recorder.values.back(), 1001);
+
+	{
+		TaskQueue pending;
+		pending.post<DestroyTask>(&runCount, &destroyCount);
+	}
+
+	ASSERT_EQ(runCount, 1);
+	ASSERT_EQ(destroyCount, 2);
+}
+
+
+TEST(TaskQueueTest, QueuedConnections)
+{
+	TaskQueue queue;
+	Signal<void(const String&, int)> signal;
+	Recorder recorder;
+
+	signal.connect(&recorder, &Recorder::addWithText, &queue);
+
+	// Arguments are copied at emission
+	String text("first");
+	signal(text, 1);
+	text = String("second");
+	signal(text, 2);
+
+	ASSERT_EQ(queue.processTasks(), 2u);
+	ASSERT_EQ(recorder.texts.size(), 2u);
+	ASSERT_EQ(recorder.texts[0], String("first"));
+	ASSERT_EQ(recorder.texts[1], String("second"));
+
+	// Tasks of a disconnected slot are dropped
+	signal(text, 3);
+	signal.disconnect(&recorder, &Recorder::addWithText);
+	ASSERT_FALSE(signal.hasConnections());
+	ASSERT_EQ(queue.processTasks(), 1u);
+	ASSERT_EQ(recorder.values.size(), 2u);
+
+	// Destruction of the trackable receiver disconnects the pending calls as well
+	{
+		Recorder temporary;
+		signal.connect(&temporary, &Recorder::addWithText, &queue);
+		signal(text, 4);
+	}
+
+	ASSERT_FALSE(signal.hasConnections());
+	ASSERT_EQ(queue.processTasks(), 1u);
+}
+
+
+TEST(TaskQueueTest, CrossThreadDelivery)
+{
+	static const int kThreadCount = 4;
+	static const int kEmitCount = 10000;
+
+	WakeupCounter wakeup;
+	TaskQueue queue(TaskQueue::WakeupHandler(&wakeup, &WakeupCounter::wakeup));
+	Recorder recorder;
+	std::vector<Box<Signal<void(int)>>> emitters;
+	std::vector<std::thread> threads;
+
+	for(int i = 0; i < kThreadCount; ++i) {
+		emitters.emplace_back(new Signal<void(int)>());
+		emitters.back()->connect(&recorder, &Recorder::add, &queue);
+	}
+
+	for(int i = 0; i < kThreadCount; ++i) {
+		Signal<void(int)>* signal = emitters[i].get();
+
+		threads.emplace_back([signal]() {
+			for(int j = 0; j < kEmitCount; ++j)
+				(*signal)(j);
+		});
+	}
+
+	// Event loop of the owner thread: every task arrives after a wakeup
+	size_t total = 0;
+	while(total < kThreadCount * kEmitCount) {
+		wakeup.semaphore.wait();
+		total += queue.processTasks();
+	}
+
+	for(auto& thread : threads)
+		thread.join();
+
+	ASSERT_EQ(recorder.values.size(), static_cast<size_t>(kThreadCount * kEmitCount));
+	ASSERT_LE(wakeup.count.load(), kThreadCount * kEmitCount);
+
+	long long sum = 0;
+
+	for(int value : recorder.values)
+		sum += value;
+
+	ASSERT_EQ(sum, static_cast<long long>(kThreadCount) * kEmitCount *
+			(kEmitCount - 1) / 2);
+}
@@ -0,0 +1,149 @@
+#include <atomic>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/platform.h>
+#include <tech/thread.h>
+
+#ifdef PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+class Probe : public Thread {
+public:
+	~Probe() override
+	{
+		waitForFinished();
+	}
+
+	std::atomic<int> runCount{0};
+	std::string name;
+	std::vector<int> cpus;
+	size_t stackSize = 0;
+	int nice = 0;
+
+protected:
+	void run() override
+	{
+		runCount.fetch_add(1);
+
+#ifdef PLATFORM_LINUX
+		char buffer[16] = {};
+		pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+		name = buffer;
+
+		cpu_set_t set;
+		pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+		for(int i = 0; i < CPU_SETSIZE; ++i) {
+			if(CPU_ISSET(i, &set))
+				cpus.push_back(i);
+		}
+
+		pthread_attr_t attributes;
+		pthread_getattr_np(pthread_self(), &attributes);
+		pthread_attr_getstacksize(&attributes, &stackSize);
+		pthread_attr_destroy(&attributes);
+
+		nice = getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)));
+#endif
+	}
+};
+
+
+} // namespace
+
+
+TEST(ThreadTest, Joinable)
+{
+	Probe thread;
+	thread.setJoinable(true);
+	ASSERT_TRUE(thread.isJoinable());
+
+	ASSERT_TRUE(thread.start());
+	thread.join();
+	ASSERT_TRUE(thread.isFinished());
+	ASSERT_EQ(thread.runCount.load(), 1);
+
+	// Restarting joins the previous run first, the destructor joins the last one
+	ASSERT_TRUE(thread.start());
+	thread.waitForFinished();
+	ASSERT_TRUE(thread.start());
+	thread.waitForFinished();
+	ASSERT_TRUE(thread.isFinished());
+	ASSERT_EQ(thread.runCount.load(), 3);
+
+	Probe detached;
+	ASSERT_TRUE(detached.start());
+	detached.waitForFinished();
+	detached.join();
+	ASSERT_TRUE(detached.isFinished());
+	ASSERT_EQ(detached.runCount.load(), 1);
+}
+
+
+#ifdef PLATFORM_LINUX
+
+TEST(ThreadTest, Settings)
+{
+	Probe thread;
+	thread.setJoinable(true);
+	thread.setName("render-thread-with-long-name");
+	thread.setAffinity({0});
+	thread.setStackSize(1024 * 1024);
+
+	ASSERT_TRUE(thread.start());
+	thread.join();
+
+	ASSERT_EQ(thread.name, "render-thread-w");
+	ASSERT_EQ(thread.cpus, std::vector<int>{0});
+	ASSERT_GE(thread.stackSize, 1024u * 1024u);
+
+	// Invalid settings make start() fail
+	Probe invalid;
+	invalid.setAffinity({-1});
+	ASSERT_FALSE(invalid.start());
+	ASSERT_TRUE(invalid.isFinished());
+
+	invalid.setAffinity({});
+	invalid.setScheduling(ThreadPolicy::kFifo, 1000);
+	ASSERT_FALSE(invalid.start());
+}
+
+
+TEST(ThreadTest, NiceValues)
+{
+	Probe lower;
+	lower.setJoinable(true);
+	lower.setScheduling(ThreadPolicy::kDefault, 5);
+
+	ASSERT_TRUE(lower.start());
+	lower.join();
+	ASSERT_EQ(lower.nice, 5);
+
+	// A negative value needs privileges, without them the thread doesn't run
+	Probe higher;
+	higher.setJoinable(true);
+	higher.setScheduling(ThreadPolicy::kDefault, -5);
+
+	if(higher.start()) {
+		higher.join();
+		ASSERT_EQ(higher.nice, -5);
+	}
+	else {
+		ASSERT_TRUE(higher.isFinished());
+		ASSERT_EQ(higher.runCount.load(), 0);
+	}
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/threadpool.h>
+
+
+using namespace Tech;
+
+
+namespace {
+
+
+// Sums the range by splitting it into subtasks which are submitted from the workers
+u64 parallelSum(ThreadPool* pool, u64 begin, u64 end)
+{
+	if(end - begin <= 64) {
+		u64 sum = 0;
+		for(u64 i = begin; i < end; ++i)
+			sum += i;
+
+		return sum;
+	}
+
+	u64 middle = begin + (end - begin) / 2;
+	u64 left = 0;
+	ThreadPool::Group group;
+
+	pool->submit(&group, [pool, begin, middle, &left]() {
+		left = parallelSum(pool, begin, middle);
+	});
+
+	u64 right = parallelSum(pool, middle, end);
+	pool->wait(&group);
+	return left + right;
+}
+
+
+} // namespace
+
+
+TEST(ThreadPoolTest, RunsSubmittedTasks)
+{
+	ThreadPool pool(4);
+	ThreadPool::Group group;
+	std::atomic<int> sum(0);
+
+	ASSERT_EQ(pool.threadCount(), 4u);
+	ASSERT_TRUE(group.isFinished());
+
+	for(int i = 1; i <= 1000; ++i)
+		pool.submit(&group, [&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+
+	pool.wait(&group);
+	ASSERT_TRUE(group.isFinished());
+	ASSERT_EQ(sum.load(), 500500);
+
+	// Parked workers are woken by new tasks
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	pool.submit(&group, [&sum]() { sum.store(0); });
+	pool.wait(&group);
+	ASSERT_EQ(sum.load(), 0);
+}
+
+
+TEST(ThreadPoolTest, NestedGroups)
+{
+	ThreadPool pool(4);
+	ThreadPool::Group group;
+	u64 sum = 0;
+
+	pool.submit(&group, [&pool, &sum]() {
+		sum = parallelSum(&pool, 0, 100000);
+	});
+
+	pool.wait(&group);
+	ASSERT_EQ(sum, 100000ull * 99999 / 2);
+
+	// A single worker runs the whole tree by waiting on its own subtasks
+	ThreadPool single(1);
+	ASSERT_EQ(parallelSum(&single, 0, 10000), 10000ull * 9999 / 2);
+}
+
+
+TEST(ThreadPoolTest, ConcurrentSubmitters)
+{
+	ThreadPool pool(3);
+	std::atomic<int> count(0);
+	std::vector<std::thread> submitters;
+
+	for(int i = 0; i < 4; ++i) {
+		submitters.emplace_back([&pool, &count]() {
+			ThreadPool::Group group;
+
+			for(int j = 0; j < 2000; ++j) {
+				pool.submit(&group, [&count]() {
+					count.fetch_add(1, std::memory_order_relaxed);
+				});
+			}
+
+			pool.wait(&group);
+		});
+	}
+
+	for(auto& submitter : submitters)
+		submitter.join();
+
+	ASSERT_EQ(count.load(), 8000);
+}
+
+
+TEST(ThreadPoolTest, DestructorRunsPendingTasks)
+{
+	std::atomic<int> count(0);
+
+	{
+		ThreadPool pool(2);
+
+		for(int i = 0; i < 100; ++i) {
+			pool.submit([&pool, &count]() {
+				// Tasks submitted during the destruction are run as well
+				pool.submit([&count]() { count.fetch_add(1); });
+				count.fetch_add(1);
+			});
+		}
+	}
+
+	ASSERT_EQ(count.load(), 200);
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <tech/timerwheel.h>
+
+
+using namespace Tech;
+
+
+TEST(TimerWheelTest, ExpiresAtDeadlines)
+{
+	TimerWheel wheel(1000);
+	ASSERT_EQ(wheel.nextDeadline(), -1);
+
+	auto t1 = wheel.create();
+	auto t2 = wheel.create();
+	auto t3 = wheel.create();
+	ASSERT_NE(t1, TimerWheel::kInvalidHandle);
+	ASSERT_FALSE(wheel.isActive(t1));
+
+	wheel.start(t1, 1000, 5);
+	wheel.start(t2, 1000, 100);
+	wheel.start(t3, 1000, 70000);
+	ASSERT_TRUE(wheel.isActive(t1));
+	ASSERT_EQ(wheel.activeCount(), 3u);
+	ASSERT_EQ(wheel.interval(t2), 100);
+	ASSERT_EQ(wheel.nextDeadline(), 1005);
+
+	std::vector<std::pair<TimerWheel::Handle, i64>> expired;
+	auto record = [&wheel, &expired](TimerWheel::Handle handle) {
+		expired.emplace_back(handle, wheel.currentTime());
+	};
+
+	ASSERT_EQ(wheel.advance(1004, record), 0u);
+	ASSERT_EQ(wheel.advance(1005, record), 1u);
+	ASSERT_EQ(expired.back(), std::make_pair(t1, i64(1005)));
+	ASSERT_FALSE(wheel.isActive(t1));
+
+	// Upper levels may report the time their slot is moved down, never later than the
+	// deadline
+	i64 next = wheel.nextDeadline();
+	ASSERT_GT(next, 1005);
+	ASSERT_LE(next, 1100);
+
+	ASSERT_EQ(wheel.advance(2000, record), 1u);
+	ASSERT_EQ(expired.back(), std::make_pair(t2, i64(1100)));
+
+	wheel.stop(t3);
+	ASSERT_EQ(wheel.activeCount(), 0u);
+	ASSERT_EQ(wheel.advance(100000, record), 0u);
+	ASSERT_EQ(wheel.nextDeadline(), -1);
+
+	// Deadlines in the past expire on the next advance
+	wheel.start(t3, 0, 10);
+	ASSERT_EQ(wheel.advance(100001, record), 1u);
+	ASSERT_EQ(expired.back().first, t3);
+
+	wheel.destroy(t1);
+	ASSERT_FALSE(wheel.isActive(t1));
+	ASSERT_EQ(wheel.create(), t1);
+}
+
+
+TEST(TimerWheelTest, PeriodicAndReentrant)
+{
+	TimerWheel wheel;
+	auto periodic = wheel.create();
+	auto victim = wheel.create();
+	auto chained = wheel.create();
+	int periodicCount = 0;
+	int chainedCount = 0;
+
+	wheel.start(periodic, 0, 10, true);
+	wheel.start(victim, 0, 25);
+
+	auto handler = [&](TimerWheel::Handle handle) {
+		if(handle == periodic) {
+			ASSERT_TRUE(wheel.isActive(periodic));
+			if(++periodicCount == 2) {
+				wheel.destroy(victim);
+				wheel.start(chained, wheel.currentTime(), 0);
+			}
+		}
+		else if(handle == chained) {
+			++chainedCount;
+		}
+		else {
+			FAIL() << "destroyed timer expired";
+		}
+	};
+
+	ASSERT_EQ(wheel.advance(10, handler), 1u);
+	ASSERT_EQ(wheel.advance(20, handler), 1u);
+	ASSERT_EQ(chainedCount, 0);
+	ASSERT_EQ(wheel.advance(21, handler), 1u);
+	ASSERT_EQ(chainedCount, 1);
+
+	for(i64 now = 22; now <= 1000; ++now)
+		wheel.advance(now, handler);
+
+	ASSERT_EQ(periodicCount, 100);
+	ASSERT_EQ(wheel.nextDeadline(), 1010);
+
+	// A late advance() expires a periodic timer once and keeps its phase
+	ASSERT_EQ(wheel.advance(1555, handler), 1u);
+	ASSERT_EQ(periodicCount, 101);
+	ASSERT_EQ(wheel.nextDeadline(), 1560);
+}
+
+
+// Compares the wheel with a sorted map of deadlines over random operations with timeouts
+// on every level
+TEST(TimerWheelTest, MatchesReference)
+{
+	std::mt19937 random(3);
+	TimerWheel wheel(123456789);
+	std::vector<TimerWheel::Handle> handles;
+	std::map<TimerWheel::Handle, i64> deadlines;
+	i64 now = 123456789;
+
+	for(int i = 0; i < 500; ++i)
+		handles.push_back(wheel.create());
+
+	for(int step = 0; step < 20000; ++step) {
+		TimerWheel::Handle handle = handles[random() % handles.size()];
+		u32 action = random() % 10;
+
+		if(action < 5) {
+			i64 timeout = static_cast<i64>(random() % (1u << (random() % 31)));
+			wheel.start(handle, now, timeout);
+			deadlines[handle] = std::max(now + timeout, wheel.currentTime() + 1);
+		}
+		else if(action < 7) {
+			wheel.stop(handle);
+			deadlines.erase(handle);
+		}
+		else {
+			now += static_cast<i64>(random() % (1u << (random() % 24)));
+
+			std::vector<std::pair<i64, TimerWheel::Handle>> expected;
+			for(auto& pair : deadlines) {
+				if(pair.second <= now)
+					expected.emplace_back(pair.second, pair.first);
+			}
+
+			std::vector<std::pair<i64, TimerWheel::Handle>> actual;
+			wheel.advance(now, [&](TimerWheel::Handle expiredHandle) {
+				actual.emplace_back(wheel.currentTime(), expiredHandle);
+				deadlines.erase(expiredHandle);
+			});
+
+			std::sort(expected.begin(), expected.end());
+			std::sort(actual.begin(), actual.end());
+			ASSERT_EQ(actual, expected);
+		}
+
+		ASSERT_EQ(wheel.activeCount(), deadlines.size());
+
+		i64 next = wheel.nextDeadline();
+		if(deadlines.empty()) {
+			ASSERT_EQ(next, -1);
+		}
+		else {
+			i64 nearest = std::min_element(deadlines.begin(), deadlines.end(),
+					[](const std::pair<const TimerWheel::Handle, i64>& a,
+							const std::pair<const TimerWheel::Handle, i64>& b) {
+						return a.second < b.second;
+					})->second;
+			ASSERT_GT(next, wheel.currentTime());
+			ASSERT_LE(next, nearest);
+		}
+	}
+}